@@ -21,7 +21,12 @@
 //
 
 #include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/CommandLine.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
 #include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
 #include <Urho3D/Graphics/Camera.h>
 #include <Urho3D/Graphics/DebugRenderer.h>
 #include <Urho3D/Graphics/Graphics.h>
@@ -35,6 +40,7 @@
 #include <Urho3D/Input/Input.h>
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
 #include <Urho3D/Physics/CollisionShape.h>
 #include <Urho3D/Physics/PhysicsWorld.h>
 #include <Urho3D/Physics/RigidBody.h>
@@ -52,12 +58,33 @@ URHO3D_DEFINE_APPLICATION_MAIN(PhysicsStressTest)
 
 PhysicsStressTest::PhysicsStressTest(Context* context) :
     Sample(context),
-    drawDebug_(false)
+    drawDebug_(false),
+    benchmark_(false)
 {
 }
 
+void PhysicsStressTest::Setup()
+{
+    // Execute base class setup
+    Sample::Setup();
+
+    // The benchmark only steps physics, so it does not need a window
+    GetCommandLineParser().add_flag_function("--benchmark", [this](size_t)
+    {
+        benchmark_ = true;
+        engineParameters_[EP_HEADLESS] = true;
+    }, "Measure physics step time per body count and exit");
+}
+
 void PhysicsStressTest::Start()
 {
+    if (benchmark_)
+    {
+        RunBenchmark();
+        engine_->Exit();
+        return;
+    }
+
     // Execute base class startup
     Sample::Start();
 
@@ -179,6 +206,100 @@ void PhysicsStressTest::CreateScene()
     cameraNode_->SetPosition(Vector3(0.0f, 3.0f, -20.0f));
 }
 
+SharedPtr<Scene> PhysicsStressTest::CreateBenchmarkScene(unsigned numObjects)
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+
+    // Same random sequence on every run, so that results are comparable between runs and builds
+    SetRandomSeed(1);
+
+    SharedPtr<Scene> scene(new Scene(context_));
+    scene->CreateComponent<PhysicsWorld>();
+
+    {
+        Node* floorNode = scene->CreateChild("Floor");
+        floorNode->SetPosition(Vector3(0.0f, -0.5f, 0.0f));
+        floorNode->SetScale(Vector3(500.0f, 1.0f, 500.0f));
+        floorNode->CreateComponent<RigidBody>();
+        auto* shape = floorNode->CreateComponent<CollisionShape>();
+        shape->SetBox(Vector3::ONE);
+    }
+
+    {
+        const unsigned NUM_MUSHROOMS = 50;
+        for (unsigned i = 0; i < NUM_MUSHROOMS; ++i)
+        {
+            Node* mushroomNode = scene->CreateChild("Mushroom");
+            mushroomNode->SetPosition(Vector3(Random(400.0f) - 200.0f, 0.0f, Random(400.0f) - 200.0f));
+            mushroomNode->SetRotation(Quaternion(0.0f, Random(360.0f), 0.0f));
+            mushroomNode->SetScale(5.0f + Random(5.0f));
+            mushroomNode->CreateComponent<RigidBody>();
+            auto* shape = mushroomNode->CreateComponent<CollisionShape>();
+            shape->SetTriangleMesh(cache->GetResource<Model>("Models/Mushroom.mdl"));
+        }
+    }
+
+    {
+        // Drop the boxes in a grid of short stacks. A single stack would settle into one simulation island,
+        // which can not be solved in parallel
+        const unsigned STACK_HEIGHT = 10;
+        const unsigned numStacks = (numObjects + STACK_HEIGHT - 1) / STACK_HEIGHT;
+        const auto gridSize = (unsigned)CeilToInt(Sqrt((float)numStacks));
+        const float STACK_SPACING = 6.0f;
+        for (unsigned i = 0; i < numObjects; ++i)
+        {
+            const unsigned stack = i / STACK_HEIGHT;
+            const float x = ((float)(stack % gridSize) - gridSize * 0.5f) * STACK_SPACING;
+            const float z = ((float)(stack / gridSize) - gridSize * 0.5f) * STACK_SPACING;
+
+            Node* boxNode = scene->CreateChild("Box");
+            boxNode->SetPosition(Vector3(x, (i % STACK_HEIGHT) * 2.0f + 20.0f, z));
+            boxNode->SetRotation(Quaternion(Random(360.0f), Random(360.0f), Random(360.0f)));
+            auto* body = boxNode->CreateComponent<RigidBody>();
+            body->SetMass(1.0f);
+            body->SetFriction(1.0f);
+            body->SetCollisionEventMode(COLLISION_NEVER);
+            auto* shape = boxNode->CreateComponent<CollisionShape>();
+            shape->SetBox(Vector3::ONE);
+        }
+    }
+
+    return scene;
+}
+
+void PhysicsStressTest::RunBenchmark()
+{
+    const unsigned BODY_COUNTS[] = { 250, 500, 1000, 2000, 4000 };
+    // Five seconds of simulation at the default 60 fps, long enough for the boxes to land and settle
+    const unsigned NUM_STEPS = 300;
+    const float TIME_STEP = 1.0f / 60.0f;
+
+    PrintLine(Format("Physics benchmark, {} steps per run, {} worker threads", NUM_STEPS,
+        GetSubsystem<WorkQueue>()->GetNumThreads()));
+    PrintLine("Bodies  Single (ms/step)  Multithreaded (ms/step)");
+
+    for (unsigned numObjects : BODY_COUNTS)
+    {
+        float stepTimes[2];
+        for (unsigned multithreaded = 0; multithreaded < 2; ++multithreaded)
+        {
+            // Must be set before the physics world is created
+            PhysicsWorld::config.multithreaded_ = multithreaded != 0;
+            SharedPtr<Scene> scene = CreateBenchmarkScene(numObjects);
+            auto* physicsWorld = scene->GetComponent<PhysicsWorld>();
+
+            HiresTimer timer;
+            for (unsigned i = 0; i < NUM_STEPS; ++i)
+                physicsWorld->Update(TIME_STEP);
+            stepTimes[multithreaded] = timer.GetUSec(false) / 1000.0f / NUM_STEPS;
+        }
+
+        PrintLine(Format("{:>6}  {:>16.3f}  {:>23.3f}", numObjects, stepTimes[0], stepTimes[1]));
+    }
+
+    PhysicsWorld::config.multithreaded_ = false;
+}
+
 void PhysicsStressTest::CreateInstructions()
 {
     auto* cache = GetSubsystem<ResourceCache>();
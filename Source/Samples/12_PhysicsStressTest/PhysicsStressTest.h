@@ -37,6 +37,7 @@ class Scene;
 ///     - Physics and rendering performance with a high (1000) moving object count
 ///     - Using triangle meshes for collision
 ///     - Optimizing physics simulation by leaving out collision event signaling
+///     - Measuring physics step time per body count, single and multithreaded, when run with --benchmark
 class PhysicsStressTest : public Sample
 {
     URHO3D_OBJECT(PhysicsStressTest, Sample);
@@ -45,6 +46,8 @@ public:
     /// Construct.
     explicit PhysicsStressTest(Context* context);
 
+    /// Setup before engine initialization. Register the benchmark command line flag.
+    void Setup() override;
     /// Setup after engine initialization and before running the main loop.
     void Start() override;
 
@@ -74,6 +77,10 @@ protected:
 private:
     /// Construct the scene content.
     void CreateScene();
+    /// Construct a scene with physics components only for the benchmark. Uses a fixed random seed.
+    SharedPtr<Scene> CreateBenchmarkScene(unsigned numObjects);
+    /// Step the physics of benchmark scenes with increasing body counts and print the average step time.
+    void RunBenchmark();
     /// Construct an instruction text to the UI.
     void CreateInstructions();
     /// Set up a viewport for displaying the scene.
@@ -91,4 +98,6 @@ private:
 
     /// Flag for drawing debug geometry.
     bool drawDebug_;
+    /// Flag for running the headless benchmark instead of the interactive sample.
+    bool benchmark_;
 };
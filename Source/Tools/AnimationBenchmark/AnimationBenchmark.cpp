@@ -0,0 +1,225 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Math/Random.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Keyframes per second of the generated clips, as exported from a typical authoring tool.
+static const float KEYFRAME_RATE = 30.0f;
+/// Number of random time positions sampled per clip.
+static const unsigned SAMPLES_PER_CLIP = 4096;
+
+int main(int argc, char** argv);
+void Run(const ea::vector<ea::string>& arguments);
+
+int main(int argc, char** argv)
+{
+    ea::vector<ea::string> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+/// Create a clip of smooth bone motion. Positions move within a unit range, rotations within 90 degrees around each axis, scales are constant.
+SharedPtr<Animation> CreateClip(Context* context, unsigned numBones, float length)
+{
+    SharedPtr<Animation> animation(new Animation(context));
+    animation->SetLength(length);
+
+    const unsigned numKeyFrames = (unsigned)(length * KEYFRAME_RATE) + 1;
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        AnimationTrack* track = animation->CreateTrack(Format("Bone{}", i));
+        track->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION | CHANNEL_SCALE;
+
+        Vector3 frequency(Random(0.2f, 2.0f), Random(0.2f, 2.0f), Random(0.2f, 2.0f));
+        Vector3 phase(Random(0.0f, 360.0f), Random(0.0f, 360.0f), Random(0.0f, 360.0f));
+        for (unsigned j = 0; j < numKeyFrames; ++j)
+        {
+            const float time = Min((float)j / KEYFRAME_RATE, length);
+            const Vector3 angles(Sin(360.0f * frequency.x_ * time + phase.x_), Sin(360.0f * frequency.y_ * time + phase.y_),
+                Sin(360.0f * frequency.z_ * time + phase.z_));
+
+            AnimationKeyFrame keyFrame;
+            keyFrame.time_ = time;
+            keyFrame.position_ = angles * 0.5f;
+            keyFrame.rotation_ = Quaternion(angles.x_ * 45.0f, angles.y_ * 45.0f, angles.z_ * 45.0f);
+            keyFrame.scale_ = Vector3::ONE;
+            track->AddKeyFrame(keyFrame);
+        }
+    }
+
+    return animation;
+}
+
+/// Return the angle in degrees between two rotations. Uses the distance of the quaternions in double precision, as the arc cosine of their dot product loses precision for small angles.
+float GetAngleError(const Quaternion& lhs, const Quaternion& rhs)
+{
+    const double sign = lhs.DotProduct(rhs) < 0.0f ? -1.0 : 1.0;
+    const double dw = (double)lhs.w_ - sign * rhs.w_;
+    const double dx = (double)lhs.x_ - sign * rhs.x_;
+    const double dy = (double)lhs.y_ - sign * rhs.y_;
+    const double dz = (double)lhs.z_ - sign * rhs.z_;
+    // The distance of unit quaternions is 2 sin(angle / 4)
+    const double distance = sqrt(dw * dw + dx * dx + dy * dy + dz * dz);
+    return (float)(4.0 * asin(Min(distance * 0.5, 1.0)) * M_RADTODEG);
+}
+
+/// Sample every track of the clips at the given time positions, starting each lookup from a stale keyframe index. Return elapsed time in milliseconds.
+double SampleClips(const ea::vector<SharedPtr<Animation> >& clips, const ea::vector<float>& times, float& checksum)
+{
+    HiresTimer timer;
+    for (unsigned i = 0; i < clips.size(); ++i)
+    {
+        Animation* clip = clips[i];
+        for (unsigned j = 0; j < SAMPLES_PER_CLIP; ++j)
+        {
+            const float time = times[(i * SAMPLES_PER_CLIP + j) % times.size()] * clip->GetLength();
+            for (auto k = clip->GetTracks().begin(); k != clip->GetTracks().end(); ++k)
+            {
+                unsigned index = 0;
+                Vector3 position;
+                Quaternion rotation;
+                Vector3 scale;
+                k->second.Sample(time, clip->GetLength(), true, index, position, rotation, scale);
+                checksum += position.x_ + rotation.w_;
+            }
+        }
+    }
+    return (double)timer.GetUSec(false) / 1000.0;
+}
+
+void Run(const ea::vector<ea::string>& arguments)
+{
+    if (arguments.size() < 1)
+    {
+        ErrorExit("Usage: AnimationBenchmark <clips> [bones] [seconds] [rate]\n\n"
+            "Generates clips of smooth bone motion keyed at 30 frames per second, compresses copies of them at the\n"
+            "given rate (default 0, which keeps the keyframe rate) and reports the memory use, the sampling error\n"
+            "of the compressed clips and the random-time sampling throughput of both. Defaults are 50 bones and\n"
+            "2 seconds per clip.");
+    }
+
+    const unsigned numClips = Max(ToUInt(arguments[0]), 1u);
+    const unsigned numBones = arguments.size() > 1 ? Max(ToUInt(arguments[1]), 1u) : 50;
+    const float length = arguments.size() > 2 ? Max(ToFloat(arguments[2]), 0.1f) : 2.0f;
+    const float sampleRate = arguments.size() > 3 ? Max(ToFloat(arguments[3]), 0.0f) : 0.0f;
+
+    SharedPtr<Context> context(new Context());
+    // Time initializes the high-resolution timer
+    context->RegisterSubsystem(new Time(context));
+    Animation::RegisterObject(context);
+    SetRandomSeed(1);
+
+    ea::vector<SharedPtr<Animation> > clips;
+    ea::vector<SharedPtr<Animation> > compressedClips;
+    unsigned memoryUse = 0;
+    unsigned compressedMemoryUse = 0;
+    for (unsigned i = 0; i < numClips; ++i)
+    {
+        clips.push_back(CreateClip(context, numBones, length));
+        // Clips created in code do not update their memory use, decompressing the uncompressed clip recalculates it
+        clips.back()->Decompress();
+        compressedClips.push_back(clips.back()->Clone());
+        compressedClips.back()->Compress(sampleRate);
+        memoryUse += clips.back()->GetMemoryUse();
+        compressedMemoryUse += compressedClips.back()->GetMemoryUse();
+    }
+
+    // Compare the compressed clips against the originals at random time positions
+    float maxPositionError = 0.0f;
+    float maxRotationError = 0.0f;
+    double positionErrorSum = 0.0;
+    double rotationErrorSum = 0.0;
+    unsigned numErrorSamples = 0;
+    for (unsigned i = 0; i < numClips; ++i)
+    {
+        for (unsigned j = 0; j < SAMPLES_PER_CLIP / 16; ++j)
+        {
+            const float time = Random(0.0f, length);
+            // Track order of a cloned clip may differ, so match the tracks by name
+            for (auto k = clips[i]->GetTracks().begin(); k != clips[i]->GetTracks().end(); ++k)
+            {
+                unsigned index = 0;
+                Vector3 position, compressedPosition, scale;
+                Quaternion rotation, compressedRotation;
+                k->second.Sample(time, length, true, index, position, rotation, scale);
+                index = 0;
+                compressedClips[i]->GetTrack(k->first)->Sample(time, length, true, index, compressedPosition, compressedRotation,
+                    scale);
+
+                const float positionError = (position - compressedPosition).Length();
+                const float rotationError = GetAngleError(rotation, compressedRotation);
+                maxPositionError = Max(maxPositionError, positionError);
+                maxRotationError = Max(maxRotationError, rotationError);
+                positionErrorSum += positionError;
+                rotationErrorSum += rotationError;
+                ++numErrorSamples;
+            }
+        }
+    }
+
+    ea::vector<float> times(SAMPLES_PER_CLIP * 4);
+    for (float& time : times)
+        time = Random(0.0f, 1.0f);
+
+    float checksum = 0.0f;
+    // Warm up
+    SampleClips(clips, times, checksum);
+    SampleClips(compressedClips, times, checksum);
+    const double elapsedMs = SampleClips(clips, times, checksum);
+    const double compressedElapsedMs = SampleClips(compressedClips, times, checksum);
+    const double numSamples = (double)numClips * SAMPLES_PER_CLIP * numBones;
+
+    PrintLine(Format("{} clips, {} bones, {:.1f} s at {:.0f} keyframes/s, compressed at rate {:.0f}",
+        numClips, numBones, length, KEYFRAME_RATE, sampleRate));
+    PrintLine(Format("Memory: {} KB -> {} KB ({:.1f}x)", memoryUse / 1024, compressedMemoryUse / 1024,
+        (double)memoryUse / Max(compressedMemoryUse, 1u)));
+    PrintLine(Format("Position error (range 1): max {:.2e}, mean {:.2e}", maxPositionError,
+        positionErrorSum / numErrorSamples));
+    PrintLine(Format("Rotation error (degrees): max {:.2e}, mean {:.2e}", maxRotationError,
+        rotationErrorSum / numErrorSamples));
+    PrintLine(Format("Random-time sampling: {:.1f} ns -> {:.1f} ns per track ({:.1f}x)", elapsedMs * 1e6 / numSamples,
+        compressedElapsedMs * 1e6 / numSamples, elapsedMs / compressedElapsedMs));
+    // Keep the sampling from being optimized away
+    if (checksum == M_INFINITY)
+        PrintLine("");
+}
@@ -172,6 +172,8 @@ ea::hash_set<aiAnimation*> allAnimations_;
 ea::vector<aiAnimation*> sceneAnimations_;
 
 float defaultTicksPerSecond_ = 4800.0f;
+bool compressAnimations_ = false;
+float compressedSampleRate_ = 0.0f;
 // For subset animation import usage
 float importStartTime_ = 0.0f;
 float importEndTime_ = 0.0f;
@@ -307,6 +309,8 @@ void Run(const ea::vector<ea::string>& arguments)
             "-split <start> <end> (animation model only)\n"
             "            Split animation, will only import from start frame to end frame\n"
             "-np         Do not suppress $fbx pivot nodes (FBX files only)\n"
+            "-ac <rate>  Compress animations, resampling keyframes at the given rate per second.\n"
+            "            Rate 0 keeps the average keyframe rate of each track\n"
         );
     }
 
@@ -457,6 +461,12 @@ void Run(const ea::vector<ea::string>& arguments)
                 checkUniqueModel_ = false;
             else if (argument == "bp")
                 moveToBindPose_ = true;
+            else if (argument == "ac" && !value.empty())
+            {
+                compressAnimations_ = true;
+                compressedSampleRate_ = ToFloat(value);
+                ++i;
+            }
             else if (argument == "split")
             {
                 ea::string value2 = i + 2 < arguments.size() ? arguments[i + 2] : EMPTY_STRING;
@@ -1493,6 +1503,8 @@ void BuildAndSaveAnimations(OutModel* model)
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
             ErrorExit("Could not open output file " + animOutName);
+        if (compressAnimations_)
+            outAnim->Compress(compressedSampleRate_);
         outAnim->Save(outFile);
     }
 }
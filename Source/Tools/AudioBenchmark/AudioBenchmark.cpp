@@ -0,0 +1,198 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Audio/Audio.h>
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Audio/SoundSource.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <SDL/SDL.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const int MIX_RATE = 44100;
+static const unsigned MIX_SAMPLES = 1024;
+#ifdef WIN32
+static const char* NULL_DEVICE = "NUL";
+#else
+static const char* NULL_DEVICE = "/dev/null";
+#endif
+
+/// Thread which mixes like the audio device thread, which is not managed by the work queue.
+class MixThread : public Thread
+{
+public:
+    /// Construct.
+    MixThread(Audio* audio, unsigned numIterations) :
+        audio_(audio),
+        numIterations_(numIterations)
+    {
+    }
+
+    /// Mix the requested number of times and measure the elapsed time.
+    void ThreadFunction() override
+    {
+        ea::vector<short> output(MIX_SAMPLES * 2);
+        // Hold the audio mutex so that the device callback does not mix concurrently
+        MutexLock lock(audio_->GetMutex());
+        audio_->Play();
+
+        // Warm up
+        for (unsigned i = 0; i < 10; ++i)
+            audio_->MixOutput(output.data(), MIX_SAMPLES);
+
+        HiresTimer timer;
+        for (unsigned i = 0; i < numIterations_; ++i)
+            audio_->MixOutput(output.data(), MIX_SAMPLES);
+        elapsedMs_ = (double)timer.GetUSec(false) / 1000.0;
+    }
+
+    /// Audio subsystem.
+    Audio* audio_;
+    /// Number of mixing calls.
+    unsigned numIterations_;
+    /// Elapsed time in milliseconds.
+    double elapsedMs_{};
+};
+
+int main(int argc, char** argv);
+void Run(const ea::vector<ea::string>& arguments);
+
+int main(int argc, char** argv)
+{
+    ea::vector<ea::string> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+/// Create a looped sine tone. Mixes mono and stereo, 8 and 16-bit sounds at rates that need resampling and rates that do not.
+SharedPtr<Sound> CreateTone(Context* context, unsigned index)
+{
+    const bool stereo = index % 3 == 2;
+    const bool sixteenBit = index % 5 != 4;
+    const unsigned frequency = index % 2 ? 22050 : MIX_RATE;
+    const unsigned numFrames = frequency / 2;
+    const unsigned numChannels = stereo ? 2 : 1;
+    const float pitch = 110.0f * (1.0f + (float)(index % 12) / 12.0f);
+
+    ea::vector<short> samples(numFrames * numChannels);
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        const float value = Sin(360.0f * pitch * (float)i / (float)frequency);
+        for (unsigned c = 0; c < numChannels; ++c)
+            samples[i * numChannels + c] = (short)(value * 8192.0f);
+    }
+
+    SharedPtr<Sound> sound(new Sound(context));
+    if (sixteenBit)
+        sound->SetData(samples.data(), samples.size() * sizeof(short));
+    else
+    {
+        ea::vector<signed char> bytes(samples.size());
+        for (unsigned i = 0; i < samples.size(); ++i)
+            bytes[i] = (signed char)(samples[i] >> 8);
+        sound->SetData(bytes.data(), bytes.size());
+    }
+    sound->SetFormat(frequency, sixteenBit, stereo);
+    sound->SetLooped(true);
+    return sound;
+}
+
+void Run(const ea::vector<ea::string>& arguments)
+{
+    if (arguments.size() < 1)
+    {
+        ErrorExit("Usage: AudioBenchmark <sources> [threads] [iterations]\n\n"
+            "Mixes the sound sources to a stereo interpolated 44.1 kHz buffer of 1024 samples and reports the mixing\n"
+            "throughput. Threads is the number of work queue threads, default 0. Uses the disk audio driver, so no\n"
+            "audio device is needed.");
+    }
+
+    const unsigned numSources = Max(ToUInt(arguments[0]), 1u);
+    const unsigned numThreads = arguments.size() > 1 ? ToUInt(arguments[1]) : 0;
+    const unsigned numIterations = arguments.size() > 2 ? Max(ToUInt(arguments[2]), 1u) : 1000;
+
+    // The disk driver runs without audio hardware. Discard its output
+    SDL_setenv("SDL_AUDIODRIVER", "disk", 1);
+    SDL_setenv("SDL_DISKAUDIOFILE", NULL_DEVICE, 1);
+
+    SharedPtr<Context> context(new Context());
+    // Time initializes the high-resolution timer
+    context->RegisterSubsystem(new Time(context));
+    context->RegisterSubsystem(new WorkQueue(context));
+    RegisterSceneLibrary(context);
+    context->RegisterSubsystem(new Audio(context));
+
+    auto* workQueue = context->GetSubsystem<WorkQueue>();
+    if (numThreads)
+        workQueue->CreateThreads(numThreads);
+
+    auto* audio = context->GetSubsystem<Audio>();
+    if (!audio->SetMode(100, MIX_RATE, true, true))
+        ErrorExit("Could not initialize audio output");
+    // Output silence from the device callback until the mixing thread starts, so that each run mixes the same data
+    audio->Stop();
+
+    SharedPtr<Scene> scene(new Scene(context));
+    ea::vector<SharedPtr<Sound> > sounds;
+    for (unsigned i = 0; i < numSources; ++i)
+    {
+        sounds.push_back(CreateTone(context, i));
+        auto* source = scene->CreateChild()->CreateComponent<SoundSource>();
+        source->SetPanning((float)(i % 7) / 3.0f - 1.0f);
+        source->Play(sounds.back(), sounds.back()->GetFrequency() * (1.0f + (float)(i % 4) * 0.1f), 0.5f);
+    }
+
+    // Keep the worker threads running, as they would be during a frame
+    workQueue->Resume();
+
+    MixThread thread(audio, numIterations);
+    thread.Run();
+    thread.Stop();
+
+    const double elapsedMs = thread.elapsedMs_;
+    const double mixedMs = (double)numIterations * MIX_SAMPLES * 1000.0 / MIX_RATE;
+    PrintLine(Format("Mixed {} sources with {} worker threads: {:.3f} ms per {} samples, {:.1f} sources per ms, {:.1f}x realtime",
+        numSources, numThreads, elapsedMs / numIterations, MIX_SAMPLES, numSources * numIterations / elapsedMs,
+        mixedMs / elapsedMs));
+}
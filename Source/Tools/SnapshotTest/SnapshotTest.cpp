@@ -0,0 +1,276 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Network/Snapshot.h>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Largest quantized position magnitude, as clamped by QuantizeTransform.
+static const int MAX_QUANTIZED_POSITION = 0x3fffffff;
+/// Largest replicated node ID.
+static const unsigned LAST_REPLICATED_ID = 0xffffff;
+
+/// Number of failed checks.
+static unsigned numFailures = 0;
+
+/// Report a failed check.
+static void Check(bool condition, const ea::string& description)
+{
+    if (!condition)
+    {
+        PrintLine("FAILED: " + description, true);
+        ++numFailures;
+    }
+}
+
+/// Return angle in degrees between two rotations, ignoring the sign and length of the quaternions. Calculated in double
+/// precision, as the float arc cosine near 1 is not accurate enough.
+static double GetAngleError(const Quaternion& lhs, const Quaternion& rhs)
+{
+    const double dot = (double)lhs.w_ * rhs.w_ + (double)lhs.x_ * rhs.x_ + (double)lhs.y_ * rhs.y_ + (double)lhs.z_ * rhs.z_;
+    const double lhsLength = sqrt((double)lhs.w_ * lhs.w_ + (double)lhs.x_ * lhs.x_ + (double)lhs.y_ * lhs.y_ + (double)lhs.z_ * lhs.z_);
+    const double rhsLength = sqrt((double)rhs.w_ * rhs.w_ + (double)rhs.x_ * rhs.x_ + (double)rhs.y_ * rhs.y_ + (double)rhs.z_ * rhs.z_);
+    return 2.0 * Acos(Min(Abs(dot) / (lhsLength * rhsLength), 1.0));
+}
+
+/// Return quantized transform with the given values.
+static QuantizedTransform MakeTransform(int x, int y, int z, unsigned short a, unsigned short b, unsigned short c, unsigned char largest)
+{
+    QuantizedTransform transform;
+    transform.position_[0] = x;
+    transform.position_[1] = y;
+    transform.position_[2] = z;
+    transform.rotation_[0] = a;
+    transform.rotation_[1] = b;
+    transform.rotation_[2] = c;
+    transform.rotationLargest_ = largest;
+    return transform;
+}
+
+/// Return snapshot entry.
+static SnapshotEntry MakeEntry(unsigned nodeID, const QuantizedTransform& transform, const QuantizedTransform* baseline = nullptr)
+{
+    SnapshotEntry entry;
+    entry.nodeID_ = nodeID;
+    entry.transform_ = transform;
+    entry.hasBaseline_ = baseline != nullptr;
+    if (baseline)
+        entry.baseline_ = *baseline;
+    return entry;
+}
+
+/// Write entries and read them back against the baseline. Return whether reading succeeded.
+static bool Roundtrip(const ea::vector<SnapshotEntry>& entries, const SnapshotState* baseline, unsigned rotationBits,
+    SnapshotState& state, unsigned truncate = 0)
+{
+    VectorBuffer buffer;
+    WriteSnapshotEntries(buffer, entries, rotationBits);
+    const unsigned size = buffer.GetSize() > truncate ? buffer.GetSize() - truncate : 0;
+    return ReadSnapshotEntries(buffer.GetData(), size, entries.size(), baseline, rotationBits, state);
+}
+
+/// Check positions at the precision and range boundaries.
+static void TestPositionQuantization()
+{
+    const float precision = DEFAULT_SNAPSHOT_POSITION_PRECISION;
+    const Vector3 positions[] = {
+        Vector3::ZERO,
+        Vector3(precision * 0.49f, -precision * 0.49f, precision * 0.51f),
+        Vector3(1000.0f, -1000.0f, 0.001f),
+        Vector3(MAX_QUANTIZED_POSITION * precision * 0.999f, -MAX_QUANTIZED_POSITION * precision * 0.999f, 0.0f),
+    };
+
+    for (const Vector3& position : positions)
+    {
+        const QuantizedTransform transform = QuantizeTransform(position, Quaternion::IDENTITY, precision, DEFAULT_SNAPSHOT_ROTATION_BITS);
+        const Vector3 result = DequantizePosition(transform, precision);
+        // Half a step per axis, plus the float rounding of large coordinates
+        const float tolerance = precision * 0.5f * Sqrt(3.0f) + position.Length() * 2.4e-7f;
+        Check((result - position).Length() <= tolerance, Format("position {} -> {}", position.ToString(), result.ToString()));
+    }
+
+    // Positions out of range are clamped, not wrapped around
+    const QuantizedTransform clamped = QuantizeTransform(Vector3(1e12f, -1e12f, 0.0f), Quaternion::IDENTITY, precision,
+        DEFAULT_SNAPSHOT_ROTATION_BITS);
+    Check(clamped.position_[0] == MAX_QUANTIZED_POSITION && clamped.position_[1] == -MAX_QUANTIZED_POSITION,
+        "out of range position is clamped");
+}
+
+/// Check rotations where each component is the largest, where two components tie, and with both quaternion signs, for every supported bit count.
+static void TestRotationQuantization()
+{
+    const float halfSqrt2 = 0.70710678f;
+    const Quaternion rotations[] = {
+        Quaternion::IDENTITY,
+        Quaternion(-1.0f, 0.0f, 0.0f, 0.0f),
+        Quaternion(0.0f, 1.0f, 0.0f, 0.0f),
+        Quaternion(0.0f, 0.0f, -1.0f, 0.0f),
+        Quaternion(0.0f, 0.0f, 0.0f, 1.0f),
+        Quaternion(halfSqrt2, halfSqrt2, 0.0f, 0.0f),
+        Quaternion(halfSqrt2, 0.0f, -halfSqrt2, 0.0f),
+        Quaternion(0.5f, 0.5f, 0.5f, 0.5f),
+        Quaternion(-0.5f, 0.5f, -0.5f, 0.5f),
+        Quaternion(37.0f, Vector3(1.0f, 2.0f, 3.0f).Normalized()),
+        Quaternion(179.9f, Vector3(-3.0f, 1.0f, 2.0f).Normalized()),
+    };
+
+    for (unsigned bits = MIN_SNAPSHOT_ROTATION_BITS; bits <= MAX_SNAPSHOT_ROTATION_BITS; ++bits)
+    {
+        // Each of the three stored components is off by at most half a step of the [-1/sqrt(2), 1/sqrt(2)] range,
+        // and the omitted component is reconstructed from them
+        const double step = 2.0 * halfSqrt2 / (double)((1u << bits) - 2);
+        const double tolerance = 2.0 * Asin(Min(Sqrt(3.0) * step, 1.0)) + 1e-3;
+
+        for (const Quaternion& rotation : rotations)
+        {
+            const QuantizedTransform transform = QuantizeTransform(Vector3::ZERO, rotation, DEFAULT_SNAPSHOT_POSITION_PRECISION, bits);
+            for (unsigned i = 0; i < 3; ++i)
+                Check(transform.rotation_[i] < (1u << bits), Format("rotation component fits {} bits", bits));
+
+            const Quaternion result = DequantizeRotation(transform, bits);
+            Check(Abs(result.LengthSquared() - 1.0f) < 1e-5f, Format("dequantized rotation is normalized at {} bits", bits));
+            const double error = GetAngleError(rotation, result);
+            Check(error <= tolerance, Format("rotation {} at {} bits: error {} > {} degrees", rotation.ToString(), bits, error, tolerance));
+        }
+    }
+}
+
+/// Check full and delta-encoded entries at the value boundaries.
+static void TestEntryRoundtrip()
+{
+    const int maxPos = MAX_QUANTIZED_POSITION;
+
+    for (unsigned bits = MIN_SNAPSHOT_ROTATION_BITS; bits <= MAX_SNAPSHOT_ROTATION_BITS; ++bits)
+    {
+        const auto maxRot = static_cast<unsigned short>((1u << bits) - 1);
+
+        // Full transforms, including the node ID delta to the largest replicated ID
+        const QuantizedTransform fullTransforms[] = {
+            MakeTransform(0, 0, 0, 0, 0, 0, 0),
+            MakeTransform(maxPos, -maxPos, 1, maxRot, 0, maxRot, 3),
+            MakeTransform(-maxPos, maxPos, -1, 0, maxRot, 1, 1),
+        };
+        ea::vector<SnapshotEntry> entries = {
+            MakeEntry(1, fullTransforms[0]),
+            MakeEntry(2, fullTransforms[1]),
+            MakeEntry(LAST_REPLICATED_ID, fullTransforms[2]),
+        };
+
+        SnapshotState state;
+        Check(Roundtrip(entries, nullptr, bits, state), Format("read full entries at {} bits", bits));
+        Check(state.size() == entries.size(), "full entry count");
+
+        // Components which are zero are reproduced exactly
+        Check(DequantizeRotation(QuantizeTransform(Vector3::ZERO, Quaternion::IDENTITY, 1.0f, bits), bits) == Quaternion::IDENTITY,
+            Format("identity rotation is exact at {} bits", bits));
+        for (unsigned i = 0; i < state.size() && i < entries.size(); ++i)
+        {
+            Check(state[i].first == entries[i].nodeID_, Format("full entry node ID {}", entries[i].nodeID_));
+            Check(state[i].second == entries[i].transform_, Format("full entry {} at {} bits", i, bits));
+        }
+
+        // Deltas spanning the whole position and rotation ranges, unchanged channels and a change of the largest component
+        const SnapshotState baseline = {
+            { 1, MakeTransform(-maxPos, maxPos, 0, 0, maxRot, 0, 0) },
+            { 5, MakeTransform(10, 20, 30, 1, 2, 3, 2) },
+            { 6, MakeTransform(7, 7, 7, 4, 5, 6, 1) },
+            { 9, MakeTransform(0, 0, 0, 0, 0, 0, 0) },
+            { LAST_REPLICATED_ID, MakeTransform(maxPos, maxPos, maxPos, maxRot, maxRot, maxRot, 3) },
+        };
+        const QuantizedTransform deltaTransforms[] = {
+            MakeTransform(maxPos, -maxPos, 0, maxRot, 0, maxRot, 0),
+            MakeTransform(10, 20, 30, 3, 2, 1, 2),
+            MakeTransform(8, 6, 7, 4, 5, 6, 1),
+            MakeTransform(-maxPos, -maxPos, -maxPos, 0, 0, 0, 3),
+        };
+        entries = {
+            MakeEntry(1, deltaTransforms[0], &baseline[0].second),
+            MakeEntry(5, deltaTransforms[1], &baseline[1].second),
+            MakeEntry(6, deltaTransforms[2], &baseline[2].second),
+            MakeEntry(LAST_REPLICATED_ID, deltaTransforms[3], &baseline[4].second),
+        };
+
+        Check(Roundtrip(entries, &baseline, bits, state), Format("read delta entries at {} bits", bits));
+        const SnapshotState expected = {
+            { 1, deltaTransforms[0] },
+            { 5, deltaTransforms[1] },
+            { 6, deltaTransforms[2] },
+            { 9, baseline[3].second },
+            { LAST_REPLICATED_ID, deltaTransforms[3] },
+        };
+        Check(state == expected, Format("delta entries merged into baseline at {} bits", bits));
+
+        // Only the changed transforms are reported
+        SnapshotState changes;
+        DiffSnapshotStates(baseline, state, changes);
+        Check(changes.size() == 4 && changes[0].first == 1 && changes[3].first == LAST_REPLICATED_ID, "changed transforms");
+    }
+
+    // An empty snapshot carries the whole baseline over
+    const SnapshotState baseline = { { 3, MakeTransform(1, 2, 3, 4, 5, 6, 0) } };
+    SnapshotState state;
+    Check(Roundtrip({}, &baseline, DEFAULT_SNAPSHOT_ROTATION_BITS, state) && state == baseline, "empty snapshot");
+}
+
+/// Check that malformed data is rejected.
+static void TestMalformed()
+{
+    const QuantizedTransform transform = MakeTransform(MAX_QUANTIZED_POSITION, 0, 0, 1, 2, 3, 0);
+    const QuantizedTransform baselineTransform = MakeTransform(0, 0, 0, 1, 2, 3, 0);
+    SnapshotState state;
+
+    // Truncated data
+    Check(!Roundtrip({ MakeEntry(1, transform) }, nullptr, DEFAULT_SNAPSHOT_ROTATION_BITS, state, 1), "truncated snapshot is rejected");
+
+    // Delta against a transform missing from the baseline
+    Check(!Roundtrip({ MakeEntry(1, transform, &baselineTransform) }, nullptr, DEFAULT_SNAPSHOT_ROTATION_BITS, state),
+        "delta without baseline is rejected");
+
+    // More entries than were written
+    VectorBuffer buffer;
+    WriteSnapshotEntries(buffer, { MakeEntry(1, transform) }, DEFAULT_SNAPSHOT_ROTATION_BITS);
+    Check(!ReadSnapshotEntries(buffer.GetData(), buffer.GetSize(), 2, nullptr, DEFAULT_SNAPSHOT_ROTATION_BITS, state),
+        "entry count past the data is rejected");
+}
+
+int main(int argc, char** argv)
+{
+    TestPositionQuantization();
+    TestRotationQuantization();
+    TestEntryRoundtrip();
+    TestMalformed();
+
+    if (numFailures)
+    {
+        PrintLine(Format("{} checks failed", numFailures), true);
+        return 1;
+    }
+
+    PrintLine("All snapshot codec checks passed");
+    return 0;
+}
@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/Variant.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Number of values in the source and destination arrays. Small enough to stay in the cache, so that the copies themselves are measured.
+static const unsigned NUM_VALUES = 1024;
+
+int main(int argc, char** argv);
+void Run(const ea::vector<ea::string>& arguments);
+
+int main(int argc, char** argv)
+{
+    ea::vector<ea::string> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+/// Copy-assign the source values over the destination values repeatedly. Return nanoseconds per copy.
+template <class T> double MeasureCopies(const ea::vector<T>& source, unsigned numCopies)
+{
+    ea::vector<T> dest(source.size());
+    const unsigned numRounds = Max(numCopies / (unsigned)source.size(), 1u);
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < numRounds; ++i)
+    {
+        // Rotate the source each round without a division per copy
+        unsigned k = i % source.size();
+        for (unsigned j = 0; j < source.size(); ++j)
+        {
+            dest[j] = source[k];
+            if (++k == source.size())
+                k = 0;
+        }
+    }
+    const long long elapsed = timer.GetUSec(false);
+
+    return (double)elapsed * 1000.0 / ((double)numRounds * source.size());
+}
+
+/// Move values back and forth between two arrays. Return nanoseconds per move.
+double MeasureMoves(const ea::vector<Variant>& source, unsigned numMoves)
+{
+    ea::vector<Variant> first = source;
+    ea::vector<Variant> second(source.size());
+    const unsigned numRounds = Max(numMoves / (2 * (unsigned)source.size()), 1u);
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < numRounds; ++i)
+    {
+        for (unsigned j = 0; j < source.size(); ++j)
+            second[j] = ea::move(first[j]);
+        for (unsigned j = 0; j < source.size(); ++j)
+            first[j] = ea::move(second[j]);
+    }
+    const long long elapsed = timer.GetUSec(false);
+
+    return (double)elapsed * 1000.0 / (2.0 * numRounds * source.size());
+}
+
+/// Append values to a VariantVector without reserving. Return nanoseconds per value.
+double MeasurePushBack(unsigned numValues)
+{
+    HiresTimer timer;
+    VariantVector vector;
+    for (unsigned i = 0; i < numValues; ++i)
+        vector.push_back(Vector3((float)i, 0.0f, 0.0f));
+    const long long elapsed = timer.GetUSec(false);
+
+    return (double)elapsed * 1000.0 / numValues;
+}
+
+/// Build a 16-key VariantMap as event data would be built and copy it. Return nanoseconds per map.
+double MeasureMaps(unsigned numMaps)
+{
+    ea::vector<StringHash> keys;
+    for (unsigned i = 0; i < 16; ++i)
+        keys.push_back(StringHash(Format("Key{}", i)));
+
+    unsigned checksum = 0;
+    HiresTimer timer;
+    for (unsigned i = 0; i < numMaps; ++i)
+    {
+        VariantMap map;
+        for (unsigned j = 0; j < keys.size(); ++j)
+        {
+            if (j % 2)
+                map[keys[j]] = (int)(i + j);
+            else
+                map[keys[j]] = Vector3((float)i, (float)j, 0.0f);
+        }
+        VariantMap copy = map;
+        checksum += copy.size();
+    }
+    const long long elapsed = timer.GetUSec(false);
+
+    return checksum ? (double)elapsed * 1000.0 / numMaps : 0.0;
+}
+
+void Run(const ea::vector<ea::string>& arguments)
+{
+    const unsigned numOperations = arguments.size() > 0 ? Max(ToUInt(arguments[0]), 1u) * 1000000 : 10000000;
+
+    SharedPtr<Context> context(new Context());
+    // Time initializes the high-resolution timer
+    context->RegisterSubsystem(new Time(context));
+
+    ea::vector<Variant> scalars(NUM_VALUES);
+    ea::vector<Variant> vectors(NUM_VALUES);
+    ea::vector<Variant> strings(NUM_VALUES);
+    ea::vector<Variant> resourceRefs(NUM_VALUES);
+    ea::vector<ResourceRef> plainResourceRefs(NUM_VALUES);
+    ea::vector<Variant> resourceNames(NUM_VALUES);
+    for (unsigned i = 0; i < NUM_VALUES; ++i)
+    {
+        // Names are short enough for the small string buffer, so only the ResourceRef box itself is allocated
+        const ea::string name = Format("Tex{}.png", i % 100);
+        scalars[i] = i % 2 ? Variant((int)i) : Variant((float)i);
+        vectors[i] = Vector3((float)i, 1.0f, 2.0f);
+        strings[i] = Format("Str{}", i);
+        plainResourceRefs[i] = ResourceRef(StringHash("Texture2D"), name);
+        resourceRefs[i] = plainResourceRefs[i];
+        resourceNames[i] = name;
+    }
+
+    PrintLine(Format("sizeof(Variant) = {} bytes", sizeof(Variant)));
+    PrintLine(Format("Scalar copy:                {:.2f} ns", MeasureCopies(scalars, numOperations)));
+    PrintLine(Format("Vector3 copy:               {:.2f} ns", MeasureCopies(vectors, numOperations)));
+    PrintLine(Format("Short string copy:          {:.2f} ns", MeasureCopies(strings, numOperations)));
+    PrintLine(Format("ResourceRef copy (boxed):   {:.2f} ns", MeasureCopies(resourceRefs, numOperations)));
+    PrintLine(Format("Same name as string:        {:.2f} ns", MeasureCopies(resourceNames, numOperations)));
+    PrintLine(Format("Plain ResourceRef copy:     {:.2f} ns", MeasureCopies(plainResourceRefs, numOperations)));
+    PrintLine(Format("ResourceRef move (boxed):   {:.2f} ns", MeasureMoves(resourceRefs, numOperations)));
+    PrintLine(Format("VariantVector push_back:    {:.2f} ns", MeasurePushBack(numOperations / 10)));
+    PrintLine(Format("16-key VariantMap build+copy: {:.0f} ns", MeasureMaps(numOperations / 100)));
+}
@@ -23,6 +23,7 @@
 #include "../Precompiled.h"
 
 #include "../Audio/Audio.h"
+#include "../Audio/DecodeAheadSoundStream.h"
 #include "../Audio/Sound.h"
 #include "../Audio/SoundListener.h"
 #include "../Audio/SoundSource3D.h"
@@ -30,10 +31,15 @@
 #include "../Core/CoreEvents.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 
 #include <SDL/SDL.h>
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 #ifdef _MSC_VER
@@ -49,6 +55,10 @@ static const int MIN_BUFFERLENGTH = 20;
 static const int MIN_MIXRATE = 11025;
 static const int MAX_MIXRATE = 48000;
 static const StringHash SOUND_MASTER_HASH("Master");
+/// Number of sound sources mixed by one parallel mixing task.
+static const unsigned MIX_TASK_SOURCES = 16;
+/// Work queue priority for decoding streams of audible sound sources. Inaudible ones use the lowest priority.
+static const unsigned DECODE_PRIORITY_AUDIBLE = 1;
 
 static void SDLAudioCallback(void* userdata, Uint8* stream, int len);
 
@@ -63,7 +73,7 @@ Audio::Audio(Context* context) :
     // Register Audio library object factories
     RegisterAudioLibrary(context_);
 
-    SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Audio, HandleRenderUpdate));
+    SubscribeToEvent(E_RENDERUPDATE, &Audio::HandleRenderUpdate);
 }
 
 Audio::~Audio()
@@ -118,7 +128,8 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpo
     fragmentSize_ = Min(NextPowerOfTwo((unsigned)mixRate >> 6u), (unsigned)obtained.samples);
     mixRate_ = obtained.freq;
     interpolation_ = interpolation;
-    clipBuffer_.reset(new int[stereo ? fragmentSize_ << 1u : fragmentSize_]);
+    clipBuffer_.reset(new float[stereo ? fragmentSize_ << 1u : fragmentSize_]);
+    workQueue_ = GetSubsystem<WorkQueue>();
 
     URHO3D_LOGINFO("Set audio mode " + ea::to_string(mixRate_) + " Hz " + (stereo_ ? "stereo" : "mono") + " " +
             (interpolation_ ? "interpolated" : ""));
@@ -254,6 +265,34 @@ float Audio::GetSoundSourceMasterGain(StringHash typeHash) const
     return masterIt->second.GetFloat() * typeIt->second.GetFloat();
 }
 
+void Audio::QueueStreamDecode(DecodeAheadSoundStream* stream, bool audible)
+{
+    if (!stream || !workQueue_ || stream->IsDecodeQueued() || !stream->NeedsDecode())
+        return;
+
+    stream->SetDecodeQueued(true);
+    SharedPtr<DecodeAheadSoundStream> streamPtr(stream);
+    workQueue_->AddWorkItem([streamPtr]() mutable
+    {
+        streamPtr->Decode();
+        streamPtr->SetDecodeQueued(false);
+        // Release the stream now rather than when the work item is destroyed on the main thread
+        streamPtr.Reset();
+    }, audible ? DECODE_PRIORITY_AUDIBLE : 0);
+}
+
+void Audio::AddStreamStatistics(unsigned starvations, unsigned underruns)
+{
+    numStreamStarvations_ += starvations;
+    numStreamUnderruns_ += underruns;
+}
+
+void Audio::ResetStreamStatistics()
+{
+    numStreamStarvations_ = 0;
+    numStreamUnderruns_ = 0;
+}
+
 void SDLAudioCallback(void* userdata, Uint8* stream, int len)
 {
     auto* audio = static_cast<Audio*>(userdata);
@@ -271,6 +310,27 @@ void Audio::MixOutput(void* dest, unsigned samples)
         return;
     }
 
+    // Collect the sound sources once, as they can not be added or removed while the audio mutex is held
+    mixSources_.clear();
+    for (auto i = soundSources_.begin(); i != soundSources_.end(); ++i)
+    {
+        SoundSource* source = *i;
+
+        // Check for pause if necessary
+        if (!pausedSoundTypes_.empty())
+        {
+            if (pausedSoundTypes_.contains(source->GetSoundType()))
+                continue;
+        }
+
+        mixSources_.push_back(source);
+    }
+
+    const unsigned numSources = mixSources_.size();
+    unsigned numTasks = (numSources + MIX_TASK_SOURCES - 1) / MIX_TASK_SOURCES;
+    if (!parallelMix_ || !workQueue_ || !workQueue_->GetNumThreads())
+        numTasks = 1;
+
     while (samples)
     {
         // If sample count exceeds the fragment (clip buffer) size, split the work
@@ -280,37 +340,67 @@ void Audio::MixOutput(void* dest, unsigned samples)
             clipSamples <<= 1;
 
         // Clear clip buffer
-        int* clipPtr = clipBuffer_.get();
-        memset(clipPtr, 0, clipSamples * sizeof(int));
+        float* clipPtr = clipBuffer_.get();
+        memset(clipPtr, 0, clipSamples * sizeof(float));
 
         // Mix samples to clip buffer
-        for (auto i = soundSources_.begin(); i != soundSources_.end(); ++i)
+        if (numTasks > 1)
         {
-            SoundSource* source = *i;
+            // Each task mixes its own group of sound sources to its own buffer, so no synchronization is needed
+            if (taskBuffers_.size() < (numTasks - 1) * clipSamples)
+                taskBuffers_.resize((numTasks - 1) * clipSamples);
 
-            // Check for pause if necessary
-            if (!pausedSoundTypes_.empty())
+            workQueue_->ParallelFor(0, numTasks, 1, [&](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+            {
+                for (unsigned task = begin; task < end; ++task)
+                {
+                    float* taskPtr = task ? &taskBuffers_[(task - 1) * clipSamples] : clipPtr;
+                    if (task)
+                        memset(taskPtr, 0, clipSamples * sizeof(float));
+
+                    const unsigned sourceEnd = Min((task + 1) * MIX_TASK_SOURCES, numSources);
+                    for (unsigned i = task * MIX_TASK_SOURCES; i < sourceEnd; ++i)
+                        mixSources_[i]->Mix(taskPtr, workSamples, mixRate_, stereo_, interpolation_);
+                }
+            });
+
+            // Sum in task order so that the output does not depend on scheduling
+            for (unsigned task = 1; task < numTasks; ++task)
             {
-                if (pausedSoundTypes_.contains(source->GetSoundType()))
-                    continue;
+                const float* taskPtr = &taskBuffers_[(task - 1) * clipSamples];
+                for (unsigned i = 0; i < clipSamples; ++i)
+                    clipPtr[i] += taskPtr[i];
             }
-
-            source->Mix(clipPtr, workSamples, mixRate_, stereo_, interpolation_);
         }
+        else
+        {
+            for (SoundSource* source : mixSources_)
+                source->Mix(clipPtr, workSamples, mixRate_, stereo_, interpolation_);
+        }
+
         // Copy output from clip buffer to destination
         auto* destPtr = (short*)dest;
-        while (clipSamples--)
-            *destPtr++ = (short)Clamp(*clipPtr++, -32768, 32767);
+        unsigned i = 0;
+#ifdef URHO3D_SSE
+        // Conversion rounds to nearest and packing saturates to the 16-bit range
+        for (; i + 8 <= clipSamples; i += 8)
+        {
+            const __m128i low = _mm_cvtps_epi32(_mm_loadu_ps(clipPtr + i));
+            const __m128i high = _mm_cvtps_epi32(_mm_loadu_ps(clipPtr + i + 4));
+            _mm_storeu_si128((__m128i*)(destPtr + i), _mm_packs_epi32(low, high));
+        }
+#endif
+        for (; i < clipSamples; ++i)
+            destPtr[i] = (short)RoundToInt(Clamp(clipPtr[i], -32768.0f, 32767.0f));
+
         samples -= workSamples;
         ((unsigned char*&)dest) += sampleSize_ * workSamples;
     }
 }
 
-void Audio::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Audio::HandleRenderUpdate(const Update::Data& eventData)
 {
-    using namespace RenderUpdate;
-
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 void Audio::Release()
@@ -341,6 +431,13 @@ void Audio::UpdateInternal(float timeStep)
                 continue;
         }
 
+        // Keep decoding ahead of playback. Check before the update, as the sound source may remove itself
+        if (auto* stream = dynamic_cast<DecodeAheadSoundStream*>(source->GetSoundStream()))
+        {
+            const float gain = source->GetGain() * source->GetAttenuation() * GetSoundSourceMasterGain(source->GetSoundType());
+            QueueStreamDecode(stream, gain > 0.0f);
+        }
+
         source->Update(timeStep);
     }
 }
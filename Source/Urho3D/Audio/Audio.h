@@ -24,6 +24,7 @@
 
 #include <EASTL/unique_ptr.h>
 #include <EASTL/hash_set.h>
+#include <atomic>
 
 #include "../Audio/AudioDefs.h"
 #include "../Core/Mutex.h"
@@ -32,10 +33,13 @@
 namespace Urho3D
 {
 
+namespace Update { struct Data; }
 class AudioImpl;
+class DecodeAheadSoundStream;
 class Sound;
 class SoundListener;
 class SoundSource;
+class WorkQueue;
 
 /// %Audio subsystem.
 class URHO3D_API Audio : public Object
@@ -68,6 +72,14 @@ public:
     void SetListener(SoundListener* listener);
     /// Stop any sound source playing a certain sound clip.
     void StopSound(Sound* sound);
+    /// Set whether to mix groups of sound sources in parallel on the work queue threads. Default true.
+    void SetParallelMix(bool enable) { parallelMix_ = enable; }
+    /// Set whether compressed sounds are decoded ahead of playback on the work queue threads. Default true. Affects sounds started afterward.
+    void SetStreamDecodeAhead(bool enable) { streamDecodeAhead_ = enable; }
+    /// Set how many seconds of compressed sounds to decode ahead of playback. Default 0.5. Affects sounds started afterward.
+    void SetStreamLookahead(float seconds) { streamLookahead_ = Max(seconds, 0.0f); }
+    /// Reset the stream starvation and underrun counts.
+    void ResetStreamStatistics();
 
     /// Return byte size of one sample.
     unsigned GetSampleSize() const { return sampleSize_; }
@@ -87,6 +99,21 @@ public:
     /// Return whether an audio stream has been reserved.
     bool IsInitialized() const { return deviceID_ != 0; }
 
+    /// Return whether groups of sound sources are mixed in parallel.
+    bool GetParallelMix() const { return parallelMix_; }
+
+    /// Return whether compressed sounds are decoded ahead of playback.
+    bool GetStreamDecodeAhead() const { return streamDecodeAhead_; }
+
+    /// Return how many seconds of compressed sounds to decode ahead of playback.
+    float GetStreamLookahead() const { return streamLookahead_; }
+
+    /// Return how many times the mixer ran out of data decoded ahead and had to decode on the audio thread.
+    unsigned GetNumStreamStarvations() const { return numStreamStarvations_; }
+
+    /// Return how many times the mixer had to output silence because a stream decoded ahead produced no data.
+    unsigned GetNumStreamUnderruns() const { return numStreamUnderruns_; }
+
     /// Return master gain for a specific sound source type. Unknown sound types will return full gain (1).
     float GetMasterGain(const ea::string& type) const;
 
@@ -113,19 +140,30 @@ public:
     /// Return sound type specific gain multiplied by master gain.
     float GetSoundSourceMasterGain(StringHash typeHash) const;
 
+    /// Queue decoding a stream ahead of playback on the work queue if it needs more data. Audible streams are decoded first. Called by SoundSource and internally.
+    void QueueStreamDecode(DecodeAheadSoundStream* stream, bool audible);
+    /// Add to the stream starvation and underrun counts. Called by DecodeAheadSoundStream from the mixing thread.
+    void AddStreamStatistics(unsigned starvations, unsigned underruns);
+
     /// Mix sound sources into the buffer.
     void MixOutput(void* dest, unsigned samples);
 
 private:
     /// Handle render update event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const Update::Data& eventData);
     /// Stop sound output and release the sound buffer.
     void Release();
     /// Actually update sound sources with the specific timestep. Called internally.
     void UpdateInternal(float timeStep);
 
-    /// Clipping buffer for mixing.
-    ea::unique_ptr<int[]> clipBuffer_;
+    /// Floating point clipping buffer for mixing.
+    ea::unique_ptr<float[]> clipBuffer_;
+    /// Accumulation buffers of the parallel mixing tasks except the first, which mixes to the clipping buffer.
+    ea::vector<float> taskBuffers_;
+    /// Sound sources to mix in the current fragment.
+    ea::vector<SoundSource*> mixSources_;
+    /// Work queue for parallel mixing.
+    WeakPtr<WorkQueue> workQueue_;
     /// Audio thread mutex.
     Mutex audioMutex_;
     /// SDL audio device ID.
@@ -142,6 +180,16 @@ private:
     bool stereo_{};
     /// Playing flag.
     bool playing_{};
+    /// Parallel mixing flag.
+    bool parallelMix_{true};
+    /// Decode-ahead flag for compressed sounds.
+    bool streamDecodeAhead_{true};
+    /// Seconds to decode compressed sounds ahead of playback.
+    float streamLookahead_{0.5f};
+    /// Stream starvation count.
+    std::atomic<unsigned> numStreamStarvations_{};
+    /// Stream underrun count.
+    std::atomic<unsigned> numStreamUnderruns_{};
     /// Master gain by sound source type.
     ea::unordered_map<StringHash, Variant> masterGain_;
     /// Paused sound types.
@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Audio/Audio.h"
+#include "../Audio/DecodeAheadSoundStream.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Maximum bytes to decode at a time. When the mixer runs out of data, it waits for at most one chunk being decoded.
+static const unsigned DECODE_CHUNK_SIZE = 4096;
+
+DecodeAheadSoundStream::DecodeAheadSoundStream(SoundStream* source, float lookahead, Audio* audio) :
+    source_(source),
+    audio_(audio)
+{
+    assert(source);
+
+    SetFormat(source->GetIntFrequency(), source->IsSixteenBit(), source->IsStereo());
+    SetStopAtEnd(source->GetStopAtEnd());
+
+    // Lookahead is whole samples and at least one chunk. Chunks and the power of two buffer size are multiples of the sample size
+    const unsigned sampleSize = GetSampleSize();
+    lookaheadSize_ = Max((unsigned)(Max(lookahead, 0.0f) * GetFrequency()) * sampleSize, DECODE_CHUNK_SIZE);
+    const unsigned bufferSize = NextPowerOfTwo(lookaheadSize_);
+    buffer_.reset(new signed char[bufferSize]);
+    bufferMask_ = bufferSize - 1;
+}
+
+DecodeAheadSoundStream::~DecodeAheadSoundStream() = default;
+
+bool DecodeAheadSoundStream::Seek(unsigned sample_number)
+{
+    MutexLock lock(decodeMutex_);
+
+    if (!source_->Seek(sample_number))
+        return false;
+
+    // Discard the data decoded from the previous position
+    readPosition_.store(writePosition_.load(std::memory_order_relaxed), std::memory_order_release);
+    endReached_ = false;
+    return true;
+}
+
+unsigned DecodeAheadSoundStream::GetData(signed char* dest, unsigned numBytes)
+{
+    unsigned outBytes = 0;
+    bool starved = false;
+
+    while (outBytes < numBytes)
+    {
+        const unsigned readPosition = readPosition_.load(std::memory_order_relaxed);
+        const unsigned numBuffered = writePosition_.load(std::memory_order_acquire) - readPosition;
+        if (!numBuffered)
+        {
+            if (endReached_)
+                break;
+
+            // Out of decoded data. Wait for the chunk being decoded if any, then decode the rest on this thread
+            starved = true;
+            MutexLock lock(decodeMutex_);
+            bool moreData;
+            DecodeChunk(numBytes - outBytes, moreData);
+            if (writePosition_.load(std::memory_order_acquire) == readPosition)
+                break;
+            continue;
+        }
+
+        // Copy in at most two parts, as the data may wrap around the end of the ring buffer
+        const unsigned copySize = Min(numBuffered, numBytes - outBytes);
+        const unsigned offset = readPosition & bufferMask_;
+        const unsigned firstSize = Min(copySize, bufferMask_ + 1 - offset);
+        memcpy(dest + outBytes, buffer_.get() + offset, firstSize);
+        if (firstSize < copySize)
+            memcpy(dest + outBytes + firstSize, buffer_.get(), copySize - firstSize);
+
+        readPosition_.store(readPosition + copySize, std::memory_order_release);
+        outBytes += copySize;
+    }
+
+    unsigned starvations = 0;
+    unsigned underruns = 0;
+    // Nothing has been decoded ahead of the first read, unless the decoder was quicker
+    if (starved && started_)
+        starvations = 1;
+    started_ = true;
+
+    // Output silence if the stream could not produce data but has not ended, so that playback does not stop
+    if (outBytes < numBytes && !endReached_)
+    {
+        memset(dest + outBytes, 0, numBytes - outBytes);
+        outBytes = numBytes;
+        underruns = 1;
+    }
+
+    if (starvations || underruns)
+    {
+        numStarvations_ += starvations;
+        numUnderruns_ += underruns;
+        if (Audio* audio = audio_.Get())
+            audio->AddStreamStatistics(starvations, underruns);
+    }
+
+    return outBytes;
+}
+
+unsigned DecodeAheadSoundStream::Decode()
+{
+    unsigned decodedBytes = 0;
+    bool moreData = true;
+
+    // Lock per chunk, so that a starving mixer waits for at most one chunk instead of the whole lookahead
+    while (moreData && decodedBytes < lookaheadSize_)
+    {
+        MutexLock lock(decodeMutex_);
+        decodedBytes += DecodeChunk(lookaheadSize_ - decodedBytes, moreData);
+    }
+
+    return decodedBytes;
+}
+
+unsigned DecodeAheadSoundStream::DecodeChunk(unsigned maxBytes, bool& moreData)
+{
+    moreData = false;
+    if (endReached_)
+        return 0;
+
+    const unsigned writePosition = writePosition_.load(std::memory_order_relaxed);
+    const unsigned numBuffered = writePosition - readPosition_.load(std::memory_order_acquire);
+    if (numBuffered >= lookaheadSize_)
+        return 0;
+
+    // Decode whole samples to a contiguous part of the ring buffer
+    const unsigned offset = writePosition & bufferMask_;
+    unsigned numBytes = Min(Min(maxBytes, lookaheadSize_ - numBuffered), Min(bufferMask_ + 1 - offset, DECODE_CHUNK_SIZE));
+    numBytes -= numBytes % GetSampleSize();
+    if (!numBytes)
+        return 0;
+
+    const unsigned outBytes = source_->GetData(buffer_.get() + offset, numBytes);
+    // Publish the decoded data to the mixing thread
+    writePosition_.store(writePosition + outBytes, std::memory_order_release);
+
+    if (outBytes < numBytes)
+    {
+        // A stream which does not stop at end may produce more data later
+        if (source_->GetStopAtEnd())
+            endReached_ = true;
+    }
+    else
+        moreData = true;
+
+    return outBytes;
+}
+
+}
@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <EASTL/unique_ptr.h>
+#include <atomic>
+
+#include "../Audio/SoundStream.h"
+#include "../Container/Ptr.h"
+#include "../Core/Mutex.h"
+
+namespace Urho3D
+{
+
+class Audio;
+
+/// %Sound stream that decodes another stream ahead of playback into a ring buffer. The decoding is normally done on the work queue threads, as scheduled by Audio, so that a slow decoder does not delay mixing.
+class URHO3D_API DecodeAheadSoundStream : public SoundStream
+{
+public:
+    /// Construct from the stream to decode and the number of seconds to decode ahead. Starvation and underrun counts are also reported to the audio subsystem if specified.
+    DecodeAheadSoundStream(SoundStream* source, float lookahead, Audio* audio = nullptr);
+    /// Destruct.
+    ~DecodeAheadSoundStream() override;
+
+    /// Seek to sample number. Return true on success. Discards the decoded data. Must not be called while the stream is being mixed.
+    bool Seek(unsigned sample_number) override;
+
+    /// Produce sound data into destination. Return number of bytes produced. Called by SoundSource from the mixing thread.
+    unsigned GetData(signed char* dest, unsigned numBytes) override;
+
+    /// Decode until the lookahead is filled or the decoded stream ends. Return number of bytes decoded. May be called from any thread.
+    unsigned Decode();
+    /// Set whether decoding has been queued on the work queue. Called by Audio.
+    void SetDecodeQueued(bool queued) { decodeQueued_ = queued; }
+
+    /// Return the stream being decoded.
+    SoundStream* GetSource() const { return source_; }
+
+    /// Return number of seconds to decode ahead.
+    float GetLookahead() const { return (float)lookaheadSize_ / (GetFrequency() * (float)GetSampleSize()); }
+
+    /// Return amount of decoded (unplayed) sound data in bytes.
+    unsigned GetBufferNumBytes() const { return writePosition_.load(std::memory_order_acquire) - readPosition_.load(std::memory_order_acquire); }
+
+    /// Return length of decoded (unplayed) sound data in seconds.
+    float GetBufferLength() const { return (float)GetBufferNumBytes() / (GetFrequency() * (float)GetSampleSize()); }
+
+    /// Return whether more data should be decoded. True when at least half of the lookahead has been played.
+    bool NeedsDecode() const { return !endReached_ && GetBufferNumBytes() <= lookaheadSize_ / 2; }
+
+    /// Return whether decoding has been queued on the work queue.
+    bool IsDecodeQueued() const { return decodeQueued_; }
+
+    /// Return whether the decoded stream has ended.
+    bool IsEndReached() const { return endReached_; }
+
+    /// Return number of times the mixer ran out of decoded data and had to decode on its own thread.
+    unsigned GetNumStarvations() const { return numStarvations_; }
+
+    /// Return number of times the mixer had to output silence because the decoded stream produced no data.
+    unsigned GetNumUnderruns() const { return numUnderruns_; }
+
+private:
+    /// Decode at most one chunk, limited to the specified amount of bytes. The decode mutex must be held. Return number of bytes decoded, and whether decoding can continue.
+    unsigned DecodeChunk(unsigned maxBytes, bool& moreData);
+
+    /// Stream being decoded.
+    SharedPtr<SoundStream> source_;
+    /// Audio subsystem for statistics.
+    WeakPtr<Audio> audio_;
+    /// Ring buffer. Size is a power of two.
+    ea::unique_ptr<signed char[]> buffer_;
+    /// Ring buffer size minus one.
+    unsigned bufferMask_{};
+    /// Number of bytes to decode ahead.
+    unsigned lookaheadSize_{};
+    /// Total bytes written to the ring buffer. Modified only with the decode mutex held.
+    std::atomic<unsigned> writePosition_{};
+    /// Total bytes read from the ring buffer. Modified by the mixing thread, and when seeking.
+    std::atomic<unsigned> readPosition_{};
+    /// Mutex held while decoding, as the decoded stream is not thread-safe.
+    Mutex decodeMutex_;
+    /// Decoded stream end flag.
+    std::atomic<bool> endReached_{};
+    /// Decoding queued flag.
+    std::atomic<bool> decodeQueued_{};
+    /// Whether the mixer has read any data yet. The first read is not counted as starvation.
+    bool started_{};
+    /// Starvation count.
+    std::atomic<unsigned> numStarvations_{};
+    /// Underrun count.
+    std::atomic<unsigned> numUnderruns_{};
+};
+
+}
@@ -24,78 +24,289 @@
 
 #include "../Audio/Audio.h"
 #include "../Audio/AudioEvents.h"
+#include "../Audio/DecodeAheadSoundStream.h"
 #include "../Audio/Sound.h"
 #include "../Audio/SoundSource.h"
 #include "../Audio/SoundStream.h"
 #include "../Core/Context.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Node.h"
 #include "../Scene/ReplicationState.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
-#define INC_POS_LOOPED() \
-    pos += intAdd; \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        ++pos; \
-    } \
-    while (pos >= end) \
-        pos -= (end - repeat); \
-
-#define INC_POS_ONESHOT() \
-    pos += intAdd; \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        ++pos; \
-    } \
-    if (pos >= end) \
-    { \
-        pos = 0; \
-        break; \
-    } \
-
-#define INC_POS_STEREO_LOOPED() \
-    pos += ((unsigned)intAdd << 1u); \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        pos += 2; \
-    } \
-    while (pos >= end) \
-        pos -= (end - repeat); \
-
-#define INC_POS_STEREO_ONESHOT() \
-    pos += ((unsigned)intAdd << 1u); \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        pos += 2; \
-    } \
-    if (pos >= end) \
-    { \
-        pos = 0; \
-        break; \
-    } \
-
-#define GET_IP_SAMPLE() (((((int)pos[1] - (int)pos[0]) * fractPos) / 65536) + (int)pos[0])
-
-#define GET_IP_SAMPLE_LEFT() (((((int)pos[2] - (int)pos[0]) * fractPos) / 65536) + (int)pos[0])
-
-#define GET_IP_SAMPLE_RIGHT() (((((int)pos[3] - (int)pos[1]) * fractPos) / 65536) + (int)pos[1])
-
 static const int STREAM_SAFETY_SAMPLES = 4;
 
+/// Number of sample frames resampled at a time into a stack buffer before gain and panning are applied.
+static const unsigned MIX_BLOCK_FRAMES = 256;
+
+/// Convert signed 16-bit samples to float.
+static void ConvertSamples(const short* src, float* dest, unsigned count)
+{
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        // Sign-extend by unpacking into the high halves and shifting back
+        _mm_storeu_ps(dest + i, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)));
+        _mm_storeu_ps(dest + i + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)));
+    }
+#endif
+    for (; i < count; ++i)
+        dest[i] = (float)src[i];
+}
+
+/// Convert signed 8-bit samples to float in 16-bit range.
+static void ConvertSamples(const signed char* src, float* dest, unsigned count)
+{
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        // Placing the bytes in the high halves of 16-bit values multiplies them by 256
+        const __m128i low = _mm_unpacklo_epi8(zero, s);
+        const __m128i high = _mm_unpackhi_epi8(zero, s);
+        _mm_storeu_ps(dest + i, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(low, low), 16)));
+        _mm_storeu_ps(dest + i + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(low, low), 16)));
+        _mm_storeu_ps(dest + i + 8, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(high, high), 16)));
+        _mm_storeu_ps(dest + i + 12, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(high, high), 16)));
+    }
+#endif
+    for (; i < count; ++i)
+        dest[i] = (float)src[i] * 256.0f;
+}
+
+/// Resample a run of frames which does not reach the end of the sound data. Offsets are in 16.16 fixed point frames from the run start.
+template <class T, unsigned Channels, bool Interpolate> void ResampleRun(const T* pos, unsigned offset, unsigned step, float* dest,
+    unsigned frames)
+{
+    const float scale = sizeof(T) == 1 ? 256.0f : 1.0f;
+    const float fractScale = 1.0f / 65536.0f;
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    // Gather the samples of four output frames per channel and interpolate them together
+    const __m128 scaleVec = _mm_set1_ps(scale);
+    for (; i + 4 <= frames; i += 4)
+    {
+        const unsigned o0 = offset;
+        const unsigned o1 = o0 + step;
+        const unsigned o2 = o1 + step;
+        const unsigned o3 = o2 + step;
+        offset = o3 + step;
+
+        const T* p0 = pos + (o0 >> 16u) * Channels;
+        const T* p1 = pos + (o1 >> 16u) * Channels;
+        const T* p2 = pos + (o2 >> 16u) * Channels;
+        const T* p3 = pos + (o3 >> 16u) * Channels;
+        const __m128 fract = _mm_mul_ps(_mm_setr_ps((float)(o0 & 0xffffu), (float)(o1 & 0xffffu), (float)(o2 & 0xffffu),
+            (float)(o3 & 0xffffu)), _mm_set1_ps(fractScale));
+
+        __m128 channel[Channels];
+        for (unsigned c = 0; c < Channels; ++c)
+        {
+            __m128 s = _mm_setr_ps((float)p0[c], (float)p1[c], (float)p2[c], (float)p3[c]);
+            if (Interpolate)
+            {
+                const __m128 next = _mm_setr_ps((float)p0[c + Channels], (float)p1[c + Channels], (float)p2[c + Channels],
+                    (float)p3[c + Channels]);
+                s = _mm_add_ps(s, _mm_mul_ps(_mm_sub_ps(next, s), fract));
+            }
+            channel[c] = _mm_mul_ps(s, scaleVec);
+        }
+
+        if (Channels == 1)
+            _mm_storeu_ps(dest + i, channel[0]);
+        else
+        {
+            _mm_storeu_ps(dest + i * 2, _mm_unpacklo_ps(channel[0], channel[Channels - 1]));
+            _mm_storeu_ps(dest + i * 2 + 4, _mm_unpackhi_ps(channel[0], channel[Channels - 1]));
+        }
+    }
+#endif
+
+    for (; i < frames; ++i)
+    {
+        const T* sample = pos + (offset >> 16u) * Channels;
+        const float fract = (float)(offset & 0xffffu) * fractScale;
+        for (unsigned c = 0; c < Channels; ++c)
+        {
+            float s = (float)sample[c];
+            if (Interpolate)
+                s += ((float)sample[c + Channels] - s) * fract;
+            dest[i * Channels + c] = s * scale;
+        }
+        offset += step;
+    }
+}
+
+/// Resample sound data to float frames with the channel count of the sound, in 16-bit range. Advance the play position. Return the number of frames written, which is less than requested if a one-shot sound ended, in which case the position is set to null.
+template <class T, unsigned Channels, bool Interpolate> unsigned ResampleBlock(T*& pos, int& fractPos, T* end, T* repeat,
+    bool looped, int intAdd, int fractAdd, float* dest, unsigned frames)
+{
+    const unsigned step = ((unsigned)intAdd << 16u) + (unsigned)fractAdd;
+    // Keep the fixed point offsets of a run within 32 bits
+    const unsigned maxRunFrames = step ? Max(0x7fff0000u / step, 1u) : frames;
+    unsigned written = 0;
+
+    while (written < frames)
+    {
+        // Find how many frames can be produced before the position reaches the end of the data. The frame after the
+        // last may be read for interpolation, which Sound::FixInterpolation() has made valid
+        const auto available = (unsigned)((end - pos) / Channels);
+        unsigned run = frames - written;
+        if (step)
+        {
+            const unsigned long long lastOffset = ((unsigned long long)available << 16u) - 1 - (unsigned)fractPos;
+            run = Min(run, (unsigned)Min(lastOffset / step + 1, (unsigned long long)maxRunFrames));
+        }
+
+        // Playing at the mixing rate without fractional position is a straight conversion
+        if (step == 0x10000u && fractPos == 0)
+            ConvertSamples(pos, dest + written * Channels, run * Channels);
+        else
+            ResampleRun<T, Channels, Interpolate>(pos, (unsigned)fractPos, step, dest + written * Channels, run);
+
+        const unsigned long long total = (unsigned long long)fractPos + (unsigned long long)run * step;
+        pos += (size_t)(total >> 16u) * Channels;
+        fractPos = (int)(total & 0xffffu);
+        written += run;
+
+        if (pos >= end)
+        {
+            if (!looped)
+            {
+                pos = nullptr;
+                break;
+            }
+            while (pos >= end)
+                pos -= (end - repeat);
+        }
+    }
+
+    return written;
+}
+
+/// Accumulate samples with gain. Used for mono to mono and stereo to stereo mixing.
+static void AccumulateSamples(float* dest, const float* src, unsigned count, float gain)
+{
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+#endif
+    for (; i < count; ++i)
+        dest[i] += src[i] * gain;
+}
+
+/// Accumulate mono frames to stereo frames with left and right gain.
+static void AccumulateMonoToStereo(float* dest, const float* src, unsigned frames, float leftGain, float rightGain)
+{
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    const __m128 g = _mm_setr_ps(leftGain, rightGain, leftGain, rightGain);
+    for (; i + 4 <= frames; i += 4)
+    {
+        const __m128 s = _mm_loadu_ps(src + i);
+        float* out = dest + i * 2;
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(_mm_unpacklo_ps(s, s), g)));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(_mm_unpackhi_ps(s, s), g)));
+    }
+#endif
+    for (; i < frames; ++i)
+    {
+        dest[i * 2] += src[i] * leftGain;
+        dest[i * 2 + 1] += src[i] * rightGain;
+    }
+}
+
+/// Accumulate stereo frames to mono frames with gain, averaging the channels.
+static void AccumulateStereoToMono(float* dest, const float* src, unsigned frames, float gain)
+{
+    const float halfGain = 0.5f * gain;
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    const __m128 g = _mm_set1_ps(halfGain);
+    for (; i + 4 <= frames; i += 4)
+    {
+        const __m128 a = _mm_loadu_ps(src + i * 2);
+        const __m128 b = _mm_loadu_ps(src + i * 2 + 4);
+        const __m128 sum = _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(sum, g)));
+    }
+#endif
+    for (; i < frames; ++i)
+        dest[i] += (src[i * 2] + src[i * 2 + 1]) * halfGain;
+}
+
+/// Resample and accumulate a sound in blocks. Return the new play position, null if a one-shot sound ended.
+template <class T, unsigned Channels, bool Interpolate> T* MixBlocks(T* pos, int& fractPos, const Sound* sound, float* dest,
+    unsigned samples, bool stereo, int intAdd, int fractAdd, float leftGain, float rightGain)
+{
+    auto* end = (T*)sound->GetEnd();
+    auto* repeat = (T*)sound->GetRepeat();
+    const bool looped = sound->IsLooped();
+    const unsigned outChannels = stereo ? 2 : 1;
+    float block[MIX_BLOCK_FRAMES * Channels];
+
+    while (samples && pos)
+    {
+        const unsigned frames = ResampleBlock<T, Channels, Interpolate>(pos, fractPos, end, repeat, looped, intAdd, fractAdd,
+            block, Min(samples, MIX_BLOCK_FRAMES));
+
+        if (Channels == 1)
+        {
+            if (stereo)
+                AccumulateMonoToStereo(dest, block, frames, leftGain, rightGain);
+            else
+                AccumulateSamples(dest, block, frames, leftGain);
+        }
+        else
+        {
+            if (stereo)
+                AccumulateSamples(dest, block, frames * 2, leftGain);
+            else
+                AccumulateStereoToMono(dest, block, frames, leftGain);
+        }
+
+        dest += frames * outChannels;
+        samples -= frames;
+    }
+
+    return pos;
+}
+
+/// Select the mixing routine for the sample format.
+template <class T> T* MixSamples(T* pos, int& fractPos, const Sound* sound, float* dest, unsigned samples, bool stereo,
+    bool interpolation, int intAdd, int fractAdd, float leftGain, float rightGain)
+{
+    if (sound->IsStereo())
+    {
+        return interpolation ?
+            MixBlocks<T, 2, true>(pos, fractPos, sound, dest, samples, stereo, intAdd, fractAdd, leftGain, rightGain) :
+            MixBlocks<T, 2, false>(pos, fractPos, sound, dest, samples, stereo, intAdd, fractAdd, leftGain, rightGain);
+    }
+    else
+    {
+        return interpolation ?
+            MixBlocks<T, 1, true>(pos, fractPos, sound, dest, samples, stereo, intAdd, fractAdd, leftGain, rightGain) :
+            MixBlocks<T, 1, false>(pos, fractPos, sound, dest, samples, stereo, intAdd, fractAdd, leftGain, rightGain);
+    }
+}
+
 extern const char* AUDIO_CATEGORY;
 
 extern const char* autoRemoveModeNames[];
@@ -160,10 +371,14 @@ void SoundSource::Seek(float seekTime)
     }
     else
     {
-        // Ogg format
+        // Ogg format. Lock the audio mutex so that the stream is not being mixed while seeking
+        MutexLock lock(audio_->GetMutex());
         if (soundStream_->Seek((unsigned)(seekTime * soundStream_->GetFrequency())))
         {
             timePosition_ = seekTime;
+            // Refill the decoded data discarded by the seek
+            if (auto* decodeAheadStream = dynamic_cast<DecodeAheadSoundStream*>(soundStream_.Get()))
+                audio_->QueueStreamDecode(decodeAheadStream, true);
         }
     }
 }
@@ -363,7 +578,7 @@ void SoundSource::Update(float timeStep)
     }
 }
 
-void SoundSource::Mix(int* dest, unsigned samples, int mixRate, bool stereo, bool interpolation)
+void SoundSource::Mix(float* dest, unsigned samples, int mixRate, bool stereo, bool interpolation)
 {
     if (!position_ || (!sound_ && !soundStream_) || !IsEnabledEffective())
         return;
@@ -401,41 +616,7 @@ void SoundSource::Mix(int* dest, unsigned samples, int mixRate, bool stereo, boo
     if (!sound)
         return;
 
-    // Choose the correct mixing routine
-    if (!sound->IsStereo())
-    {
-        if (interpolation)
-        {
-            if (stereo)
-                MixMonoToStereoIP(sound, dest, samples, mixRate);
-            else
-                MixMonoToMonoIP(sound, dest, samples, mixRate);
-        }
-        else
-        {
-            if (stereo)
-                MixMonoToStereo(sound, dest, samples, mixRate);
-            else
-                MixMonoToMono(sound, dest, samples, mixRate);
-        }
-    }
-    else
-    {
-        if (interpolation)
-        {
-            if (stereo)
-                MixStereoToStereoIP(sound, dest, samples, mixRate);
-            else
-                MixStereoToMonoIP(sound, dest, samples, mixRate);
-        }
-        else
-        {
-            if (stereo)
-                MixStereoToStereo(sound, dest, samples, mixRate);
-            else
-                MixStereoToMono(sound, dest, samples, mixRate);
-        }
-    }
+    MixSound(sound, dest, samples, mixRate, stereo, interpolation);
 
     // Update the time position. In stream mode, copy unused data back to the beginning of the stream buffer
     if (soundStream_)
@@ -533,8 +714,17 @@ void SoundSource::PlayLockless(Sound* sound)
         }
         else
         {
-            // Compressed sound start
-            PlayLockless(sound->GetDecoderStream());
+            // Compressed sound start. Decode ahead on the work queue threads if possible, so that the mixer
+            // does not need to wait for the decoder
+            SharedPtr<SoundStream> stream = sound->GetDecoderStream();
+            if (stream && audio_->GetStreamDecodeAhead() && GetSubsystem<WorkQueue>())
+            {
+                SharedPtr<DecodeAheadSoundStream> decodeAheadStream(
+                    new DecodeAheadSoundStream(stream, audio_->GetStreamLookahead(), audio_));
+                audio_->QueueStreamDecode(decodeAheadStream, true);
+                stream = decodeAheadStream;
+            }
+            PlayLockless(stream);
             sound_ = sound;
             return;
         }
@@ -602,87 +792,23 @@ void SoundSource::SetPlayPositionLockless(signed char* pos)
     timePosition_ = ((float)(int)(size_t)(pos - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency());
 }
 
-void SoundSource::MixMonoToMono(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::MixSound(Sound* sound, float* dest, unsigned samples, int mixRate, bool stereo, bool interpolation)
 {
     float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
+    // Below the 16-bit quantization step the sound is inaudible
+    if (256.0f * totalGain < 0.5f)
     {
         MixZeroVolume(sound, samples, mixRate);
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * vol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * vol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * vol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * vol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixMonoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto leftVol = (int)((-panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    auto rightVol = (int)((panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    if (!leftVol && !rightVol)
+    // Panning only applies to mono sounds on stereo output
+    float leftGain = totalGain;
+    float rightGain = totalGain;
+    if (stereo && !sound->IsStereo())
     {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
+        leftGain = (-panning_ + 1.0f) * totalGain;
+        rightGain = (panning_ + 1.0f) * totalGain;
     }
 
     float add = frequency_ / (float)mixRate;
@@ -692,545 +818,17 @@ void SoundSource::MixMonoToStereo(Sound* sound, int* dest, unsigned samples, int
 
     if (sound->IsSixteenBit())
     {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (*pos * rightVol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (*pos * rightVol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
+        position_ = (signed char*)MixSamples((short*)position_, fractPos, sound, dest, samples, stereo, interpolation, intAdd,
+            fractAdd, leftGain, rightGain);
     }
     else
     {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * leftVol;
-                ++dest;
-                *dest = *dest + *pos * rightVol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * leftVol;
-                ++dest;
-                *dest = *dest + *pos * rightVol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
+        position_ = MixSamples((signed char*)position_, fractPos, sound, dest, samples, stereo, interpolation, intAdd,
+            fractAdd, leftGain, rightGain);
     }
 
     fractPosition_ = fractPos;
 }
-
-void SoundSource::MixMonoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE() * vol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE() * vol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE() * vol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE() * vol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixMonoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto leftVol = (int)((-panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    auto rightVol = (int)((panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    if (!leftVol && !rightVol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + (s * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (s * rightVol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + (s * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (s * rightVol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + s * leftVol;
-                ++dest;
-                *dest = *dest + s * rightVol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + s * leftVol;
-                ++dest;
-                *dest = *dest + s * rightVol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixStereoToMono(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixStereoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (pos[0] * vol) / 256;
-                ++dest;
-                *dest = *dest + (pos[1] * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (pos[0] * vol) / 256;
-                ++dest;
-                *dest = *dest + (pos[1] * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + pos[0] * vol;
-                ++dest;
-                *dest = *dest + pos[1] * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + pos[0] * vol;
-                ++dest;
-                *dest = *dest + pos[1] * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixStereoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE_LEFT() * vol) / 256;
-                ++dest;
-                *dest = *dest + (GET_IP_SAMPLE_RIGHT() * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE_LEFT() * vol) / 256;
-                ++dest;
-                *dest = *dest + (GET_IP_SAMPLE_RIGHT() * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE_LEFT() * vol;
-                ++dest;
-                *dest = *dest + GET_IP_SAMPLE_RIGHT() * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE_LEFT() * vol;
-                ++dest;
-                *dest = *dest + GET_IP_SAMPLE_RIGHT() * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
-}
-
 void SoundSource::MixZeroVolume(Sound* sound, unsigned samples, int mixRate)
 {
     float add = frequency_ * (float)samples / (float)mixRate;
@@ -28,9 +28,18 @@ IGNORE_SUBSYSTEM(Tasks)
 %ignore Urho3D::EventHandler;
 %ignore Urho3D::EventHandlerImpl;
 %ignore Urho3D::EventHandler11Impl;
+%ignore Urho3D::TypedEventHandlerImpl;
+%ignore Urho3D::TypedEventHandler11Impl;
+%ignore Urho3D::EventPayload;
+%ignore Urho3D::EventDataWriter;
+%ignore Urho3D::EventDataReader;
 %ignore Urho3D::ObjectFactory;
 %ignore Urho3D::Object::GetEventHandler;
 %ignore Urho3D::Object::SubscribeToEvent;
+%ignore Urho3D::Object::SendEvent(StringHash, EventPayload&);
+%ignore Urho3D::Object::SendTypedEvent;
+%ignore Urho3D::Object::OnEvent(Object*, StringHash, EventPayload&);
+%ignore Urho3D::Context::GetTypedEventDataMap;
 %ignore Urho3D::Object::context_;
 
 %csexposefunc(runtime, CloneGCHandle, void*, void*) %{
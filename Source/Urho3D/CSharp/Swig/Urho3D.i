@@ -207,6 +207,12 @@ namespace SDL
 %ignore Urho3D::MakeCustomValue;
 %ignore Urho3D::VariantValue;
 %ignore Urho3D::Variant::Variant(const VectorBuffer&);
+%ignore Urho3D::Variant::Variant(Variant&&);
+%ignore Urho3D::Variant::Variant(ea::string&&);
+%ignore Urho3D::Variant::Variant(ea::vector<unsigned char>&&);
+%ignore Urho3D::Variant::Variant(VariantVector&&);
+%ignore Urho3D::Variant::Variant(VariantMap&&);
+%ignore Urho3D::Variant::Variant(StringVector&&);
 %ignore Urho3D::Variant::GetVectorBuffer;
 %ignore Urho3D::Variant::SetCustomVariantValue;
 %ignore Urho3D::Variant::GetCustomVariantValuePtr;
@@ -229,6 +235,8 @@ namespace SDL
 %include "Urho3D/Core/Object.h"
 %include "Urho3D/Core/Context.h"
 %include "Urho3D/Core/Timer.h"
+%template(ProfilerBlockStatsVector) eastl::vector<Urho3D::ProfilerBlockStats>;
+%include "Urho3D/Core/FrameProfiler.h"
 %include "Urho3D/Core/Spline.h"
 %include "Urho3D/Core/Mutex.h"
 
@@ -271,6 +279,9 @@ namespace SDL
 // --------------------------------------- IO ---------------------------------------
 %ignore Urho3D::GetWideNativePath;
 %ignore Urho3D::logLevelNames;
+%ignore Urho3D::AsyncLogRecord;
+%ignore Urho3D::AsyncLogRecordImpl;
+%ignore Urho3D::AsyncLogArgument;
 
 %interface_custom("%s", "I%s", Urho3D::Serializer);
 %include "Urho3D/IO/Serializer.h"
@@ -338,12 +349,18 @@ public:
 %ignore Urho3D::ValueAnimation::GetKeyFrames;
 %ignore Urho3D::Serializable::networkState_;
 %ignore Urho3D::ReplicationState::connection_;
+%ignore Urho3D::NodeSnapshotHistory;
+%ignore Urho3D::NodeReplicationState::snapshotHistory_;
+%ignore Urho3D::QuantizedTransform::position_;
+%ignore Urho3D::QuantizedTransform::rotation_;
 %ignore Urho3D::Node::SetOwner;
 %ignore Urho3D::Node::GetOwner;
 %ignore Urho3D::Component::CleanupConnection;
 %ignore Urho3D::Scene::CleanupConnection;
 %ignore Urho3D::Node::CleanupConnection;
 %ignore Urho3D::NodeImpl;
+%ignore Urho3D::IsInterestImmediate;
+%ignore Urho3D::NodeReplicationState::MarkDirty;
 
 %include "Urho3D/Scene/AnimationDefs.h"
 %include "Urho3D/Scene/ValueAnimationInfo.h"
@@ -351,6 +368,7 @@ public:
 %include "Urho3D/Scene/Animatable.h"
 %include "Urho3D/Scene/Component.h"
 %include "Urho3D/Scene/Node.h"
+%include "Urho3D/Scene/InterestGrid.h"
 %include "Urho3D/Scene/ReplicationState.h"
 %include "Urho3D/Scene/Scene.h"
 %include "Urho3D/Scene/SplinePath.h"
@@ -358,6 +376,7 @@ public:
 %include "Urho3D/Scene/LogicComponent.h"
 %include "Urho3D/Scene/ObjectAnimation.h"
 %include "Urho3D/Scene/SceneResolver.h"
+%include "Urho3D/Scene/NodePrefab.h"
 %include "Urho3D/Scene/SmoothedTransform.h"
 %include "Urho3D/Scene/UnknownComponent.h"
 
@@ -377,6 +396,7 @@ public:
 %include "Urho3D/Audio/SoundStream.h"
 %include "Urho3D/Audio/BufferedSoundStream.h"
 %include "Urho3D/Audio/OggVorbisSoundStream.h"
+%include "Urho3D/Audio/DecodeAheadSoundStream.h"
 %include "Urho3D/Audio/SoundListener.h"
 %include "Urho3D/Audio/SoundSource.h"
 %include "Urho3D/Audio/SoundSource3D.h"
@@ -434,6 +454,16 @@ public:
 %ignore Urho3D::ScenePassInfo::batchQueue_;
 %ignore Urho3D::LightQueryResult;
 %ignore Urho3D::View::GetLightQueues;
+%ignore Urho3D::Scene::AddLogicUpdate;
+%ignore Urho3D::Scene::RemoveLogicUpdate;
+%ignore Urho3D::SkeletonPose;
+%ignore Urho3D::AnimatedModel::GetPose;
+%ignore Urho3D::AnimationState::ApplyToPose;
+%ignore Urho3D::CompressedAnimationTrack;
+%ignore Urho3D::AnimationTrack::compressed_;
+%ignore Urho3D::AnimationTrack::Sample;
+%ignore Urho3D::Octree::GetParticleManager;
+%ignore Urho3D::ParticleStreams;
 %rename(DrawableFlags) Urho3D::DrawableFlag;
 
 
@@ -501,6 +531,7 @@ public:
 %include "Urho3D/Graphics/Skybox.h"
 %include "Urho3D/Graphics/TerrainPatch.h"
 %include "Urho3D/Graphics/Terrain.h"
+%include "Urho3D/Graphics/TerrainPager.h"
 %include "Urho3D/Graphics/DebugRenderer.h"
 %include "Urho3D/Graphics/Zone.h"
 %include "Urho3D/Graphics/Renderer.h"
@@ -524,7 +555,10 @@ public:
 	rcPolyMeshDetail*
 }
 %ignore Urho3D::NavBuildData::navAreas_;
+%ignore Urho3D::NavTileData::layers_;
 %ignore Urho3D::NavigationMesh::FindPath;
+%ignore Urho3D::NavigationMesh::RequestPath;
+%ignore Urho3D::CrowdManager::RequestPath;
 %include "Urho3D/Navigation/CrowdAgent.h"
 %include "Urho3D/Navigation/CrowdManager.h"
 %include "Urho3D/Navigation/NavigationMesh.h"
@@ -539,8 +573,11 @@ public:
 // --------------------------------------- Network ---------------------------------------
 #if defined(URHO3D_NETWORK)
 %ignore Urho3D::Network::MakeHttpRequest;
+%ignore Urho3D::Network::GetSnapshotTransform;
 %ignore Urho3D::PackageDownload;
 %ignore Urho3D::PackageUpload;
+%ignore Urho3D::ReceivedSnapshot;
+%ignore Urho3D::SnapshotEntry;
 
 %template(ConnectionVector) eastl::vector<Urho3D::SharedPtr<Urho3D::Connection>>;
 
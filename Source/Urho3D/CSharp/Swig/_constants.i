@@ -698,19 +698,12 @@
 %rename(Priority) Urho3D::WorkItem::priority_;
 %rename(SendEvent) Urho3D::WorkItem::sendEvent_;
 %rename(Completed) Urho3D::WorkItem::completed_;
-%rename(Pooled) Urho3D::WorkItem::pooled_;
 %rename(WorkLambda) Urho3D::WorkItem::workLambda_;
 %rename(Threads) Urho3D::WorkQueue::threads_;
-%rename(PoolItems) Urho3D::WorkQueue::poolItems_;
 %rename(WorkItems) Urho3D::WorkQueue::workItems_;
-%rename(Queue) Urho3D::WorkQueue::queue_;
-%rename(QueueMutex) Urho3D::WorkQueue::queueMutex_;
 %rename(ShutDown) Urho3D::WorkQueue::shutDown_;
-%rename(Pausing) Urho3D::WorkQueue::pausing_;
 %rename(Paused) Urho3D::WorkQueue::paused_;
 %rename(Completing) Urho3D::WorkQueue::completing_;
-%rename(Tolerance) Urho3D::WorkQueue::tolerance_;
-%rename(LastSize) Urho3D::WorkQueue::lastSize_;
 %rename(MaxNonThreadedWorkMs) Urho3D::WorkQueue::maxNonThreadedWorkMs_;
 %rename(Engine) Urho3D::Application::engine_;
 %rename(EngineParameters) Urho3D::Application::engineParameters_;
@@ -3504,7 +3497,18 @@
 %rename(WorldRotation) Urho3D::DelayedWorldTransform::worldRotation_;
 %rename(Manifold) Urho3D::ManifoldPair::manifold_;
 %rename(FlippedManifold) Urho3D::ManifoldPair::flippedManifold_;
+%rename(Position) Urho3D::PhysicsContactPoint::position_;
+%rename(Normal) Urho3D::PhysicsContactPoint::normal_;
+%rename(Distance) Urho3D::PhysicsContactPoint::distance_;
+%rename(Impulse) Urho3D::PhysicsContactPoint::impulse_;
+%rename(BodyA) Urho3D::PhysicsContactPair::bodyA_;
+%rename(BodyB) Urho3D::PhysicsContactPair::bodyB_;
+%rename(FirstContact) Urho3D::PhysicsContactPair::firstContact_;
+%rename(NumContacts) Urho3D::PhysicsContactPair::numContacts_;
+%rename(Trigger) Urho3D::PhysicsContactPair::trigger_;
+%rename(Started) Urho3D::PhysicsContactPair::started_;
 %rename(CollisionConfig) Urho3D::PhysicsWorldConfig::collisionConfig_;
+%rename(Multithreaded) Urho3D::PhysicsWorldConfig::multithreaded_;
 %ignore Urho3D::DEFAULT_FPS;
 %ignore Urho3D::DEFAULT_MAX_NETWORK_ANGULAR_VELOCITY;
 %rename(IsVisible) Urho3D::PhysicsWorld::isVisible;
@@ -3918,10 +3922,10 @@
 %rename(DebughudShowNone) DEBUGHUD_SHOW_NONE;
 %rename(DebughudShowStats) DEBUGHUD_SHOW_STATS;
 %rename(DebughudShowMode) DEBUGHUD_SHOW_MODE;
+%rename(DebughudShowProfiler) DEBUGHUD_SHOW_PROFILER;
 %rename(DebughudShowAll) DEBUGHUD_SHOW_ALL;
 %rename(AppStats) Urho3D::DebugHud::appStats_;
 %rename(ProfilerMaxDepth) Urho3D::DebugHud::profilerMaxDepth_;
-%rename(ProfilerInterval) Urho3D::DebugHud::profilerInterval_;
 %rename(UseRendererStats) Urho3D::DebugHud::useRendererStats_;
 %rename(Mode) Urho3D::DebugHud::mode_;
 %rename(FpsTimer) Urho3D::DebugHud::fpsTimer_;
@@ -1,5 +1,6 @@
 URHO3D_REFCOUNTED(Urho3D::Audio);
 URHO3D_REFCOUNTED(Urho3D::BufferedSoundStream);
+URHO3D_REFCOUNTED(Urho3D::DecodeAheadSoundStream);
 URHO3D_REFCOUNTED(Urho3D::OggVorbisSoundStream);
 URHO3D_REFCOUNTED(Urho3D::Sound);
 URHO3D_REFCOUNTED(Urho3D::SoundListener);
@@ -57,6 +58,7 @@ URHO3D_REFCOUNTED(Urho3D::Pass);
 URHO3D_REFCOUNTED(Urho3D::Technique);
 URHO3D_REFCOUNTED(Urho3D::Terrain);
 URHO3D_REFCOUNTED(Urho3D::TerrainPatch);
+URHO3D_REFCOUNTED(Urho3D::TerrainPager);
 URHO3D_REFCOUNTED(Urho3D::Texture);
 URHO3D_REFCOUNTED(Urho3D::Texture2D);
 URHO3D_REFCOUNTED(Urho3D::Texture2DArray);
@@ -114,6 +116,7 @@ URHO3D_REFCOUNTED(Urho3D::CameraViewport);
 URHO3D_REFCOUNTED(Urho3D::Component);
 URHO3D_REFCOUNTED(Urho3D::LogicComponent);
 URHO3D_REFCOUNTED(Urho3D::Node);
+URHO3D_REFCOUNTED(Urho3D::NodePrefab);
 URHO3D_REFCOUNTED(Urho3D::ObjectAnimation);
 URHO3D_REFCOUNTED(Urho3D::Scene);
 URHO3D_REFCOUNTED(Urho3D::SceneManager);
@@ -144,4 +144,20 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     allocator->free_ = node;
 }
 
+void* AllocateAligned(size_t size, size_t alignment)
+{
+    // Over-allocate, and store the original pointer just before the aligned block
+    auto* blockPtr = new unsigned char[size + alignment + sizeof(void*)];
+    const auto address = reinterpret_cast<uintptr_t>(blockPtr + sizeof(void*));
+    auto* alignedPtr = reinterpret_cast<unsigned char*>((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    reinterpret_cast<unsigned char**>(alignedPtr)[-1] = blockPtr;
+    return alignedPtr;
+}
+
+void FreeAligned(void* ptr)
+{
+    if (ptr)
+        delete[] static_cast<unsigned char**>(ptr)[-1];
+}
+
 }
@@ -29,6 +29,7 @@
 #endif
 
 #include <cstddef>
+#include <cstdint>
 #include <EASTL/utility.h>
 
 
@@ -68,6 +69,10 @@ URHO3D_API void AllocatorUninitialize(AllocatorBlock* allocator);
 URHO3D_API void* AllocatorReserve(AllocatorBlock* allocator);
 /// Free a node. Does not free any blocks.
 URHO3D_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
+/// Allocate memory aligned to a power of two. Used by over-aligned types, whose alignment operator new does not respect before C++17.
+URHO3D_API void* AllocateAligned(size_t size, size_t alignment);
+/// Free memory allocated with AllocateAligned().
+URHO3D_API void FreeAligned(void* ptr);
 
 /// %Allocator template class. Allocates objects of a specific class.
 template <class T> class Allocator
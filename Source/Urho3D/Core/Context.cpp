@@ -174,6 +174,10 @@ Context::~Context()
     for (auto i = eventDataMaps_.begin(); i != eventDataMaps_.end(); ++i)
         delete *i;
     eventDataMaps_.clear();
+
+    for (auto i = typedEventDataMaps_.begin(); i != typedEventDataMaps_.end(); ++i)
+        delete *i;
+    typedEventDataMaps_.clear();
 }
 
 SharedPtr<Object> Context::CreateObject(StringHash objectType)
@@ -294,6 +298,17 @@ VariantMap& Context::GetEventDataMap()
     return ret;
 }
 
+VariantMap& Context::GetTypedEventDataMap()
+{
+    unsigned nestingLevel = eventSenders_.size();
+    while (typedEventDataMaps_.size() < nestingLevel + 1)
+        typedEventDataMaps_.push_back(new VariantMap());
+
+    VariantMap& ret = *typedEventDataMaps_[nestingLevel];
+    ret.clear();
+    return ret;
+}
+
 #ifndef MINI_URHO
 bool Context::RequireSDL(unsigned int sdlFlags)
 {
@@ -104,6 +104,8 @@ public:
     void UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
+    /// Return a preallocated map for converting a typed event payload at the current nesting level. Separate from GetEventDataMap() so that handlers can send events of their own.
+    VariantMap& GetTypedEventDataMap();
     /// Initialises the specified SDL systems, if not already. Returns true if successful. This call must be matched with ReleaseSDL() when SDL functions are no longer required, even if this call fails.
     bool RequireSDL(unsigned int sdlFlags);
     /// Indicate that you are done with using SDL. Must be called after using RequireSDL().
@@ -320,6 +322,8 @@ private:
     ea::vector<Object*> eventSenders_;
     /// Event data stack.
     ea::vector<VariantMap*> eventDataMaps_;
+    /// Typed event payload conversion stack.
+    ea::vector<VariantMap*> typedEventDataMaps_;
     /// Active event handler. Not stored in a stack for performance reasons; is needed only in esoteric cases.
     EventHandler* eventHandler_;
     /// Object categories.
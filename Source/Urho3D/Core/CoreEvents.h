@@ -38,24 +38,37 @@ URHO3D_EVENT(E_BEGINFRAME, BeginFrame)
 URHO3D_EVENT(E_UPDATE, Update)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+
+    /// Typed payload, shared by all application-wide update events.
+    struct Data
+    {
+        /// Frame timestep in seconds.
+        float timeStep_{};
+
+        /// List members for conversion from and to event parameters.
+        template <class Visitor> void Visit(Visitor& visitor) { visitor(P_TIMESTEP, timeStep_); }
+    };
 }
 
 /// Application-wide logic post-update event.
 URHO3D_EVENT(E_POSTUPDATE, PostUpdate)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    using Data = Update::Data;
 }
 
 /// Render update event.
 URHO3D_EVENT(E_RENDERUPDATE, RenderUpdate)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    using Data = Update::Data;
 }
 
 /// Post-render update event.
 URHO3D_EVENT(E_POSTRENDERUPDATE, PostRenderUpdate)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    using Data = Update::Data;
 }
 
 /// Frame end event.
@@ -0,0 +1,279 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include <EASTL/sort.h>
+
+#include "../Core/CoreEvents.h"
+#include "../Core/FrameProfiler.h"
+#include "../IO/File.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned DEFAULT_PROFILER_INTERVAL = 1000;
+
+/// Append a string escaped for a JSON string literal.
+static void AppendJSONString(ea::string& dest, const char* str)
+{
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+            dest += '\\';
+        dest += *str;
+    }
+}
+
+FrameProfiler::FrameProfiler(Context* context) :
+    Object(context),
+    interval_(DEFAULT_PROFILER_INTERVAL),
+    traceFramesLeft_(0),
+    intervalDropped_(0),
+    numDropped_(0)
+{
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(FrameProfiler, HandleEndFrame));
+}
+
+FrameProfiler::~FrameProfiler() = default;
+
+void FrameProfiler::SetEnabled(bool enable)
+{
+    ProfilerScope::SetRecording(enable);
+}
+
+void FrameProfiler::SetInterval(unsigned ms)
+{
+    interval_ = Max(ms, 1u);
+}
+
+void FrameProfiler::CaptureTrace(unsigned numFrames)
+{
+    traceRecords_.clear();
+    traceFramesLeft_ = numFrames;
+}
+
+void FrameProfiler::EndFrame()
+{
+    records_.clear();
+    intervalDropped_ += ReadProfilerRecords(records_);
+
+    for (const ProfilerRecord& record : records_)
+    {
+        const unsigned index = GetBlockIndex(record.node_);
+        Block& block = blocks_[index];
+        if (!block.frameCount_)
+            frameBlocks_.push_back(index);
+        block.frameTime_ += record.endTime_ - record.startTime_;
+        ++block.frameCount_;
+    }
+
+    for (unsigned index : frameBlocks_)
+    {
+        Block& block = blocks_[index];
+        if (!block.intervalFrames_)
+        {
+            block.intervalMinTime_ = block.frameTime_;
+            block.intervalMaxTime_ = block.frameTime_;
+        }
+        else
+        {
+            block.intervalMinTime_ = Min(block.intervalMinTime_, block.frameTime_);
+            block.intervalMaxTime_ = Max(block.intervalMaxTime_, block.frameTime_);
+        }
+        block.intervalTime_ += block.frameTime_;
+        block.intervalCount_ += block.frameCount_;
+        ++block.intervalFrames_;
+        block.frameTime_ = 0;
+        block.frameCount_ = 0;
+    }
+    frameBlocks_.clear();
+
+    if (traceFramesLeft_)
+    {
+        traceRecords_.insert(traceRecords_.end(), records_.begin(), records_.end());
+        --traceFramesLeft_;
+    }
+
+    if (intervalTimer_.GetMSec(false) >= interval_)
+        FinishInterval();
+}
+
+bool FrameProfiler::SaveTrace(Serializer& dest) const
+{
+    long long baseTime = traceRecords_.empty() ? 0 : traceRecords_.front().startTime_;
+    for (const ProfilerRecord& record : traceRecords_)
+        baseTime = Min(baseTime, record.startTime_);
+    const double usecPerTick = 1000000.0 / (double)HiresTimer::GetFrequency();
+
+    ea::string json = "{\"traceEvents\":[";
+    ea::vector<bool> threadNamed;
+    for (const ProfilerRecord& record : traceRecords_)
+    {
+        const unsigned threadIndex = record.node_->threadIndex_;
+        if (threadIndex >= threadNamed.size())
+            threadNamed.resize(threadIndex + 1, false);
+        if (!threadNamed[threadIndex])
+        {
+            threadNamed[threadIndex] = true;
+            json.append_sprintf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"", threadIndex);
+            AppendJSONString(json, GetProfilerThreadName(threadIndex).c_str());
+            json += "\"}},\n";
+        }
+
+        json += "{\"name\":\"";
+        AppendJSONString(json, record.node_->name_);
+        json.append_sprintf("\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n", threadIndex,
+            (double)(record.startTime_ - baseTime) * usecPerTick, (double)(record.endTime_ - record.startTime_) * usecPerTick);
+    }
+    // Remove the separator after the last event
+    if (!traceRecords_.empty())
+        json.resize(json.size() - 2);
+    json += "]}\n";
+
+    return dest.Write(json.data(), json.size()) == json.size();
+}
+
+bool FrameProfiler::SaveTrace(const ea::string& fileName) const
+{
+    File file(context_, fileName, FILE_WRITE);
+    return file.IsOpen() && SaveTrace(file);
+}
+
+ea::string FrameProfiler::PrintData(unsigned maxDepth) const
+{
+    ea::string output;
+    output.append_sprintf("%-40s %7s %8s %8s %8s %9s\n", "Block", "Count", "Min ms", "Avg ms", "Max ms", "Total ms");
+
+    const ea::string* threadName = nullptr;
+    for (const ProfilerBlockStats& stats : data_)
+    {
+        if (stats.depth_ > maxDepth)
+            continue;
+
+        if (!threadName || *threadName != stats.threadName_)
+        {
+            threadName = &stats.threadName_;
+            output.append_sprintf("[%s]\n", threadName->c_str());
+        }
+
+        const ea::string label = ea::string(stats.depth_ * 2 + 1, ' ') + stats.name_;
+        output.append_sprintf("%-40s %7u %8.3f %8.3f %8.3f %9.3f\n", label.c_str(), stats.count_, stats.minMs_, stats.avgMs_,
+            stats.maxMs_, stats.totalMs_);
+    }
+
+    if (numDropped_)
+        output.append_sprintf("%u blocks dropped\n", numDropped_);
+    return output;
+}
+
+bool FrameProfiler::IsEnabled() const
+{
+    return ProfilerScope::IsRecording();
+}
+
+void FrameProfiler::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    EndFrame();
+}
+
+unsigned FrameProfiler::GetBlockIndex(const ProfilerNode* node)
+{
+    auto it = blockIndices_.find(node);
+    if (it != blockIndices_.end())
+        return it->second;
+
+    // Parents come first, so that the hierarchy can be walked in order
+    if (node->parent_->name_)
+        GetBlockIndex(node->parent_);
+
+    const unsigned index = blocks_.size();
+    blocks_.emplace_back();
+    blocks_.back().node_ = node;
+    blockIndices_[node] = index;
+    return index;
+}
+
+void FrameProfiler::FinishInterval()
+{
+    ea::vector<ea::vector<unsigned> > children(blocks_.size());
+    ea::vector<unsigned> roots;
+    for (unsigned i = 0; i < blocks_.size(); ++i)
+    {
+        const ProfilerNode* parent = blocks_[i].node_->parent_;
+        if (parent->name_)
+            children[blockIndices_[parent]].push_back(i);
+        else
+            roots.push_back(i);
+    }
+    ea::stable_sort(roots.begin(), roots.end(),
+        [this](unsigned lhs, unsigned rhs) { return blocks_[lhs].node_->threadIndex_ < blocks_[rhs].node_->threadIndex_; });
+
+    data_.clear();
+    for (unsigned root : roots)
+        AddBlockData(root, children);
+
+    for (Block& block : blocks_)
+    {
+        block.intervalTime_ = 0;
+        block.intervalCount_ = 0;
+        block.intervalFrames_ = 0;
+    }
+
+    numDropped_ = intervalDropped_;
+    intervalDropped_ = 0;
+    intervalTimer_.Reset();
+}
+
+void FrameProfiler::AddBlockData(unsigned index, const ea::vector<ea::vector<unsigned> >& children)
+{
+    const Block& block = blocks_[index];
+    const float msPerTick = 1000.0f / (float)HiresTimer::GetFrequency();
+    const unsigned position = data_.size();
+
+    data_.emplace_back();
+    ProfilerBlockStats& stats = data_.back();
+    stats.name_ = block.node_->name_;
+    stats.threadName_ = GetProfilerThreadName(block.node_->threadIndex_);
+    stats.depth_ = block.node_->depth_;
+    stats.count_ = block.intervalCount_;
+    stats.frames_ = block.intervalFrames_;
+    if (block.intervalFrames_)
+    {
+        stats.minMs_ = block.intervalMinTime_ * msPerTick;
+        stats.avgMs_ = block.intervalTime_ * msPerTick / block.intervalFrames_;
+        stats.maxMs_ = block.intervalMaxTime_ * msPerTick;
+        stats.totalMs_ = block.intervalTime_ * msPerTick;
+    }
+
+    for (unsigned child : children[index])
+        AddBlockData(child, children);
+
+    // Leave out blocks which did not finish during the interval and have no children that did
+    if (!block.intervalFrames_ && data_.size() == position + 1)
+        data_.pop_back();
+}
+
+}
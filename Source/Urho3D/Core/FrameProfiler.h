@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <EASTL/unordered_map.h>
+
+#include "../Core/Object.h"
+#include "../Core/Timer.h"
+
+namespace Urho3D
+{
+
+class Serializer;
+
+/// Timing statistics of a profiler block over an interval.
+struct URHO3D_API ProfilerBlockStats
+{
+    /// Block name.
+    ea::string name_;
+    /// Name of the thread the block was recorded on.
+    ea::string threadName_;
+    /// Depth in the block hierarchy, 0 for the top level blocks of a thread.
+    unsigned depth_{};
+    /// Number of times the block finished during the interval.
+    unsigned count_{};
+    /// Number of frames the block finished in during the interval.
+    unsigned frames_{};
+    /// Minimum time per frame in milliseconds, over the frames the block finished in.
+    float minMs_{};
+    /// Average time per frame in milliseconds, over the frames the block finished in.
+    float avgMs_{};
+    /// Maximum time per frame in milliseconds.
+    float maxMs_{};
+    /// Total time in milliseconds.
+    float totalMs_{};
+};
+
+/// Built-in profiler subsystem. Reads the blocks recorded by URHO3D_PROFILE scopes on all threads at the end of each frame and aggregates them over intervals. Works without Tracy, e.g. on headless servers.
+class URHO3D_API FrameProfiler : public Object
+{
+    URHO3D_OBJECT(FrameProfiler, Object);
+
+public:
+    /// Construct.
+    explicit FrameProfiler(Context* context);
+    /// Destruct.
+    ~FrameProfiler() override;
+
+    /// Set whether to record profiler blocks. Recording is shared by all threads and is disabled by default.
+    void SetEnabled(bool enable);
+    /// Set statistics interval in milliseconds.
+    void SetInterval(unsigned ms);
+    /// Record the individual blocks of the following frames for a trace dump, discarding the previous capture.
+    void CaptureTrace(unsigned numFrames);
+    /// Read the blocks finished since the last frame and update the statistics. Called automatically at the end of the frame.
+    void EndFrame();
+    /// Write the captured blocks in Chrome trace event format, viewable in chrome://tracing or Perfetto. Return true if successful.
+    bool SaveTrace(Serializer& dest) const;
+    /// Write the captured blocks in Chrome trace event format to a file. Return true if successful.
+    bool SaveTrace(const ea::string& fileName) const;
+    /// Return the statistics of the last interval as text.
+    ea::string PrintData(unsigned maxDepth = M_MAX_UNSIGNED) const;
+
+    /// Return whether recording profiler blocks.
+    bool IsEnabled() const;
+
+    /// Return statistics interval in milliseconds.
+    unsigned GetInterval() const { return interval_; }
+
+    /// Return whether capturing a trace.
+    bool IsCapturingTrace() const { return traceFramesLeft_ > 0; }
+
+    /// Return statistics of the last interval in hierarchy order.
+    const ea::vector<ProfilerBlockStats>& GetData() const { return data_; }
+
+    /// Return number of blocks dropped during the last interval because a thread buffer was full.
+    unsigned GetNumDroppedBlocks() const { return numDropped_; }
+
+private:
+    /// Accumulated timing of a block.
+    struct Block
+    {
+        /// Block node.
+        const ProfilerNode* node_{};
+        /// Time during the current frame in ticks.
+        long long frameTime_{};
+        /// Number of finished blocks during the current frame.
+        unsigned frameCount_{};
+        /// Total time during the interval in ticks.
+        long long intervalTime_{};
+        /// Minimum frame time during the interval in ticks.
+        long long intervalMinTime_{};
+        /// Maximum frame time during the interval in ticks.
+        long long intervalMaxTime_{};
+        /// Number of finished blocks during the interval.
+        unsigned intervalCount_{};
+        /// Number of frames with finished blocks during the interval.
+        unsigned intervalFrames_{};
+    };
+
+    /// Handle frame end event.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Return index of the block for a node, creating it and its parents if necessary.
+    unsigned GetBlockIndex(const ProfilerNode* node);
+    /// Fill the interval statistics and reset the blocks.
+    void FinishInterval();
+    /// Add statistics of a block and its children in hierarchy order.
+    void AddBlockData(unsigned index, const ea::vector<ea::vector<unsigned> >& children);
+
+    /// Blocks in the order they were first seen. Parents come before their children.
+    ea::vector<Block> blocks_;
+    /// Block indices by node.
+    ea::unordered_map<const ProfilerNode*, unsigned> blockIndices_;
+    /// Blocks finished during the current frame.
+    ea::vector<unsigned> frameBlocks_;
+    /// Records read during the current frame.
+    ea::vector<ProfilerRecord> records_;
+    /// Captured records for the trace.
+    ea::vector<ProfilerRecord> traceRecords_;
+    /// Statistics of the last interval.
+    ea::vector<ProfilerBlockStats> data_;
+    /// Interval timer.
+    Timer intervalTimer_;
+    /// Statistics interval in milliseconds.
+    unsigned interval_;
+    /// Frames left to capture for the trace.
+    unsigned traceFramesLeft_;
+    /// Blocks dropped during the current interval.
+    unsigned intervalDropped_;
+    /// Blocks dropped during the last interval.
+    unsigned numDropped_;
+};
+
+}
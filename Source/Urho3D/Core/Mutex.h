@@ -28,6 +28,12 @@
 #include <Urho3D/Urho3D.h>
 #endif
 
+#include <atomic>
+#include <thread>
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -71,4 +77,49 @@ private:
     Mutex& mutex_;
 };
 
+/// Lightweight busy-waiting lock for very short critical sections. Not recursive.
+class SpinLock
+{
+public:
+    /// Acquire the lock. Busy-wait if already acquired.
+    void Acquire()
+    {
+        while (flag_.test_and_set(std::memory_order_acquire))
+        {
+#ifdef URHO3D_SSE
+            _mm_pause();
+#else
+            std::this_thread::yield();
+#endif
+        }
+    }
+    /// Try to acquire the lock without waiting. Return true if successful.
+    bool TryAcquire() { return !flag_.test_and_set(std::memory_order_acquire); }
+    /// Release the lock.
+    void Release() { flag_.clear(std::memory_order_release); }
+
+private:
+    /// Lock flag.
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+/// Lock that automatically acquires and releases a spin lock.
+class SpinLockGuard
+{
+public:
+    /// Construct and acquire the lock.
+    explicit SpinLockGuard(SpinLock& lock) : lock_(lock) { lock_.Acquire(); }
+    /// Destruct. Release the lock.
+    ~SpinLockGuard() { lock_.Release(); }
+
+    /// Prevent copy construction.
+    SpinLockGuard(const SpinLockGuard& rhs) = delete;
+    /// Prevent assignment.
+    SpinLockGuard& operator =(const SpinLockGuard& rhs) = delete;
+
+private:
+    /// Lock reference.
+    SpinLock& lock_;
+};
+
 }
@@ -91,7 +91,30 @@ void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData
 
     // Make a copy of the context pointer in case the object is destroyed during event handler invocation
     Context* context = context_;
-    EventHandler* specific = nullptr;
+    if (EventHandler* handler = SelectEventHandler(sender, eventType))
+    {
+        context->SetEventHandler(handler);
+        handler->Invoke(eventData);
+        context->SetEventHandler(nullptr);
+    }
+}
+
+void Object::OnEvent(Object* sender, StringHash eventType, EventPayload& payload)
+{
+    if (blockEvents_)
+        return;
+
+    Context* context = context_;
+    if (EventHandler* handler = SelectEventHandler(sender, eventType))
+    {
+        context->SetEventHandler(handler);
+        handler->InvokeTyped(payload);
+        context->SetEventHandler(nullptr);
+    }
+}
+
+EventHandler* Object::SelectEventHandler(Object* sender, StringHash eventType)
+{
     EventHandler* nonSpecific = nullptr;
 
     for (auto& handler : eventHandlers_)
@@ -100,29 +123,13 @@ void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData
         {
             if (!handler.GetSender())
                 nonSpecific = &handler;
+            // Specific event handlers have priority
             else if (handler.GetSender() == sender)
-            {
-                specific = &handler;
-                break;
-            }
+                return &handler;
         }
     }
 
-    // Specific event handlers have priority, so if found, invoke first
-    if (specific)
-    {
-        context->SetEventHandler(specific);
-        specific->Invoke(eventData);
-        context->SetEventHandler(nullptr);
-        return;
-    }
-
-    if (nonSpecific)
-    {
-        context->SetEventHandler(nonSpecific);
-        nonSpecific->Invoke(eventData);
-        context->SetEventHandler(nullptr);
-    }
+    return nonSpecific;
 }
 
 bool Object::IsInstanceOf(StringHash type) const
@@ -281,7 +288,7 @@ void Object::SendEvent(StringHash eventType)
     SendEvent(eventType, noEventData);
 }
 
-void Object::SendEvent(StringHash eventType, VariantMap& eventData)
+template <class T> void Object::DispatchEvent(StringHash eventType, T& eventData)
 {
     if (!Thread::IsMainThread())
     {
@@ -363,6 +370,16 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     context->EndSendEvent();
 }
 
+void Object::SendEvent(StringHash eventType, VariantMap& eventData)
+{
+    DispatchEvent(eventType, eventData);
+}
+
+void Object::SendEvent(StringHash eventType, EventPayload& payload)
+{
+    DispatchEvent(eventType, payload);
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     return context_->GetEventDataMap();
@@ -464,6 +481,21 @@ void Object::RemoveEventSender(Object* sender)
     }
 }
 
+void EventHandler::InvokeTyped(EventPayload& payload)
+{
+    Invoke(payload.GetEventData());
+}
+
+VariantMap& EventPayload::GetEventData()
+{
+    if (!eventData_)
+    {
+        eventData_ = &context_->GetTypedEventDataMap();
+        writeEventData_(data_, *eventData_);
+    }
+    return *eventData_;
+}
+
 StringHashRegister& GetEventNameRegister()
 {
     static StringHashRegister eventNameRegister(false /*non thread safe*/);
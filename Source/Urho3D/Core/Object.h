@@ -37,6 +37,7 @@ namespace Urho3D
 
 class Context;
 class EventHandler;
+class EventPayload;
 class Engine;
 class Time;
 class WorkQueue;
@@ -126,6 +127,8 @@ public:
     virtual const TypeInfo* GetTypeInfo() const = 0;
     /// Handle event.
     virtual void OnEvent(Object* sender, StringHash eventType, VariantMap& eventData);
+    /// Handle event with typed payload.
+    virtual void OnEvent(Object* sender, StringHash eventType, EventPayload& payload);
 
     /// Return type info static.
     static const TypeInfo* GetTypeInfoStatic() { return nullptr; }
@@ -148,6 +151,14 @@ public:
     void SubscribeToEvent(StringHash eventType, const std::function<void(StringHash, VariantMap&)>& function, void* userData = nullptr);
     /// Subscribe to a specific sender's event.
     void SubscribeToEvent(Object* sender, StringHash eventType, const std::function<void(StringHash, VariantMap&)>& function, void* userData = nullptr);
+    /// Subscribe to an event that can be sent by any sender with a member function taking a typed payload.
+    template <class T, class U> void SubscribeToEvent(StringHash eventType, void (T::*function)(const U&));
+    /// Subscribe to a specific sender's event with a member function taking a typed payload.
+    template <class T, class U> void SubscribeToEvent(Object* sender, StringHash eventType, void (T::*function)(const U&));
+    /// Subscribe to an event that can be sent by any sender with a function taking a typed payload. The payload type must be specified explicitly.
+    template <class U> void SubscribeToEvent(StringHash eventType, const std::function<void(const U&)>& function, void* userData = nullptr);
+    /// Subscribe to a specific sender's event with a function taking a typed payload. The payload type must be specified explicitly.
+    template <class U> void SubscribeToEvent(Object* sender, StringHash eventType, const std::function<void(const U&)>& function, void* userData = nullptr);
     /// Unsubscribe from an event.
     void UnsubscribeFromEvent(StringHash eventType);
     /// Unsubscribe from a specific sender's event.
@@ -169,6 +180,10 @@ public:
     {
         SendEvent(eventType, GetEventDataMap().populate(args...));
     }
+    /// Send event with typed payload to all subscribers.
+    void SendEvent(StringHash eventType, EventPayload& payload);
+    /// Send event with typed payload to all subscribers. Handlers taking the same payload type receive it directly, other handlers receive it converted to a VariantMap.
+    template <class T> void SendTypedEvent(StringHash eventType, const T& data);
 
     /// Return execution context.
     Context* GetContext() const { return context_; }
@@ -244,6 +259,10 @@ protected:
     Context* context_;
 
 private:
+    /// Deliver event to all subscribers.
+    template <class T> void DispatchEvent(StringHash eventType, T& eventData);
+    /// Return the event handler that should receive an event from the sender, or null if none.
+    EventHandler* SelectEventHandler(Object* sender, StringHash eventType);
     /// Find the first event handler with no specific sender.
     ea::intrusive_list<EventHandler>::iterator FindEventHandler(StringHash eventType);
     /// Find the first event handler with no specific sender.
@@ -345,6 +364,8 @@ public:
 
     /// Invoke event handler function.
     virtual void Invoke(VariantMap& eventData) = 0;
+    /// Invoke event handler function with typed payload. By default the payload is converted to a VariantMap.
+    virtual void InvokeTyped(EventPayload& payload);
     /// Return a unique copy of the event handler.
     virtual EventHandler* Clone() const = 0;
 
@@ -433,6 +454,190 @@ private:
     std::function<void(StringHash, VariantMap&)> function_;
 };
 
+/// Visitor that writes typed event payload members to event parameters.
+struct EventDataWriter
+{
+    /// Write value.
+    template <class T> void operator()(StringHash param, const T& value) { eventData_[param] = value; }
+    /// Write object pointer. The object type must be complete.
+    template <class T> void operator()(StringHash param, T* value) { eventData_[param] = static_cast<RefCounted*>(value); }
+    /// Write buffer.
+    void operator()(StringHash param, const ea::vector<unsigned char>* value) { eventData_[param] = value ? *value : ea::vector<unsigned char>(); }
+
+    /// Event parameters.
+    VariantMap& eventData_;
+};
+
+/// Visitor that reads typed event payload members from event parameters. Missing parameters read as default values.
+struct EventDataReader
+{
+    /// Read value.
+    template <class T> void operator()(StringHash param, T& value) { value = GetParam(param).Get<T>(); }
+    /// Read object pointer. The object type must be complete.
+    template <class T> void operator()(StringHash param, T*& value) { value = static_cast<T*>(GetParam(param).GetPtr()); }
+    /// Read buffer. The pointer is valid as long as the event parameters.
+    void operator()(StringHash param, const ea::vector<unsigned char>*& value) { value = &GetParam(param).GetBuffer(); }
+    /// Return parameter or empty variant.
+    const Variant& GetParam(StringHash param) const
+    {
+        auto i = eventData_.find(param);
+        return i != eventData_.end() ? i->second : Variant::EMPTY;
+    }
+
+    /// Event parameters.
+    const VariantMap& eventData_;
+};
+
+/// Typed event payload being sent. Payload types are declared in the event namespace and list their members to a visitor in Visit(), which is used to convert the payload to a VariantMap only when a handler needs one.
+class URHO3D_API EventPayload
+{
+public:
+    /// Construct from payload data, which must stay alive during the send.
+    template <class T> EventPayload(Context* context, const T& data) :
+        context_(context),
+        data_(&data),
+        type_(&typeid(T)),
+        writeEventData_(&WriteEventData<T>)
+    {
+    }
+
+    /// Return payload data if it has the specified type, null otherwise.
+    template <class T> const T* Get() const { return *type_ == typeid(T) ? static_cast<const T*>(data_) : nullptr; }
+    /// Return payload converted to event parameters. Converted only once per send.
+    VariantMap& GetEventData();
+
+private:
+    /// Write payload of specific type to event parameters.
+    template <class T> static void WriteEventData(const void* data, VariantMap& eventData)
+    {
+        EventDataWriter writer{eventData};
+        // Visit() is shared with the reader and therefore not const, but the writer does not modify the payload
+        const_cast<T*>(static_cast<const T*>(data))->Visit(writer);
+    }
+
+    /// Execution context.
+    Context* context_;
+    /// Payload data.
+    const void* data_;
+    /// Payload type.
+    const std::type_info* type_;
+    /// Conversion function.
+    void (*writeEventData_)(const void*, VariantMap&);
+    /// Converted event parameters, null until requested.
+    VariantMap* eventData_{};
+};
+
+/// Template implementation of the event handler invoke helper for typed payloads (stores a function pointer of specific class.)
+template <class T, class U> class TypedEventHandlerImpl : public EventHandler
+{
+public:
+    using HandlerFunctionPtr = void (T::*)(const U&);
+
+    /// Construct with receiver and function pointers.
+    TypedEventHandlerImpl(T* receiver, HandlerFunctionPtr function) :
+        EventHandler(receiver),
+        function_(function)
+    {
+        assert(receiver_);
+        assert(function_);
+    }
+
+    /// Invoke event handler function, converting event parameters to the payload.
+    void Invoke(VariantMap& eventData) override
+    {
+        U data{};
+        EventDataReader reader{eventData};
+        data.Visit(reader);
+        (static_cast<T*>(receiver_)->*function_)(data);
+    }
+
+    /// Invoke event handler function with typed payload.
+    void InvokeTyped(EventPayload& payload) override
+    {
+        if (const U* data = payload.Get<U>())
+            (static_cast<T*>(receiver_)->*function_)(*data);
+        else
+            Invoke(payload.GetEventData());
+    }
+
+    /// Return a unique copy of the event handler.
+    EventHandler* Clone() const override
+    {
+        return new TypedEventHandlerImpl(static_cast<T*>(receiver_), function_);
+    }
+
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
+/// Template implementation of the event handler invoke helper for typed payloads (std::function instance).
+template <class U> class TypedEventHandler11Impl : public EventHandler
+{
+public:
+    /// Construct with function and userdata.
+    explicit TypedEventHandler11Impl(std::function<void(const U&)> function, void* userData = nullptr) :
+        EventHandler(nullptr, userData),
+        function_(std::move(function))
+    {
+        assert(function_);
+    }
+
+    /// Invoke event handler function, converting event parameters to the payload.
+    void Invoke(VariantMap& eventData) override
+    {
+        U data{};
+        EventDataReader reader{eventData};
+        data.Visit(reader);
+        function_(data);
+    }
+
+    /// Invoke event handler function with typed payload.
+    void InvokeTyped(EventPayload& payload) override
+    {
+        if (const U* data = payload.Get<U>())
+            function_(*data);
+        else
+            Invoke(payload.GetEventData());
+    }
+
+    /// Return a unique copy of the event handler.
+    EventHandler* Clone() const override
+    {
+        return new TypedEventHandler11Impl(function_, userData_);
+    }
+
+private:
+    /// Handler function.
+    std::function<void(const U&)> function_;
+};
+
+template <class T, class U> void Object::SubscribeToEvent(StringHash eventType, void (T::*function)(const U&))
+{
+    SubscribeToEvent(eventType, new TypedEventHandlerImpl<T, U>(static_cast<T*>(this), function));
+}
+
+template <class T, class U> void Object::SubscribeToEvent(Object* sender, StringHash eventType, void (T::*function)(const U&))
+{
+    SubscribeToEvent(sender, eventType, new TypedEventHandlerImpl<T, U>(static_cast<T*>(this), function));
+}
+
+template <class U> void Object::SubscribeToEvent(StringHash eventType, const std::function<void(const U&)>& function, void* userData)
+{
+    SubscribeToEvent(eventType, new TypedEventHandler11Impl<U>(function, userData));
+}
+
+template <class U> void Object::SubscribeToEvent(Object* sender, StringHash eventType, const std::function<void(const U&)>& function, void* userData)
+{
+    SubscribeToEvent(sender, eventType, new TypedEventHandler11Impl<U>(function, userData));
+}
+
+template <class T> void Object::SendTypedEvent(StringHash eventType, const T& data)
+{
+    EventPayload payload(context_, data);
+    SendEvent(eventType, payload);
+}
+
 /// Get register of event names.
 URHO3D_API StringHashRegister& GetEventNameRegister();
 
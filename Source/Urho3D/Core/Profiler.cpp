@@ -30,9 +30,138 @@
 #endif
 #include "Profiler.h"
 
+#include <EASTL/unique_ptr.h>
+#include <cstring>
+
+#include "../Core/Mutex.h"
+#include "../Core/StringUtils.h"
+#include "../Core/Timer.h"
+
 namespace Urho3D
 {
 
+/// Capacity of the per-thread block buffers. Must be a power of two.
+static const unsigned PROFILER_BUFFER_SIZE = 16384;
+
+/// Per-thread profiler state. Finished blocks are passed to the reader through a single-producer single-consumer ring buffer, so recording takes no locks.
+struct ProfilerThread
+{
+    /// Thread name.
+    ea::string name_;
+    /// Root of the block hierarchy.
+    ProfilerNode root_;
+    /// Innermost block in progress.
+    ProfilerNode* current_{};
+    /// Block storage.
+    ea::vector<ea::unique_ptr<ProfilerNode> > nodes_;
+    /// Finished blocks. Allocated when the thread finishes its first block.
+    ea::unique_ptr<ProfilerRecord[]> records_;
+    /// Number of blocks written. Advanced by the owning thread.
+    std::atomic<unsigned> writeIndex_{};
+    /// Number of blocks read. Advanced by the reader.
+    std::atomic<unsigned> readIndex_{};
+    /// Number of blocks dropped because the buffer was full.
+    std::atomic<unsigned> numDropped_{};
+};
+
+/// Threads that have recorded blocks. Kept until exit, as blocks refer to them.
+struct ProfilerThreadRegistry
+{
+    /// Lock for registering threads and reading.
+    Mutex mutex_;
+    /// Threads.
+    ea::vector<ea::unique_ptr<ProfilerThread> > threads_;
+};
+
+std::atomic<bool> ProfilerScope::recording_{};
+
+static ProfilerThreadRegistry& GetProfilerThreadRegistry()
+{
+    static ProfilerThreadRegistry registry;
+    return registry;
+}
+
+static thread_local ProfilerThread* currentProfilerThread = nullptr;
+
+static ProfilerThread* GetCurrentProfilerThread()
+{
+    if (!currentProfilerThread)
+    {
+        ProfilerThreadRegistry& registry = GetProfilerThreadRegistry();
+        MutexLock lock(registry.mutex_);
+        auto thread = ea::make_unique<ProfilerThread>();
+        thread->root_.thread_ = thread.get();
+        thread->root_.threadIndex_ = registry.threads_.size();
+        thread->current_ = &thread->root_;
+        thread->name_ = "Thread " + ea::to_string(registry.threads_.size());
+        currentProfilerThread = thread.get();
+        registry.threads_.push_back(ea::move(thread));
+    }
+    return currentProfilerThread;
+}
+
+void ProfilerScope::Begin(const char* name)
+{
+    ProfilerThread* thread = GetCurrentProfilerThread();
+    ProfilerNode* parent = thread->current_;
+
+    // Names are usually literals, so compare pointers first
+    ProfilerNode* node = nullptr;
+    for (ProfilerNode* child : parent->children_)
+    {
+        if (child->name_ == name)
+        {
+            node = child;
+            break;
+        }
+    }
+    if (!node)
+    {
+        for (ProfilerNode* child : parent->children_)
+        {
+            if (!strcmp(child->name_, name))
+            {
+                node = child;
+                break;
+            }
+        }
+    }
+    if (!node)
+    {
+        thread->nodes_.push_back(ea::make_unique<ProfilerNode>());
+        node = thread->nodes_.back().get();
+        node->name_ = name;
+        node->parent_ = parent;
+        node->thread_ = thread;
+        node->threadIndex_ = parent->threadIndex_;
+        node->depth_ = parent == &thread->root_ ? 0 : parent->depth_ + 1;
+        parent->children_.push_back(node);
+    }
+
+    thread->current_ = node;
+    node_ = node;
+    startTime_ = HiresTimer::GetTick();
+}
+
+void ProfilerScope::End()
+{
+    const long long endTime = HiresTimer::GetTick();
+    ProfilerThread* thread = node_->thread_;
+    thread->current_ = node_->parent_;
+
+    const unsigned writeIndex = thread->writeIndex_.load(std::memory_order_relaxed);
+    if (writeIndex - thread->readIndex_.load(std::memory_order_acquire) >= PROFILER_BUFFER_SIZE)
+    {
+        thread->numDropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (!thread->records_)
+        thread->records_.reset(new ProfilerRecord[PROFILER_BUFFER_SIZE]);
+    thread->records_[writeIndex & (PROFILER_BUFFER_SIZE - 1)] = {node_, startTime_, endTime};
+    thread->writeIndex_.store(writeIndex + 1, std::memory_order_release);
+}
+
 void SetProfilerThreadName(const char* name)
 {
 #if URHO3D_PROFILING
@@ -44,6 +173,35 @@ void SetProfilerThreadName(const char* name)
 #endif
 
 #endif
+
+    ProfilerThread* thread = GetCurrentProfilerThread();
+    MutexLock lock(GetProfilerThreadRegistry().mutex_);
+    thread->name_ = name;
+}
+
+ea::string GetProfilerThreadName(unsigned threadIndex)
+{
+    ProfilerThreadRegistry& registry = GetProfilerThreadRegistry();
+    MutexLock lock(registry.mutex_);
+    return threadIndex < registry.threads_.size() ? registry.threads_[threadIndex]->name_ : EMPTY_STRING;
+}
+
+unsigned ReadProfilerRecords(ea::vector<ProfilerRecord>& dest)
+{
+    ProfilerThreadRegistry& registry = GetProfilerThreadRegistry();
+    MutexLock lock(registry.mutex_);
+
+    unsigned numDropped = 0;
+    for (const auto& thread : registry.threads_)
+    {
+        const unsigned readIndex = thread->readIndex_.load(std::memory_order_relaxed);
+        const unsigned writeIndex = thread->writeIndex_.load(std::memory_order_acquire);
+        for (unsigned i = readIndex; i != writeIndex; ++i)
+            dest.push_back(thread->records_[i & (PROFILER_BUFFER_SIZE - 1)]);
+        thread->readIndex_.store(writeIndex, std::memory_order_release);
+        numDropped += thread->numDropped_.exchange(0, std::memory_order_relaxed);
+    }
+    return numDropped;
 }
 
 }
@@ -22,6 +22,18 @@
 
 #pragma once
 
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+#include <atomic>
+
+#include "../Core/Macros.h"
+
 #if URHO3D_PROFILING
 #   include "ThirdParty/tracy/Tracy.hpp"
 #endif
@@ -32,27 +44,106 @@ namespace Urho3D
 static const unsigned PROFILER_COLOR_EVENTS = 0xb26d19;
 static const unsigned PROFILER_COLOR_RESOURCES = 0x006b82;
 
-void SetProfilerThreadName(const char* name);
+struct ProfilerThread;
+
+/// Node of the block hierarchy of one thread. Created by the owning thread, name and parent never change afterwards.
+struct URHO3D_API ProfilerNode
+{
+    /// Block name. Must have static storage duration.
+    const char* name_{};
+    /// Parent block, or the thread root.
+    ProfilerNode* parent_{};
+    /// Owning thread.
+    ProfilerThread* thread_{};
+    /// Index of the owning thread in the order threads started recording.
+    unsigned threadIndex_{};
+    /// Depth in the hierarchy, 0 for the top level blocks of a thread.
+    unsigned depth_{};
+    /// Child blocks. Accessed by the owning thread only.
+    ea::vector<ProfilerNode*> children_;
+};
+
+/// Finished block read from the profiler thread buffers.
+struct ProfilerRecord
+{
+    /// Block.
+    const ProfilerNode* node_;
+    /// Start time in high-resolution timer ticks.
+    long long startTime_;
+    /// End time in high-resolution timer ticks.
+    long long endTime_;
+};
+
+/// Scoped timing of a built-in profiler block. Records nothing while the profiler is disabled, so scopes may stay in production code.
+class URHO3D_API ProfilerScope
+{
+public:
+    /// Construct and begin the block if recording. Name must have static storage duration.
+    explicit ProfilerScope(const char* name)
+    {
+        if (URHO3D_UNLIKELY(recording_.load(std::memory_order_relaxed)))
+            Begin(name);
+    }
+    /// Destruct and finish the block.
+    ~ProfilerScope()
+    {
+        if (URHO3D_UNLIKELY(node_ != nullptr))
+            End();
+    }
+    /// Prevent copy construction.
+    ProfilerScope(const ProfilerScope& rhs) = delete;
+    /// Prevent assignment.
+    ProfilerScope& operator =(const ProfilerScope& rhs) = delete;
+
+    /// Set whether blocks are recorded on all threads.
+    static void SetRecording(bool enable) { recording_.store(enable, std::memory_order_relaxed); }
+    /// Return whether blocks are recorded.
+    static bool IsRecording() { return recording_.load(std::memory_order_relaxed); }
+
+private:
+    /// Begin the block on the calling thread.
+    void Begin(const char* name);
+    /// Finish the block and pass it to the reader.
+    void End();
+
+    /// Block being timed, or null if not recording.
+    ProfilerNode* node_{};
+    /// Start time in high-resolution timer ticks.
+    long long startTime_{};
+
+    /// Recording flag.
+    static std::atomic<bool> recording_;
+};
+
+/// Set name of the calling thread for the profilers.
+URHO3D_API void SetProfilerThreadName(const char* name);
+/// Return name of a thread that has recorded profiler blocks.
+URHO3D_API ea::string GetProfilerThreadName(unsigned threadIndex);
+/// Move the blocks finished on all threads since the last call to the destination. Blocks of each thread are in the order they finished. Return the number of blocks dropped because a thread buffer was full. Only one thread may read at a time.
+URHO3D_API unsigned ReadProfilerRecords(ea::vector<ProfilerRecord>& dest);
 
 }
 
+#define URHO3D_PROFILE_CONCAT_IMPL(a, b) a##b
+#define URHO3D_PROFILE_CONCAT(a, b) URHO3D_PROFILE_CONCAT_IMPL(a, b)
+#define URHO3D_PROFILE_SCOPE(name) Urho3D::ProfilerScope URHO3D_PROFILE_CONCAT(profilerScope, __LINE__)(name)
+
 #if URHO3D_PROFILING
-#   define URHO3D_PROFILE_FUNCTION()              ZoneScopedN(__FUNCTION__)
-#   define URHO3D_PROFILE_C(name, color)          ZoneScopedNC(name, color)
-#   define URHO3D_PROFILE(name)                   ZoneScopedN(name)
-#   define URHO3D_PROFILE_THREAD(name)            SetProfilerThreadName(name)
+#   define URHO3D_PROFILE_FUNCTION()              ZoneScopedN(__FUNCTION__); URHO3D_PROFILE_SCOPE(__FUNCTION__)
+#   define URHO3D_PROFILE_C(name, color)          ZoneScopedNC(name, color); URHO3D_PROFILE_SCOPE(name)
+#   define URHO3D_PROFILE(name)                   ZoneScopedN(name); URHO3D_PROFILE_SCOPE(name)
+#   define URHO3D_PROFILE_THREAD(name)            Urho3D::SetProfilerThreadName(name)
 #   define URHO3D_PROFILE_VALUE(name, value)      TracyPlot(name, value)
 #   define URHO3D_PROFILE_FRAME()                 FrameMark
 #   define URHO3D_PROFILE_MESSAGE(txt, len)       TracyMessage(txt, len)
 #   define URHO3D_PROFILE_ZONENAME(txt, len)      ZoneName(txt, len)
 #else
-#   define URHO3D_PROFILE_FUNCTION()
-#   define URHO3D_PROFILE_C(...)
-#   define URHO3D_PROFILE(...)
-#   define URHO3D_PROFILE_THREAD(...)
+#   define URHO3D_PROFILE_FUNCTION()              URHO3D_PROFILE_SCOPE(__FUNCTION__)
+#   define URHO3D_PROFILE_C(name, color)          URHO3D_PROFILE_SCOPE(name)
+#   define URHO3D_PROFILE(name)                   URHO3D_PROFILE_SCOPE(name)
+#   define URHO3D_PROFILE_THREAD(name)            Urho3D::SetProfilerThreadName(name)
 #   define URHO3D_PROFILE_VALUE(...)
 #   define URHO3D_PROFILE_FRAME()
 #   define URHO3D_PROFILE_MESSAGE(txt, len)
 #   define URHO3D_PROFILE_ZONENAME(txt, len)
 #endif
-
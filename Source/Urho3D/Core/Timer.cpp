@@ -247,4 +247,9 @@ void HiresTimer::Reset()
     startTime_ = HiresTick();
 }
 
+long long HiresTimer::GetTick()
+{
+    return HiresTick();
+}
+
 }
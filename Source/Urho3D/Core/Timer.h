@@ -62,6 +62,8 @@ public:
 
     /// Return if high-resolution timer is supported.
     static bool IsSupported() { return supported; }
+    /// Return current value of the high-resolution clock in ticks of GetFrequency().
+    static long long GetTick();
 
     /// Return high-resolution timer frequency if supported.
     static long long GetFrequency() { return frequency; }
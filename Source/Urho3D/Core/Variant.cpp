@@ -93,23 +93,23 @@ Variant& Variant::operator =(const Variant& rhs)
         break;
 
     case VAR_BUFFER:
-        value_.buffer_ = rhs.value_.buffer_;
+        *value_.buffer_ = *rhs.value_.buffer_;
         break;
 
     case VAR_RESOURCEREF:
-        value_.resourceRef_ = rhs.value_.resourceRef_;
+        *value_.resourceRef_ = *rhs.value_.resourceRef_;
         break;
 
     case VAR_RESOURCEREFLIST:
-        value_.resourceRefList_ = rhs.value_.resourceRefList_;
+        *value_.resourceRefList_ = *rhs.value_.resourceRefList_;
         break;
 
     case VAR_VARIANTVECTOR:
-        value_.variantVector_ = rhs.value_.variantVector_;
+        *value_.variantVector_ = *rhs.value_.variantVector_;
         break;
 
     case VAR_STRINGVECTOR:
-        value_.stringVector_ = rhs.value_.stringVector_;
+        *value_.stringVector_ = *rhs.value_.stringVector_;
         break;
 
     case VAR_VARIANTMAP:
@@ -140,10 +140,40 @@ Variant& Variant::operator =(const Variant& rhs)
     return *this;
 }
 
+Variant& Variant::operator =(Variant&& rhs) noexcept
+{
+    if (&rhs == this)
+        return *this;
+
+    switch (rhs.type_)
+    {
+    case VAR_STRING:
+        *this = ea::move(rhs.value_.string_);
+        break;
+
+    case VAR_PTR:
+    case VAR_CUSTOM_STACK:
+        // Inline objects which are not safe to relocate bytewise
+        *this = static_cast<const Variant&>(rhs);
+        break;
+
+    default:
+        // Plain values and heap-allocated objects: take over the storage without copying
+        SetType(VAR_NONE);
+        memcpy(&value_, &rhs.value_, sizeof(VariantValue));     // NOLINT(bugprone-undefined-memory-manipulation)
+        type_ = rhs.type_;
+        rhs.type_ = VAR_NONE;
+        return *this;
+    }
+
+    rhs.SetType(VAR_NONE);
+    return *this;
+}
+
 Variant& Variant::operator =(const VectorBuffer& rhs)
 {
     SetType(VAR_BUFFER);
-    value_.buffer_ = rhs.GetBuffer();
+    *value_.buffer_ = rhs.GetBuffer();
     return *this;
 }
 
@@ -189,19 +219,19 @@ bool Variant::operator ==(const Variant& rhs) const
         return value_.string_ == rhs.value_.string_;
 
     case VAR_BUFFER:
-        return value_.buffer_ == rhs.value_.buffer_;
+        return *value_.buffer_ == *rhs.value_.buffer_;
 
     case VAR_RESOURCEREF:
-        return value_.resourceRef_ == rhs.value_.resourceRef_;
+        return *value_.resourceRef_ == *rhs.value_.resourceRef_;
 
     case VAR_RESOURCEREFLIST:
-        return value_.resourceRefList_ == rhs.value_.resourceRefList_;
+        return *value_.resourceRefList_ == *rhs.value_.resourceRefList_;
 
     case VAR_VARIANTVECTOR:
-        return value_.variantVector_ == rhs.value_.variantVector_;
+        return *value_.variantVector_ == *rhs.value_.variantVector_;
 
     case VAR_STRINGVECTOR:
-        return value_.stringVector_ == rhs.value_.stringVector_;
+        return *value_.stringVector_ == *rhs.value_.stringVector_;
 
     case VAR_VARIANTMAP:
         return *value_.variantMap_ == *rhs.value_.variantMap_;
@@ -238,7 +268,7 @@ bool Variant::operator ==(const Variant& rhs) const
 bool Variant::operator ==(const ea::vector<unsigned char>& rhs) const
 {
     // Use strncmp() instead of ea::vector<unsigned char>::operator ==()
-    const ea::vector<unsigned char>& buffer = value_.buffer_;
+    const ea::vector<unsigned char>& buffer = GetBuffer();
     return type_ == VAR_BUFFER && buffer.size() == rhs.size() ?
         strncmp(reinterpret_cast<const char*>(&buffer[0]), reinterpret_cast<const char*>(&rhs[0]), buffer.size()) == 0 :
         false;
@@ -246,7 +276,7 @@ bool Variant::operator ==(const ea::vector<unsigned char>& rhs) const
 
 bool Variant::operator ==(const VectorBuffer& rhs) const
 {
-    const ea::vector<unsigned char>& buffer = value_.buffer_;
+    const ea::vector<unsigned char>& buffer = GetBuffer();
     return type_ == VAR_BUFFER && buffer.size() == rhs.GetSize() ?
         strncmp(reinterpret_cast<const char*>(&buffer[0]), reinterpret_cast<const char*>(rhs.GetData()), buffer.size()) == 0 :
         false;
@@ -403,7 +433,7 @@ void Variant::FromString(VariantType type, const char* value)
 
     case VAR_BUFFER:
         SetType(VAR_BUFFER);
-        StringToBuffer(value_.buffer_, value);
+        StringToBuffer(*value_.buffer_, value);
         break;
 
     case VAR_VOIDPTR:
@@ -417,8 +447,8 @@ void Variant::FromString(VariantType type, const char* value)
         if (values.size() == 2)
         {
             SetType(VAR_RESOURCEREF);
-            value_.resourceRef_.type_ = values[0];
-            value_.resourceRef_.name_ = values[1];
+            value_.resourceRef_->type_ = values[0];
+            value_.resourceRef_->name_ = values[1];
         }
         break;
     }
@@ -429,10 +459,10 @@ void Variant::FromString(VariantType type, const char* value)
         if (values.size() >= 1)
         {
             SetType(VAR_RESOURCEREFLIST);
-            value_.resourceRefList_.type_ = values[0];
-            value_.resourceRefList_.names_.resize(values.size() - 1);
+            value_.resourceRefList_->type_ = values[0];
+            value_.resourceRefList_->names_.resize(values.size() - 1);
             for (unsigned i = 1; i < values.size(); ++i)
-                value_.resourceRefList_.names_[i - 1] = values[i];
+                value_.resourceRefList_->names_[i - 1] = values[i];
         }
         break;
     }
@@ -485,7 +515,7 @@ void Variant::SetBuffer(const void* data, unsigned size)
         size = 0;
 
     SetType(VAR_BUFFER);
-    ea::vector<unsigned char>& buffer = value_.buffer_;
+    ea::vector<unsigned char>& buffer = *value_.buffer_;
     buffer.resize(size);
     if (size)
         memcpy(&buffer[0], data, size);
@@ -519,7 +549,7 @@ void Variant::SetCustomVariantValue(const CustomVariantValue& value)
 
 VectorBuffer Variant::GetVectorBuffer() const
 {
-    return VectorBuffer(type_ == VAR_BUFFER ? value_.buffer_ : emptyBuffer);
+    return VectorBuffer(type_ == VAR_BUFFER ? *value_.buffer_ : emptyBuffer);
 }
 
 ea::string Variant::GetTypeName() const
@@ -563,7 +593,7 @@ ea::string Variant::ToString() const
 
     case VAR_BUFFER:
         {
-            const ea::vector<unsigned char>& buffer = value_.buffer_;
+            const ea::vector<unsigned char>& buffer = *value_.buffer_;
             ea::string ret;
             BufferToString(ret, buffer.data(), buffer.size());
             return ret;
@@ -646,17 +676,17 @@ bool Variant::IsZero() const
         return value_.string_.empty();
 
     case VAR_BUFFER:
-        return value_.buffer_.empty();
+        return value_.buffer_->empty();
 
     case VAR_VOIDPTR:
         return value_.voidPtr_ == nullptr;
 
     case VAR_RESOURCEREF:
-        return value_.resourceRef_.name_.empty();
+        return value_.resourceRef_->name_.empty();
 
     case VAR_RESOURCEREFLIST:
     {
-        const StringVector& names = value_.resourceRefList_.names_;
+        const StringVector& names = value_.resourceRefList_->names_;
         for (auto i = names.begin(); i != names.end(); ++i)
         {
             if (!i->empty())
@@ -666,10 +696,10 @@ bool Variant::IsZero() const
     }
 
     case VAR_VARIANTVECTOR:
-        return value_.variantVector_.empty();
+        return value_.variantVector_->empty();
 
     case VAR_STRINGVECTOR:
-        return value_.stringVector_.empty();
+        return value_.stringVector_->empty();
 
     case VAR_VARIANTMAP:
         return value_.variantMap_->empty();
@@ -722,23 +752,23 @@ void Variant::SetType(VariantType newType)
         break;
 
     case VAR_BUFFER:
-        value_.buffer_.~vector<unsigned char>();
+        delete value_.buffer_;
         break;
 
     case VAR_RESOURCEREF:
-        value_.resourceRef_.~ResourceRef();
+        delete value_.resourceRef_;
         break;
 
     case VAR_RESOURCEREFLIST:
-        value_.resourceRefList_.~ResourceRefList();
+        delete value_.resourceRefList_;
         break;
 
     case VAR_VARIANTVECTOR:
-        value_.variantVector_.~VariantVector();
+        delete value_.variantVector_;
         break;
 
     case VAR_STRINGVECTOR:
-        value_.stringVector_.~StringVector();
+        delete value_.stringVector_;
         break;
 
     case VAR_VARIANTMAP:
@@ -782,23 +812,23 @@ void Variant::SetType(VariantType newType)
         break;
 
     case VAR_BUFFER:
-        new(&value_.buffer_) ea::vector<unsigned char>();
+        value_.buffer_ = new ea::vector<unsigned char>();
         break;
 
     case VAR_RESOURCEREF:
-        new(&value_.resourceRef_) ResourceRef();
+        value_.resourceRef_ = new ResourceRef();
         break;
 
     case VAR_RESOURCEREFLIST:
-        new(&value_.resourceRefList_) ResourceRefList();
+        value_.resourceRefList_ = new ResourceRefList();
         break;
 
     case VAR_VARIANTVECTOR:
-        new(&value_.variantVector_) VariantVector();
+        value_.variantVector_ = new VariantVector();
         break;
 
     case VAR_STRINGVECTOR:
-        new(&value_.stringVector_) StringVector();
+        value_.stringVector_ = new StringVector();
         break;
 
     case VAR_VARIANTMAP:
@@ -274,10 +274,10 @@ private:
 /// Make custom variant value.
 template <typename T> CustomVariantValueImpl<T> MakeCustomValue(const T& value) { return CustomVariantValueImpl<T>(value); }
 
-/// Size of variant value. 16 bytes on 32-bit platform, 32 bytes on 64-bit platform.
-static const unsigned VARIANT_VALUE_SIZE = sizeof(void*) * 4;
+/// Size of variant value. Fits the 4-component math types, short strings and WeakPtr inline on all platforms.
+static const unsigned VARIANT_VALUE_SIZE = 16;
 
-/// Union for the possible variant values. Objects exceeding the VARIANT_VALUE_SIZE are allocated on the heap.
+/// Union for the possible variant values. Objects exceeding the VARIANT_VALUE_SIZE are allocated on the heap, strings rely on their own small buffer.
 union VariantValue
 {
     unsigned char storage_[VARIANT_VALUE_SIZE];
@@ -301,12 +301,12 @@ union VariantValue
     Quaternion quaternion_;
     Color color_;
     ea::string string_;
-    StringVector stringVector_;
-    VariantVector variantVector_;
+    StringVector* stringVector_;
+    VariantVector* variantVector_;
     VariantMap* variantMap_;
-    ea::vector<unsigned char> buffer_;
-    ResourceRef resourceRef_;
-    ResourceRefList resourceRefList_;
+    ea::vector<unsigned char>* buffer_;
+    ResourceRef* resourceRef_;
+    ResourceRefList* resourceRefList_;
     CustomVariantValue* customValueHeap_;
     CustomVariantValue customValueStack_;
 
@@ -318,7 +318,7 @@ union VariantValue
     ~VariantValue() { }     // NOLINT(modernize-use-equals-default)
 };
 
-// TODO: static_assert(sizeof(VariantValue) == VARIANT_VALUE_SIZE, "Unexpected size of VariantValue");
+static_assert(sizeof(VariantValue) == VARIANT_VALUE_SIZE, "Unexpected size of VariantValue");
 
 /// Variable that supports a fixed set of types.
 class URHO3D_API Variant
@@ -411,6 +411,12 @@ public:
         *this = value;
     }
 
+    /// Construct from a string, taking over its contents.
+    Variant(ea::string&& value)             // NOLINT(google-explicit-constructor)
+    {
+        *this = ea::move(value);
+    }
+
     /// Construct from a C string.
     Variant(const char* value)          // NOLINT(google-explicit-constructor)
     {
@@ -423,6 +429,12 @@ public:
         *this = value;
     }
 
+    /// Construct from a buffer, taking over its contents.
+    Variant(ea::vector<unsigned char>&& value)           // NOLINT(google-explicit-constructor)
+    {
+        *this = ea::move(value);
+    }
+
     /// Construct from a %VectorBuffer and store as a buffer.
     Variant(const VectorBuffer& value)  // NOLINT(google-explicit-constructor)
     {
@@ -453,18 +465,36 @@ public:
         *this = value;
     }
 
+    /// Construct from a variant vector, taking over its contents.
+    Variant(VariantVector&& value)      // NOLINT(google-explicit-constructor)
+    {
+        *this = ea::move(value);
+    }
+
     /// Construct from a variant map.
     Variant(const VariantMap& value)    // NOLINT(google-explicit-constructor)
     {
         *this = value;
     }
 
+    /// Construct from a variant map, taking over its contents.
+    Variant(VariantMap&& value)         // NOLINT(google-explicit-constructor)
+    {
+        *this = ea::move(value);
+    }
+
     /// Construct from a string vector.
     Variant(const StringVector& value)  // NOLINT(google-explicit-constructor)
     {
         *this = value;
     }
 
+    /// Construct from a string vector, taking over its contents.
+    Variant(StringVector&& value)       // NOLINT(google-explicit-constructor)
+    {
+        *this = ea::move(value);
+    }
+
     /// Construct from a rect.
     Variant(const Rect& value)          // NOLINT(google-explicit-constructor)
     {
@@ -553,6 +583,12 @@ public:
         *this = value;
     }
 
+    /// Move-construct from another variant. The other variant is left empty.
+    Variant(Variant&& value) noexcept
+    {
+        *this = ea::move(value);
+    }
+
     /// Destruct.
     ~Variant()
     {
@@ -568,6 +604,9 @@ public:
     /// Assign from another variant.
     Variant& operator =(const Variant& rhs);
 
+    /// Move-assign from another variant. The other variant is left empty.
+    Variant& operator =(Variant&& rhs) noexcept;
+
     /// Assign from an integer.
     Variant& operator =(int rhs)
     {
@@ -680,6 +719,14 @@ public:
         return *this;
     }
 
+    /// Assign from a string, taking over its contents.
+    Variant& operator =(ea::string&& rhs)
+    {
+        SetType(VAR_STRING);
+        value_.string_ = ea::move(rhs);
+        return *this;
+    }
+
     /// Assign from a C string.
     Variant& operator =(const char* rhs)
     {
@@ -692,7 +739,15 @@ public:
     Variant& operator =(const ea::vector<unsigned char>& rhs)
     {
         SetType(VAR_BUFFER);
-        value_.buffer_ = rhs;
+        *value_.buffer_ = rhs;
+        return *this;
+    }
+
+    /// Assign from a buffer, taking over its contents.
+    Variant& operator =(ea::vector<unsigned char>&& rhs)
+    {
+        SetType(VAR_BUFFER);
+        *value_.buffer_ = ea::move(rhs);
         return *this;
     }
 
@@ -711,7 +766,7 @@ public:
     Variant& operator =(const ResourceRef& rhs)
     {
         SetType(VAR_RESOURCEREF);
-        value_.resourceRef_ = rhs;
+        *value_.resourceRef_ = rhs;
         return *this;
     }
 
@@ -719,7 +774,7 @@ public:
     Variant& operator =(const ResourceRefList& rhs)
     {
         SetType(VAR_RESOURCEREFLIST);
-        value_.resourceRefList_ = rhs;
+        *value_.resourceRefList_ = rhs;
         return *this;
     }
 
@@ -727,7 +782,15 @@ public:
     Variant& operator =(const VariantVector& rhs)
     {
         SetType(VAR_VARIANTVECTOR);
-        value_.variantVector_ = rhs;
+        *value_.variantVector_ = rhs;
+        return *this;
+    }
+
+    /// Assign from a variant vector, taking over its contents.
+    Variant& operator =(VariantVector&& rhs)
+    {
+        SetType(VAR_VARIANTVECTOR);
+        *value_.variantVector_ = ea::move(rhs);
         return *this;
     }
 
@@ -735,7 +798,15 @@ public:
     Variant& operator =(const StringVector& rhs)
     {
         SetType(VAR_STRINGVECTOR);
-        value_.stringVector_ = rhs;
+        *value_.stringVector_ = rhs;
+        return *this;
+    }
+
+    /// Assign from a string vector, taking over its contents.
+    Variant& operator =(StringVector&& rhs)
+    {
+        SetType(VAR_STRINGVECTOR);
+        *value_.stringVector_ = ea::move(rhs);
         return *this;
     }
 
@@ -747,6 +818,14 @@ public:
         return *this;
     }
 
+    /// Assign from a variant map, taking over its contents.
+    Variant& operator =(VariantMap&& rhs)
+    {
+        SetType(VAR_VARIANTMAP);
+        *value_.variantMap_ = ea::move(rhs);
+        return *this;
+    }
+
     /// Assign from a rect.
     Variant& operator =(const Rect& rhs)
     {
@@ -898,25 +977,25 @@ public:
     /// Test for equality with a resource reference. To return true, both the type and value must match.
     bool operator ==(const ResourceRef& rhs) const
     {
-        return type_ == VAR_RESOURCEREF ? value_.resourceRef_ == rhs : false;
+        return type_ == VAR_RESOURCEREF ? *value_.resourceRef_ == rhs : false;
     }
 
     /// Test for equality with a resource reference list. To return true, both the type and value must match.
     bool operator ==(const ResourceRefList& rhs) const
     {
-        return type_ == VAR_RESOURCEREFLIST ? value_.resourceRefList_ == rhs : false;
+        return type_ == VAR_RESOURCEREFLIST ? *value_.resourceRefList_ == rhs : false;
     }
 
     /// Test for equality with a variant vector. To return true, both the type and value must match.
     bool operator ==(const VariantVector& rhs) const
     {
-        return type_ == VAR_VARIANTVECTOR ? value_.variantVector_ == rhs : false;
+        return type_ == VAR_VARIANTVECTOR ? *value_.variantVector_ == rhs : false;
     }
 
     /// Test for equality with a string vector. To return true, both the type and value must match.
     bool operator ==(const StringVector& rhs) const
     {
-        return type_ == VAR_STRINGVECTOR ? value_.stringVector_ == rhs : false;
+        return type_ == VAR_STRINGVECTOR ? *value_.stringVector_ == rhs : false;
     }
 
     /// Test for equality with a variant map. To return true, both the type and value must match.
@@ -1202,7 +1281,7 @@ public:
     /// Return buffer or empty on type mismatch.
     const ea::vector<unsigned char>& GetBuffer() const
     {
-        return type_ == VAR_BUFFER ? value_.buffer_ : emptyBuffer;
+        return type_ == VAR_BUFFER ? *value_.buffer_ : emptyBuffer;
     }
 
     /// Return %VectorBuffer containing the buffer or empty on type mismatch.
@@ -1222,25 +1301,25 @@ public:
     /// Return a resource reference or empty on type mismatch.
     const ResourceRef& GetResourceRef() const
     {
-        return type_ == VAR_RESOURCEREF ? value_.resourceRef_ : emptyResourceRef;
+        return type_ == VAR_RESOURCEREF ? *value_.resourceRef_ : emptyResourceRef;
     }
 
     /// Return a resource reference list or empty on type mismatch.
     const ResourceRefList& GetResourceRefList() const
     {
-        return type_ == VAR_RESOURCEREFLIST ? value_.resourceRefList_ : emptyResourceRefList;
+        return type_ == VAR_RESOURCEREFLIST ? *value_.resourceRefList_ : emptyResourceRefList;
     }
 
     /// Return a variant vector or empty on type mismatch.
     const VariantVector& GetVariantVector() const
     {
-        return type_ == VAR_VARIANTVECTOR ? value_.variantVector_ : emptyVariantVector;
+        return type_ == VAR_VARIANTVECTOR ? *value_.variantVector_ : emptyVariantVector;
     }
 
     /// Return a string vector or empty on type mismatch.
     const StringVector& GetStringVector() const
     {
-        return type_ == VAR_STRINGVECTOR ? value_.stringVector_ : emptyStringVector;
+        return type_ == VAR_STRINGVECTOR ? *value_.stringVector_ : emptyStringVector;
     }
 
     /// Return a variant map or empty on type mismatch.
@@ -1350,14 +1429,14 @@ public:
     /// Return a pointer to a modifiable buffer or null on type mismatch.
     ea::vector<unsigned char>* GetBufferPtr()
     {
-        return type_ == VAR_BUFFER ? &value_.buffer_ : nullptr;
+        return type_ == VAR_BUFFER ? value_.buffer_ : nullptr;
     }
 
     /// Return a pointer to a modifiable variant vector or null on type mismatch.
-    VariantVector* GetVariantVectorPtr() { return type_ == VAR_VARIANTVECTOR ? &value_.variantVector_ : nullptr; }
+    VariantVector* GetVariantVectorPtr() { return type_ == VAR_VARIANTVECTOR ? value_.variantVector_ : nullptr; }
 
     /// Return a pointer to a modifiable string vector or null on type mismatch.
-    StringVector* GetStringVectorPtr() { return type_ == VAR_STRINGVECTOR ? &value_.stringVector_ : nullptr; }
+    StringVector* GetStringVectorPtr() { return type_ == VAR_STRINGVECTOR ? value_.stringVector_ : nullptr; }
 
     /// Return a pointer to a modifiable variant map or null on type mismatch.
     VariantMap* GetVariantMapPtr() { return type_ == VAR_VARIANTMAP ? value_.variantMap_ : nullptr; }
@@ -22,6 +22,9 @@
 
 #include "../Precompiled.h"
 
+#include <EASTL/deque.h>
+
+#include "../Container/Allocator.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
@@ -33,6 +36,79 @@
 namespace Urho3D
 {
 
+static const unsigned FRAME_TASK_ARENA_BLOCK_SIZE = 64 * 1024;
+static const unsigned MAX_PARALLEL_FOR_HELPERS = 64;
+
+namespace
+{
+
+/// Index of the current thread in the work queue.
+thread_local unsigned currentThreadIndex = M_MAX_UNSIGNED;
+
+/// Shared state of a single ParallelFor call.
+struct ParallelForContext
+{
+    /// Process chunks until none remain.
+    void ProcessChunks(unsigned threadIndex)
+    {
+        for (;;)
+        {
+            const unsigned chunk = nextChunk_.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= numChunks_)
+                break;
+
+            const unsigned chunkBegin = begin_ + chunk * grainSize_;
+            const unsigned chunkEnd = Min(chunkBegin + grainSize_, end_);
+            (*function_)(chunkBegin, chunkEnd, threadIndex);
+        }
+    }
+
+    /// Function to call.
+    const ParallelForFunction* function_{};
+    /// Beginning of the index range.
+    unsigned begin_{};
+    /// End of the index range.
+    unsigned end_{};
+    /// Max number of indices per chunk.
+    unsigned grainSize_{};
+    /// Number of chunks.
+    unsigned numChunks_{};
+    /// Next chunk to process.
+    std::atomic<unsigned> nextChunk_{};
+};
+
+/// Task which processes ParallelFor chunks. Lives on the stack of the calling thread.
+struct ParallelForHelper : public WorkTask
+{
+    /// Construct.
+    ParallelForHelper()
+    {
+        executeFunction_ = [](WorkTask* task, unsigned threadIndex)
+        {
+            static_cast<ParallelForHelper*>(task)->context_->ProcessChunks(threadIndex);
+        };
+    }
+
+    /// ParallelFor state.
+    ParallelForContext* context_{};
+};
+
+}
+
+/// Prioritized queue of tasks owned by one thread. Aligned to avoid false sharing between threads.
+struct alignas(64) WorkerDeque
+{
+    /// Allocate aligned to the cache line. Operator new does not respect the alignment before C++17.
+    static void* operator new(size_t size) { return AllocateAligned(size, alignof(WorkerDeque)); }
+    /// Free memory allocated with the aligned operator new.
+    static void operator delete(void* ptr) { FreeAligned(ptr); }
+
+    /// Lock. Held only for the duration of push or pop.
+    SpinLock lock_;
+    /// Tasks sorted by priority, highest first.
+    ea::deque<WorkTask*> tasks_;
+};
+
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
@@ -47,7 +123,7 @@ public:
     /// Process work items until stopped.
     void ThreadFunction() override
     {
-        URHO3D_PROFILE_THREAD("WorkerThread");
+        URHO3D_PROFILE_THREAD(("WorkerThread " + ea::to_string(index_)).c_str());
         // Init FPU state first
         InitFPU();
         owner_->ProcessItems(index_);
@@ -65,15 +141,23 @@ private:
 
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
+    arenaBlock_(0),
+    arenaOffset_(0),
+    frameTasks_(nullptr),
+    numPendingFrameTasks_(0),
+    numQueued_(0),
+    nextDeque_(0),
     shutDown_(false),
-    pausing_(false),
     paused_(false),
     completing_(false),
-    tolerance_(10),
-    lastSize_(0),
     maxNonThreadedWorkMs_(5)
 {
+    // Work queue is created by the main thread
+    currentThreadIndex = 0;
+    deques_.emplace_back(new WorkerDeque());
+
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(WorkQueue, HandleBeginFrame));
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(WorkQueue, HandleEndFrame));
 }
 
 WorkQueue::~WorkQueue()
@@ -84,6 +168,8 @@ WorkQueue::~WorkQueue()
 
     for (unsigned i = 0; i < threads_.size(); ++i)
         threads_[i]->Stop();
+
+    ReleaseFrameTasks();
 }
 
 void WorkQueue::CreateThreads(unsigned numThreads)
@@ -97,6 +183,10 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
 
+    // Create all queues before any thread may try to steal from them
+    for (unsigned i = 0; i < numThreads; ++i)
+        deques_.emplace_back(new WorkerDeque());
+
     for (unsigned i = 0; i < numThreads; ++i)
     {
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
@@ -111,19 +201,7 @@ void WorkQueue::CreateThreads(unsigned numThreads)
 
 SharedPtr<WorkItem> WorkQueue::GetFreeItem()
 {
-    if (!poolItems_.empty())
-    {
-        SharedPtr<WorkItem> item = poolItems_.front();
-        poolItems_.pop_front();
-        return item;
-    }
-    else
-    {
-        // No usable items found, create a new one set it as pooled and return it.
-        SharedPtr<WorkItem> item(new WorkItem());
-        item->pooled_ = true;
-        return item;
-    }
+    return MakeShared<WorkItem>();
 }
 
 void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
@@ -142,36 +220,12 @@ void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
     workItems_.push_back(item);
     item->completed_ = false;
 
-    // Make sure worker threads' list is safe to modify
-    if (threads_.size() && !paused_)
-        queueMutex_.Acquire();
-
-    // Find position for new item
-    if (queue_.empty())
-        queue_.push_back(item.Get());
-    else
-    {
-        bool inserted = false;
-
-        for (auto i = queue_.begin(); i != queue_.end(); ++i)
-        {
-            if ((*i)->priority_ <= item->priority_)
-            {
-                queue_.insert(i, item.Get());
-                inserted = true;
-                break;
-            }
-        }
-
-        if (!inserted)
-            queue_.push_back(item.Get());
-    }
+    // Queue the item now unless it still waits for dependencies
+    if (item->pendingDependencies_.fetch_sub(1) == 1)
+        QueueTask(item.Get());
 
     if (threads_.size())
-    {
-        queueMutex_.Release();
-        paused_ = false;
-    }
+        Resume();
 }
 
 WorkItem* WorkQueue::AddWorkItem(std::function<void()> workFunction, unsigned priority)
@@ -184,25 +238,113 @@ WorkItem* WorkQueue::AddWorkItem(std::function<void()> workFunction, unsigned pr
     return item;
 }
 
+void WorkQueue::AddTask(WorkTask* task)
+{
+    assert(task && task->frameTask_);
+
+    ++numPendingFrameTasks_;
+    task->completed_ = false;
+
+    if (task->pendingDependencies_.fetch_sub(1) == 1)
+        QueueTask(task);
+
+    if (threads_.size() && GetThreadIndex() == 0)
+        Resume();
+}
+
+void WorkQueue::AddDependency(WorkTask* task, WorkTask* dependency)
+{
+    assert(task && dependency && task != dependency);
+
+    ++task->pendingDependencies_;
+    dependency->continuations_.push_back(task);
+}
+
+void WorkQueue::ParallelFor(unsigned begin, unsigned end, unsigned grainSize, const ParallelForFunction& function)
+{
+    if (begin >= end)
+        return;
+
+    grainSize = Max(grainSize, 1u);
+    const unsigned numChunks = (end - begin + grainSize - 1) / grainSize;
+    const unsigned threadIndex = GetThreadIndex();
+
+    // Execute in the calling thread if there is nothing to split
+    const unsigned numHelpers = Min(Min(numChunks - 1, GetNumThreads()), MAX_PARALLEL_FOR_HELPERS);
+    if (numHelpers == 0)
+    {
+        for (unsigned chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize)
+            function(chunkBegin, Min(chunkBegin + grainSize, end), threadIndex);
+        return;
+    }
+
+    ParallelForContext context;
+    context.function_ = &function;
+    context.begin_ = begin;
+    context.end_ = end;
+    context.grainSize_ = grainSize;
+    context.numChunks_ = numChunks;
+
+    // Helper tasks grab chunks dynamically, so a helper which starts late simply finds no work
+    ParallelForHelper helpers[MAX_PARALLEL_FOR_HELPERS];
+    for (unsigned i = 0; i < numHelpers; ++i)
+    {
+        ParallelForHelper& helper = helpers[i];
+        helper.priority_ = M_MAX_UNSIGNED;
+        helper.context_ = &context;
+        QueueTask(&helper);
+    }
+
+    const bool wasPaused = threadIndex == 0 && paused_;
+    if (wasPaused)
+        Resume();
+
+    // A thread not managed by the queue, such as the audio thread, must not execute unrelated tasks. It processes
+    // chunks itself, then withdraws the helpers that no worker has taken and waits only for the running ones
+    if (threadIndex >= deques_.size())
+    {
+        context.ProcessChunks(threadIndex);
+        for (unsigned i = 0; i < numHelpers; ++i)
+        {
+            if (RemoveQueuedTask(&helpers[i]))
+                continue;
+            while (!helpers[i].completed_)
+                Time::Sleep(0);
+        }
+        return;
+    }
+
+    context.ProcessChunks(threadIndex);
+
+    // Helpers reference the context on the stack, so wait for all of them. Execute them in this thread if not taken yet
+    for (unsigned i = 0; i < numHelpers; ++i)
+    {
+        while (!helpers[i].completed_)
+        {
+            if (WorkTask* task = PopTask(threadIndex, M_MAX_UNSIGNED))
+                ExecuteTask(task, threadIndex);
+        }
+    }
+
+    if (wasPaused && numQueued_ == 0)
+        Pause();
+}
+
 bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
 {
     if (!item)
         return false;
 
-    MutexLock lock(queueMutex_);
+    // Items with continuations can not be removed, as their dependent items would never be queued
+    if (!item->continuations_.empty())
+        return false;
 
     // Can only remove successfully if the item was not yet taken by threads for execution
-    auto i = ea::find(queue_.begin(), queue_.end(), item.Get());
-    if (i != queue_.end())
+    auto j = ea::find(workItems_.begin(), workItems_.end(), item);
+    if (j != workItems_.end() && RemoveQueuedTask(item))
     {
-        auto j = ea::find(workItems_.begin(), workItems_.end(), item);
-        if (j != workItems_.end())
-        {
-            queue_.erase(i);
-            ReturnToPool(item);
-            workItems_.erase(j);
-            return true;
-        }
+        workItems_.erase(j);
+        return true;
     }
 
     return false;
@@ -210,23 +352,12 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
 
 unsigned WorkQueue::RemoveWorkItems(const ea::vector<SharedPtr<WorkItem> >& items)
 {
-    MutexLock lock(queueMutex_);
     unsigned removed = 0;
 
     for (auto i = items.begin(); i != items.end(); ++i)
     {
-        auto j = ea::find(queue_.begin(), queue_.end(), i->Get());
-        if (j != queue_.end())
-        {
-            auto k = ea::find(workItems_.begin(), workItems_.end(), *i);
-            if (k != workItems_.end())
-            {
-                queue_.erase(j);
-                ReturnToPool(*k);
-                workItems_.erase(k);
-                ++removed;
-            }
-        }
+        if (RemoveWorkItem(*i))
+            ++removed;
     }
 
     return removed;
@@ -236,12 +367,8 @@ void WorkQueue::Pause()
 {
     if (!paused_)
     {
-        pausing_ = true;
-
-        queueMutex_.Acquire();
+        pauseMutex_.Acquire();
         paused_ = true;
-
-        pausing_ = false;
     }
 }
 
@@ -249,8 +376,8 @@ void WorkQueue::Resume()
 {
     if (paused_)
     {
-        queueMutex_.Release();
         paused_ = false;
+        pauseMutex_.Release();
     }
 }
 
@@ -263,44 +390,23 @@ void WorkQueue::Complete(unsigned priority)
     {
         Resume();
 
-        // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.empty())
-        {
-            queueMutex_.Acquire();
-            if (!queue_.empty() && queue_.front()->priority_ >= priority)
-            {
-                WorkItem* item = queue_.front();
-                queue_.pop_front();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
-            }
-            else
-            {
-                queueMutex_.Release();
-                break;
-            }
-        }
-
-        // Wait for threaded work to complete
+        // Take work items also in the main thread until no high-priority items remain.
+        // Keep checking while waiting, as continuations may be queued by the worker threads
         while (!IsCompleted(priority))
         {
+            if (WorkTask* task = PopTask(0, priority))
+                ExecuteTask(task, 0);
         }
 
         // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.empty())
+        if (numQueued_ == 0)
             Pause();
     }
     else
     {
         // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.empty() && queue_.front()->priority_ >= priority)
-        {
-            WorkItem* item = queue_.front();
-            queue_.pop_front();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
-        }
+        while (WorkTask* task = PopTask(0, priority))
+            ExecuteTask(task, 0);
     }
 
     PurgeCompleted(priority);
@@ -309,7 +415,8 @@ void WorkQueue::Complete(unsigned priority)
 
 unsigned WorkQueue::GetNumIncomplete(unsigned priority) const
 {
-    unsigned incomplete = 0;
+    // Frame tasks always have the highest priority
+    unsigned incomplete = numPendingFrameTasks_;
     for (const auto& workItem : workItems_)
     {
         if (workItem->priority_ >= priority && !workItem->completed_)
@@ -321,6 +428,9 @@ unsigned WorkQueue::GetNumIncomplete(unsigned priority) const
 
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
+    if (numPendingFrameTasks_ > 0)
+        return false;
+
     for (const auto & workItem : workItems_)
     {
         if (workItem->priority_ >= priority && !workItem->completed_)
@@ -330,39 +440,130 @@ bool WorkQueue::IsCompleted(unsigned priority) const
     return true;
 }
 
+unsigned WorkQueue::GetThreadIndex()
+{
+    return currentThreadIndex;
+}
+
 void WorkQueue::ProcessItems(unsigned threadIndex)
 {
-    bool wasActive = false;
+    currentThreadIndex = threadIndex;
 
     for (;;)
     {
         if (shutDown_)
             return;
 
-        if (pausing_ && !wasActive)
-            Time::Sleep(0);
+        if (paused_)
+        {
+            // Block until the main thread resumes the queue
+            pauseMutex_.Acquire();
+            pauseMutex_.Release();
+        }
+        else if (WorkTask* task = PopTask(threadIndex, 0))
+            ExecuteTask(task, threadIndex);
         else
+            Time::Sleep(0);
+    }
+}
+
+void WorkQueue::QueueTask(WorkTask* task)
+{
+    unsigned index = GetThreadIndex();
+    if (index >= deques_.size())
+        index = 0;
+    else if (index == 0 && !threads_.empty())
+    {
+        // Main thread distributes tasks evenly so that worker threads rarely need to steal
+        index = 1 + nextDeque_;
+        nextDeque_ = (nextDeque_ + 1) % threads_.size();
+    }
+
+    WorkerDeque& deque = *deques_[index];
+    SpinLockGuard lock(deque.lock_);
+
+    // Common case is equal priority, which goes to the end
+    ea::deque<WorkTask*>& tasks = deque.tasks_;
+    if (tasks.empty() || tasks.back()->priority_ >= task->priority_)
+        tasks.push_back(task);
+    else
+    {
+        auto position = ea::find_if(tasks.begin(), tasks.end(),
+            [task](const WorkTask* other) { return other->priority_ < task->priority_; });
+        tasks.insert(position, task);
+    }
+
+    ++numQueued_;
+}
+
+WorkTask* WorkQueue::PopTask(unsigned threadIndex, unsigned priority)
+{
+    if (numQueued_.load(std::memory_order_relaxed) == 0)
+        return nullptr;
+
+    const unsigned numDeques = deques_.size();
+    for (unsigned i = 0; i < numDeques; ++i)
+    {
+        WorkerDeque& deque = *deques_[(threadIndex + i) % numDeques];
+
+        // Wait for the own queue, but skip busy queues of other threads
+        if (i == 0)
+            deque.lock_.Acquire();
+        else if (!deque.lock_.TryAcquire())
+            continue;
+
+        if (!deque.tasks_.empty() && deque.tasks_.front()->priority_ >= priority)
         {
-            queueMutex_.Acquire();
-            if (!queue_.empty())
-            {
-                wasActive = true;
+            WorkTask* task = deque.tasks_.front();
+            deque.tasks_.pop_front();
+            --numQueued_;
+            deque.lock_.Release();
+            return task;
+        }
 
-                WorkItem* item = queue_.front();
-                queue_.pop_front();
-                queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
-            }
-            else
-            {
-                wasActive = false;
+        deque.lock_.Release();
+    }
 
-                queueMutex_.Release();
-                Time::Sleep(0);
-            }
+    return nullptr;
+}
+
+void WorkQueue::ExecuteTask(WorkTask* task, unsigned threadIndex)
+{
+    task->executeFunction_(task, threadIndex);
+
+    for (WorkTask* continuation : task->continuations_)
+    {
+        if (continuation->pendingDependencies_.fetch_sub(1) == 1)
+            QueueTask(continuation);
+    }
+
+    // Task is no longer submitted
+    task->continuations_.clear();
+    task->pendingDependencies_ = 1;
+
+    // Frame task memory may be released as soon as the counter reaches zero, so don't touch the task afterwards
+    const bool frameTask = task->frameTask_;
+    task->completed_ = true;
+    if (frameTask)
+        --numPendingFrameTasks_;
+}
+
+bool WorkQueue::RemoveQueuedTask(WorkTask* task)
+{
+    for (auto& deque : deques_)
+    {
+        SpinLockGuard lock(deque->lock_);
+        auto i = ea::find(deque->tasks_.begin(), deque->tasks_.end(), task);
+        if (i != deque->tasks_.end())
+        {
+            deque->tasks_.erase(i);
+            --numQueued_;
+            task->pendingDependencies_ = 1;
+            return true;
         }
     }
+
+    return false;
 }
 
 void WorkQueue::PurgeCompleted(unsigned priority)
@@ -370,81 +571,117 @@ void WorkQueue::PurgeCompleted(unsigned priority)
     // Purge completed work items and send completion events. Do not signal items lower than priority threshold,
     // as those may be user submitted and lead to eg. scene manipulation that could happen in the middle of the
     // render update, which is not allowed
-    for (auto i = workItems_.begin(); i != workItems_.end();)
+    unsigned numRemaining = 0;
+    for (unsigned i = 0; i < workItems_.size(); ++i)
     {
-        if ((*i)->completed_ && (*i)->priority_ >= priority)
+        SharedPtr<WorkItem>& item = workItems_[i];
+        if (item->completed_ && item->priority_ >= priority)
         {
-            if ((*i)->sendEvent_)
+            if (item->sendEvent_)
             {
                 using namespace WorkItemCompleted;
 
                 VariantMap& eventData = GetEventDataMap();
-                eventData[P_ITEM] = i->Get();
+                eventData[P_ITEM] = item.Get();
                 SendEvent(E_WORKITEMCOMPLETED, eventData);
             }
-
-            ReturnToPool(*i);
-            i = workItems_.erase(i);
         }
         else
-            ++i;
+        {
+            if (numRemaining != i)
+                workItems_[numRemaining] = ea::move(item);
+            ++numRemaining;
+        }
     }
+
+    workItems_.resize(numRemaining);
 }
 
-void WorkQueue::PurgePool()
+void* WorkQueue::AllocateFrameTask(unsigned size)
 {
-    unsigned currentSize = poolItems_.size();
-    int difference = lastSize_ - currentSize;
+    size = (size + FRAME_TASK_ALIGNMENT - 1) & ~(FRAME_TASK_ALIGNMENT - 1);
+
+    SpinLockGuard lock(arenaLock_);
 
-    // Difference tolerance, should be fairly significant to reduce the pool size.
-    for (unsigned i = 0; !poolItems_.empty() && difference > tolerance_ && i < (unsigned)difference; i++)
-        poolItems_.pop_front();
+    // Move to the next block if the task does not fit. Blocks are kept for the next frames
+    if (arenaBlock_ >= arenaBlocks_.size() || arenaOffset_ + size > arenaBlocks_[arenaBlock_].second)
+    {
+        if (arenaBlock_ < arenaBlocks_.size())
+            ++arenaBlock_;
+        arenaOffset_ = 0;
+
+        // Drop kept blocks that are too small for the task; an oversized task gets its own block
+        while (arenaBlock_ < arenaBlocks_.size() && size > arenaBlocks_[arenaBlock_].second)
+            arenaBlocks_.erase(arenaBlocks_.begin() + arenaBlock_);
+        if (arenaBlock_ == arenaBlocks_.size())
+        {
+            const unsigned blockSize = Max(size, FRAME_TASK_ARENA_BLOCK_SIZE);
+            arenaBlocks_.emplace_back(ea::unique_ptr<unsigned char[]>(new unsigned char[blockSize]), blockSize);
+        }
+    }
 
-    lastSize_ = currentSize;
+    void* memory = arenaBlocks_[arenaBlock_].first.get() + arenaOffset_;
+    arenaOffset_ += size;
+    return memory;
 }
 
-void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
+void WorkQueue::RegisterFrameTask(FrameTaskBase* task)
 {
-    // Check if this was a pooled item and set it to usable
-    if (item->pooled_)
+    task->frameTask_ = true;
+    task->priority_ = M_MAX_UNSIGNED;
+    task->nextFrameTask_ = frameTasks_.load(std::memory_order_relaxed);
+    while (!frameTasks_.compare_exchange_weak(task->nextFrameTask_, task, std::memory_order_release, std::memory_order_relaxed))
     {
-        // Reset the values to their defaults. This should
-        // be safe to do here as the completed event has
-        // already been handled and this is part of the
-        // internal pool.
-        item->start_ = nullptr;
-        item->end_ = nullptr;
-        item->aux_ = nullptr;
-        item->workFunction_ = nullptr;
-        item->priority_ = M_MAX_UNSIGNED;
-        item->sendEvent_ = false;
-        item->completed_ = false;
-
-        poolItems_.push_back(item);
     }
 }
 
+void WorkQueue::ReleaseFrameTasks()
+{
+    // Frame tasks are normally completed within the frame. Finish leftovers before releasing the memory
+    while (numPendingFrameTasks_ > 0)
+    {
+        if (WorkTask* task = PopTask(0, 0))
+            ExecuteTask(task, 0);
+    }
+
+    FrameTaskBase* task = frameTasks_.exchange(nullptr);
+    while (task)
+    {
+        FrameTaskBase* nextTask = task->nextFrameTask_;
+        task->destroyFunction_(task);
+        task = nextTask;
+    }
+
+    SpinLockGuard lock(arenaLock_);
+    arenaBlock_ = 0;
+    arenaOffset_ = 0;
+}
+
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.empty() && !queue_.empty())
+    if (threads_.empty() && numQueued_ > 0)
     {
         URHO3D_PROFILE("CompleteWorkNonthreaded");
 
         HiresTimer timer;
 
-        while (!queue_.empty() && timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
+        while (timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
         {
-            WorkItem* item = queue_.front();
-            queue_.pop_front();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkTask* task = PopTask(0, 0);
+            if (!task)
+                break;
+            ExecuteTask(task, 0);
         }
     }
 
     // Complete and signal items down to the lowest priority
     PurgeCompleted(0);
-    PurgePool();
+}
+
+void WorkQueue::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    ReleaseFrameTasks();
 }
 
 }
@@ -22,8 +22,10 @@
 
 #pragma once
 
-#include <EASTL/list.h>
+#include <EASTL/fixed_vector.h>
+#include <EASTL/unique_ptr.h>
 #include <atomic>
+#include <functional>
 
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
@@ -38,13 +40,48 @@ URHO3D_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 }
 
 class WorkerThread;
+struct WorkerDeque;
+
+/// Unit of work executed by the work queue. Base of work items and frame tasks.
+struct WorkTask
+{
+    friend class WorkQueue;
+
+public:
+    /// Priority. Higher value = will be completed first.
+    unsigned priority_{};
+    /// Completed flag.
+    std::atomic<bool> completed_{};
+
+protected:
+    /// Execute function. Called with the task and thread index (0 = main thread) as parameters.
+    void (* executeFunction_)(WorkTask*, unsigned){};
+
+private:
+    /// Number of dependencies that have not finished yet, plus one until the task is added to the queue. Task is queued for execution when this reaches zero.
+    std::atomic<unsigned> pendingDependencies_{1};
+    /// Whether the task is allocated from the frame task arena.
+    bool frameTask_{};
+    /// Tasks which depend on this task and should be queued once it finishes. Few tasks have more than a couple.
+    ea::fixed_vector<WorkTask*, 2> continuations_;
+};
 
 /// Work queue item.
-struct WorkItem : public RefCounted
+struct WorkItem : public RefCounted, public WorkTask
 {
     friend class WorkQueue;
 
 public:
+    /// Construct.
+    WorkItem()
+    {
+        executeFunction_ = [](WorkTask* task, unsigned threadIndex)
+        {
+            auto* item = static_cast<WorkItem*>(task);
+            item->workFunction_(item, threadIndex);
+        };
+    }
+
     /// Work function. Called with the work item and thread index (0 = main thread) as parameters.
     void (* workFunction_)(const WorkItem*, unsigned){};
     /// Data start pointer.
@@ -53,19 +90,44 @@ public:
     void* end_{};
     /// Auxiliary data pointer.
     void* aux_{};
-    /// Priority. Higher value = will be completed first.
-    unsigned priority_{};
     /// Whether to send event on completion.
     bool sendEvent_{};
-    /// Completed flag.
-    std::atomic<bool> completed_{};
 
 private:
-    bool pooled_{};
     /// Work function. Called without any parameters.
     std::function<void()> workLambda_;
 };
 
+/// Task allocated from the frame task arena. Released at the end of the frame without reference counting.
+struct FrameTaskBase : public WorkTask
+{
+    friend class WorkQueue;
+
+protected:
+    /// Destroy function. Calls the destructor of the derived task.
+    void (* destroyFunction_)(FrameTaskBase*){};
+    /// Next task allocated in the same frame.
+    FrameTaskBase* nextFrameTask_{};
+};
+
+/// Frame task with the callable stored inline, right after the task header.
+template <class T> struct FrameTask : public FrameTaskBase
+{
+    /// Construct.
+    explicit FrameTask(T&& callback) :
+        callback_(ea::move(callback))
+    {
+        executeFunction_ = [](WorkTask* task, unsigned threadIndex) { static_cast<FrameTask*>(task)->callback_(threadIndex); };
+        destroyFunction_ = [](FrameTaskBase* task) { static_cast<FrameTask*>(task)->~FrameTask(); };
+    }
+
+    /// Callable. Called with the thread index (0 = main thread).
+    T callback_;
+};
+
+/// Parallel for callback. Called with the begin and end of the index range and the thread index (0 = main thread, M_MAX_UNSIGNED = thread not managed by the queue). Per-thread data indexed by the thread index needs a separate slot for M_MAX_UNSIGNED.
+using ParallelForFunction = std::function<void(unsigned begin, unsigned end, unsigned threadIndex)>;
+
 /// Work queue subsystem for multithreading.
 class URHO3D_API WorkQueue : public Object
 {
@@ -81,12 +143,34 @@ public:
 
     /// Create worker threads. Can only be called once.
     void CreateThreads(unsigned numThreads);
-    /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
+    /// Allocate a new work item. Prefer frame tasks for work which is completed within the frame.
     SharedPtr<WorkItem> GetFreeItem();
+    /// Create a frame task with the highest priority from a callable taking the thread index. Task memory is bump-allocated and released at the end of the frame. Task must be added to the queue in the same frame. May be called from any thread managed by the queue.
+    template <class T> WorkTask* CreateTask(T callback)
+    {
+        static_assert(alignof(FrameTask<T>) <= FRAME_TASK_ALIGNMENT, "Frame task callable is overaligned");
+        void* memory = AllocateFrameTask(sizeof(FrameTask<T>));
+        auto* task = new(memory) FrameTask<T>(ea::move(callback));
+        RegisterFrameTask(task);
+        return task;
+    }
+    /// Add a frame task and resume worker threads. May be called from any thread managed by the queue.
+    void AddTask(WorkTask* task);
+    /// Create and add a frame task. Return the task.
+    template <class T> WorkTask* AddTask(T callback)
+    {
+        WorkTask* task = CreateTask(ea::move(callback));
+        AddTask(task);
+        return task;
+    }
     /// Add a work item and resume worker threads.
     void AddWorkItem(const SharedPtr<WorkItem>& item);
     /// Add a work item and resume worker threads.
     WorkItem* AddWorkItem(std::function<void()> workFunction, unsigned priority = 0);
+    /// Make task start only after dependency has finished. Must be called before either task is added to the queue.
+    void AddDependency(WorkTask* task, WorkTask* dependency);
+    /// Split the index range into chunks of at most grainSize indices and process them on all threads. Calling thread participates and returns when all chunks are done. May be called from the main thread, from work items or from threads not managed by the queue, which are passed thread index M_MAX_UNSIGNED for the chunks they process themselves and only get help from worker threads that are not paused.
+    void ParallelFor(unsigned begin, unsigned end, unsigned grainSize, const ParallelForFunction& function);
     /// Remove a work item before it has started executing. Return true if successfully removed.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
@@ -98,24 +182,21 @@ public:
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
 
-    /// Set the pool telerance before it starts deleting pool items.
-    void SetTolerance(int tolerance) { tolerance_ = tolerance; }
-
     /// Set how many milliseconds maximum per frame to spend on low-priority work, when there are no worker threads.
     void SetNonThreadedWorkMs(int ms) { maxNonThreadedWorkMs_ = Max(ms, 1); }
 
     /// Return number of worker threads.
     unsigned GetNumThreads() const { return threads_.size(); }
 
-    /// Return number of incomplete tasks with at least the specified priority.
+    /// Return number of incomplete work items and frame tasks with at least the specified priority.
     unsigned GetNumIncomplete(unsigned priority) const;
     /// Return whether all work with at least the specified priority is finished.
     bool IsCompleted(unsigned priority) const;
     /// Return whether the queue is currently completing work in the main thread.
     bool IsCompleting() const { return completing_; }
 
-    /// Return the pool tolerance.
-    int GetTolerance() const { return tolerance_; }
+    /// Return index of the calling thread: 0 for the main thread, 1..N for worker threads, M_MAX_UNSIGNED for other threads.
+    static unsigned GetThreadIndex();
 
     /// Return how many milliseconds maximum to spend on non-threaded low-priority work.
     int GetNonThreadedWorkMs() const { return maxNonThreadedWorkMs_; }
@@ -123,37 +204,60 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Push task to the queue of the calling thread, or distribute between worker queues if called from the main thread.
+    void QueueTask(WorkTask* task);
+    /// Pop task from the queue of specified thread or steal it from other threads. Only tasks with at least the specified priority are taken.
+    WorkTask* PopTask(unsigned threadIndex, unsigned priority);
+    /// Execute task and queue its continuations.
+    void ExecuteTask(WorkTask* task, unsigned threadIndex);
+    /// Remove task from the thread queues. Return true if found.
+    bool RemoveQueuedTask(WorkTask* task);
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
-    /// Purge the pool to reduce allocation where its unneeded.
-    void PurgePool();
-    /// Return a work item to the pool.
-    void ReturnToPool(SharedPtr<WorkItem>& item);
+    /// Allocate memory for a frame task.
+    void* AllocateFrameTask(unsigned size);
+    /// Register frame task for destruction at the end of the frame.
+    void RegisterFrameTask(FrameTaskBase* task);
+    /// Complete outstanding frame tasks, destroy them and reset the arena.
+    void ReleaseFrameTasks();
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    /// Handle frame end event. Release frame tasks.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+
+    /// Alignment of frame tasks in the arena.
+    static const unsigned FRAME_TASK_ALIGNMENT = 16;
 
     /// Worker threads.
     ea::vector<SharedPtr<WorkerThread> > threads_;
-    /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
-    ea::list<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
-    ea::list<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems.)
-    ea::list<WorkItem*> queue_;
-    /// Worker queue mutex.
-    Mutex queueMutex_;
+    ea::vector<SharedPtr<WorkItem> > workItems_;
+    /// Per-thread prioritized queues. Index 0 is the main thread queue. Idle threads steal items from the queues of other threads.
+    ea::vector<ea::unique_ptr<WorkerDeque> > deques_;
+    /// Frame task arena blocks. Kept between frames.
+    ea::vector<ea::pair<ea::unique_ptr<unsigned char[]>, unsigned> > arenaBlocks_;
+    /// Arena block used for new allocations.
+    unsigned arenaBlock_;
+    /// Offset of the next allocation in the current arena block.
+    unsigned arenaOffset_;
+    /// Arena lock.
+    SpinLock arenaLock_;
+    /// Frame tasks allocated in this frame.
+    std::atomic<FrameTaskBase*> frameTasks_;
+    /// Number of frame tasks added to the queue but not finished.
+    std::atomic<unsigned> numPendingFrameTasks_;
+    /// Number of items in all thread queues.
+    std::atomic<unsigned> numQueued_;
+    /// Next worker queue to receive items pushed by the main thread.
+    unsigned nextDeque_;
+    /// Pause mutex. Held by the main thread while worker threads are paused.
+    Mutex pauseMutex_;
     /// Shutting down flag.
     std::atomic<bool> shutDown_;
-    /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
-    std::atomic<bool> pausing_;
-    /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
-    bool paused_;
+    /// Paused flag. Indicates the pause mutex being locked to prevent worker threads using up CPU time.
+    std::atomic<bool> paused_;
     /// Completing work in the main thread flag.
     bool completing_;
-    /// Tolerance for the shared pool before it begins to deallocate.
-    int tolerance_;
-    /// Last size of the shared pool.
-    unsigned lastSize_;
     /// Maximum milliseconds per frame to spend on low-priority work, when there are no worker threads.
     int maxNonThreadedWorkMs_;
 };
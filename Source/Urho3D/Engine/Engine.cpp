@@ -25,6 +25,7 @@
 #include "../Audio/Audio.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/FrameProfiler.h"
 #include "../Core/Profiler.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Thread.h"
@@ -125,6 +126,7 @@ Engine::Engine(Context* context) :
     // Create subsystems which do not depend on engine initialization or startup parameters
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
+    context_->RegisterSubsystem(new FrameProfiler(context_));
     context_->RegisterSubsystem(new FileSystem(context_));
 #ifdef URHO3D_LOGGING
     context_->RegisterSubsystem(new Log(context_));
@@ -173,9 +175,14 @@ bool Engine::Initialize(const VariantMap& parameters)
         if (HasParameter(parameters, EP_LOG_LEVEL))
             log->SetLevel(static_cast<LogLevel>(GetParameter(parameters, EP_LOG_LEVEL).GetInt()));
         log->SetQuiet(GetParameter(parameters, EP_LOG_QUIET, false).GetBool());
+        log->SetAsync(GetParameter(parameters, EP_LOG_ASYNC, false).GetBool());
         log->Open(GetParameter(parameters, EP_LOG_NAME, "Urho3D.log").GetString());
     }
 
+    // Start the built-in profiler if requested
+    if (GetParameter(parameters, EP_PROFILER, false).GetBool())
+        GetSubsystem<FrameProfiler>()->SetEnabled(true);
+
     // Set headless mode
     headless_ = GetParameter(parameters, EP_HEADLESS, false).GetBool();
 
@@ -335,6 +342,8 @@ bool Engine::InitializeResourceCache(const VariantMap& parameters, bool removeOl
             cache->RemovePackageFile(packageFiles[i].Get());
     }
 
+    cache->SetMemoryMapPackages(GetParameter(parameters, EP_MAP_RESOURCE_PACKAGES, false).GetBool());
+
     // Add resource paths
     ea::vector<ea::string> resourcePrefixPaths = GetParameter(parameters, EP_RESOURCE_PREFIX_PATHS,
         EMPTY_STRING).GetString().split(';', true);
@@ -619,7 +628,9 @@ void Engine::DumpProfiler()
     if (!Thread::IsMainThread())
         return;
 
-    // TODO: Put something here or remove API
+    auto* profiler = GetSubsystem<FrameProfiler>();
+    if (profiler && profiler->IsEnabled())
+        URHO3D_LOGINFO("Profiler data:\n" + profiler->PrintData());
 #endif
 }
 
@@ -696,20 +707,18 @@ void Engine::Update()
     URHO3D_PROFILE("Update");
 
     // Logic update event
-    using namespace Update;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_TIMESTEP] = timeStep_;
-    SendEvent(E_UPDATE, eventData);
+    Update::Data eventData;
+    eventData.timeStep_ = timeStep_;
+    SendTypedEvent(E_UPDATE, eventData);
 
     // Logic post-update event
-    SendEvent(E_POSTUPDATE, eventData);
+    SendTypedEvent(E_POSTUPDATE, eventData);
 
     // Rendering update event
-    SendEvent(E_RENDERUPDATE, eventData);
+    SendTypedEvent(E_RENDERUPDATE, eventData);
 
     // Post-render update event
-    SendEvent(E_POSTRENDERUPDATE, eventData);
+    SendTypedEvent(E_POSTRENDERUPDATE, eventData);
 }
 
 void Engine::Render()
@@ -896,6 +905,8 @@ void Engine::DefineParameters(CLI::App& commandLine, VariantMap& engineParameter
     auto optLowQualityShadows = addFlag("--lqshadows", EP_LOW_QUALITY_SHADOWS, true, "Use low quality shadows")->excludes(optNoShadows);
     optNoShadows->excludes(optLowQualityShadows);
     addFlag("--nothreads", EP_WORKER_THREADS, false, "Disable multithreading");
+    addFlag("--mmap", EP_MAP_RESOURCE_PACKAGES, true, "Map resource packages to memory");
+    addFlag("--profiler", EP_PROFILER, true, "Enable built-in profiler");
     addFlag("-v,--vsync", EP_VSYNC, true, "Enable vsync");
     addFlag("-t,--tripple-buffer", EP_TRIPLE_BUFFER, true, "Enable tripple-buffering");
     addFlag("-w,--windoed", EP_FULL_SCREEN, false, "Windowed mode");
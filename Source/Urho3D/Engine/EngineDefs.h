@@ -40,16 +40,19 @@ static const ea::string EP_FRAME_LIMITER = "FrameLimiter";
 static const ea::string EP_FULL_SCREEN = "FullScreen";
 static const ea::string EP_HEADLESS = "Headless";
 static const ea::string EP_HIGH_DPI = "HighDPI";
+static const ea::string EP_LOG_ASYNC = "LogAsync";
 static const ea::string EP_LOG_LEVEL = "LogLevel";
 static const ea::string EP_LOG_NAME = "LogName";
 static const ea::string EP_LOG_QUIET = "LogQuiet";
 static const ea::string EP_LOW_QUALITY_SHADOWS = "LowQualityShadows";
+static const ea::string EP_MAP_RESOURCE_PACKAGES = "MapResourcePackages";
 static const ea::string EP_MATERIAL_QUALITY = "MaterialQuality";
 static const ea::string EP_MONITOR = "Monitor";
 static const ea::string EP_MULTI_SAMPLE = "MultiSample";
 static const ea::string EP_ORGANIZATION_NAME = "OrganizationName";
 static const ea::string EP_ORIENTATIONS = "Orientations";
 static const ea::string EP_PACKAGE_CACHE_DIR = "PackageCacheDir";
+static const ea::string EP_PROFILER = "Profiler";
 static const ea::string EP_RENDER_PATH = "RenderPath";
 static const ea::string EP_REFRESH_RATE = "RefreshRate";
 static const ea::string EP_RESOURCE_PACKAGES = "ResourcePackages";
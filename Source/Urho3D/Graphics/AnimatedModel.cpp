@@ -85,7 +85,10 @@ AnimatedModel::AnimatedModel(Context* context) :
     isMaster_(true),
     loading_(false),
     assignBonesPending_(false),
-    forceAnimationUpdate_(false)
+    forceAnimationUpdate_(false),
+    lazyBoneNodes_(false),
+    boneNodesDirty_(false),
+    poseLayoutDirty_(true)
 {
 }
 
@@ -113,6 +116,7 @@ void AnimatedModel::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Can Be Occluded", IsOccludee, SetOccludee, bool, true, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Cast Shadows", bool, castShadows_, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Update When Invisible", GetUpdateInvisible, SetUpdateInvisible, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Lazy Bone Nodes", GetLazyBoneNodes, SetLazyBoneNodes, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw Distance", GetDrawDistance, SetDrawDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Distance", GetShadowDistance, SetShadowDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
@@ -327,7 +331,24 @@ void AnimatedModel::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     if (debug && IsEnabledEffective())
     {
         debug->AddBoundingBox(GetWorldBoundingBox(), Color::GREEN, depthTest);
-        debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
+        if (!boneNodesDirty_)
+            debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
+        else
+        {
+            // Bone nodes lag behind the pose, so draw the skeleton from the model-space bone transforms
+            const Matrix3x4& worldTransform = node_->GetWorldTransform();
+            const ea::vector<Bone>& bones = skeleton_.GetBones();
+            for (unsigned i = 0; i < bones.size(); ++i)
+            {
+                if (!bones[i].node_ || (bones[i].radius_ < M_EPSILON && bones[i].boundingBox_.Size().LengthSquared() < M_EPSILON))
+                    continue;
+
+                const unsigned j = bones[i].parentIndex_;
+                const Vector3 start = worldTransform * boneTransforms_[i].Translation();
+                const Vector3 end = j != i && j < bones.size() ? worldTransform * boneTransforms_[j].Translation() : start;
+                debug->AddLine(start, end, Color(0.75f, 0.75f, 0.75f), depthTest);
+            }
+        }
     }
 }
 
@@ -550,6 +571,17 @@ void AnimatedModel::SetUpdateInvisible(bool enable)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetLazyBoneNodes(bool enable)
+{
+    if (enable == lazyBoneNodes_)
+        return;
+
+    lazyBoneNodes_ = enable;
+    if (!lazyBoneNodes_)
+        UpdateBoneNodes();
+    MarkNetworkUpdate();
+}
+
 
 void AnimatedModel::SetMorphWeight(unsigned index, float weight)
 {
@@ -796,6 +828,8 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
     }
 
     assignBonesPending_ = !createBones;
+    poseLayoutDirty_ = true;
+    boneNodesDirty_ = false;
 }
 
 void AnimatedModel::SetModelAttr(const ResourceRef& value)
@@ -909,23 +943,32 @@ void AnimatedModel::UpdateBoneBoundingBox()
 {
     if (skeleton_.GetNumBones())
     {
-        // The bone bounding box is in local space, so need the node's inverse transform
+        // The bone bounding box is in local space, so need the node's inverse transform. If the bone nodes lag behind
+        // the pose, use the model-space bone transforms instead
         boneBoundingBox_.Clear();
-        Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
+        Matrix3x4 inverseNodeTransform;
+        if (boneNodesDirty_)
+            UpdatePoseTransforms();
+        else
+            inverseNodeTransform = node_->GetWorldTransform().Inverse();
 
         const ea::vector<Bone>& bones = skeleton_.GetBones();
-        for (auto i = bones.begin(); i != bones.end(); ++i)
+        for (unsigned i = 0; i < bones.size(); ++i)
         {
-            Node* boneNode = i->node_;
+            const Bone& bone = bones[i];
+            Node* boneNode = bone.node_;
             if (!boneNode)
                 continue;
 
+            const Matrix3x4 boneTransform = boneNodesDirty_ ? boneTransforms_[i] :
+                inverseNodeTransform * boneNode->GetWorldTransform();
+
             // Use hitbox if available. If not, use only half of the sphere radius
             /// \todo The sphere radius should be multiplied with bone scale
-            if (i->collisionMask_ & BONECOLLISION_BOX)
-                boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
-            else if (i->collisionMask_ & BONECOLLISION_SPHERE)
-                boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+            if (bone.collisionMask_ & BONECOLLISION_BOX)
+                boneBoundingBox_.Merge(bone.boundingBox_.Transformed(boneTransform));
+            else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                boneBoundingBox_.Merge(Sphere(boneTransform.Translation(), bone.radius_ * 0.5f));
         }
     }
 
@@ -981,6 +1024,8 @@ void AnimatedModel::OnWorldBoundingBoxUpdate()
 void AnimatedModel::AssignBoneNodes()
 {
     assignBonesPending_ = false;
+    poseLayoutDirty_ = true;
+    boneNodesDirty_ = false;
 
     if (!node_)
         return;
@@ -1284,17 +1329,28 @@ void AnimatedModel::ApplyAnimation()
         animationOrderDirty_ = false;
     }
 
-    // Reset skeleton, apply all animations, calculate bones' bounding box. Make sure this is only done for the master model
-    // (first AnimatedModel in a node)
+    // Reset pose, blend all animations into it, calculate bones' bounding box. Make sure this is only done for the master
+    // model (first AnimatedModel in a node)
     if (isMaster_)
     {
-        skeleton_.ResetSilent();
+        if (poseLayoutDirty_)
+            UpdatePoseLayout();
+
+        ResetPose();
         for (auto i = animationStates_.begin(); i !=
             animationStates_.end(); ++i)
-            (*i)->Apply();
+            (*i)->ApplyToPose(pose_);
 
-        // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
-        node_->MarkDirty();
+        // Leave the bone nodes alone unless something may read them. In that case skinning and the bounding box are
+        // calculated from the pose, and the model is dirtied directly instead of through the node hierarchy
+        if (lazyBoneNodes_ && !AreBoneNodesObserved())
+        {
+            boneNodesDirty_ = true;
+            skinningDirty_ = true;
+            MarkForUpdate();
+        }
+        else
+            WritePoseToBoneNodes();
 
         // Calculate new bone bounding box
         UpdateBoneBoundingBox();
@@ -1310,8 +1366,30 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
+    // Skinning from the pose, if the bone nodes lag behind it
+    if (boneNodesDirty_)
+    {
+        if (boneBoundingBoxDirty_)
+            UpdatePoseTransforms();
+
+        for (unsigned i = 0; i < bones.size(); ++i)
+        {
+            const Bone& bone = bones[i];
+            if (bone.node_)
+                skinMatrices_[i] = worldTransform * boneTransforms_[i] * bone.offsetMatrix_;
+            else
+                skinMatrices_[i] = worldTransform;
+
+            // Copy the skin matrix to per-geometry matrices as needed
+            if (i < geometrySkinMatrixPtrs_.size())
+            {
+                for (unsigned j = 0; j < geometrySkinMatrixPtrs_[i].size(); ++j)
+                    *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
+            }
+        }
+    }
     // Skinning with global matrices only
-    if (!geometrySkinMatrices_.size())
+    else if (!geometrySkinMatrices_.size())
     {
         for (unsigned i = 0; i < bones.size(); ++i)
         {
@@ -1342,6 +1420,136 @@ void AnimatedModel::UpdateSkinning()
     skinningDirty_ = false;
 }
 
+void AnimatedModel::UpdatePoseLayout()
+{
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    const unsigned numBones = bones.size();
+
+    pose_.Resize(numBones);
+    boneTransforms_.resize(numBones);
+    boneNodeChildren_.clear();
+    boneNodeChildren_.resize(numBones);
+
+    // Sort bones by depth, so that parent transforms are always calculated first
+    ea::vector<unsigned> depths(numBones);
+    boneOrder_.resize(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        unsigned depth = 0;
+        for (unsigned j = i; bones[j].parentIndex_ != j && bones[j].parentIndex_ < numBones && depth < numBones;
+            j = bones[j].parentIndex_)
+            ++depth;
+
+        depths[i] = depth;
+        boneOrder_[i] = i;
+
+        const unsigned parentIndex = bones[i].parentIndex_;
+        if (parentIndex != i && parentIndex < numBones && bones[i].node_)
+            ++boneNodeChildren_[parentIndex];
+    }
+    ea::quick_sort(boneOrder_.begin(), boneOrder_.end(), [&depths](unsigned lhs, unsigned rhs) { return depths[lhs] < depths[rhs]; });
+
+    poseLayoutDirty_ = false;
+}
+
+void AnimatedModel::ResetPose()
+{
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        const Bone& bone = bones[i];
+        if (bone.animated_)
+        {
+            pose_.positions_[i] = bone.initialPosition_;
+            pose_.rotations_[i] = bone.initialRotation_;
+            pose_.scales_[i] = bone.initialScale_;
+        }
+    }
+}
+
+void AnimatedModel::UpdatePoseTransforms()
+{
+    if (poseLayoutDirty_)
+        UpdatePoseLayout();
+
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i : boneOrder_)
+    {
+        const Bone& bone = bones[i];
+        Node* boneNode = bone.node_;
+        if (!boneNode)
+        {
+            boneTransforms_[i] = Matrix3x4::IDENTITY;
+            continue;
+        }
+
+        // Bones with animation disabled are controlled through their nodes
+        if (!bone.animated_)
+        {
+            pose_.positions_[i] = boneNode->GetPosition();
+            pose_.rotations_[i] = boneNode->GetRotation();
+            pose_.scales_[i] = boneNode->GetScale();
+        }
+
+        const Matrix3x4 localTransform(pose_.positions_[i], pose_.rotations_[i], pose_.scales_[i]);
+        const unsigned parentIndex = bone.parentIndex_;
+        if (parentIndex != i && parentIndex < bones.size())
+            boneTransforms_[i] = boneTransforms_[parentIndex] * localTransform;
+        else
+            boneTransforms_[i] = localTransform;
+    }
+}
+
+void AnimatedModel::WritePoseToBoneNodes()
+{
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i = 0; i < bones.size() && i < pose_.positions_.size(); ++i)
+    {
+        const Bone& bone = bones[i];
+        if (bone.animated_ && bone.node_)
+            bone.node_->SetTransformSilent(pose_.positions_[i], pose_.rotations_[i], pose_.scales_[i]);
+    }
+    boneNodesDirty_ = false;
+
+    // The pose is applied to the nodes "silently" to avoid repeated marking dirty. Mark dirty now
+    if (node_)
+        node_->MarkDirty();
+}
+
+bool AnimatedModel::AreBoneNodesObserved() const
+{
+    // Other animated models in the same node skin from the bone nodes
+    const ea::vector<SharedPtr<Component> >& components = node_->GetComponents();
+    for (auto i = components.begin(); i != components.end(); ++i)
+    {
+        if (*i != this && (*i)->IsInstanceOf<AnimatedModel>())
+            return true;
+    }
+
+    // Pose is only valid in place of the nodes if the bone node hierarchy still mirrors the skeleton, and has no attachments
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        if (!boneNode)
+            continue;
+
+        const unsigned parentIndex = bones[i].parentIndex_;
+        Node* parentNode = parentIndex != i && parentIndex < bones.size() ? bones[parentIndex].node_.Get() : node_;
+        if (boneNode->GetParent() != parentNode || boneNode->GetNumComponents() ||
+            boneNode->GetNumChildren() != boneNodeChildren_[i])
+            return true;
+    }
+
+    return false;
+}
+
+void AnimatedModel::UpdateBoneNodes()
+{
+    if (boneNodesDirty_)
+        WritePoseToBoneNodes();
+}
+
 void AnimatedModel::UpdateMorphs()
 {
     auto* graphics = GetSubsystem<Graphics>();
@@ -88,6 +88,8 @@ public:
     void SetAnimationLodBias(float bias);
     /// Set whether to update animation and the bounding box when not visible. Recommended to enable for physically controlled models like ragdolls.
     void SetUpdateInvisible(bool enable);
+    /// Set whether to keep the animated pose out of the bone nodes. When enabled, skinning and the bounding box are calculated from the pose, and bone nodes are written only if they have attached child nodes or components, or when UpdateBoneNodes() is called.
+    void SetLazyBoneNodes(bool enable);
     /// Set vertex morph weight by index.
     void SetMorphWeight(unsigned index, float weight);
     /// Set vertex morph weight by name.
@@ -98,6 +100,8 @@ public:
     void ResetMorphWeights();
     /// Apply all animation states to nodes.
     void ApplyAnimation();
+    /// Write the animated pose to the bone nodes if they lag behind it. Needed before reading bone node transforms directly when lazy bone nodes are enabled.
+    void UpdateBoneNodes();
 
     /// Return skeleton.
     Skeleton& GetSkeleton() { return skeleton_; }
@@ -123,6 +127,18 @@ public:
     /// Return whether to update animation when not visible.
     bool GetUpdateInvisible() const { return updateInvisible_; }
 
+    /// Return whether to keep the animated pose out of the bone nodes.
+    bool GetLazyBoneNodes() const { return lazyBoneNodes_; }
+
+    /// Return whether the bone nodes lag behind the animated pose.
+    bool AreBoneNodesDirty() const { return boneNodesDirty_; }
+
+    /// Return local-space bone transforms of the animated pose.
+    const SkeletonPose& GetPose() const { return pose_; }
+
+    /// Return model-space bone transforms of the animated pose. Up to date while the bone nodes lag behind the pose.
+    const ea::vector<Matrix3x4>& GetBoneTransforms() const { return boneTransforms_; }
+
     /// Return all vertex morphs.
     const ea::vector<ModelMorph>& GetMorphs() const { return morphs_; }
 
@@ -201,6 +217,16 @@ private:
     void UpdateAnimation(const FrameInfo& frame);
     /// Recalculate skinning.
     void UpdateSkinning();
+    /// Resize the pose and sort the bones for evaluation after the skeleton has changed.
+    void UpdatePoseLayout();
+    /// Reset animated bones of the pose to initial transforms.
+    void ResetPose();
+    /// Recalculate model-space bone transforms from the pose.
+    void UpdatePoseTransforms();
+    /// Write the pose to the bone nodes and mark them dirty.
+    void WritePoseToBoneNodes();
+    /// Return whether anything may read the bone nodes: attached nodes or components, other animated models or a modified bone hierarchy.
+    bool AreBoneNodesObserved() const;
     /// Reapply all vertex morphs.
     void UpdateMorphs();
     /// Apply a vertex morph.
@@ -227,6 +253,14 @@ private:
     ea::vector<ea::vector<Matrix3x4*> > geometrySkinMatrixPtrs_;
     /// Bounding box calculated from bones.
     BoundingBox boneBoundingBox_;
+    /// Local-space bone transforms of the animated pose.
+    SkeletonPose pose_;
+    /// Model-space bone transforms of the animated pose.
+    ea::vector<Matrix3x4> boneTransforms_;
+    /// Bone indices sorted so that parents precede their children.
+    ea::vector<unsigned> boneOrder_;
+    /// Number of child bone nodes of each bone node. Any other children are attachments.
+    ea::vector<unsigned> boneNodeChildren_;
     /// Attribute buffer.
     mutable VectorBuffer attrBuffer_;
     /// The frame number animation LOD distance was last calculated on.
@@ -259,6 +293,12 @@ private:
     bool assignBonesPending_;
     /// Force animation update after becoming visible flag.
     bool forceAnimationUpdate_;
+    /// Keep the animated pose out of the bone nodes flag.
+    bool lazyBoneNodes_;
+    /// Bone nodes lag behind the animated pose flag.
+    bool boneNodesDirty_;
+    /// Pose layout needs to be updated flag.
+    bool poseLayoutDirty_;
 };
 
 }
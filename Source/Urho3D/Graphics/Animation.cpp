@@ -50,8 +50,107 @@ inline bool CompareKeyFrames(const AnimationKeyFrame& lhs, const AnimationKeyFra
     return lhs.time_ < rhs.time_;
 }
 
+/// Largest possible value of the three smallest quaternion components.
+static const float QUATERNION_COMPONENT_MAX = 0.70710678f;
+/// Position or scale difference under which a channel is considered constant.
+static const float CONSTANT_VECTOR_EPSILON = 0.00001f;
+/// Rotation dot product difference from one under which a channel is considered constant.
+static const float CONSTANT_ROTATION_EPSILON = 0.000001f;
+
+static void QuantizeVector(const Vector3& value, const Vector3& min, const Vector3& range, unsigned short* dest)
+{
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        const float normalized = range.Data()[i] > 0.0f ? (value.Data()[i] - min.Data()[i]) / range.Data()[i] : 0.0f;
+        dest[i] = (unsigned short)RoundToInt(Clamp(normalized, 0.0f, 1.0f) * 65535.0f);
+    }
+}
+
+static Vector3 DequantizeVector(const unsigned short* src, const Vector3& min, const Vector3& range)
+{
+    const Vector3 scale = range * (1.0f / 65535.0f);
+    return Vector3(min.x_ + src[0] * scale.x_, min.y_ + src[1] * scale.y_, min.z_ + src[2] * scale.z_);
+}
+
+static void QuantizeRotation(const Quaternion& value, unsigned short* dest)
+{
+    const Quaternion rotation = value.Normalized();
+    const float components[4] = { rotation.w_, rotation.x_, rotation.y_, rotation.z_ };
+
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+
+    // Store the index of the largest component in 2 bits and the rest in 15 bits each. The largest component is
+    // reconstructed from the unit length, and is made positive by negating the quaternion, which is the same rotation
+    const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    unsigned long long bits = largest;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        const float normalized = (components[i] * sign / QUATERNION_COMPONENT_MAX + 1.0f) * 0.5f;
+        bits = (bits << 15u) | (unsigned)RoundToInt(Clamp(normalized, 0.0f, 1.0f) * 32767.0f);
+    }
+
+    dest[0] = (unsigned short)(bits & 0xffffu);
+    dest[1] = (unsigned short)((bits >> 16u) & 0xffffu);
+    dest[2] = (unsigned short)((bits >> 32u) & 0xffffu);
+}
+
+static Quaternion DequantizeRotation(const unsigned short* src)
+{
+    unsigned long long bits = src[0] | ((unsigned long long)src[1] << 16u) | ((unsigned long long)src[2] << 32u);
+    const int largest = (int)((bits >> 45u) & 0x3u);
+
+    float components[4];
+    float sumSquares = 0.0f;
+    for (int i = 3; i >= 0; --i)
+    {
+        if (i == largest)
+            continue;
+        components[i] = (bits & 0x7fffu) * (2.0f * QUATERNION_COMPONENT_MAX / 32767.0f) - QUATERNION_COMPONENT_MAX;
+        sumSquares += components[i] * components[i];
+        bits >>= 15u;
+    }
+    components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+
+    return Quaternion(components[0], components[1], components[2], components[3]);
+}
+
+void CompressedAnimationTrack::GetKeyFrame(unsigned index, Vector3& position, Quaternion& rotation, Vector3& scale) const
+{
+    const unsigned short* src = data_.data() + index * stride_;
+
+    if (storedChannels_ & CHANNEL_POSITION)
+    {
+        position = DequantizeVector(src, positionMin_, positionRange_);
+        src += 3;
+    }
+    else
+        position = positionMin_;
+
+    if (storedChannels_ & CHANNEL_ROTATION)
+    {
+        rotation = DequantizeRotation(src);
+        src += 3;
+    }
+    else
+        rotation = constantRotation_;
+
+    if (storedChannels_ & CHANNEL_SCALE)
+        scale = DequantizeVector(src, scaleMin_, scaleRange_);
+    else
+        scale = scaleMin_;
+}
+
 void AnimationTrack::SetKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame)
 {
+    Decompress();
+
     if (index < keyFrames_.size())
     {
         keyFrames_[index] = keyFrame;
@@ -63,6 +162,8 @@ void AnimationTrack::SetKeyFrame(unsigned index, const AnimationKeyFrame& keyFra
 
 void AnimationTrack::AddKeyFrame(const AnimationKeyFrame& keyFrame)
 {
+    Decompress();
+
     bool needSort = keyFrames_.size() ? keyFrames_.back().time_ > keyFrame.time_ : false;
     keyFrames_.push_back(keyFrame);
     if (needSort)
@@ -71,22 +172,29 @@ void AnimationTrack::AddKeyFrame(const AnimationKeyFrame& keyFrame)
 
 void AnimationTrack::InsertKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame)
 {
+    Decompress();
+
     keyFrames_.insert_at(index, keyFrame);
     ea::quick_sort(keyFrames_.begin(), keyFrames_.end(), CompareKeyFrames);
 }
 
 void AnimationTrack::RemoveKeyFrame(unsigned index)
 {
+    Decompress();
+
     keyFrames_.erase_at(index);
 }
 
 void AnimationTrack::RemoveAllKeyFrames()
 {
     keyFrames_.clear();
+    compressed_.reset();
 }
 
 AnimationKeyFrame* AnimationTrack::GetKeyFrame(unsigned index)
 {
+    Decompress();
+
     return index < keyFrames_.size() ? &keyFrames_[index] : nullptr;
 }
 
@@ -95,6 +203,14 @@ void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
     if (time < 0.0f)
         time = 0.0f;
 
+    // Compressed keyframes are uniformly spaced
+    if (compressed_)
+    {
+        const float keyTime = (time - compressed_->startTime_) * compressed_->sampleRate_;
+        index = keyTime > 0.0f ? Min((unsigned)keyTime, compressed_->numKeyFrames_ - 1) : 0;
+        return;
+    }
+
     if (index >= keyFrames_.size())
         index = keyFrames_.size() - 1;
 
@@ -107,6 +223,233 @@ void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
         ++index;
 }
 
+void AnimationTrack::Sample(float time, float length, bool looped, unsigned& index, Vector3& position, Quaternion& rotation,
+    Vector3& scale) const
+{
+    if (IsEmpty())
+        return;
+
+    Vector3 newPosition;
+    Quaternion newRotation;
+    Vector3 newScale;
+
+    if (compressed_)
+    {
+        // Keyframes are uniformly spaced, so the keyframe index is calculated directly from the time position
+        const CompressedAnimationTrack& compressed = *compressed_;
+        const unsigned lastFrame = compressed.numKeyFrames_ - 1;
+        const float keyTime = (time - compressed.startTime_) * compressed.sampleRate_;
+
+        unsigned frame = 0;
+        float t = 0.0f;
+        if (keyTime > 0.0f)
+        {
+            frame = Min((unsigned)keyTime, lastFrame);
+            t = keyTime - frame;
+        }
+
+        unsigned nextFrame = frame + 1;
+        if (frame == lastFrame)
+        {
+            // Interpolate from the last keyframe to the first if looping, over the rest of the animation length
+            nextFrame = looped ? 0 : frame;
+            if (looped)
+            {
+                const float lastTime = compressed.GetKeyFrameTime(lastFrame);
+                const float timeInterval = length - lastTime + compressed.startTime_;
+                t = timeInterval > 0.0f ? Clamp((time - lastTime) / timeInterval, 0.0f, 1.0f) : 1.0f;
+            }
+            else
+                t = 0.0f;
+        }
+        index = frame;
+
+        compressed.GetKeyFrame(frame, newPosition, newRotation, newScale);
+        if (t > 0.0f && nextFrame != frame)
+        {
+            Vector3 nextPosition;
+            Quaternion nextRotation;
+            Vector3 nextScale;
+            compressed.GetKeyFrame(nextFrame, nextPosition, nextRotation, nextScale);
+
+            // Keyframes are close to each other, so normalized lerp is accurate enough for rotations
+            if (channelMask_ & CHANNEL_POSITION)
+                newPosition = newPosition.Lerp(nextPosition, t);
+            if (channelMask_ & CHANNEL_ROTATION)
+                newRotation = newRotation.Nlerp(nextRotation, t, true);
+            if (channelMask_ & CHANNEL_SCALE)
+                newScale = newScale.Lerp(nextScale, t);
+        }
+    }
+    else
+    {
+        unsigned& frame = index;
+        GetKeyFrameIndex(time, frame);
+
+        // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
+        unsigned nextFrame = frame + 1;
+        bool interpolate = true;
+        if (nextFrame >= keyFrames_.size())
+        {
+            if (!looped)
+            {
+                nextFrame = frame;
+                interpolate = false;
+            }
+            else
+                nextFrame = 0;
+        }
+
+        const AnimationKeyFrame* keyFrame = &keyFrames_[frame];
+
+        if (interpolate)
+        {
+            const AnimationKeyFrame* nextKeyFrame = &keyFrames_[nextFrame];
+            float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
+            if (timeInterval < 0.0f)
+                timeInterval += length;
+            float t = timeInterval > 0.0f ? (time - keyFrame->time_) / timeInterval : 1.0f;
+
+            if (channelMask_ & CHANNEL_POSITION)
+                newPosition = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+            if (channelMask_ & CHANNEL_ROTATION)
+                newRotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+            if (channelMask_ & CHANNEL_SCALE)
+                newScale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+        }
+        else
+        {
+            newPosition = keyFrame->position_;
+            newRotation = keyFrame->rotation_;
+            newScale = keyFrame->scale_;
+        }
+    }
+
+    if (channelMask_ & CHANNEL_POSITION)
+        position = newPosition;
+    if (channelMask_ & CHANNEL_ROTATION)
+        rotation = newRotation;
+    if (channelMask_ & CHANNEL_SCALE)
+        scale = newScale;
+}
+
+void AnimationTrack::Compress(float sampleRate)
+{
+    if (keyFrames_.empty())
+        return;
+
+    compressed_.reset();
+    const float startTime = keyFrames_.front().time_;
+    const float duration = keyFrames_.back().time_ - startTime;
+    if (sampleRate <= 0.0f)
+        sampleRate = duration > 0.0f ? (keyFrames_.size() - 1) / duration : 0.0f;
+    const unsigned numKeyFrames = duration > 0.0f && sampleRate > 0.0f ? (unsigned)Max(RoundToInt(duration * sampleRate), 1) + 1 : 1;
+
+    auto compressed = ea::make_shared<CompressedAnimationTrack>();
+    compressed->numKeyFrames_ = numKeyFrames;
+    compressed->startTime_ = startTime;
+    // Adjust the rate so that the last keyframe time is preserved exactly
+    compressed->sampleRate_ = numKeyFrames > 1 ? (numKeyFrames - 1) / duration : 1.0f;
+
+    // Resample keyframes at the uniform rate, and find the value range of each channel
+    ea::vector<AnimationKeyFrame> samples(numKeyFrames);
+    unsigned index = 0;
+    for (unsigned i = 0; i < numKeyFrames; ++i)
+    {
+        AnimationKeyFrame& sample = samples[i];
+        sample.time_ = i < numKeyFrames - 1 ? compressed->GetKeyFrameTime(i) : keyFrames_.back().time_;
+        Sample(sample.time_, 0.0f, false, index, sample.position_, sample.rotation_, sample.scale_);
+    }
+
+    Vector3 positionMin = samples[0].position_;
+    Vector3 positionMax = positionMin;
+    Vector3 scaleMin = samples[0].scale_;
+    Vector3 scaleMax = scaleMin;
+    bool constantRotation = true;
+    for (unsigned i = 1; i < numKeyFrames; ++i)
+    {
+        const AnimationKeyFrame& sample = samples[i];
+        positionMin = VectorMin(positionMin, sample.position_);
+        positionMax = VectorMax(positionMax, sample.position_);
+        scaleMin = VectorMin(scaleMin, sample.scale_);
+        scaleMax = VectorMax(scaleMax, sample.scale_);
+        if (1.0f - Abs(sample.rotation_.DotProduct(samples[0].rotation_)) > CONSTANT_ROTATION_EPSILON)
+            constantRotation = false;
+    }
+
+    // Store channels which do not change only once
+    const Vector3 positionRange = positionMax - positionMin;
+    const Vector3 scaleRange = scaleMax - scaleMin;
+    AnimationChannelFlags storedChannels;
+    if ((channelMask_ & CHANNEL_POSITION) && positionRange.Length() > CONSTANT_VECTOR_EPSILON)
+    {
+        storedChannels |= CHANNEL_POSITION;
+        compressed->positionMin_ = positionMin;
+        compressed->positionRange_ = positionRange;
+    }
+    else
+        compressed->positionMin_ = (positionMin + positionMax) * 0.5f;
+    if ((channelMask_ & CHANNEL_ROTATION) && !constantRotation)
+        storedChannels |= CHANNEL_ROTATION;
+    else
+        compressed->constantRotation_ = samples[0].rotation_;
+    if ((channelMask_ & CHANNEL_SCALE) && scaleRange.Length() > CONSTANT_VECTOR_EPSILON)
+    {
+        storedChannels |= CHANNEL_SCALE;
+        compressed->scaleMin_ = scaleMin;
+        compressed->scaleRange_ = scaleRange;
+    }
+    else
+        compressed->scaleMin_ = (scaleMin + scaleMax) * 0.5f;
+
+    compressed->storedChannels_ = storedChannels;
+    compressed->stride_ = ((storedChannels & CHANNEL_POSITION) ? 3 : 0) + ((storedChannels & CHANNEL_ROTATION) ? 3 : 0) +
+        ((storedChannels & CHANNEL_SCALE) ? 3 : 0);
+    compressed->data_.resize(numKeyFrames * compressed->stride_);
+
+    unsigned short* dest = compressed->data_.data();
+    for (unsigned i = 0; i < numKeyFrames; ++i)
+    {
+        const AnimationKeyFrame& sample = samples[i];
+        if (storedChannels & CHANNEL_POSITION)
+        {
+            QuantizeVector(sample.position_, positionMin, positionRange, dest);
+            dest += 3;
+        }
+        if (storedChannels & CHANNEL_ROTATION)
+        {
+            QuantizeRotation(sample.rotation_, dest);
+            dest += 3;
+        }
+        if (storedChannels & CHANNEL_SCALE)
+        {
+            QuantizeVector(sample.scale_, scaleMin, scaleRange, dest);
+            dest += 3;
+        }
+    }
+
+    compressed_ = compressed;
+    keyFrames_.clear();
+    keyFrames_.shrink_to_fit();
+}
+
+void AnimationTrack::Decompress()
+{
+    if (!compressed_)
+        return;
+
+    const CompressedAnimationTrack& compressed = *compressed_;
+    keyFrames_.resize(compressed.numKeyFrames_);
+    for (unsigned i = 0; i < compressed.numKeyFrames_; ++i)
+    {
+        AnimationKeyFrame& keyFrame = keyFrames_[i];
+        keyFrame.time_ = compressed.GetKeyFrameTime(i);
+        compressed.GetKeyFrame(i, keyFrame.position_, keyFrame.rotation_, keyFrame.scale_);
+    }
+
+    compressed_.reset();
+}
+
 Animation::Animation(Context* context) :
     ResourceWithMetadata(context),
     length_(0.f)
@@ -122,15 +465,17 @@ void Animation::RegisterObject(Context* context)
 
 bool Animation::BeginLoad(Deserializer& source)
 {
-    unsigned memoryUse = sizeof(Animation);
-
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    ea::string fileID = source.ReadFileID();
+    if (fileID != "UANI" && fileID != "UAN2")
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
     }
 
+    // UAN2 supports compressed tracks
+    bool hasCompressedTracks = (fileID == "UAN2");
+
     // Read name and length
     animationName_ = source.ReadString();
     animationNameHash_ = animationName_;
@@ -138,7 +483,6 @@ bool Animation::BeginLoad(Deserializer& source)
     tracks_.clear();
 
     unsigned tracks = source.ReadUInt();
-    memoryUse += tracks * sizeof(AnimationTrack);
 
     // Read tracks
     for (unsigned i = 0; i < tracks; ++i)
@@ -146,9 +490,45 @@ bool Animation::BeginLoad(Deserializer& source)
         AnimationTrack* newTrack = CreateTrack(source.ReadString());
         newTrack->channelMask_ = AnimationChannelFlags(source.ReadUByte());
 
+        if (hasCompressedTracks && source.ReadBool())
+        {
+            auto compressed = ea::make_shared<CompressedAnimationTrack>();
+            compressed->numKeyFrames_ = source.ReadUInt();
+            compressed->startTime_ = source.ReadFloat();
+            compressed->sampleRate_ = source.ReadFloat();
+            compressed->storedChannels_ = AnimationChannelFlags(source.ReadUByte());
+            compressed->positionMin_ = source.ReadVector3();
+            compressed->positionRange_ = source.ReadVector3();
+            compressed->constantRotation_ = source.ReadQuaternion();
+            compressed->scaleMin_ = source.ReadVector3();
+            compressed->scaleRange_ = source.ReadVector3();
+
+            const AnimationChannelFlags storedChannels = compressed->storedChannels_;
+            compressed->stride_ = ((storedChannels & CHANNEL_POSITION) ? 3 : 0) + ((storedChannels & CHANNEL_ROTATION) ? 3 : 0) +
+                ((storedChannels & CHANNEL_SCALE) ? 3 : 0);
+
+            // Check the keyframe count against the remaining data before allocating
+            const unsigned long long dataSize = (unsigned long long)compressed->numKeyFrames_ * compressed->stride_ * sizeof(unsigned short);
+            if (!compressed->numKeyFrames_ || compressed->sampleRate_ <= 0.0f || source.GetPosition() > source.GetSize() ||
+                dataSize > source.GetSize() - source.GetPosition())
+            {
+                URHO3D_LOGERROR("Invalid compressed track " + newTrack->name_ + " in animation " + source.GetName());
+                return false;
+            }
+
+            compressed->data_.resize(compressed->numKeyFrames_ * compressed->stride_);
+            if (source.Read(compressed->data_.data(), (unsigned)dataSize) != dataSize)
+            {
+                URHO3D_LOGERROR("Invalid compressed track " + newTrack->name_ + " in animation " + source.GetName());
+                return false;
+            }
+
+            newTrack->compressed_ = compressed;
+            continue;
+        }
+
         unsigned keyFrames = source.ReadUInt();
         newTrack->keyFrames_.resize(keyFrames);
-        memoryUse += keyFrames * sizeof(AnimationKeyFrame);
 
         // Read keyframes of the track
         for (unsigned j = 0; j < keyFrames; ++j)
@@ -182,8 +562,7 @@ bool Animation::BeginLoad(Deserializer& source)
 
         LoadMetadataFromXML(rootElem);
 
-        memoryUse += triggers_.size() * sizeof(AnimationTriggerPoint);
-        SetMemoryUse(memoryUse);
+        UpdateMemoryUse();
         return true;
     }
 
@@ -213,19 +592,22 @@ bool Animation::BeginLoad(Deserializer& source)
         const JSONArray& metadataArray = rootVal.Get("metadata").GetArray();
         LoadMetadataFromJSON(metadataArray);
 
-        memoryUse += triggers_.size() * sizeof(AnimationTriggerPoint);
-        SetMemoryUse(memoryUse);
+        UpdateMemoryUse();
         return true;
     }
 
-    SetMemoryUse(memoryUse);
+    UpdateMemoryUse();
     return true;
 }
 
 bool Animation::Save(Serializer& dest) const
 {
-    // Write ID, name and length
-    dest.WriteFileID("UANI");
+    // Write ID, name and length. Use the older format if there are no compressed tracks
+    bool hasCompressedTracks = false;
+    for (auto i = tracks_.begin(); i != tracks_.end(); ++i)
+        hasCompressedTracks |= i->second.IsCompressed();
+
+    dest.WriteFileID(hasCompressedTracks ? "UAN2" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
 
@@ -236,6 +618,27 @@ bool Animation::Save(Serializer& dest) const
         const AnimationTrack& track = i->second;
         dest.WriteString(track.name_);
         dest.WriteUByte(track.channelMask_);
+
+        if (hasCompressedTracks)
+        {
+            dest.WriteBool(track.IsCompressed());
+            if (track.IsCompressed())
+            {
+                const CompressedAnimationTrack& compressed = *track.compressed_;
+                dest.WriteUInt(compressed.numKeyFrames_);
+                dest.WriteFloat(compressed.startTime_);
+                dest.WriteFloat(compressed.sampleRate_);
+                dest.WriteUByte(compressed.storedChannels_);
+                dest.WriteVector3(compressed.positionMin_);
+                dest.WriteVector3(compressed.positionRange_);
+                dest.WriteQuaternion(compressed.constantRotation_);
+                dest.WriteVector3(compressed.scaleMin_);
+                dest.WriteVector3(compressed.scaleRange_);
+                dest.Write(compressed.data_.data(), compressed.data_.size() * sizeof(unsigned short));
+                continue;
+            }
+        }
+
         dest.WriteUInt(track.keyFrames_.size());
 
         // Write keyframes of the track
@@ -382,6 +785,20 @@ SharedPtr<Animation> Animation::Clone(const ea::string& cloneName) const
     return ret;
 }
 
+void Animation::Compress(float sampleRate)
+{
+    for (auto i = tracks_.begin(); i != tracks_.end(); ++i)
+        i->second.Compress(sampleRate);
+    UpdateMemoryUse();
+}
+
+void Animation::Decompress()
+{
+    for (auto i = tracks_.begin(); i != tracks_.end(); ++i)
+        i->second.Decompress();
+    UpdateMemoryUse();
+}
+
 AnimationTrack* Animation::GetTrack(unsigned index)
 {
     if (index >= GetNumTracks())
@@ -426,4 +843,20 @@ void Animation::SetTracks(const ea::vector<AnimationTrack>& tracks)
     }
 }
 
+void Animation::UpdateMemoryUse()
+{
+    unsigned memoryUse = sizeof(Animation) + tracks_.size() * sizeof(AnimationTrack) +
+        triggers_.size() * sizeof(AnimationTriggerPoint);
+
+    for (auto i = tracks_.begin(); i != tracks_.end(); ++i)
+    {
+        const AnimationTrack& track = i->second;
+        memoryUse += track.keyFrames_.size() * sizeof(AnimationKeyFrame);
+        if (track.compressed_)
+            memoryUse += sizeof(CompressedAnimationTrack) + track.compressed_->data_.size() * sizeof(unsigned short);
+    }
+
+    SetMemoryUse(memoryUse);
+}
+
 }
@@ -72,6 +72,38 @@ struct AnimationKeyFrame
     Vector3 scale_;
 };
 
+/// Compressed keyframes of a skeletal animation track. Keyframes are resampled at a uniform rate, so that finding the keyframe for a time position is an index computation. Rotations are quantized to the smallest three components, positions and scales to the value range of the track, and channels which do not change are stored only once.
+struct URHO3D_API CompressedAnimationTrack
+{
+    /// Return time position of keyframe at index.
+    float GetKeyFrameTime(unsigned index) const { return startTime_ + index / sampleRate_; }
+    /// Decode keyframe at index.
+    void GetKeyFrame(unsigned index, Vector3& position, Quaternion& rotation, Vector3& scale) const;
+
+    /// Number of keyframes.
+    unsigned numKeyFrames_{};
+    /// Time position of the first keyframe.
+    float startTime_{};
+    /// Keyframes per second.
+    float sampleRate_{};
+    /// Channels which are stored per keyframe. Other channels have the same value in all keyframes.
+    AnimationChannelFlags storedChannels_{};
+    /// Constant position, or minimum of quantized positions.
+    Vector3 positionMin_;
+    /// Range of quantized positions.
+    Vector3 positionRange_;
+    /// Constant rotation.
+    Quaternion constantRotation_;
+    /// Constant scale, or minimum of quantized scales.
+    Vector3 scaleMin_{Vector3::ONE};
+    /// Range of quantized scales.
+    Vector3 scaleRange_;
+    /// Number of 16-bit values per keyframe.
+    unsigned stride_{};
+    /// Quantized keyframe data. Three values per stored channel per keyframe, in position, rotation, scale order.
+    ea::vector<unsigned short> data_;
+};
+
 /// Skeletal animation track, stores keyframes of a single bone.
 struct URHO3D_API AnimationTrack
 {
@@ -80,23 +112,35 @@ struct URHO3D_API AnimationTrack
     {
     }
 
-    /// Assign keyframe at index.
+    /// Assign keyframe at index. Decompresses the keyframes if compressed.
     void SetKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame);
-    /// Add a keyframe at the end.
+    /// Add a keyframe at the end. Decompresses the keyframes if compressed.
     void AddKeyFrame(const AnimationKeyFrame& keyFrame);
-    /// Insert a keyframe at index.
+    /// Insert a keyframe at index. Decompresses the keyframes if compressed.
     void InsertKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame);
-    /// Remove a keyframe at index.
+    /// Remove a keyframe at index. Decompresses the keyframes if compressed.
     void RemoveKeyFrame(unsigned index);
-    /// Remove all keyframes.
+    /// Remove all keyframes, compressed or not.
     void RemoveAllKeyFrames();
 
-    /// Return keyframe at index, or null if not found.
+    /// Return keyframe at index, or null if not found. Decompresses the keyframes if compressed, as the keyframe may be modified through the pointer.
     AnimationKeyFrame* GetKeyFrame(unsigned index);
-    /// Return number of keyframes.
-    unsigned GetNumKeyFrames() const { return keyFrames_.size(); }
+    /// Return number of keyframes, compressed or not.
+    unsigned GetNumKeyFrames() const { return compressed_ ? compressed_->numKeyFrames_ : keyFrames_.size(); }
     /// Return keyframe index based on time and previous index.
     void GetKeyFrameIndex(float time, unsigned& index) const;
+    /// Sample the track at time position. Interpolates from the last keyframe to the first if looped. Index is the previous keyframe index, used to speed up finding uncompressed keyframes. Only the channels in the channel mask are written.
+    void Sample(float time, float length, bool looped, unsigned& index, Vector3& position, Quaternion& rotation, Vector3& scale) const;
+    /// Compress keyframes, resampling them at the given rate in keyframes per second. Zero rate keeps the average rate of the keyframes. Uncompressed keyframes are released.
+    void Compress(float sampleRate = 0.0f);
+    /// Restore uncompressed keyframes from the compressed data, so that they can be edited.
+    void Decompress();
+
+    /// Return whether keyframes are compressed.
+    bool IsCompressed() const { return compressed_ != nullptr; }
+
+    /// Return whether there are no keyframes, compressed or not.
+    bool IsEmpty() const { return keyFrames_.empty() && !compressed_; }
 
     /// Bone or scene node name.
     ea::string name_;
@@ -106,6 +150,8 @@ struct URHO3D_API AnimationTrack
     AnimationChannelFlags channelMask_{};
     /// Keyframes.
     ea::vector<AnimationKeyFrame> keyFrames_;
+    /// Compressed keyframes, shared between clones. Null if not compressed.
+    ea::shared_ptr<const CompressedAnimationTrack> compressed_;
 
     /// Instance equality operator.
     bool operator ==(const AnimationTrack& rhs) const
@@ -189,6 +235,10 @@ public:
     void SetNumTriggers(unsigned num);
     /// Clone the animation.
     SharedPtr<Animation> Clone(const ea::string& cloneName = EMPTY_STRING) const;
+    /// Compress keyframes of all tracks, resampling them at the given rate in keyframes per second. Zero rate keeps the average rate of each track. This is unsafe if the animation is currently used in playback.
+    void Compress(float sampleRate = 0.0f);
+    /// Restore uncompressed keyframes of all tracks. This is unsafe if the animation is currently used in playback.
+    void Decompress();
 
     /// Return animation name.
     const ea::string& GetAnimationName() const { return animationName_; }
@@ -225,6 +275,9 @@ public:
     /// Set all animation tracks.
     void SetTracks(const ea::vector<AnimationTrack>& tracks);
 private:
+    /// Recalculate memory use from the tracks and triggers.
+    void UpdateMemoryUse();
+
     /// Animation name.
     ea::string animationName_;
     /// Animation name hash.
@@ -29,6 +29,7 @@
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
 class AnimatedModel;
 class Animation;
 struct Bone;
@@ -212,7 +213,7 @@ private:
     /// Find the internal index and animation state of an animation.
     void FindAnimation(const ea::string& name, unsigned& index, AnimationState*& state) const;
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const SceneUpdate::Data& eventData);
 
     /// Animation control structures.
     ea::vector<AnimationControl> animations_;
@@ -36,6 +36,7 @@ namespace Urho3D
 AnimationStateTrack::AnimationStateTrack() :
     track_(nullptr),
     bone_(nullptr),
+    boneIndex_(0),
     weight_(1.0f),
     keyFrame_(0)
 {
@@ -150,6 +151,7 @@ void AnimationState::SetStartBone(Bone* startBone)
         if (trackBone && trackBone->node_)
         {
             stateTrack.bone_ = trackBone;
+            stateTrack.boneIndex_ = skeleton.GetBoneIndex(trackBone);
             stateTrack.node_ = trackBone->node_;
             stateTracks_.push_back(stateTrack);
         }
@@ -475,81 +477,90 @@ void AnimationState::ApplyToNodes()
         ApplyTrack(*i, 1.0f, false);
 }
 
-void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent)
+void AnimationState::ApplyToPose(SkeletonPose& pose)
 {
-    const AnimationTrack* track = stateTrack.track_;
-    Node* node = stateTrack.node_;
-
-    if (track->keyFrames_.empty() || !node)
+    if (!model_ || !animation_ || !IsEnabled())
         return;
 
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
-
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.size())
+    for (auto i = stateTracks_.begin(); i != stateTracks_.end(); ++i)
     {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
+        AnimationStateTrack& stateTrack = *i;
+        float finalWeight = weight_ * stateTrack.weight_;
+
+        // Do not apply if zero effective weight or the bone has animation disabled
+        if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_ || stateTrack.boneIndex_ >= pose.positions_.size())
+            continue;
+
+        const unsigned index = stateTrack.boneIndex_;
+        BlendTrack(stateTrack, finalWeight, pose.positions_[index], pose.rotations_[index], pose.scales_[index]);
     }
+}
 
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
-    const AnimationChannelFlags channelMask = track->channelMask_;
+void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent)
+{
+    Node* node = stateTrack.node_;
+    if (stateTrack.track_->IsEmpty() || !node)
+        return;
 
-    Vector3 newPosition;
-    Quaternion newRotation;
-    Vector3 newScale;
+    const AnimationChannelFlags channelMask = stateTrack.track_->channelMask_;
+    Vector3 newPosition = node->GetPosition();
+    Quaternion newRotation = node->GetRotation();
+    Vector3 newScale = node->GetScale();
+    BlendTrack(stateTrack, weight, newPosition, newRotation, newScale);
 
-    if (interpolate)
+    if (silent)
     {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-
         if (channelMask & CHANNEL_POSITION)
-            newPosition = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+            node->SetPositionSilent(newPosition);
         if (channelMask & CHANNEL_ROTATION)
-            newRotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+            node->SetRotationSilent(newRotation);
         if (channelMask & CHANNEL_SCALE)
-            newScale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+            node->SetScaleSilent(newScale);
     }
     else
     {
         if (channelMask & CHANNEL_POSITION)
-            newPosition = keyFrame->position_;
+            node->SetPosition(newPosition);
         if (channelMask & CHANNEL_ROTATION)
-            newRotation = keyFrame->rotation_;
+            node->SetRotation(newRotation);
         if (channelMask & CHANNEL_SCALE)
-            newScale = keyFrame->scale_;
+            node->SetScale(newScale);
     }
+}
+
+void AnimationState::BlendTrack(AnimationStateTrack& stateTrack, float weight, Vector3& position, Quaternion& rotation,
+    Vector3& scale)
+{
+    const AnimationTrack* track = stateTrack.track_;
+    if (track->IsEmpty())
+        return;
+
+    const AnimationChannelFlags channelMask = track->channelMask_;
+
+    Vector3 newPosition;
+    Quaternion newRotation;
+    Vector3 newScale;
+    track->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, newPosition, newRotation, newScale);
 
     if (blendingMode_ == ABM_ADDITIVE) // not ABM_LERP
     {
         if (channelMask & CHANNEL_POSITION)
         {
             Vector3 delta = newPosition - stateTrack.bone_->initialPosition_;
-            newPosition = node->GetPosition() + delta * weight;
+            position = position + delta * weight;
         }
         if (channelMask & CHANNEL_ROTATION)
         {
             Quaternion delta = newRotation * stateTrack.bone_->initialRotation_.Inverse();
-            newRotation = (delta * node->GetRotation()).Normalized();
+            newRotation = (delta * rotation).Normalized();
             if (!Equals(weight, 1.0f))
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                newRotation = rotation.Slerp(newRotation, weight);
+            rotation = newRotation;
         }
         if (channelMask & CHANNEL_SCALE)
         {
             Vector3 delta = newScale - stateTrack.bone_->initialScale_;
-            newScale = node->GetScale() + delta * weight;
+            scale = scale + delta * weight;
         }
     }
     else
@@ -557,31 +568,21 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
         if (!Equals(weight, 1.0f)) // not full weight
         {
             if (channelMask & CHANNEL_POSITION)
-                newPosition = node->GetPosition().Lerp(newPosition, weight);
+                position = position.Lerp(newPosition, weight);
             if (channelMask & CHANNEL_ROTATION)
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                rotation = rotation.Slerp(newRotation, weight);
             if (channelMask & CHANNEL_SCALE)
-                newScale = node->GetScale().Lerp(newScale, weight);
+                scale = scale.Lerp(newScale, weight);
+        }
+        else
+        {
+            if (channelMask & CHANNEL_POSITION)
+                position = newPosition;
+            if (channelMask & CHANNEL_ROTATION)
+                rotation = newRotation;
+            if (channelMask & CHANNEL_SCALE)
+                scale = newScale;
         }
-    }
-
-    if (silent)
-    {
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(newPosition);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(newRotation);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(newScale);
-    }
-    else
-    {
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(newPosition);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(newRotation);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(newScale);
     }
 }
 
@@ -34,10 +34,13 @@ class Animation;
 class AnimatedModel;
 class Deserializer;
 class Node;
+class Quaternion;
 class Serializer;
 class Skeleton;
+class Vector3;
 struct AnimationTrack;
 struct Bone;
+struct SkeletonPose;
 
 /// %Animation blending mode.
 enum AnimationBlendMode
@@ -72,6 +75,8 @@ struct URHO3D_API AnimationStateTrack
     const AnimationTrack* track_;
     /// Bone pointer.
     Bone* bone_;
+    /// Bone index in the model skeleton.
+    unsigned boneIndex_;
     /// Scene node pointer.
     WeakPtr<Node> node_;
     /// Blending weight.
@@ -159,6 +164,8 @@ public:
 
     /// Apply the animation at the current time position.
     void Apply();
+    /// Blend the animation at the current time position into a skeleton pose of the model without touching the bone nodes. Model mode only.
+    void ApplyToPose(SkeletonPose& pose);
 
 private:
     /// Apply animation to a skeleton. Transform changes are applied silently, so the model needs to dirty its root model afterward.
@@ -167,6 +174,8 @@ private:
     void ApplyToNodes();
     /// Apply track.
     void ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent);
+    /// Sample track at the current time position and blend it over the given transform.
+    void BlendTrack(AnimationStateTrack& stateTrack, float weight, Vector3& position, Quaternion& rotation, Vector3& scale);
 
     /// Animated model (model mode.)
     WeakPtr<AnimatedModel> model_;
@@ -24,6 +24,7 @@
 
 #include <EASTL/sort.h>
 
+#include "../Core/Timer.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/Graphics.h"
@@ -82,6 +83,85 @@ inline bool CompareBatchGroupOrder(const BatchGroup* lhs, const BatchGroup* rhs)
     return lhs->renderOrder_ < rhs->renderOrder_;
 }
 
+/// Convert float to an unsigned integer which sorts in the same order.
+inline unsigned FloatToSortableBits(float value)
+{
+    unsigned bits;
+    memcpy(&bits, &value, sizeof bits);
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+/// Return number of bits needed to store values up to count - 1.
+inline unsigned GetNumBitsNeeded(unsigned count)
+{
+    unsigned bits = 0;
+    while (bits < 32 && (1ull << bits) < count)
+        ++bits;
+    return bits;
+}
+
+/// Return radix sort key for distance sorting. Render order has priority, ties are broken by the shader part of the state sorting key.
+inline unsigned long long GetDistanceSortKey(const Batch* batch, bool backToFront)
+{
+    unsigned distanceBits = FloatToSortableBits(batch->distance_);
+    if (backToFront)
+        distanceBits = ~distanceBits;
+
+    return ((unsigned long long)batch->renderOrder_ << 56u) | ((unsigned long long)distanceBits << 24u) | (batch->sortKey_ >> 40u);
+}
+
+/// Sort elements by 64-bit keys using stable least significant digit first radix sort. Digits which are the same in all keys are skipped. Return pointer to the sorted elements, which is either data or buffer.
+template <class T, class U> T* RadixSort(T* data, T* buffer, unsigned count, U getKey)
+{
+    static const unsigned NUM_DIGITS = 8;
+
+    if (count < 2)
+        return data;
+
+    unsigned histograms[NUM_DIGITS][256] = {};
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const unsigned long long key = getKey(data[i]);
+        for (unsigned j = 0; j < NUM_DIGITS; ++j)
+            ++histograms[j][(key >> (j * 8u)) & 0xffu];
+    }
+
+    T* src = data;
+    T* dest = buffer;
+    for (unsigned j = 0; j < NUM_DIGITS; ++j)
+    {
+        unsigned* histogram = histograms[j];
+        const unsigned shift = j * 8u;
+        if (histogram[(getKey(src[0]) >> shift) & 0xffu] == count)
+            continue;
+
+        unsigned offset = 0;
+        for (unsigned k = 0; k < 256; ++k)
+        {
+            const unsigned num = histogram[k];
+            histogram[k] = offset;
+            offset += num;
+        }
+
+        for (unsigned i = 0; i < count; ++i)
+            dest[histogram[(getKey(src[i]) >> shift) & 0xffu]++] = src[i];
+
+        ea::swap(src, dest);
+    }
+
+    return src;
+}
+
+/// Radix sort batch records by their keys.
+static void SortBatchRecords(ea::vector<BatchSortRecord>& records, ea::vector<BatchSortRecord>& buffer)
+{
+    buffer.resize(records.size());
+    const BatchSortRecord* sorted = RadixSort(records.data(), buffer.data(), records.size(),
+        [](const BatchSortRecord& record) { return record.key_; });
+    if (sorted != records.data())
+        records.swap(buffer);
+}
+
 void CalculateShadowMatrix(Matrix4& dest, LightBatchQueue* queue, unsigned split, Renderer* renderer)
 {
     Camera* shadowCamera = queue->shadowSplits_[split].shadowCamera_;
@@ -721,67 +801,118 @@ unsigned BatchGroupKey::ToHash() const
                       (size_t)material_ / sizeof(Material) + (size_t)geometry_ / sizeof(Geometry)) + renderOrder_;
 }
 
-void BatchQueue::Clear(int maxSortedInstances)
+void BatchQueue::Clear(int maxSortedInstances, bool radixSort)
 {
     batches_.clear();
     sortedBatches_.clear();
-    batchGroups_.clear();
+    sortedBatchGroups_.clear();
+
+    // Keep the groups used during the last frame, so that their map entries and instance storage are reused
+    for (auto i = batchGroups_.begin(); i != batchGroups_.end();)
+    {
+        if (i->second.used_)
+        {
+            i->second.used_ = false;
+            i->second.instances_.clear();
+            ++i;
+        }
+        else
+            i = batchGroups_.erase(i);
+    }
+
     maxSortedInstances_ = (unsigned)maxSortedInstances;
+    radixSort_ = radixSort;
+    numReusedBatchGroups_ = 0;
+    sortTime_ = 0;
 }
 
 void BatchQueue::SortBackToFront()
 {
+    HiresTimer sortTimer;
+
     sortedBatches_.resize(batches_.size());
 
-    for (unsigned i = 0; i < batches_.size(); ++i)
-        sortedBatches_[i] = &batches_[i];
+    if (radixSort_)
+    {
+        sortRecords_.resize(batches_.size());
+        for (unsigned i = 0; i < batches_.size(); ++i)
+            sortRecords_[i] = { GetDistanceSortKey(&batches_[i], true), &batches_[i] };
+
+        SortBatchRecords(sortRecords_, sortBuffer_);
 
-    ea::quick_sort(sortedBatches_.begin(), sortedBatches_.end(), CompareBatchesBackToFront);
+        for (unsigned i = 0; i < sortRecords_.size(); ++i)
+            sortedBatches_[i] = sortRecords_[i].batch_;
 
-    sortedBatchGroups_.resize(batchGroups_.size());
+        sortRecords_.resize(sortedBatchGroups_.size());
+        for (unsigned i = 0; i < sortedBatchGroups_.size(); ++i)
+            sortRecords_[i] = { sortedBatchGroups_[i]->renderOrder_, sortedBatchGroups_[i] };
 
-    unsigned index = 0;
-    for (auto i = batchGroups_.begin(); i != batchGroups_.end(); ++i)
-        sortedBatchGroups_[index++] = &i->second;
+        SortBatchRecords(sortRecords_, sortBuffer_);
 
-    ea::quick_sort(sortedBatchGroups_.begin(), sortedBatchGroups_.end(), CompareBatchGroupOrder);
+        for (unsigned i = 0; i < sortRecords_.size(); ++i)
+            sortedBatchGroups_[i] = static_cast<BatchGroup*>(sortRecords_[i].batch_);
+    }
+    else
+    {
+        for (unsigned i = 0; i < batches_.size(); ++i)
+            sortedBatches_[i] = &batches_[i];
+
+        ea::quick_sort(sortedBatches_.begin(), sortedBatches_.end(), CompareBatchesBackToFront);
+        ea::quick_sort(sortedBatchGroups_.begin(), sortedBatchGroups_.end(), CompareBatchGroupOrder);
+    }
+
+    sortTime_ += sortTimer.GetUSec(false);
 }
 
 void BatchQueue::SortFrontToBack()
 {
+    HiresTimer sortTimer;
+
     sortedBatches_.clear();
 
     for (unsigned i = 0; i < batches_.size(); ++i)
         sortedBatches_.push_back(&batches_[i]);
 
-    SortFrontToBack2Pass(sortedBatches_);
+    if (radixSort_)
+        SortFrontToBackRadix(sortedBatches_);
+    else
+        SortFrontToBack2Pass(sortedBatches_);
 
     // Sort each group front to back
-    for (auto i = batchGroups_.begin(); i != batchGroups_.end(); ++i)
+    for (auto i = sortedBatchGroups_.begin(); i != sortedBatchGroups_.end(); ++i)
     {
-        if (i->second.instances_.size() <= maxSortedInstances_)
+        BatchGroup* group = *i;
+        if (group->instances_.size() <= maxSortedInstances_)
         {
-            ea::quick_sort(i->second.instances_.begin(), i->second.instances_.end(), CompareInstancesFrontToBack);
-            if (i->second.instances_.size())
-                i->second.distance_ = i->second.instances_[0].distance_;
+            if (radixSort_)
+            {
+                instanceSortBuffer_.resize(group->instances_.size());
+                const InstanceData* sorted = RadixSort(group->instances_.data(), instanceSortBuffer_.data(),
+                    group->instances_.size(), [](const InstanceData& instance) { return FloatToSortableBits(instance.distance_); });
+                if (sorted != group->instances_.data())
+                    group->instances_.swap(instanceSortBuffer_);
+            }
+            else
+                ea::quick_sort(group->instances_.begin(), group->instances_.end(), CompareInstancesFrontToBack);
+
+            if (group->instances_.size())
+                group->distance_ = group->instances_[0].distance_;
         }
         else
         {
             float minDistance = M_INFINITY;
-            for (auto j = i->second.instances_.begin(); j !=
-                i->second.instances_.end(); ++j)
+            for (auto j = group->instances_.begin(); j != group->instances_.end(); ++j)
                 minDistance = Min(minDistance, j->distance_);
-            i->second.distance_ = minDistance;
+            group->distance_ = minDistance;
         }
     }
 
-    sortedBatchGroups_.resize(batchGroups_.size());
-
-    unsigned index = 0;
-    for (auto i = batchGroups_.begin(); i != batchGroups_.end(); ++i)
-        sortedBatchGroups_[index++] = &i->second;
+    if (radixSort_)
+        SortFrontToBackRadix(reinterpret_cast<ea::vector<Batch*>& >(sortedBatchGroups_));
+    else
+        SortFrontToBack2Pass(reinterpret_cast<ea::vector<Batch*>& >(sortedBatchGroups_));
 
-    SortFrontToBack2Pass(reinterpret_cast<ea::vector<Batch*>& >(sortedBatchGroups_));
+    sortTime_ += sortTimer.GetUSec(false);
 }
 
 void BatchQueue::SortFrontToBack2Pass(ea::vector<Batch*>& batches)
@@ -794,6 +925,66 @@ void BatchQueue::SortFrontToBack2Pass(ea::vector<Batch*>& batches)
     // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
     ea::quick_sort(batches.begin(), batches.end(), CompareBatchesFrontToBack);
 
+    RemapSortKeys(batches);
+
+    // Finally sort again with the rewritten ID's
+    ea::quick_sort(batches.begin(), batches.end(), CompareBatchesState);
+#endif
+}
+
+void BatchQueue::SortFrontToBackRadix(ea::vector<Batch*>& batches)
+{
+#ifdef GL_ES_VERSION_2_0
+    // The state key with render order does not fit the radix sort key, and is sorted the same way as with the 2-pass method
+    ea::quick_sort(batches.begin(), batches.end(), CompareBatchesState);
+#else
+    // First sort by distance, then remap shader/material/geometry IDs to small consecutive numbers
+    sortRecords_.resize(batches.size());
+    for (unsigned i = 0; i < batches.size(); ++i)
+        sortRecords_[i] = { GetDistanceSortKey(batches[i], false), batches[i] };
+
+    SortBatchRecords(sortRecords_, sortBuffer_);
+
+    for (unsigned i = 0; i < sortRecords_.size(); ++i)
+        batches[i] = sortRecords_[i].batch_;
+
+    unsigned numShaderIDs;
+    unsigned numMaterialIDs;
+    unsigned numGeometryIDs;
+    RemapSortKeys(batches, &numShaderIDs, &numMaterialIDs, &numGeometryIDs);
+
+    // Pack render order and the remapped IDs into one key. The sort is stable, so distance order is kept for equal state
+    const unsigned geometryBits = GetNumBitsNeeded(numGeometryIDs);
+    const unsigned materialBits = GetNumBitsNeeded(numMaterialIDs);
+    const unsigned shaderBits = GetNumBitsNeeded(numShaderIDs);
+    if (9 + shaderBits + materialBits + geometryBits > 64)
+    {
+        ea::quick_sort(batches.begin(), batches.end(), CompareBatchesState);
+        return;
+    }
+
+    for (unsigned i = 0; i < sortRecords_.size(); ++i)
+    {
+        BatchSortRecord& record = sortRecords_[i];
+        const unsigned long long sortKey = record.batch_->sortKey_;
+        const unsigned long long shaderID = (sortKey >> 32u) & 0x7fffffffu;
+        const unsigned long long materialID = (sortKey >> 16u) & 0xffffu;
+        const unsigned long long geometryID = sortKey & 0xffffu;
+
+        record.key_ = ((unsigned long long)record.batch_->renderOrder_ << 56u) | ((sortKey >> 63u) << 55u) |
+            (shaderID << (materialBits + geometryBits)) | (materialID << geometryBits) | geometryID;
+    }
+
+    SortBatchRecords(sortRecords_, sortBuffer_);
+
+    for (unsigned i = 0; i < sortRecords_.size(); ++i)
+        batches[i] = sortRecords_[i].batch_;
+#endif
+}
+
+void BatchQueue::RemapSortKeys(ea::vector<Batch*>& batches, unsigned* numShaderIDs, unsigned* numMaterialIDs,
+    unsigned* numGeometryIDs)
+{
     unsigned freeShaderID = 0;
     unsigned short freeMaterialID = 0;
     unsigned short freeGeometryID = 0;
@@ -835,19 +1026,23 @@ void BatchQueue::SortFrontToBack2Pass(ea::vector<Batch*>& batches)
         batch->sortKey_ = (((unsigned long long)shaderID) << 32u) | (((unsigned long long)materialID) << 16u) | geometryID;
     }
 
+    // Report the number of distinct IDs. Material and geometry IDs wrap around at 16 bits
+    if (numShaderIDs)
+        *numShaderIDs = freeShaderID;
+    if (numMaterialIDs)
+        *numMaterialIDs = materialRemapping_.size() > 0xffffu ? 0x10000u : materialRemapping_.size();
+    if (numGeometryIDs)
+        *numGeometryIDs = geometryRemapping_.size() > 0xffffu ? 0x10000u : geometryRemapping_.size();
+
     shaderRemapping_.clear();
     materialRemapping_.clear();
     geometryRemapping_.clear();
-
-    // Finally sort again with the rewritten ID's
-    ea::quick_sort(batches.begin(), batches.end(), CompareBatchesState);
-#endif
 }
 
 void BatchQueue::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex)
 {
-    for (auto i = batchGroups_.begin(); i != batchGroups_.end(); ++i)
-        i->second.SetInstancingData(lockedData, stride, freeIndex);
+    for (auto i = sortedBatchGroups_.begin(); i != sortedBatchGroups_.end(); ++i)
+        (*i)->SetInstancingData(lockedData, stride, freeIndex);
 }
 
 void BatchQueue::Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const
@@ -897,11 +1092,10 @@ unsigned BatchQueue::GetNumInstances() const
 {
     unsigned total = 0;
 
-    for (auto i = batchGroups_.begin(); i !=
-        batchGroups_.end(); ++i)
+    for (auto i = sortedBatchGroups_.begin(); i != sortedBatchGroups_.end(); ++i)
     {
-        if (i->second.geometryType_ == GEOM_INSTANCED)
-            total += i->second.instances_.size();
+        if ((*i)->geometryType_ == GEOM_INSTANCED)
+            total += (*i)->instances_.size();
     }
 
     return total;
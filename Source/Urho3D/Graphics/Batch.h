@@ -172,6 +172,17 @@ struct BatchGroup : public Batch
     ea::vector<InstanceData> instances_;
     /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
     unsigned startIndex_;
+    /// Whether the group has been used since the queue was last cleared. Groups left unused for a whole frame are removed.
+    bool used_{};
+};
+
+/// Compact record for radix sorting batches.
+struct BatchSortRecord
+{
+    /// Sort key.
+    unsigned long long key_;
+    /// Batch.
+    Batch* batch_;
 };
 
 /// Instanced draw call grouping key.
@@ -226,14 +237,19 @@ struct BatchGroupKey
 struct BatchQueue
 {
 public:
-    /// Clear for new frame by clearing all groups and batches.
-    void Clear(int maxSortedInstances);
+    /// Clear for new frame by clearing all batches. Batch groups are kept for reuse, unless they were not used during the last frame.
+    void Clear(int maxSortedInstances, bool radixSort);
     /// Sort non-instanced draw calls back to front.
     void SortBackToFront();
     /// Sort instanced and non-instanced draw calls front to back.
     void SortFrontToBack();
     /// Sort batches front to back while also maintaining state sorting.
     void SortFrontToBack2Pass(ea::vector<Batch*>& batches);
+    /// Sort batches front to back while also maintaining state sorting, using radix sort on compact records.
+    void SortFrontToBackRadix(ea::vector<Batch*>& batches);
+    /// Remap shader, material and geometry IDs in the sort keys of distance sorted batches to consecutive numbers. Optionally return the number of distinct IDs.
+    void RemapSortKeys(ea::vector<Batch*>& batches, unsigned* numShaderIDs = nullptr, unsigned* numMaterialIDs = nullptr,
+        unsigned* numGeometryIDs = nullptr);
     /// Pre-set instance data of all groups. The vertex buffer must be big enough to hold all data.
     void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex);
     /// Draw.
@@ -242,9 +258,9 @@ public:
     unsigned GetNumInstances() const;
 
     /// Return whether the batch group is empty.
-    bool IsEmpty() const { return batches_.empty() && batchGroups_.empty(); }
+    bool IsEmpty() const { return batches_.empty() && sortedBatchGroups_.empty(); }
 
-    /// Instanced draw calls.
+    /// Instanced draw calls. Kept between frames.
     ea::unordered_map<BatchGroupKey, BatchGroup> batchGroups_;
     /// Shader remapping table for 2-pass state and distance sort.
     ea::unordered_map<unsigned, unsigned> shaderRemapping_;
@@ -257,10 +273,22 @@ public:
     ea::vector<Batch> batches_;
     /// Sorted non-instanced draw calls.
     ea::vector<Batch*> sortedBatches_;
-    /// Sorted instanced draw calls.
+    /// Sorted instanced draw calls. Groups are added here when first used during the frame.
     ea::vector<BatchGroup*> sortedBatchGroups_;
+    /// Radix sort records.
+    ea::vector<BatchSortRecord> sortRecords_;
+    /// Radix sort temporary buffer.
+    ea::vector<BatchSortRecord> sortBuffer_;
+    /// Instance radix sort temporary buffer.
+    ea::vector<InstanceData> instanceSortBuffer_;
     /// Maximum sorted instances.
     unsigned maxSortedInstances_;
+    /// Whether to use radix sort instead of comparison sort.
+    bool radixSort_{};
+    /// Number of batch groups reused from the previous frame.
+    unsigned numReusedBatchGroups_{};
+    /// Time spent sorting during the last frame in microseconds.
+    long long sortTime_{};
     /// Whether the pass command contains extra shader defines.
     bool hasExtraDefines_;
     /// Vertex shader extra defines.
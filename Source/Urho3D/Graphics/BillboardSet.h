@@ -163,6 +163,18 @@ protected:
     void OnWorldBoundingBoxUpdate() override;
     /// Mark billboard vertex buffer to need an update.
     void MarkPositionsDirty();
+    /// Return number of billboards the vertex and index buffers are sized for.
+    virtual unsigned GetMaxBillboards() const { return billboards_.size(); }
+    /// Rewrite billboard vertex buffer.
+    virtual void UpdateVertexBuffer(const FrameInfo& frame);
+    /// Calculate billboard scale factors in fixed screen size mode.
+    virtual void CalculateFixedScreenSize(const FrameInfo& frame);
+    /// Write the vertices of one billboard facing the camera. Return the position after the written vertices.
+    static float* WriteBillboardVertices(float* dest, const Vector3& position, const Vector2& size, const Rect& uv, unsigned color,
+        float rotation);
+    /// Write the vertices of one billboard aligned to a direction. Return the position after the written vertices.
+    static float* WriteDirectionBillboardVertices(float* dest, const Vector3& position, const Vector3& direction, const Vector2& size,
+        const Rect& uv, unsigned color, float rotation);
 
     /// Billboards.
     ea::vector<Billboard> billboards_;
@@ -182,29 +194,29 @@ protected:
     FaceCameraMode faceCameraMode_;
     /// Minimal angle between billboard normal and look-at direction.
     float minAngle_;
+    /// Vertex buffer.
+    SharedPtr<VertexBuffer> vertexBuffer_;
+    /// Buffers need resize flag.
+    bool bufferSizeDirty_;
+    /// Vertex buffer needs rewrite flag.
+    bool bufferDirty_;
+    /// Force update flag (ignore animation LOD momentarily.)
+    bool forceUpdate_;
+    /// Previous offset to camera for determining whether sorting is necessary.
+    Vector3 previousOffset_;
 
 private:
     /// Resize billboard vertex and index buffers.
     void UpdateBufferSize();
-    /// Rewrite billboard vertex buffer.
-    void UpdateVertexBuffer(const FrameInfo& frame);
-    /// Calculate billboard scale factors in fixed screen size mode.
-    void CalculateFixedScreenSize(const FrameInfo& frame);
+    /// Advance the animation LOD timer. Return true if the vertex buffer should be rewritten now.
+    bool CheckAnimationLod(const FrameInfo& frame);
 
     /// Geometry.
     SharedPtr<Geometry> geometry_;
-    /// Vertex buffer.
-    SharedPtr<VertexBuffer> vertexBuffer_;
     /// Index buffer.
     SharedPtr<IndexBuffer> indexBuffer_;
     /// Transform matrices for position and billboard orientation.
     Matrix3x4 transforms_[2];
-    /// Buffers need resize flag.
-    bool bufferSizeDirty_;
-    /// Vertex buffer needs rewrite flag.
-    bool bufferDirty_;
-    /// Force update flag (ignore animation LOD momentarily.)
-    bool forceUpdate_;
     /// Update billboard geometry type
     bool geometryTypeUpdate_;
     /// Sorting flag. Triggers a vertex buffer rewrite for each view this billboard set is rendered from.
@@ -213,8 +225,6 @@ private:
     bool hasOrthoCamera_;
     /// Frame number on which was last sorted.
     unsigned sortFrameNumber_;
-    /// Previous offset to camera for determining whether sorting is necessary.
-    Vector3 previousOffset_;
     /// Billboard pointers for sorting.
     ea::vector<Billboard*> sortedBillboards_;
     /// Attribute buffer for network replication.
@@ -31,6 +31,7 @@
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
 class IndexBuffer;
 class VertexBuffer;
 
@@ -226,7 +227,7 @@ private:
     /// Subscribe/unsubscribe from scene post-update as necessary.
     void UpdateEventSubscription(bool checkAllDecals);
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const SceneUpdate::Data& eventData);
 
     /// Geometry.
     SharedPtr<Geometry> geometry_;
@@ -189,6 +189,8 @@ void Drawable::SetLodBias(float bias)
 void Drawable::SetViewMask(unsigned mask)
 {
     viewMask_ = mask;
+    if (octant_)
+        octant_->UpdateDrawableViewMask(this);
     MarkNetworkUpdate();
 }
 
@@ -57,7 +57,6 @@ class Octant;
 class RayOctreeQuery;
 class Zone;
 struct RayQueryResult;
-struct WorkItem;
 
 /// Geometry update type.
 enum UpdateGeometryType
@@ -132,7 +131,6 @@ class URHO3D_API Drawable : public Component
 
     friend class Octant;
     friend class Octree;
-    friend void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex);
 
 public:
     /// Construct.
@@ -366,6 +364,8 @@ protected:
     bool zoneDirty_;
     /// Octree octant.
     Octant* octant_;
+    /// Index in the octant's drawable list.
+    unsigned octantIndex_{};
     /// Current zone.
     Zone* zone_;
     /// View mask.
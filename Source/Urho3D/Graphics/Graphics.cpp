@@ -47,6 +47,7 @@
 #include "../Graphics/StaticModelGroup.h"
 #include "../Graphics/Technique.h"
 #include "../Graphics/Terrain.h"
+#include "../Graphics/TerrainPager.h"
 #include "../Graphics/TerrainPatch.h"
 #ifdef _WIN32
 #include "../Graphics/Texture2D.h"
@@ -432,6 +433,7 @@ void RegisterGraphicsLibrary(Context* context)
     DecalSet::RegisterObject(context);
     Terrain::RegisterObject(context);
     TerrainPatch::RegisterObject(context);
+    TerrainPager::RegisterObject(context);
     DebugRenderer::RegisterObject(context);
     Octree::RegisterObject(context);
     Zone::RegisterObject(context);
@@ -45,14 +45,6 @@ enum ClipMask : unsigned
 };
 URHO3D_FLAGSET(ClipMask, ClipMaskFlags);
 
-void DrawOcclusionBatchWork(const WorkItem* item, unsigned threadIndex)
-{
-    URHO3D_PROFILE("DrawOcclusionBatchWork");
-    auto* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
-    OcclusionBatch& batch = *reinterpret_cast<OcclusionBatch*>(item->start_);
-    buffer->DrawBatch(batch, threadIndex);
-}
-
 OcclusionBuffer::OcclusionBuffer(Context* context) :
     Object(context)
 {
@@ -221,12 +213,12 @@ void OcclusionBuffer::DrawTriangles()
 
         for (auto i = batches_.begin(); i != batches_.end(); ++i)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = DrawOcclusionBatchWork;
-            item->aux_ = this;
-            item->start_ = &(*i);
-            queue->AddWorkItem(item);
+            OcclusionBatch* batch = &(*i);
+            queue->AddTask([this, batch](unsigned threadIndex)
+            {
+                URHO3D_PROFILE("DrawOcclusionBatchWork");
+                DrawBatch(*batch, threadIndex);
+            });
         }
 
         queue->Complete(M_MAX_UNSIGNED);
@@ -47,25 +47,10 @@ namespace Urho3D
 
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
+static const unsigned DRAWABLE_UPDATE_GRAIN_SIZE = 64;
 
 extern const char* SUBSYSTEM_CATEGORY;
 
-void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
-{
-    URHO3D_PROFILE("UpdateDrawablesWork");
-    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
-
-    while (start != end)
-    {
-        Drawable* drawable = *start;
-        if (drawable)
-            drawable->Update(frame);
-        ++start;
-    }
-}
-
 inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
@@ -88,10 +73,11 @@ Octant::~Octant()
         for (auto i = drawables_.begin(); i != drawables_.end(); ++i)
         {
             (*i)->SetOctant(root_);
-            root_->drawables_.push_back(*i);
+            root_->PushDrawable(*i);
             root_->QueueUpdate(*i);
         }
         drawables_.clear();
+        drawableData_.Clear();
         numDrawables_ = 0;
     }
 
@@ -152,9 +138,13 @@ void Octant::InsertDrawable(Drawable* drawable)
         if (oldOctant != this)
         {
             // Add first, then remove, because drawable count going to zero deletes the octree branch in question
+            const unsigned oldIndex = drawable->octantIndex_;
             AddDrawable(drawable);
             if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
+            {
+                oldOctant->RemoveDrawableAt(oldIndex);
+                oldOctant->DecDrawableCount();
+            }
         }
     }
     else
@@ -247,7 +237,20 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     {
         auto** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.size();
-        query.TestDrawables(start, end, inside);
+
+        if (root_->GetBatchedCulling() && query.TestDrawableBounds(drawableData_, start, inside))
+        {
+            // Only the drawables which passed the batched test are accessed. Drawables with out of date bounds get the full test
+            if (!query.candidates_.empty())
+                query.TestDrawables(query.candidates_.data(), query.candidates_.data() + query.candidates_.size(), true);
+            if (!query.uncheckedCandidates_.empty())
+            {
+                query.TestDrawables(query.uncheckedCandidates_.data(),
+                    query.uncheckedCandidates_.data() + query.uncheckedCandidates_.size(), inside);
+            }
+        }
+        else
+            query.TestDrawables(start, end, inside);
     }
 
     for (auto child : children_)
@@ -314,12 +317,13 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, ea::vector<Drawable
 Octree::Octree(Context* context) :
     Component(context),
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, nullptr, this),
-    numLevels_(DEFAULT_OCTREE_LEVELS)
+    numLevels_(DEFAULT_OCTREE_LEVELS),
+    particleManager_(this)
 {
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
     if (!GetSubsystem<Graphics>())
-        SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Octree, HandleRenderUpdate));
+        SubscribeToEvent(E_RENDERUPDATE, &Octree::HandleRenderUpdate);
 }
 
 Octree::~Octree()
@@ -339,6 +343,7 @@ void Octree::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE_EX("Bounding Box Min", Vector3, worldBoundingBox_.min_, UpdateOctreeSize, defaultBoundsMin, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Bounding Box Max", Vector3, worldBoundingBox_.max_, UpdateOctreeSize, defaultBoundsMax, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Number of Levels", int, numLevels_, UpdateOctreeSize, DEFAULT_OCTREE_LEVELS, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Batched Culling", bool, batchedCulling_, false, AM_DEFAULT);
 }
 
 void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -383,30 +388,21 @@ void Octree::Update(const FrameInfo& frame)
         auto* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.size() / numWorkItems), 1);
+        // Particle emitters are simulated together, before the rest of their update
+        particleManager_.Update(frame);
 
-        auto start = drawableUpdates_.begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        // Split into small chunks, so that threads which finish early can take work from the others
+        queue->ParallelFor(0, drawableUpdates_.size(), DRAWABLE_UPDATE_GRAIN_SIZE,
+            [this, &frame](unsigned begin, unsigned end, unsigned /*threadIndex*/)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            auto end = drawableUpdates_.end();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
+            URHO3D_PROFILE("UpdateDrawablesWork");
+            for (unsigned i = begin; i < end; ++i)
+            {
+                if (Drawable* drawable = drawableUpdates_[i])
+                    drawable->Update(frame);
+            }
+        });
 
-        queue->Complete(M_MAX_UNSIGNED);
         scene->EndThreadedUpdate();
     }
 
@@ -457,11 +453,15 @@ void Octree::Update(const FrameInfo& frame)
             // Skip if no octant or does not belong to this octree anymore
             if (!octant || octant->GetRoot() != this)
                 continue;
-            // Skip if still fits the current octant
+            // Skip reinsertion if still fits the current octant, but refresh the batched culling data
             if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+            {
+                octant->UpdateDrawableData(drawable);
                 continue;
+            }
 
             InsertDrawable(drawable);
+            drawable->GetOctant()->UpdateDrawableData(drawable);
 
 #ifdef _DEBUG
             // Verify that the drawable will be culled correctly
@@ -562,6 +562,10 @@ void Octree::QueueUpdate(Drawable* drawable)
     else
         drawableUpdates_.push_back(drawable);
 
+    // Bounds in the batched culling data are no longer reliable, let queries test the drawable itself until reinsertion
+    if (Octant* octant = drawable->GetOctant())
+        octant->MarkDrawableDataDirty(drawable);
+
     drawable->updateQueued_ = true;
 }
 
@@ -579,21 +583,32 @@ void Octree::DrawDebugGeometry(bool depthTest)
     DrawDebugGeometry(debug, depthTest);
 }
 
-void Octree::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Octree::OnSceneSet(Scene* scene)
+{
+    if (scene)
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, &Octree::HandleScenePostUpdate);
+    else
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+void Octree::HandleRenderUpdate(const Update::Data& eventData)
 {
     // When running in headless mode, update the Octree manually during the RenderUpdate event
     Scene* scene = GetScene();
     if (!scene || !scene->IsUpdateEnabled())
         return;
 
-    using namespace RenderUpdate;
-
     FrameInfo frame;
     frame.frameNumber_ = GetSubsystem<Time>()->GetFrameNumber();
-    frame.timeStep_ = eventData[P_TIMESTEP].GetFloat();
+    frame.timeStep_ = eventData.timeStep_;
     frame.camera_ = nullptr;
 
     Update(frame);
 }
 
+void Octree::HandleScenePostUpdate(const SceneUpdate::Data& eventData)
+{
+    particleManager_.PostUpdate(eventData.timeStep_);
+}
+
 }
@@ -25,10 +25,13 @@
 #include "../Core/Mutex.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/OctreeQuery.h"
+#include "../Graphics/ParticleManager.h"
 
 namespace Urho3D
 {
 
+namespace Update { struct Data; }
+namespace SceneUpdate { struct Data; }
 class Octree;
 
 static const int NUM_OCTANTS = 8;
@@ -56,23 +59,35 @@ public:
     void AddDrawable(Drawable* drawable)
     {
         drawable->SetOctant(this);
-        drawables_.push_back(drawable);
+        PushDrawable(drawable);
         IncDrawableCount();
     }
 
     /// Remove a drawable object from this octant.
     void RemoveDrawable(Drawable* drawable, bool resetOctant = true)
     {
-        auto it = drawables_.find(drawable);
-        if (it != drawables_.end())
+        unsigned index = drawable->octantIndex_;
+        if (index >= drawables_.size() || drawables_[index] != drawable)
         {
-            drawables_.erase(it);
-            if (resetOctant)
-                drawable->SetOctant(nullptr);
-            DecDrawableCount();
+            auto it = drawables_.find(drawable);
+            if (it == drawables_.end())
+                return;
+            index = it - drawables_.begin();
         }
+
+        RemoveDrawableAt(index);
+        if (resetOctant)
+            drawable->SetOctant(nullptr);
+        DecDrawableCount();
     }
 
+    /// Refresh batched culling data of a drawable object in this octant.
+    void UpdateDrawableData(Drawable* drawable) { drawableData_.Update(drawable->octantIndex_, drawable); }
+    /// Mark batched culling bounds of a drawable object in this octant out of date.
+    void MarkDrawableDataDirty(Drawable* drawable) { drawableData_.MarkDirty(drawable->octantIndex_); }
+    /// Refresh view mask of a drawable object in this octant.
+    void UpdateDrawableViewMask(Drawable* drawable) { drawableData_.SetViewMask(drawable->octantIndex_, drawable->GetViewMask()); }
+
     /// Return world-space bounding box.
     const BoundingBox& GetWorldBoundingBox() const { return worldBoundingBox_; }
 
@@ -109,6 +124,27 @@ protected:
     /// Return drawable objects only for a threaded ray query, called internally.
     void GetDrawablesOnlyInternal(RayOctreeQuery& query, ea::vector<Drawable*>& drawables) const;
 
+    /// Append a drawable object to the drawable list and the batched culling data.
+    void PushDrawable(Drawable* drawable)
+    {
+        drawable->octantIndex_ = drawables_.size();
+        drawables_.push_back(drawable);
+        drawableData_.Push(drawable);
+    }
+
+    /// Remove a drawable object from the drawable list and the batched culling data by moving the last one in its place.
+    void RemoveDrawableAt(unsigned index)
+    {
+        const unsigned last = drawables_.size() - 1;
+        if (index != last)
+        {
+            drawables_[index] = drawables_[last];
+            drawables_[index]->octantIndex_ = index;
+        }
+        drawables_.pop_back();
+        drawableData_.RemoveSwap(index);
+    }
+
     /// Increase drawable object count recursively.
     void IncDrawableCount()
     {
@@ -137,8 +173,10 @@ protected:
     BoundingBox worldBoundingBox_;
     /// Bounding box used for drawable object fitting.
     BoundingBox cullingBox_;
-    /// Drawable objects.
+    /// Drawable objects. Order is not preserved on removal.
     ea::vector<Drawable*> drawables_;
+    /// Bounding boxes, flags and view masks of the drawable objects for batched culling.
+    OctantDrawableData drawableData_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS]{};
     /// World bounding box center.
@@ -189,8 +227,13 @@ public:
     /// Return the closest drawable object by a ray query.
     void RaycastSingle(RayOctreeQuery& query) const;
 
+    /// Set whether to use the batched culling data for queries. Drawable objects are then accessed only if they pass the bounds test.
+    void SetBatchedCulling(bool enable) { batchedCulling_ = enable; }
+
     /// Return subdivision levels.
     unsigned GetNumLevels() const { return numLevels_; }
+    /// Return whether batched culling is used for queries.
+    bool GetBatchedCulling() const { return batchedCulling_; }
 
     /// Mark drawable object as requiring an update and a reinsertion.
     void QueueUpdate(Drawable* drawable);
@@ -199,9 +242,18 @@ public:
     /// Visualize the component as debug geometry.
     void DrawDebugGeometry(bool depthTest);
 
+    /// Return the particle manager that simulates the particle emitters in the octree.
+    ParticleManager& GetParticleManager() { return particleManager_; }
+
+protected:
+    /// Handle scene being assigned.
+    void OnSceneSet(Scene* scene) override;
+
 private:
     /// Handle render update in case of headless execution.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const Update::Data& eventData);
+    /// Handle scene post-update event.
+    void HandleScenePostUpdate(const SceneUpdate::Data& eventData);
     /// Update octree size.
     void UpdateOctreeSize() { SetSize(worldBoundingBox_, numLevels_); }
 
@@ -215,6 +267,10 @@ private:
     mutable ea::vector<Drawable*> rayQueryDrawables_;
     /// Subdivision level.
     unsigned numLevels_;
+    /// Batched culling flag.
+    bool batchedCulling_{};
+    /// Particle emitter simulation.
+    ParticleManager particleManager_;
 };
 
 }
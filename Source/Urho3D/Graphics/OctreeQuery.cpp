@@ -29,6 +29,368 @@
 namespace Urho3D
 {
 
+/// Batched point containment test.
+struct PointBoundsTest
+{
+    /// Construct.
+    explicit PointBoundsTest(const Vector3& point) :
+        point_(point)
+    {
+    }
+
+    /// Test one entry.
+    bool TestOne(const OctantDrawableData& data, unsigned i) const
+    {
+        return point_.x_ >= data.minX_[i] && point_.x_ <= data.maxX_[i] &&
+            point_.y_ >= data.minY_[i] && point_.y_ <= data.maxY_[i] &&
+            point_.z_ >= data.minZ_[i] && point_.z_ <= data.maxZ_[i];
+    }
+
+#ifdef URHO3D_SSE
+    /// Test four entries. Return a bit mask of the entries which pass.
+    int TestFour(const OctantDrawableData& data, unsigned i) const
+    {
+        const __m128 x = _mm_set1_ps(point_.x_);
+        const __m128 y = _mm_set1_ps(point_.y_);
+        const __m128 z = _mm_set1_ps(point_.z_);
+        __m128 inside = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&data.minX_[i]), x), _mm_cmpge_ps(_mm_loadu_ps(&data.maxX_[i]), x));
+        inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&data.minY_[i]), y), _mm_cmpge_ps(_mm_loadu_ps(&data.maxY_[i]), y)));
+        inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&data.minZ_[i]), z), _mm_cmpge_ps(_mm_loadu_ps(&data.maxZ_[i]), z)));
+        return _mm_movemask_ps(inside);
+    }
+#endif
+
+    /// Point.
+    Vector3 point_;
+};
+
+/// Batched sphere intersection test.
+struct SphereBoundsTest
+{
+    /// Construct.
+    explicit SphereBoundsTest(const Sphere& sphere) :
+        center_(sphere.center_),
+        radiusSquared_(sphere.radius_ * sphere.radius_)
+    {
+    }
+
+    /// Test one entry.
+    bool TestOne(const OctantDrawableData& data, unsigned i) const
+    {
+        const float dx = Max(Max(data.minX_[i] - center_.x_, center_.x_ - data.maxX_[i]), 0.0f);
+        const float dy = Max(Max(data.minY_[i] - center_.y_, center_.y_ - data.maxY_[i]), 0.0f);
+        const float dz = Max(Max(data.minZ_[i] - center_.z_, center_.z_ - data.maxZ_[i]), 0.0f);
+        return dx * dx + dy * dy + dz * dz < radiusSquared_;
+    }
+
+#ifdef URHO3D_SSE
+    /// Test four entries. Return a bit mask of the entries which pass.
+    int TestFour(const OctantDrawableData& data, unsigned i) const
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 x = _mm_set1_ps(center_.x_);
+        const __m128 y = _mm_set1_ps(center_.y_);
+        const __m128 z = _mm_set1_ps(center_.z_);
+        const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&data.minX_[i]), x), _mm_sub_ps(x, _mm_loadu_ps(&data.maxX_[i]))), zero);
+        const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&data.minY_[i]), y), _mm_sub_ps(y, _mm_loadu_ps(&data.maxY_[i]))), zero);
+        const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&data.minZ_[i]), z), _mm_sub_ps(z, _mm_loadu_ps(&data.maxZ_[i]))), zero);
+        const __m128 distSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        return _mm_movemask_ps(_mm_cmplt_ps(distSquared, _mm_set1_ps(radiusSquared_)));
+    }
+#endif
+
+    /// Sphere center.
+    Vector3 center_;
+    /// Squared sphere radius.
+    float radiusSquared_;
+};
+
+/// Batched bounding box intersection test.
+struct BoxBoundsTest
+{
+    /// Construct.
+    explicit BoxBoundsTest(const BoundingBox& box) :
+        min_(box.min_),
+        max_(box.max_)
+    {
+    }
+
+    /// Test one entry.
+    bool TestOne(const OctantDrawableData& data, unsigned i) const
+    {
+        return data.maxX_[i] >= min_.x_ && data.minX_[i] <= max_.x_ &&
+            data.maxY_[i] >= min_.y_ && data.minY_[i] <= max_.y_ &&
+            data.maxZ_[i] >= min_.z_ && data.minZ_[i] <= max_.z_;
+    }
+
+#ifdef URHO3D_SSE
+    /// Test four entries. Return a bit mask of the entries which pass.
+    int TestFour(const OctantDrawableData& data, unsigned i) const
+    {
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&data.maxX_[i]), _mm_set1_ps(min_.x_)),
+            _mm_cmple_ps(_mm_loadu_ps(&data.minX_[i]), _mm_set1_ps(max_.x_)));
+        inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&data.maxY_[i]), _mm_set1_ps(min_.y_)),
+            _mm_cmple_ps(_mm_loadu_ps(&data.minY_[i]), _mm_set1_ps(max_.y_))));
+        inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&data.maxZ_[i]), _mm_set1_ps(min_.z_)),
+            _mm_cmple_ps(_mm_loadu_ps(&data.minZ_[i]), _mm_set1_ps(max_.z_))));
+        return _mm_movemask_ps(inside);
+    }
+#endif
+
+    /// Box minimum.
+    Vector3 min_;
+    /// Box maximum.
+    Vector3 max_;
+};
+
+/// Batched frustum intersection test. Same as Frustum::IsInsideFast().
+struct FrustumBoundsTest
+{
+    /// Construct.
+    explicit FrustumBoundsTest(const Frustum& frustum) :
+        frustum_(frustum)
+    {
+#ifdef URHO3D_SSE
+        for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+        {
+            const Plane& plane = frustum.planes_[i];
+            normalX_[i] = _mm_set1_ps(plane.normal_.x_);
+            normalY_[i] = _mm_set1_ps(plane.normal_.y_);
+            normalZ_[i] = _mm_set1_ps(plane.normal_.z_);
+            absNormalX_[i] = _mm_set1_ps(plane.absNormal_.x_);
+            absNormalY_[i] = _mm_set1_ps(plane.absNormal_.y_);
+            absNormalZ_[i] = _mm_set1_ps(plane.absNormal_.z_);
+            d_[i] = _mm_set1_ps(plane.d_);
+        }
+#endif
+    }
+
+    /// Test one entry.
+    template <class T> bool TestOne(const T& data, unsigned i) const
+    {
+        const Vector3 min(data.minX_[i], data.minY_[i], data.minZ_[i]);
+        const Vector3 center = (Vector3(data.maxX_[i], data.maxY_[i], data.maxZ_[i]) + min) * 0.5f;
+        const Vector3 edge = center - min;
+
+        for (const auto& plane : frustum_.planes_)
+        {
+            if (plane.normal_.DotProduct(center) + plane.d_ < -plane.absNormal_.DotProduct(edge))
+                return false;
+        }
+
+        return true;
+    }
+
+#ifdef URHO3D_SSE
+    /// Test four entries. Return a bit mask of the entries which pass.
+    template <class T> int TestFour(const T& data, unsigned i) const
+    {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 minX = _mm_loadu_ps(&data.minX_[i]);
+        const __m128 minY = _mm_loadu_ps(&data.minY_[i]);
+        const __m128 minZ = _mm_loadu_ps(&data.minZ_[i]);
+        const __m128 centerX = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&data.maxX_[i]), minX), half);
+        const __m128 centerY = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&data.maxY_[i]), minY), half);
+        const __m128 centerZ = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&data.maxZ_[i]), minZ), half);
+        const __m128 edgeX = _mm_sub_ps(centerX, minX);
+        const __m128 edgeY = _mm_sub_ps(centerY, minY);
+        const __m128 edgeZ = _mm_sub_ps(centerZ, minZ);
+
+        __m128 outside = _mm_setzero_ps();
+        for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+        {
+            const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX_[j], centerX),
+                _mm_mul_ps(normalY_[j], centerY)), _mm_mul_ps(normalZ_[j], centerZ)), d_[j]);
+            const __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absNormalX_[j], edgeX),
+                _mm_mul_ps(absNormalY_[j], edgeY)), _mm_mul_ps(absNormalZ_[j], edgeZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(_mm_setzero_ps(), absDist)));
+        }
+
+        return ~_mm_movemask_ps(outside) & 0xf;
+    }
+#endif
+
+    /// Frustum.
+    const Frustum& frustum_;
+#ifdef URHO3D_SSE
+    /// Plane normal X components.
+    __m128 normalX_[NUM_FRUSTUM_PLANES];
+    /// Plane normal Y components.
+    __m128 normalY_[NUM_FRUSTUM_PLANES];
+    /// Plane normal Z components.
+    __m128 normalZ_[NUM_FRUSTUM_PLANES];
+    /// Absolute plane normal X components.
+    __m128 absNormalX_[NUM_FRUSTUM_PLANES];
+    /// Absolute plane normal Y components.
+    __m128 absNormalY_[NUM_FRUSTUM_PLANES];
+    /// Absolute plane normal Z components.
+    __m128 absNormalZ_[NUM_FRUSTUM_PLANES];
+    /// Plane distances.
+    __m128 d_[NUM_FRUSTUM_PLANES];
+#endif
+};
+
+/// Test that always passes. Used when only flags and view mask need to be checked.
+struct NoBoundsTest
+{
+    /// Test one entry.
+    bool TestOne(const OctantDrawableData& /*data*/, unsigned /*i*/) const { return true; }
+
+#ifdef URHO3D_SSE
+    /// Test four entries.
+    int TestFour(const OctantDrawableData& /*data*/, unsigned /*i*/) const { return 0xf; }
+#endif
+};
+
+/// Collect the drawables of an octant which pass the flags, view mask and bounds tests into the query candidate lists. Bounds are tested four at a time when SSE is enabled.
+template <class T> static void CollectCandidates(OctreeQuery& query, const OctantDrawableData& data, Drawable* const* drawables,
+    bool inside, const T& test)
+{
+    query.candidates_.clear();
+    query.uncheckedCandidates_.clear();
+
+    const unsigned size = data.Size();
+    const unsigned drawableFlags = query.drawableFlags_.AsInteger();
+    const unsigned viewMask = query.viewMask_;
+    const unsigned* flags = data.flags_.data();
+    const unsigned* viewMasks = data.viewMasks_.data();
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    if (!inside)
+    {
+        for (; i + 4 <= size; i += 4)
+        {
+            const int passed = test.TestFour(data, i);
+            for (unsigned j = 0; j < 4; ++j)
+            {
+                const unsigned index = i + j;
+                if (!(flags[index] & drawableFlags) || !(viewMasks[index] & viewMask))
+                    continue;
+
+                if (flags[index] & OctantDrawableData::DIRTY_FLAG)
+                    query.uncheckedCandidates_.push_back(drawables[index]);
+                else if (passed & (1 << j))
+                    query.candidates_.push_back(drawables[index]);
+            }
+        }
+    }
+#endif
+
+    for (; i < size; ++i)
+    {
+        if (!(flags[i] & drawableFlags) || !(viewMasks[i] & viewMask))
+            continue;
+
+        if (flags[i] & OctantDrawableData::DIRTY_FLAG)
+            query.uncheckedCandidates_.push_back(drawables[i]);
+        else if (inside || test.TestOne(data, i))
+            query.candidates_.push_back(drawables[i]);
+    }
+}
+
+void OctantDrawableData::Push(Drawable* drawable)
+{
+    minX_.push_back(0.0f);
+    minY_.push_back(0.0f);
+    minZ_.push_back(0.0f);
+    maxX_.push_back(0.0f);
+    maxY_.push_back(0.0f);
+    maxZ_.push_back(0.0f);
+    viewMasks_.push_back(drawable->GetViewMask());
+    flags_.push_back(drawable->GetDrawableFlags().AsInteger() | DIRTY_FLAG);
+}
+
+void OctantDrawableData::Update(unsigned index, Drawable* drawable)
+{
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+    minX_[index] = box.min_.x_;
+    minY_[index] = box.min_.y_;
+    minZ_[index] = box.min_.z_;
+    maxX_[index] = box.max_.x_;
+    maxY_[index] = box.max_.y_;
+    maxZ_[index] = box.max_.z_;
+    viewMasks_[index] = drawable->GetViewMask();
+    flags_[index] = drawable->GetDrawableFlags().AsInteger();
+}
+
+void OctantDrawableData::RemoveSwap(unsigned index)
+{
+    const unsigned last = flags_.size() - 1;
+    if (index != last)
+    {
+        minX_[index] = minX_[last];
+        minY_[index] = minY_[last];
+        minZ_[index] = minZ_[last];
+        maxX_[index] = maxX_[last];
+        maxY_[index] = maxY_[last];
+        maxZ_[index] = maxZ_[last];
+        viewMasks_[index] = viewMasks_[last];
+        flags_[index] = flags_[last];
+    }
+
+    minX_.pop_back();
+    minY_.pop_back();
+    minZ_.pop_back();
+    maxX_.pop_back();
+    maxY_.pop_back();
+    maxZ_.pop_back();
+    viewMasks_.pop_back();
+    flags_.pop_back();
+}
+
+void OctantDrawableData::Clear()
+{
+    minX_.clear();
+    minY_.clear();
+    minZ_.clear();
+    maxX_.clear();
+    maxY_.clear();
+    maxZ_.clear();
+    viewMasks_.clear();
+    flags_.clear();
+}
+
+void BoundingBoxArray::Push(const BoundingBox& box)
+{
+    minX_.push_back(box.min_.x_);
+    minY_.push_back(box.min_.y_);
+    minZ_.push_back(box.min_.z_);
+    maxX_.push_back(box.max_.x_);
+    maxY_.push_back(box.max_.y_);
+    maxZ_.push_back(box.max_.z_);
+}
+
+void BoundingBoxArray::Clear()
+{
+    minX_.clear();
+    minY_.clear();
+    minZ_.clear();
+    maxX_.clear();
+    maxY_.clear();
+    maxZ_.clear();
+}
+
+void BoundingBoxArray::TestFrustum(const Frustum& frustum, ea::vector<unsigned char>& result) const
+{
+    const unsigned size = Size();
+    const FrustumBoundsTest test(frustum);
+    result.resize(size);
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    for (; i + 4 <= size; i += 4)
+    {
+        const int mask = test.TestFour(*this, i);
+        for (unsigned j = 0; j < 4; ++j)
+            result[i + j] = (unsigned char)((mask >> j) & 1);
+    }
+#endif
+
+    for (; i < size; ++i)
+        result[i] = test.TestOne(*this, i);
+}
+
 Intersection PointOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -51,6 +413,12 @@ void PointOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool insi
     }
 }
 
+bool PointOctreeQuery::TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside)
+{
+    CollectCandidates(*this, data, drawables, inside, PointBoundsTest(point_));
+    return true;
+}
+
 Intersection SphereOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -73,6 +441,12 @@ void SphereOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool ins
     }
 }
 
+bool SphereOctreeQuery::TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside)
+{
+    CollectCandidates(*this, data, drawables, inside, SphereBoundsTest(sphere_));
+    return true;
+}
+
 Intersection BoxOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -95,6 +469,12 @@ void BoxOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool inside
     }
 }
 
+bool BoxOctreeQuery::TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside)
+{
+    CollectCandidates(*this, data, drawables, inside, BoxBoundsTest(box_));
+    return true;
+}
+
 Intersection FrustumOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -117,6 +497,11 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     }
 }
 
+bool FrustumOctreeQuery::TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside)
+{
+    CollectCandidates(*this, data, drawables, inside, FrustumBoundsTest(frustum_));
+    return true;
+}
 
 Intersection AllContentOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
@@ -134,4 +519,10 @@ void AllContentOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool
     }
 }
 
+bool AllContentOctreeQuery::TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside)
+{
+    CollectCandidates(*this, data, drawables, inside, NoBoundsTest());
+    return true;
+}
+
 }
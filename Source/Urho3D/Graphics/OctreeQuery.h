@@ -34,6 +34,74 @@ namespace Urho3D
 class Drawable;
 class Node;
 
+/// Structure-of-arrays copy of the culling data of the drawables in an octant, kept parallel to the octant's drawable list. Allows octree queries to test several bounding boxes at once without accessing the drawables.
+struct URHO3D_API OctantDrawableData
+{
+    /// Flag set on entries whose bounding box is out of date. Such drawables are tested by the query as usual.
+    static const unsigned DIRTY_FLAG = 0x100;
+
+    /// Add an entry. The bounding box is marked out of date until updated.
+    void Push(Drawable* drawable);
+    /// Copy bounding box, flags and view mask of the drawable to the entry.
+    void Update(unsigned index, Drawable* drawable);
+    /// Remove an entry by moving the last entry in its place.
+    void RemoveSwap(unsigned index);
+    /// Remove all entries.
+    void Clear();
+
+    /// Mark bounding box of an entry out of date.
+    void MarkDirty(unsigned index) { flags_[index] |= DIRTY_FLAG; }
+    /// Set view mask of an entry.
+    void SetViewMask(unsigned index, unsigned viewMask) { viewMasks_[index] = viewMask; }
+
+    /// Return number of entries.
+    unsigned Size() const { return flags_.size(); }
+
+    /// Bounding box minimum X coordinates.
+    ea::vector<float> minX_;
+    /// Bounding box minimum Y coordinates.
+    ea::vector<float> minY_;
+    /// Bounding box minimum Z coordinates.
+    ea::vector<float> minZ_;
+    /// Bounding box maximum X coordinates.
+    ea::vector<float> maxX_;
+    /// Bounding box maximum Y coordinates.
+    ea::vector<float> maxY_;
+    /// Bounding box maximum Z coordinates.
+    ea::vector<float> maxZ_;
+    /// View masks.
+    ea::vector<unsigned> viewMasks_;
+    /// Drawable flags and the dirty flag.
+    ea::vector<unsigned> flags_;
+};
+
+/// Structure-of-arrays bounding boxes, which can be tested against a frustum several at a time.
+struct URHO3D_API BoundingBoxArray
+{
+    /// Add a bounding box.
+    void Push(const BoundingBox& box);
+    /// Remove all bounding boxes.
+    void Clear();
+    /// Test all bounding boxes against a frustum. Set the result to nonzero for the boxes which are inside or intersect it. Tested four at a time when SSE is enabled.
+    void TestFrustum(const Frustum& frustum, ea::vector<unsigned char>& result) const;
+
+    /// Return number of bounding boxes.
+    unsigned Size() const { return minX_.size(); }
+
+    /// Bounding box minimum X coordinates.
+    ea::vector<float> minX_;
+    /// Bounding box minimum Y coordinates.
+    ea::vector<float> minY_;
+    /// Bounding box minimum Z coordinates.
+    ea::vector<float> minZ_;
+    /// Bounding box maximum X coordinates.
+    ea::vector<float> maxX_;
+    /// Bounding box maximum Y coordinates.
+    ea::vector<float> maxY_;
+    /// Bounding box maximum Z coordinates.
+    ea::vector<float> maxZ_;
+};
+
 /// Base class for octree queries.
 class URHO3D_API OctreeQuery
 {
@@ -58,6 +126,8 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Batched bounds, flags and view mask test for the drawables of an octant. Fill the candidate lists and return true if supported. Candidates are then passed to TestDrawables() as being inside, so subclasses may only add filters on top of the flags and view mask.
+    virtual bool TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside) { return false; }
 
     /// Result vector reference.
     ea::vector<Drawable*>& result_;
@@ -65,6 +135,10 @@ public:
     DrawableFlags drawableFlags_;
     /// Drawable layers to include.
     unsigned viewMask_;
+    /// Drawables which passed the batched test.
+    ea::vector<Drawable*> candidates_;
+    /// Drawables with out of date bounds in the batched culling data, which need the regular test.
+    ea::vector<Drawable*> uncheckedCandidates_;
 };
 
 /// Point octree query.
@@ -83,6 +157,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Batched bounds, flags and view mask test for the drawables of an octant.
+    bool TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside) override;
 
     /// Point.
     Vector3 point_;
@@ -104,6 +180,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Batched bounds, flags and view mask test for the drawables of an octant.
+    bool TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside) override;
 
     /// Sphere.
     Sphere sphere_;
@@ -125,6 +203,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Batched bounds, flags and view mask test for the drawables of an octant.
+    bool TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside) override;
 
     /// Bounding box.
     BoundingBox box_;
@@ -146,6 +226,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Batched bounds, flags and view mask test for the drawables of an octant.
+    bool TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside) override;
 
     /// Frustum.
     Frustum frustum_;
@@ -279,6 +361,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Batched bounds, flags and view mask test for the drawables of an octant.
+    bool TestDrawableBounds(const OctantDrawableData& data, Drawable* const* drawables, bool inside) override;
 };
 
 }
@@ -22,15 +22,22 @@
 
 #include "../Precompiled.h"
 
+#include <EASTL/sort.h>
+
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/Camera.h"
 #include "../Graphics/DrawableEvents.h"
+#include "../Graphics/Geometry.h"
+#include "../Graphics/Octree.h"
+#include "../Graphics/OctreeQuery.h"
 #include "../Graphics/ParticleEffect.h"
 #include "../Graphics/ParticleEmitter.h"
+#include "../Graphics/VertexBuffer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 #include "../Scene/Scene.h"
-#include "../Scene/SceneEvents.h"
 
 #include "../DebugNew.h"
 
@@ -40,17 +47,71 @@ namespace Urho3D
 extern const char* GEOMETRY_CATEGORY;
 extern const char* faceCameraModeNames[];
 static const unsigned MAX_PARTICLES_IN_FRAME = 100;
+static const unsigned PARTICLE_VERTEX_GRAIN_SIZE = 4096;
+static const float INV_SQRT_TWO = 1.0f / sqrtf(2.0f);
 
 extern const char* autoRemoveModeNames[];
 
+void ParticleStreams::SetCapacity(unsigned capacity)
+{
+    positionX_.resize(capacity);
+    positionY_.resize(capacity);
+    positionZ_.resize(capacity);
+    velocityX_.resize(capacity);
+    velocityY_.resize(capacity);
+    velocityZ_.resize(capacity);
+    sizeX_.resize(capacity);
+    sizeY_.resize(capacity);
+    scale_.resize(capacity);
+    rotation_.resize(capacity);
+    rotationSpeed_.resize(capacity);
+    timer_.resize(capacity);
+    timeToLive_.resize(capacity);
+    screenScaleFactor_.resize(capacity);
+    color_.resize(capacity);
+    colorIndex_.resize(capacity);
+    texIndex_.resize(capacity);
+    size_ = Min(size_, capacity);
+}
+
+void ParticleStreams::RemoveSwap(unsigned index)
+{
+    --size_;
+    if (index != size_)
+        Copy(index, size_);
+}
+
+void ParticleStreams::Copy(unsigned dest, unsigned src)
+{
+    positionX_[dest] = positionX_[src];
+    positionY_[dest] = positionY_[src];
+    positionZ_[dest] = positionZ_[src];
+    velocityX_[dest] = velocityX_[src];
+    velocityY_[dest] = velocityY_[src];
+    velocityZ_[dest] = velocityZ_[src];
+    sizeX_[dest] = sizeX_[src];
+    sizeY_[dest] = sizeY_[src];
+    scale_[dest] = scale_[src];
+    rotation_[dest] = rotation_[src];
+    rotationSpeed_[dest] = rotationSpeed_[src];
+    timer_[dest] = timer_[src];
+    timeToLive_[dest] = timeToLive_[src];
+    screenScaleFactor_[dest] = screenScaleFactor_[src];
+    color_[dest] = color_[src];
+    colorIndex_[dest] = colorIndex_[src];
+    texIndex_[dest] = texIndex_[src];
+}
+
 ParticleEmitter::ParticleEmitter(Context* context) :
     BillboardSet(context),
+    managerIndex_(M_MAX_UNSIGNED),
     periodTimer_(0.0f),
     emissionTimer_(0.0f),
     lastTimeStep_(0.0f),
     lastUpdateFrameNumber_(M_MAX_UNSIGNED),
     emitting_(true),
     needUpdate_(false),
+    simulationChanged_(false),
     serializeParticles_(true),
     sendFinishedEvent_(true),
     autoRemove_(REMOVE_DISABLED)
@@ -58,7 +119,12 @@ ParticleEmitter::ParticleEmitter(Context* context) :
     SetNumParticles(DEFAULT_NUM_PARTICLES);
 }
 
-ParticleEmitter::~ParticleEmitter() = default;
+ParticleEmitter::~ParticleEmitter()
+{
+    // Removal from the octree in the Drawable destructor can not call OnRemoveFromOctree() of this class anymore
+    if (ParticleManager* manager = GetParticleManager())
+        manager->RemoveEmitter(this);
+}
 
 void ParticleEmitter::RegisterObject(Context* context)
 {
@@ -79,185 +145,60 @@ void ParticleEmitter::RegisterObject(Context* context)
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Particles", GetParticlesAttr, SetParticlesAttr, VariantVector, Variant::emptyVariantVector,
         AM_FILE | AM_NOEDIT);
-    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Billboards", GetParticleBillboardsAttr, SetBillboardsAttr, VariantVector, Variant::emptyVariantVector,
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Billboards", GetParticleBillboardsAttr, SetParticleBillboardsAttr, VariantVector, Variant::emptyVariantVector,
         AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Serialize Particles", bool, serializeParticles_, true, AM_FILE);
 }
 
-void ParticleEmitter::OnSetEnabled()
+void ParticleEmitter::ProcessRayQuery(const RayOctreeQuery& query, ea::vector<RayQueryResult>& results)
 {
-    BillboardSet::OnSetEnabled();
-
-    Scene* scene = GetScene();
-    if (scene)
+    // If no particle-level testing, use the Drawable test
+    if (query.level_ < RAY_TRIANGLE)
     {
-        if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(ParticleEmitter, HandleScenePostUpdate));
-        else
-            UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
-    }
-}
-
-void ParticleEmitter::Update(const FrameInfo& frame)
-{
-    if (!effect_)
-        return;
-
-    // Cancel update if has only moved but does not actually need to animate the particles
-    if (!needUpdate_)
+        Drawable::ProcessRayQuery(query, results);
         return;
-
-    // If there is an amount mismatch between particles and billboards, correct it
-    if (particles_.size() != billboards_.size())
-        SetNumBillboards(particles_.size());
-
-    bool needCommit = false;
-
-    // Check active/inactive period switching
-    periodTimer_ += lastTimeStep_;
-    if (emitting_)
-    {
-        float activeTime = effect_->GetActiveTime();
-        if (activeTime && periodTimer_ >= activeTime)
-        {
-            emitting_ = false;
-            periodTimer_ -= activeTime;
-        }
     }
-    else
-    {
-        float inactiveTime = effect_->GetInactiveTime();
-        if (inactiveTime && periodTimer_ >= inactiveTime)
-        {
-            emitting_ = true;
-            sendFinishedEvent_ = true;
-            periodTimer_ -= inactiveTime;
-        }
-        // If emitter has an indefinite stop interval, keep period timer reset to allow restarting emission in the editor
-        if (inactiveTime == 0.0f)
-            periodTimer_ = 0.0f;
-    }
-
-    // Check for emitting new particles
-    if (emitting_)
-    {
-        emissionTimer_ += lastTimeStep_;
 
-        float intervalMin = 1.0f / effect_->GetMaxEmissionRate();
-        float intervalMax = 1.0f / effect_->GetMinEmissionRate();
-
-        // If emission timer has a longer delay than max. interval, clamp it
-        if (emissionTimer_ < -intervalMax)
-            emissionTimer_ = -intervalMax;
-
-        unsigned counter = MAX_PARTICLES_IN_FRAME;
-
-        while (emissionTimer_ > 0.0f && counter)
-        {
-            emissionTimer_ -= Lerp(intervalMin, intervalMax, Random(1.0f));
-            if (EmitNewParticle())
-            {
-                --counter;
-                needCommit = true;
-            }
-            else
-                break;
-        }
-    }
+    // Check ray hit distance to AABB before proceeding with particle-level tests
+    if (query.ray_.HitDistance(GetWorldBoundingBox()) >= query.maxDistance_)
+        return;
 
-    // Update existing particles
-    Vector3 relativeConstantForce = node_->GetWorldRotation().Inverse() * effect_->GetConstantForce();
-    // If billboards are not relative, apply scaling to the position update
-    Vector3 scaleVector = Vector3::ONE;
-    if (scaled_ && !relative_)
-        scaleVector = node_->GetWorldScale();
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
+    Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
 
-    for (unsigned i = 0; i < particles_.size(); ++i)
+    for (unsigned i = 0; i < particles_.Size(); ++i)
     {
-        Particle& particle = particles_[i];
-        Billboard& billboard = billboards_[i];
-
-        if (billboard.enabled_)
+        // Approximate the particles as spheres for raycasting
+        float size = INV_SQRT_TWO * particles_.scale_[i] * (particles_.sizeX_[i] * billboardScale.x_ +
+            particles_.sizeY_[i] * billboardScale.y_);
+        if (fixedScreenSize_)
+            size *= particles_.screenScaleFactor_[i];
+        Vector3 center = billboardTransform * Vector3(particles_.positionX_[i], particles_.positionY_[i], particles_.positionZ_[i]);
+        Sphere particleSphere(center, size);
+
+        float distance = query.ray_.HitDistance(particleSphere);
+        if (distance < query.maxDistance_)
         {
-            needCommit = true;
-
-            // Time to live
-            if (particle.timer_ >= particle.timeToLive_)
-            {
-                billboard.enabled_ = false;
-                continue;
-            }
-            particle.timer_ += lastTimeStep_;
-
-            // Velocity & position
-            const Vector3& constantForce = effect_->GetConstantForce();
-            if (constantForce != Vector3::ZERO)
-            {
-                if (relative_)
-                    particle.velocity_ += lastTimeStep_ * relativeConstantForce;
-                else
-                    particle.velocity_ += lastTimeStep_ * constantForce;
-            }
-
-            float dampingForce = effect_->GetDampingForce();
-            if (dampingForce != 0.0f)
-            {
-                Vector3 force = -dampingForce * particle.velocity_;
-                particle.velocity_ += lastTimeStep_ * force;
-            }
-            billboard.position_ += lastTimeStep_ * particle.velocity_ * scaleVector;
-            billboard.direction_ = particle.velocity_.Normalized();
-
-            // Rotation
-            billboard.rotation_ += lastTimeStep_ * particle.rotationSpeed_;
-
-            // Scaling
-            float sizeAdd = effect_->GetSizeAdd();
-            float sizeMul = effect_->GetSizeMul();
-            if (sizeAdd != 0.0f || sizeMul != 1.0f)
-            {
-                particle.scale_ += lastTimeStep_ * sizeAdd;
-                if (particle.scale_ < 0.0f)
-                    particle.scale_ = 0.0f;
-                if (sizeMul != 1.0f)
-                    particle.scale_ *= (lastTimeStep_ * (sizeMul - 1.0f)) + 1.0f;
-                billboard.size_ = particle.size_ * particle.scale_;
-            }
-
-            // Color interpolation
-            unsigned& index = particle.colorIndex_;
-            const ea::vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
-            if (index < colorFrames_.size())
-            {
-                if (index < colorFrames_.size() - 1)
-                {
-                    if (particle.timer_ >= colorFrames_[index + 1].time_)
-                        ++index;
-                }
-                if (index < colorFrames_.size() - 1)
-                    billboard.color_ = colorFrames_[index].Interpolate(colorFrames_[index + 1], particle.timer_);
-                else
-                    billboard.color_ = colorFrames_[index].color_;
-            }
-
-            // Texture animation
-            unsigned& texIndex = particle.texIndex_;
-            const ea::vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
-            if (textureFrames_.size() && texIndex < textureFrames_.size() - 1)
-            {
-                if (particle.timer_ >= textureFrames_[texIndex + 1].time_)
-                {
-                    billboard.uv_ = textureFrames_[texIndex + 1].uv_;
-                    ++texIndex;
-                }
-            }
+            RayQueryResult result;
+            result.position_ = query.ray_.origin_ + distance * query.ray_.direction_;
+            result.normal_ = -query.ray_.direction_;
+            result.distance_ = distance;
+            result.drawable_ = this;
+            result.node_ = node_;
+            result.subObject_ = i;
+            results.push_back(result);
         }
     }
+}
 
-    if (needCommit)
-        Commit();
+void ParticleEmitter::OnSetEnabled()
+{
+    BillboardSet::OnSetEnabled();
 
-    needUpdate_ = false;
+    // When disabled, the emitter is removed from the particle manager along with the octree
+    if (ParticleManager* manager = GetParticleManager())
+        manager->AddEmitter(this);
 }
 
 void ParticleEmitter::SetEffect(ParticleEffect* effect)
@@ -286,8 +227,12 @@ void ParticleEmitter::SetNumParticles(unsigned num)
     if (num > M_MAX_INT)
         num = 0;
 
-    particles_.resize(num);
-    SetNumBillboards(num);
+    if (num == particles_.Capacity())
+        return;
+
+    particles_.SetCapacity(num);
+    bufferSizeDirty_ = true;
+    Commit();
 }
 
 void ParticleEmitter::SetEmitting(bool enable)
@@ -322,9 +267,7 @@ void ParticleEmitter::ResetEmissionTimer()
 
 void ParticleEmitter::RemoveAllParticles()
 {
-    for (auto i = billboards_.begin(); i != billboards_.end(); ++i)
-        i->enabled_ = false;
-
+    particles_.Clear();
     Commit();
 }
 
@@ -371,16 +314,23 @@ void ParticleEmitter::SetParticlesAttr(const VariantVector& value)
     unsigned index = 0;
     SetNumParticles(index < value.size() ? value[index++].GetUInt() : 0);
 
-    for (auto i = particles_.begin(); i != particles_.end() && index < value.size(); ++i)
+    // Particle data is stored for all particles up to the maximum. The billboards attribute tells which of them are live
+    particles_.Clear();
+    for (unsigned i = 0; i < particles_.Capacity() && index < value.size(); ++i)
     {
-        i->velocity_ = value[index++].GetVector3();
-        i->size_ = value[index++].GetVector2();
-        i->timer_ = value[index++].GetFloat();
-        i->timeToLive_ = value[index++].GetFloat();
-        i->scale_ = value[index++].GetFloat();
-        i->rotationSpeed_ = value[index++].GetFloat();
-        i->colorIndex_ = (unsigned)value[index++].GetInt();
-        i->texIndex_ = (unsigned)value[index++].GetInt();
+        const Vector3 velocity = value[index++].GetVector3();
+        const Vector2 size = value[index++].GetVector2();
+        particles_.velocityX_[i] = velocity.x_;
+        particles_.velocityY_[i] = velocity.y_;
+        particles_.velocityZ_[i] = velocity.z_;
+        particles_.sizeX_[i] = size.x_;
+        particles_.sizeY_[i] = size.y_;
+        particles_.timer_[i] = value[index++].GetFloat();
+        particles_.timeToLive_[i] = value[index++].GetFloat();
+        particles_.scale_[i] = value[index++].GetFloat();
+        particles_.rotationSpeed_[i] = value[index++].GetFloat();
+        particles_.colorIndex_[i] = (unsigned)value[index++].GetInt();
+        particles_.texIndex_[i] = (unsigned)value[index++].GetInt();
     }
 }
 
@@ -389,47 +339,97 @@ VariantVector ParticleEmitter::GetParticlesAttr() const
     VariantVector ret;
     if (!serializeParticles_)
     {
-        ret.push_back((int)particles_.size());
+        ret.push_back((int)particles_.Capacity());
         return ret;
     }
 
-    ret.reserve(particles_.size() * 8 + 1);
-    ret.push_back((int)particles_.size());
-    for (auto i = particles_.begin(); i != particles_.end(); ++i)
+    ret.reserve(particles_.Capacity() * 8 + 1);
+    ret.push_back((int)particles_.Capacity());
+    for (unsigned i = 0; i < particles_.Capacity(); ++i)
     {
-        ret.push_back(i->velocity_);
-        ret.push_back(i->size_);
-        ret.push_back(i->timer_);
-        ret.push_back(i->timeToLive_);
-        ret.push_back(i->scale_);
-        ret.push_back(i->rotationSpeed_);
-        ret.push_back(i->colorIndex_);
-        ret.push_back(i->texIndex_);
+        ret.push_back(Vector3(particles_.velocityX_[i], particles_.velocityY_[i], particles_.velocityZ_[i]));
+        ret.push_back(Vector2(particles_.sizeX_[i], particles_.sizeY_[i]));
+        ret.push_back(particles_.timer_[i]);
+        ret.push_back(particles_.timeToLive_[i]);
+        ret.push_back(particles_.scale_[i]);
+        ret.push_back(particles_.rotationSpeed_[i]);
+        ret.push_back(particles_.colorIndex_[i]);
+        ret.push_back(particles_.texIndex_[i]);
     }
     return ret;
 }
 
+void ParticleEmitter::SetParticleBillboardsAttr(const VariantVector& value)
+{
+    unsigned index = 0;
+    unsigned numBillboards = index < value.size() ? value[index++].GetUInt() : 0;
+    SetNumParticles(numBillboards);
+
+    // Dealing with old billboard format, which has no direction
+    const bool hasDirection = value.size() != particles_.Capacity() * 6 + 1;
+
+    // Pack the live particles to the beginning. UV coordinates and direction follow from the particle data
+    particles_.Clear();
+    for (unsigned i = 0; i < particles_.Capacity() && index < value.size(); ++i)
+    {
+        const Vector3 position = value[index++].GetVector3();
+        index += 2;
+        const Color color = value[index++].GetColor();
+        const float rotation = value[index++].GetFloat();
+        if (hasDirection)
+            ++index;
+        if (!value[index++].GetBool())
+            continue;
+
+        const unsigned dest = particles_.Add();
+        if (dest != i)
+            particles_.Copy(dest, i);
+        particles_.positionX_[dest] = position.x_;
+        particles_.positionY_[dest] = position.y_;
+        particles_.positionZ_[dest] = position.z_;
+        particles_.rotation_[dest] = rotation;
+        particles_.color_[dest] = color;
+        particles_.screenScaleFactor_[dest] = 1.0f;
+    }
+
+    Commit();
+}
+
 VariantVector ParticleEmitter::GetParticleBillboardsAttr() const
 {
     VariantVector ret;
     if (!serializeParticles_)
     {
-        ret.push_back((int)billboards_.size());
+        ret.push_back((int)particles_.Capacity());
         return ret;
     }
 
-    ret.reserve(billboards_.size() * 7 + 1);
-    ret.push_back((int)billboards_.size());
+    ret.reserve(particles_.Capacity() * 7 + 1);
+    ret.push_back((int)particles_.Capacity());
 
-    for (auto i = billboards_.begin(); i != billboards_.end(); ++i)
+    const ea::vector<TextureFrame>* textureFrames = effect_ ? &effect_->GetTextureFrames() : nullptr;
+    for (unsigned i = 0; i < particles_.Size(); ++i)
+    {
+        const float scale = particles_.scale_[i];
+        const unsigned texIndex = particles_.texIndex_[i];
+        const Rect& uv = textureFrames && texIndex < textureFrames->size() ? (*textureFrames)[texIndex].uv_ : Rect::POSITIVE;
+        ret.push_back(Vector3(particles_.positionX_[i], particles_.positionY_[i], particles_.positionZ_[i]));
+        ret.push_back(Vector2(particles_.sizeX_[i] * scale, particles_.sizeY_[i] * scale));
+        ret.push_back(Vector4(uv.min_.x_, uv.min_.y_, uv.max_.x_, uv.max_.y_));
+        ret.push_back(particles_.color_[i]);
+        ret.push_back(particles_.rotation_[i]);
+        ret.push_back(Vector3(particles_.velocityX_[i], particles_.velocityY_[i], particles_.velocityZ_[i]).Normalized());
+        ret.push_back(true);
+    }
+    for (unsigned i = particles_.Size(); i < particles_.Capacity(); ++i)
     {
-        ret.push_back(i->position_);
-        ret.push_back(i->size_);
-        ret.push_back(Vector4(i->uv_.min_.x_, i->uv_.min_.y_, i->uv_.max_.x_, i->uv_.max_.y_));
-        ret.push_back(i->color_);
-        ret.push_back(i->rotation_);
-        ret.push_back(i->direction_);
-        ret.push_back(i->enabled_);
+        ret.push_back(Vector3::ZERO);
+        ret.push_back(Vector2::ONE);
+        ret.push_back(Vector4(0.0f, 0.0f, 1.0f, 1.0f));
+        ret.push_back(Color::WHITE);
+        ret.push_back(0.0f);
+        ret.push_back(Vector3::UP);
+        ret.push_back(false);
     }
 
     return ret;
@@ -439,20 +439,154 @@ void ParticleEmitter::OnSceneSet(Scene* scene)
 {
     BillboardSet::OnSceneSet(scene);
 
-    if (scene && IsEnabledEffective())
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(ParticleEmitter, HandleScenePostUpdate));
-    else if (!scene)
-         UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+    if (ParticleManager* manager = GetParticleManager())
+        manager->AddEmitter(this);
+}
+
+void ParticleEmitter::OnRemoveFromOctree()
+{
+    if (ParticleManager* manager = GetParticleManager())
+        manager->RemoveEmitter(this);
+}
+
+void ParticleEmitter::OnWorldBoundingBoxUpdate()
+{
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
+    BoundingBox worldBox;
+
+    if (const unsigned numParticles = particles_.Size())
+    {
+        // Bound the particle positions first, then expand by the largest particle
+        Vector3 min(M_INFINITY, M_INFINITY, M_INFINITY);
+        Vector3 max(-M_INFINITY, -M_INFINITY, -M_INFINITY);
+        float maxSize = 0.0f;
+        for (unsigned i = 0; i < numParticles; ++i)
+        {
+            min.x_ = Min(min.x_, particles_.positionX_[i]);
+            min.y_ = Min(min.y_, particles_.positionY_[i]);
+            min.z_ = Min(min.z_, particles_.positionZ_[i]);
+            max.x_ = Max(max.x_, particles_.positionX_[i]);
+            max.y_ = Max(max.y_, particles_.positionY_[i]);
+            max.z_ = Max(max.z_, particles_.positionZ_[i]);
+
+            float size = particles_.scale_[i] * (particles_.sizeX_[i] * billboardScale.x_ + particles_.sizeY_[i] * billboardScale.y_);
+            if (fixedScreenSize_)
+                size *= particles_.screenScaleFactor_[i];
+            maxSize = Max(maxSize, size);
+        }
+
+        BoundingBox positionBox(min, max);
+        if (relative_)
+            positionBox = positionBox.Transformed(worldTransform);
+        Vector3 edge = Vector3::ONE * (INV_SQRT_TWO * maxSize);
+        worldBox.Merge(BoundingBox(positionBox.min_ - edge, positionBox.max_ + edge));
+    }
+
+    // Always merge the node's own position to ensure particle emitter updates continue when the relative mode is switched
+    worldBox.Merge(node_->GetWorldPosition());
+
+    worldBoundingBox_ = worldBox;
+}
+
+void ParticleEmitter::UpdateVertexBuffer(const FrameInfo& frame)
+{
+    const unsigned numParticles = particles_.Size();
+    batches_[0].geometry_->SetDrawRange(TRIANGLE_LIST, 0, numParticles * 6, false);
+
+    bufferDirty_ = false;
+    forceUpdate_ = false;
+    if (!numParticles)
+        return;
+
+    if (sorted_)
+    {
+        Matrix3x4 billboardTransform = relative_ ? node_->GetWorldTransform() : Matrix3x4::IDENTITY;
+        sortedParticles_.resize(numParticles);
+        sortDistances_.resize(numParticles);
+        for (unsigned i = 0; i < numParticles; ++i)
+        {
+            sortedParticles_[i] = i;
+            sortDistances_[i] = frame.camera_->GetDistanceSquared(billboardTransform *
+                Vector3(particles_.positionX_[i], particles_.positionY_[i], particles_.positionZ_[i]));
+        }
+
+        const float* distances = sortDistances_.data();
+        ea::quick_sort(sortedParticles_.begin(), sortedParticles_.end(),
+            [distances](unsigned lhs, unsigned rhs) { return distances[lhs] > distances[rhs]; });
+
+        Vector3 worldPos = node_->GetWorldPosition();
+        // Store the "last sorted position" now
+        previousOffset_ = (worldPos - frame.camera_->GetNode()->GetWorldPosition());
+    }
+
+    auto* dest = (float*)vertexBuffer_->Lock(0, numParticles * 4, true);
+    if (!dest)
+        return;
+
+    // Large emitters write their vertices on all threads
+    const unsigned billboardSize = vertexBuffer_->GetVertexSize() * 4 / sizeof(float);
+    auto* queue = GetSubsystem<WorkQueue>();
+    queue->ParallelFor(0, numParticles, PARTICLE_VERTEX_GRAIN_SIZE, [this, dest, billboardSize](unsigned begin, unsigned end, unsigned)
+    {
+        WriteParticleVertices(dest + begin * billboardSize, begin, end);
+    });
+
+    vertexBuffer_->Unlock();
+    vertexBuffer_->ClearDataLost();
+}
+
+void ParticleEmitter::CalculateFixedScreenSize(const FrameInfo& frame)
+{
+    float invViewHeight = 1.0f / frame.viewSize_.y_;
+    float halfViewWorldSize = frame.camera_->GetHalfViewSize();
+    bool scaleFactorChanged = false;
+
+    if (!frame.camera_->IsOrthographic())
+    {
+        // Only the W component of the projected position is needed
+        Matrix3x4 billboardTransform = relative_ ? node_->GetWorldTransform() : Matrix3x4::IDENTITY;
+        Matrix4 transform(frame.camera_->GetProjection() * frame.camera_->GetView() * billboardTransform);
+        const float scale = invViewHeight * halfViewWorldSize;
+
+        for (unsigned i = 0; i < particles_.Size(); ++i)
+        {
+            float w = transform.m30_ * particles_.positionX_[i] + transform.m31_ * particles_.positionY_[i] +
+                transform.m32_ * particles_.positionZ_[i] + transform.m33_;
+            float newScaleFactor = scale * w;
+            if (newScaleFactor != particles_.screenScaleFactor_[i])
+            {
+                particles_.screenScaleFactor_[i] = newScaleFactor;
+                scaleFactorChanged = true;
+            }
+        }
+    }
+    else
+    {
+        float newScaleFactor = invViewHeight * halfViewWorldSize;
+        for (unsigned i = 0; i < particles_.Size(); ++i)
+        {
+            if (newScaleFactor != particles_.screenScaleFactor_[i])
+            {
+                particles_.screenScaleFactor_[i] = newScaleFactor;
+                scaleFactorChanged = true;
+            }
+        }
+    }
+
+    if (scaleFactorChanged)
+    {
+        bufferDirty_ = true;
+        forceUpdate_ = true;
+        worldBoundingBoxDirty_ = true;
+    }
 }
 
 bool ParticleEmitter::EmitNewParticle()
 {
-    unsigned index = GetFreeParticle();
+    unsigned index = particles_.Add();
     if (index == M_MAX_UNSIGNED)
         return false;
-    assert(index < particles_.size());
-    Particle& particle = particles_[index];
-    Billboard& billboard = billboards_[index];
 
     Vector3 startDir;
     Vector3 startPos;
@@ -513,17 +647,19 @@ bool ParticleEmitter::EmitNewParticle()
         break;
     }
 
-    particle.size_ = effect_->GetRandomSize();
-    particle.timer_ = 0.0f;
-    particle.timeToLive_ = effect_->GetRandomTimeToLive();
-    particle.scale_ = 1.0f;
-    particle.rotationSpeed_ = effect_->GetRandomRotationSpeed();
-    particle.colorIndex_ = 0;
-    particle.texIndex_ = 0;
+    const Vector2 size = effect_->GetRandomSize();
+    particles_.sizeX_[index] = size.x_;
+    particles_.sizeY_[index] = size.y_;
+    particles_.timer_[index] = 0.0f;
+    particles_.timeToLive_[index] = effect_->GetRandomTimeToLive();
+    particles_.scale_[index] = 1.0f;
+    particles_.rotationSpeed_[index] = effect_->GetRandomRotationSpeed();
+    particles_.colorIndex_[index] = 0;
+    particles_.texIndex_[index] = 0;
 
     if (faceCameraMode_ == FC_DIRECTION)
     {
-        startPos += startDir * particle.size_.y_;
+        startPos += startDir * size.y_;
     }
 
     if (!relative_)
@@ -532,52 +668,26 @@ bool ParticleEmitter::EmitNewParticle()
         startDir = node_->GetWorldRotation() * startDir;
     };
 
-    particle.velocity_ = effect_->GetRandomVelocity() * startDir;
+    const Vector3 velocity = effect_->GetRandomVelocity() * startDir;
+    particles_.velocityX_[index] = velocity.x_;
+    particles_.velocityY_[index] = velocity.y_;
+    particles_.velocityZ_[index] = velocity.z_;
 
-    billboard.position_ = startPos;
-    billboard.size_ = particles_[index].size_;
-    const ea::vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
-    billboard.uv_ = textureFrames_.size() ? textureFrames_[0].uv_ : Rect::POSITIVE;
-    billboard.rotation_ = effect_->GetRandomRotation();
+    particles_.positionX_[index] = startPos.x_;
+    particles_.positionY_[index] = startPos.y_;
+    particles_.positionZ_[index] = startPos.z_;
+    particles_.rotation_[index] = effect_->GetRandomRotation();
     const ea::vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
-    billboard.color_ = colorFrames_.size() ? colorFrames_[0].color_ : Color();
-    billboard.enabled_ = true;
-    billboard.direction_ = startDir;
+    particles_.color_[index] = colorFrames_.size() ? colorFrames_[0].color_ : Color();
+    particles_.screenScaleFactor_[index] = 1.0f;
 
     return true;
 }
 
-unsigned ParticleEmitter::GetFreeParticle() const
-{
-    for (unsigned i = 0; i < billboards_.size(); ++i)
-    {
-        if (!billboards_[i].enabled_)
-            return i;
-    }
-
-    return M_MAX_UNSIGNED;
-}
-
-bool ParticleEmitter::CheckActiveParticles() const
-{
-    for (unsigned i = 0; i < billboards_.size(); ++i)
-    {
-        if (billboards_[i].enabled_)
-        {
-            return true;
-            break;
-        }
-    }
-
-    return false;
-}
-
-void ParticleEmitter::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void ParticleEmitter::PostUpdate(float timeStep)
 {
     // Store scene's timestep and use it instead of global timestep, as time scale may be other than 1
-    using namespace ScenePostUpdate;
-
-    lastTimeStep_ = eventData[P_TIMESTEP].GetFloat();
+    lastTimeStep_ = timeStep;
 
     // If no invisible update, check that the billboardset is in view (framenumber has changed)
     if ((effect_ && effect_->GetUpdateInvisible()) || viewFrameNumber_ != lastUpdateFrameNumber_)
@@ -610,6 +720,230 @@ void ParticleEmitter::HandleScenePostUpdate(StringHash eventType, VariantMap& ev
     }
 }
 
+void ParticleEmitter::PrepareSimulation()
+{
+    simulationChanged_ = false;
+    if (!effect_)
+        return;
+
+    // Remove the particles which reached their time to live on the previous step
+    for (unsigned i = 0; i < particles_.Size();)
+    {
+        if (particles_.timer_[i] >= particles_.timeToLive_[i])
+        {
+            particles_.RemoveSwap(i);
+            simulationChanged_ = true;
+        }
+        else
+            ++i;
+    }
+
+    // Check active/inactive period switching
+    periodTimer_ += lastTimeStep_;
+    if (emitting_)
+    {
+        float activeTime = effect_->GetActiveTime();
+        if (activeTime && periodTimer_ >= activeTime)
+        {
+            emitting_ = false;
+            periodTimer_ -= activeTime;
+        }
+    }
+    else
+    {
+        float inactiveTime = effect_->GetInactiveTime();
+        if (inactiveTime && periodTimer_ >= inactiveTime)
+        {
+            emitting_ = true;
+            sendFinishedEvent_ = true;
+            periodTimer_ -= inactiveTime;
+        }
+        // If emitter has an indefinite stop interval, keep period timer reset to allow restarting emission in the editor
+        if (inactiveTime == 0.0f)
+            periodTimer_ = 0.0f;
+    }
+
+    // Check for emitting new particles
+    if (emitting_)
+    {
+        emissionTimer_ += lastTimeStep_;
+
+        float intervalMin = 1.0f / effect_->GetMaxEmissionRate();
+        float intervalMax = 1.0f / effect_->GetMinEmissionRate();
+
+        // If emission timer has a longer delay than max. interval, clamp it
+        if (emissionTimer_ < -intervalMax)
+            emissionTimer_ = -intervalMax;
+
+        unsigned counter = MAX_PARTICLES_IN_FRAME;
+
+        while (emissionTimer_ > 0.0f && counter)
+        {
+            emissionTimer_ -= Lerp(intervalMin, intervalMax, Random(1.0f));
+            if (EmitNewParticle())
+                --counter;
+            else
+                break;
+        }
+    }
+
+    if (particles_.Size())
+        simulationChanged_ = true;
+
+    // Constant force is applied in the space of the particle positions
+    const Vector3& constantForce = effect_->GetConstantForce();
+    stepForce_ = relative_ ? node_->GetWorldRotation().Inverse() * constantForce : constantForce;
+    // If billboards are not relative, apply scaling to the position update
+    stepScale_ = scaled_ && !relative_ ? node_->GetWorldScale() : Vector3::ONE;
+}
+
+void ParticleEmitter::SimulateParticles(unsigned begin, unsigned end)
+{
+    if (!effect_)
+        return;
+
+    const float timeStep = lastTimeStep_;
+    const Vector3 velocityAdd = timeStep * stepForce_;
+    const float damping = 1.0f - timeStep * effect_->GetDampingForce();
+    const Vector3 positionScale = timeStep * stepScale_;
+    const float sizeAdd = effect_->GetSizeAdd();
+    const float sizeMul = effect_->GetSizeMul();
+    const bool scaling = sizeAdd != 0.0f || sizeMul != 1.0f;
+    const float scaleAdd = timeStep * sizeAdd;
+    const float scaleMul = timeStep * (sizeMul - 1.0f) + 1.0f;
+
+    float* positionX = particles_.positionX_.data();
+    float* positionY = particles_.positionY_.data();
+    float* positionZ = particles_.positionZ_.data();
+    float* velocityX = particles_.velocityX_.data();
+    float* velocityY = particles_.velocityY_.data();
+    float* velocityZ = particles_.velocityZ_.data();
+    float* rotation = particles_.rotation_.data();
+    const float* rotationSpeed = particles_.rotationSpeed_.data();
+    float* timer = particles_.timer_.data();
+    float* scale = particles_.scale_.data();
+
+    unsigned i = begin;
+#ifdef URHO3D_SSE
+    {
+        const __m128 dt = _mm_set1_ps(timeStep);
+        const __m128 addX = _mm_set1_ps(velocityAdd.x_);
+        const __m128 addY = _mm_set1_ps(velocityAdd.y_);
+        const __m128 addZ = _mm_set1_ps(velocityAdd.z_);
+        const __m128 damp = _mm_set1_ps(damping);
+        const __m128 moveX = _mm_set1_ps(positionScale.x_);
+        const __m128 moveY = _mm_set1_ps(positionScale.y_);
+        const __m128 moveZ = _mm_set1_ps(positionScale.z_);
+        const __m128 scaleAddVec = _mm_set1_ps(scaleAdd);
+        const __m128 scaleMulVec = _mm_set1_ps(scaleMul);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (; i + 4 <= end; i += 4)
+        {
+            const __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityX[i]), addX), damp);
+            const __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityY[i]), addY), damp);
+            const __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velocityZ[i]), addZ), damp);
+            _mm_storeu_ps(&velocityX[i], vx);
+            _mm_storeu_ps(&velocityY[i], vy);
+            _mm_storeu_ps(&velocityZ[i], vz);
+            _mm_storeu_ps(&positionX[i], _mm_add_ps(_mm_loadu_ps(&positionX[i]), _mm_mul_ps(vx, moveX)));
+            _mm_storeu_ps(&positionY[i], _mm_add_ps(_mm_loadu_ps(&positionY[i]), _mm_mul_ps(vy, moveY)));
+            _mm_storeu_ps(&positionZ[i], _mm_add_ps(_mm_loadu_ps(&positionZ[i]), _mm_mul_ps(vz, moveZ)));
+            _mm_storeu_ps(&rotation[i], _mm_add_ps(_mm_loadu_ps(&rotation[i]), _mm_mul_ps(_mm_loadu_ps(&rotationSpeed[i]), dt)));
+            _mm_storeu_ps(&timer[i], _mm_add_ps(_mm_loadu_ps(&timer[i]), dt));
+            if (scaling)
+            {
+                const __m128 s = _mm_max_ps(_mm_add_ps(_mm_loadu_ps(&scale[i]), scaleAddVec), zero);
+                _mm_storeu_ps(&scale[i], _mm_mul_ps(s, scaleMulVec));
+            }
+        }
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        velocityX[i] = (velocityX[i] + velocityAdd.x_) * damping;
+        velocityY[i] = (velocityY[i] + velocityAdd.y_) * damping;
+        velocityZ[i] = (velocityZ[i] + velocityAdd.z_) * damping;
+        positionX[i] += velocityX[i] * positionScale.x_;
+        positionY[i] += velocityY[i] * positionScale.y_;
+        positionZ[i] += velocityZ[i] * positionScale.z_;
+        rotation[i] += rotationSpeed[i] * timeStep;
+        timer[i] += timeStep;
+        if (scaling)
+            scale[i] = Max(scale[i] + scaleAdd, 0.0f) * scaleMul;
+    }
+
+    // Color interpolation
+    const ea::vector<ColorFrame>& colorFrames = effect_->GetColorFrames();
+    if (!colorFrames.empty())
+    {
+        const unsigned lastFrame = colorFrames.size() - 1;
+        for (i = begin; i < end; ++i)
+        {
+            unsigned& index = particles_.colorIndex_[i];
+            if (index < lastFrame && timer[i] >= colorFrames[index + 1].time_)
+                ++index;
+            if (index < lastFrame)
+                particles_.color_[i] = colorFrames[index].Interpolate(colorFrames[index + 1], timer[i]);
+            else if (index == lastFrame)
+                particles_.color_[i] = colorFrames[index].color_;
+        }
+    }
+
+    // Texture animation
+    const ea::vector<TextureFrame>& textureFrames = effect_->GetTextureFrames();
+    if (textureFrames.size() > 1)
+    {
+        const unsigned lastFrame = textureFrames.size() - 1;
+        for (i = begin; i < end; ++i)
+        {
+            unsigned& texIndex = particles_.texIndex_[i];
+            if (texIndex < lastFrame && timer[i] >= textureFrames[texIndex + 1].time_)
+                ++texIndex;
+        }
+    }
+}
+
+void ParticleEmitter::WriteParticleVertices(float* dest, unsigned begin, unsigned end) const
+{
+    Vector3 billboardScale = scaled_ ? node_->GetWorldTransform().Scale() : Vector3::ONE;
+    const TextureFrame* textureFrames = nullptr;
+    unsigned lastTextureFrame = 0;
+    if (effect_ && !effect_->GetTextureFrames().empty())
+    {
+        textureFrames = effect_->GetTextureFrames().data();
+        lastTextureFrame = effect_->GetTextureFrames().size() - 1;
+    }
+
+    for (unsigned i = begin; i < end; ++i)
+    {
+        const unsigned index = sorted_ ? sortedParticles_[i] : i;
+
+        const Vector3 position(particles_.positionX_[index], particles_.positionY_[index], particles_.positionZ_[index]);
+        const float scale = particles_.scale_[index];
+        Vector2 size(particles_.sizeX_[index] * scale * billboardScale.x_, particles_.sizeY_[index] * scale * billboardScale.y_);
+        if (fixedScreenSize_)
+            size *= particles_.screenScaleFactor_[index];
+        const Rect& uv = textureFrames ? textureFrames[Min(particles_.texIndex_[index], lastTextureFrame)].uv_ : Rect::POSITIVE;
+        const unsigned color = particles_.color_[index].ToUInt();
+        const float rotation = particles_.rotation_[index];
+
+        if (faceCameraMode_ != FC_DIRECTION)
+            dest = WriteBillboardVertices(dest, position, size, uv, color, rotation);
+        else
+        {
+            const Vector3 direction = Vector3(particles_.velocityX_[index], particles_.velocityY_[index],
+                particles_.velocityZ_[index]).Normalized();
+            dest = WriteDirectionBillboardVertices(dest, position, direction, size, uv, color, rotation);
+        }
+    }
+}
+
+ParticleManager* ParticleEmitter::GetParticleManager() const
+{
+    return octant_ ? &octant_->GetRoot()->GetParticleManager() : nullptr;
+}
+
 void ParticleEmitter::HandleEffectReloadFinished(StringHash eventType, VariantMap& eventData)
 {
     // When particle effect file is live-edited, remove existing particles and reapply the effect parameters
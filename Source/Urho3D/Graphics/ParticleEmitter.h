@@ -28,26 +28,63 @@ namespace Urho3D
 {
 
 class ParticleEffect;
+class ParticleManager;
 
-/// One particle in the particle system.
-struct Particle
+/// Particle state of a particle emitter as structure-of-arrays streams. Live particles are kept packed at the beginning of the streams, so that they can be simulated several at a time.
+struct URHO3D_API ParticleStreams
 {
-    /// Velocity.
-    Vector3 velocity_;
-    /// Original billboard size.
-    Vector2 size_;
-    /// Time elapsed from creation.
-    float timer_;
-    /// Lifetime.
-    float timeToLive_;
-    /// Size scaling value.
-    float scale_;
-    /// Rotation speed.
-    float rotationSpeed_;
-    /// Current color animation index.
-    unsigned colorIndex_;
-    /// Current texture animation index.
-    unsigned texIndex_;
+    /// Set maximum number of particles. Live particles beyond the new maximum are removed.
+    void SetCapacity(unsigned capacity);
+    /// Add a live particle and return its index, or M_MAX_UNSIGNED if full. The stream values of the particle are not initialized.
+    unsigned Add() { return size_ < timer_.size() ? size_++ : M_MAX_UNSIGNED; }
+    /// Remove a live particle by moving the last live particle in its place.
+    void RemoveSwap(unsigned index);
+    /// Copy a particle over another.
+    void Copy(unsigned dest, unsigned src);
+
+    /// Remove all particles.
+    void Clear() { size_ = 0; }
+    /// Return number of live particles.
+    unsigned Size() const { return size_; }
+    /// Return maximum number of particles.
+    unsigned Capacity() const { return timer_.size(); }
+
+    /// Position X coordinates. Relative to the scene node if the emitter is relative, world space otherwise.
+    ea::vector<float> positionX_;
+    /// Position Y coordinates.
+    ea::vector<float> positionY_;
+    /// Position Z coordinates.
+    ea::vector<float> positionZ_;
+    /// Velocity X components.
+    ea::vector<float> velocityX_;
+    /// Velocity Y components.
+    ea::vector<float> velocityY_;
+    /// Velocity Z components.
+    ea::vector<float> velocityZ_;
+    /// Original billboard widths.
+    ea::vector<float> sizeX_;
+    /// Original billboard heights.
+    ea::vector<float> sizeY_;
+    /// Size scaling values.
+    ea::vector<float> scale_;
+    /// Rotations.
+    ea::vector<float> rotation_;
+    /// Rotation speeds.
+    ea::vector<float> rotationSpeed_;
+    /// Times elapsed from creation.
+    ea::vector<float> timer_;
+    /// Lifetimes.
+    ea::vector<float> timeToLive_;
+    /// Scale factors for fixed screen size mode.
+    ea::vector<float> screenScaleFactor_;
+    /// Colors.
+    ea::vector<Color> color_;
+    /// Current color animation indices.
+    ea::vector<unsigned> colorIndex_;
+    /// Current texture animation indices.
+    ea::vector<unsigned> texIndex_;
+    /// Number of live particles.
+    unsigned size_{};
 };
 
 /// %Particle emitter component.
@@ -55,6 +92,8 @@ class URHO3D_API ParticleEmitter : public BillboardSet
 {
     URHO3D_OBJECT(ParticleEmitter, BillboardSet);
 
+    friend class ParticleManager;
+
 public:
     /// Construct.
     explicit ParticleEmitter(Context* context);
@@ -63,10 +102,10 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
 
+    /// Process octree raycast. May be called from a worker thread.
+    void ProcessRayQuery(const RayOctreeQuery& query, ea::vector<RayQueryResult>& results) override;
     /// Handle enabled/disabled state change.
     void OnSetEnabled() override;
-    /// Update before octree reinsertion. Is called from a worker thread.
-    void Update(const FrameInfo& frame) override;
 
     /// Set particle effect.
     void SetEffect(ParticleEffect* effect);
@@ -91,7 +130,10 @@ public:
     ParticleEffect* GetEffect() const;
 
     /// Return maximum number of particles.
-    unsigned GetNumParticles() const { return particles_.size(); }
+    unsigned GetNumParticles() const { return particles_.Capacity(); }
+
+    /// Return number of live particles.
+    unsigned GetNumLiveParticles() const { return particles_.Size(); }
 
     /// Return whether is currently emitting.
     bool IsEmitting() const { return emitting_; }
@@ -110,30 +152,58 @@ public:
     void SetParticlesAttr(const VariantVector& value);
     /// Return particles attribute. Returns particle amount only if particles are not to be serialized.
     VariantVector GetParticlesAttr() const;
+    /// Set billboards attribute.
+    void SetParticleBillboardsAttr(const VariantVector& value);
     /// Return billboards attribute. Returns billboard amount only if particles are not to be serialized.
     VariantVector GetParticleBillboardsAttr() const;
 
 protected:
     /// Handle scene being assigned.
     void OnSceneSet(Scene* scene) override;
+    /// Handle removal from octree.
+    void OnRemoveFromOctree() override;
+    /// Recalculate the world-space bounding box.
+    void OnWorldBoundingBoxUpdate() override;
+    /// Return number of billboards the vertex and index buffers are sized for.
+    unsigned GetMaxBillboards() const override { return particles_.Capacity(); }
+    /// Rewrite billboard vertex buffer from the particle streams.
+    void UpdateVertexBuffer(const FrameInfo& frame) override;
+    /// Calculate particle scale factors in fixed screen size mode.
+    void CalculateFixedScreenSize(const FrameInfo& frame) override;
 
     /// Create a new particle. Return true if there was room.
     bool EmitNewParticle();
-    /// Return a free particle index.
-    unsigned GetFreeParticle() const;
     /// Return whether has active particles.
-    bool CheckActiveParticles() const;
+    bool CheckActiveParticles() const { return particles_.Size() != 0; }
 
 private:
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Check visibility and effect completion after the scene update. Called by the particle manager.
+    void PostUpdate(float timeStep);
+    /// Remove expired particles, update the emission period and emit new particles. Called by the particle manager, possibly from a worker thread.
+    void PrepareSimulation();
+    /// Simulate a range of live particles. Called by the particle manager, possibly from a worker thread.
+    void SimulateParticles(unsigned begin, unsigned end);
+    /// Write the vertices of a range of particles, in vertex order. Particle indices are taken from the sort order if sorted.
+    void WriteParticleVertices(float* dest, unsigned begin, unsigned end) const;
+    /// Return the particle manager of the octree the emitter is inserted into, or null if not inserted.
+    ParticleManager* GetParticleManager() const;
     /// Handle live reload of the particle effect.
     void HandleEffectReloadFinished(StringHash eventType, VariantMap& eventData);
 
     /// Particle effect.
     SharedPtr<ParticleEffect> effect_;
     /// Particles.
-    ea::vector<Particle> particles_;
+    ParticleStreams particles_;
+    /// Particle indices in vertex order when sorted.
+    ea::vector<unsigned> sortedParticles_;
+    /// Particle sort distances.
+    ea::vector<float> sortDistances_;
+    /// Velocity change per second for the current simulation step, in the space of the particle positions.
+    Vector3 stepForce_;
+    /// Position scaling for the current simulation step.
+    Vector3 stepScale_;
+    /// Index in the particle manager's emitter list.
+    unsigned managerIndex_;
     /// Active/inactive period timer.
     float periodTimer_;
     /// New particle emission timer.
@@ -146,6 +216,8 @@ private:
     bool emitting_;
     /// Need update flag.
     bool needUpdate_;
+    /// Particles changed during the current simulation step flag.
+    bool simulationChanged_;
     /// Serialize particles flag.
     bool serializeParticles_;
     /// Ready to send effect finish event flag.
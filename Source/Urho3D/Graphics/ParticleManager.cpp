@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/Octree.h"
+#include "../Graphics/ParticleEmitter.h"
+#include "../Graphics/ParticleManager.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned EMITTER_UPDATE_GRAIN_SIZE = 16;
+static const unsigned PARTICLE_RANGE_SIZE = 2048;
+
+ParticleManager::ParticleManager(Octree* octree) :
+    octree_(octree)
+{
+}
+
+ParticleManager::~ParticleManager()
+{
+    // Allow the emitters to be added to another octree
+    for (ParticleEmitter* emitter : emitters_)
+    {
+        if (emitter)
+            emitter->managerIndex_ = M_MAX_UNSIGNED;
+    }
+}
+
+void ParticleManager::AddEmitter(ParticleEmitter* emitter)
+{
+    if (emitter->managerIndex_ != M_MAX_UNSIGNED)
+        return;
+
+    emitter->managerIndex_ = emitters_.size();
+    emitters_.push_back(emitter);
+}
+
+void ParticleManager::RemoveEmitter(ParticleEmitter* emitter)
+{
+    const unsigned index = emitter->managerIndex_;
+    if (index == M_MAX_UNSIGNED)
+        return;
+
+    assert(emitters_[index] == emitter);
+
+    // Emitters may be removed by the effect finished event handlers during the post-update, keep the indices valid until then
+    if (postUpdating_)
+    {
+        emitters_[index] = nullptr;
+        ++numRemoved_;
+    }
+    else
+    {
+        ParticleEmitter* last = emitters_.back();
+        emitters_[index] = last;
+        last->managerIndex_ = index;
+        emitters_.pop_back();
+    }
+
+    emitter->managerIndex_ = M_MAX_UNSIGNED;
+}
+
+void ParticleManager::PostUpdate(float timeStep)
+{
+    URHO3D_PROFILE("PostUpdateParticleEmitters");
+
+    // Emitters added during the loop are post-updated as well
+    postUpdating_ = true;
+    for (unsigned i = 0; i < emitters_.size(); ++i)
+    {
+        if (ParticleEmitter* emitter = emitters_[i])
+            emitter->PostUpdate(timeStep);
+    }
+    postUpdating_ = false;
+
+    if (numRemoved_)
+        CompactEmitters();
+}
+
+void ParticleManager::Update(const FrameInfo& frame)
+{
+    updates_.clear();
+    for (ParticleEmitter* emitter : emitters_)
+    {
+        if (emitter && emitter->needUpdate_)
+            updates_.push_back(emitter);
+    }
+
+    if (updates_.empty())
+        return;
+
+    URHO3D_PROFILE("UpdateParticles");
+
+    auto* queue = octree_->GetSubsystem<WorkQueue>();
+
+    // Expiration and emission depend on the emitter timers, so they are processed per emitter
+    queue->ParallelFor(0, updates_.size(), EMITTER_UPDATE_GRAIN_SIZE, [this](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+    {
+        for (unsigned i = begin; i < end; ++i)
+            updates_[i]->PrepareSimulation();
+    });
+
+    // Simulate the live particles of all emitters in equal ranges, so that large emitters are spread across the threads
+    ranges_.clear();
+    for (ParticleEmitter* emitter : updates_)
+    {
+        const unsigned numParticles = emitter->particles_.Size();
+        for (unsigned begin = 0; begin < numParticles; begin += PARTICLE_RANGE_SIZE)
+            ranges_.push_back(ParticleRange{emitter, begin, Min(begin + PARTICLE_RANGE_SIZE, numParticles)});
+    }
+
+    queue->ParallelFor(0, ranges_.size(), 1, [this](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+    {
+        URHO3D_PROFILE("SimulateParticles");
+        for (unsigned i = begin; i < end; ++i)
+            ranges_[i].emitter_->SimulateParticles(ranges_[i].begin_, ranges_[i].end_);
+    });
+
+    for (ParticleEmitter* emitter : updates_)
+    {
+        if (emitter->simulationChanged_)
+            emitter->Commit();
+        emitter->needUpdate_ = false;
+    }
+
+    updates_.clear();
+}
+
+void ParticleManager::CompactEmitters()
+{
+    unsigned count = 0;
+    for (ParticleEmitter* emitter : emitters_)
+    {
+        if (emitter)
+        {
+            emitter->managerIndex_ = count;
+            emitters_[count++] = emitter;
+        }
+    }
+
+    emitters_.resize(count);
+    numRemoved_ = 0;
+}
+
+}
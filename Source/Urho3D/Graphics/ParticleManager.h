@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <EASTL/vector.h>
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+namespace Urho3D
+{
+
+class Octree;
+class ParticleEmitter;
+struct FrameInfo;
+
+/// Particle simulation of the particle emitters in an octree. Instead of each emitter updating itself, the live particles of all emitters that need an update are split into fixed-size ranges and simulated in one pass on the worker threads.
+class URHO3D_API ParticleManager
+{
+public:
+    /// Construct.
+    explicit ParticleManager(Octree* octree);
+    /// Destruct.
+    ~ParticleManager();
+
+    /// Add a particle emitter. Called when the emitter is inserted into the octree.
+    void AddEmitter(ParticleEmitter* emitter);
+    /// Remove a particle emitter. Called when the emitter is removed from the octree.
+    void RemoveEmitter(ParticleEmitter* emitter);
+    /// Check emitter visibility and effect completion after the scene update. Called from the main thread.
+    void PostUpdate(float timeStep);
+    /// Emit and simulate the particles of the emitters that need an update. Called by the octree before the drawables are updated.
+    void Update(const FrameInfo& frame);
+
+    /// Return number of particle emitters.
+    unsigned GetNumEmitters() const { return emitters_.size() - numRemoved_; }
+
+private:
+    /// Range of particles of one emitter to simulate.
+    struct ParticleRange
+    {
+        /// Emitter.
+        ParticleEmitter* emitter_;
+        /// First particle index.
+        unsigned begin_;
+        /// Particle index after the last.
+        unsigned end_;
+    };
+
+    /// Remove the null entries left by emitters removed during the post-update.
+    void CompactEmitters();
+
+    /// Octree.
+    Octree* octree_;
+    /// Particle emitters. Entries of removed emitters are null until compacted.
+    ea::vector<ParticleEmitter*> emitters_;
+    /// Emitters being updated this frame.
+    ea::vector<ParticleEmitter*> updates_;
+    /// Particle ranges being simulated this frame.
+    ea::vector<ParticleRange> ranges_;
+    /// Number of null entries in the emitter list.
+    unsigned numRemoved_{};
+    /// Post-update in progress flag.
+    bool postUpdating_{};
+};
+
+}
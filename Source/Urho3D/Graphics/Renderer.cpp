@@ -485,6 +485,11 @@ void Renderer::SetMaxSortedInstances(int instances)
     maxSortedInstances_ = Max(instances, 0);
 }
 
+void Renderer::SetRadixSortBatches(bool enable)
+{
+    radixSortBatches_ = enable;
+}
+
 void Renderer::SetMaxOccluderTriangles(int triangles)
 {
     maxOccluderTriangles_ = Max(triangles, 0);
@@ -646,6 +651,40 @@ unsigned Renderer::GetNumOccluders(bool allViews) const
     return numOccluders;
 }
 
+long long Renderer::GetBatchSortTime(bool allViews) const
+{
+    long long sortTime = 0;
+    unsigned lastView = allViews ? views_.size() : 1;
+
+    for (unsigned i = 0; i < lastView; ++i)
+    {
+        View* view = GetActualView(views_[i]);
+        if (!view)
+            continue;
+
+        sortTime += view->GetBatchSortTime();
+    }
+
+    return sortTime;
+}
+
+unsigned Renderer::GetNumReusedBatchGroups(bool allViews) const
+{
+    unsigned numReusedGroups = 0;
+    unsigned lastView = allViews ? views_.size() : 1;
+
+    for (unsigned i = 0; i < lastView; ++i)
+    {
+        View* view = GetActualView(views_[i]);
+        if (!view)
+            continue;
+
+        numReusedGroups += view->GetNumReusedBatchGroups();
+    }
+
+    return numReusedGroups;
+}
+
 void Renderer::Update(float timeStep)
 {
     URHO3D_PROFILE("UpdateViews");
@@ -1615,7 +1654,7 @@ void Renderer::Initialize()
 
     initialized_ = true;
 
-    SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Renderer, HandleRenderUpdate));
+    SubscribeToEvent(E_RENDERUPDATE, &Renderer::HandleRenderUpdate);
 
     URHO3D_LOGINFO("Initialized renderer");
 }
@@ -1958,11 +1997,9 @@ void Renderer::HandleScreenMode(StringHash eventType, VariantMap& eventData)
         resetViews_ = true;
 }
 
-void Renderer::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Renderer::HandleRenderUpdate(const Update::Data& eventData)
 {
-    using namespace RenderUpdate;
-
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 
@@ -33,6 +33,7 @@
 namespace Urho3D
 {
 
+namespace Update { struct Data; }
 class Geometry;
 class Drawable;
 class Light;
@@ -231,6 +232,8 @@ public:
     void SetMinInstances(int instances);
     /// Set maximum number of sorted instances per batch group. If exceeded, instances are rendered unsorted.
     void SetMaxSortedInstances(int instances);
+    /// Set whether to sort batches with radix sort. Default true. When off, comparison sort is used.
+    void SetRadixSortBatches(bool enable);
     /// Set maximum number of occluder triangles.
     void SetMaxOccluderTriangles(int triangles);
     /// Set occluder buffer width.
@@ -317,6 +320,9 @@ public:
     /// Return maximum number of sorted instances per batch group.
     int GetMaxSortedInstances() const { return maxSortedInstances_; }
 
+    /// Return whether batches are sorted with radix sort.
+    bool GetRadixSortBatches() const { return radixSortBatches_; }
+
     /// Return maximum number of occluder triangles.
     int GetMaxOccluderTriangles() const { return maxOccluderTriangles_; }
 
@@ -355,6 +361,10 @@ public:
     unsigned GetNumShadowMaps(bool allViews = false) const;
     /// Return number of occluders rendered.
     unsigned GetNumOccluders(bool allViews = false) const;
+    /// Return time spent sorting batches in microseconds.
+    long long GetBatchSortTime(bool allViews = false) const;
+    /// Return number of instanced batch groups reused from the previous frame.
+    unsigned GetNumReusedBatchGroups(bool allViews = false) const;
 
     /// Return the default zone.
     Zone* GetDefaultZone() const { return defaultZone_; }
@@ -465,7 +475,7 @@ private:
     /// Handle screen mode event.
     void HandleScreenMode(StringHash eventType, VariantMap& eventData);
     /// Handle render update event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const Update::Data& eventData);
     /// Blur the shadow map.
     void BlurShadowMap(View* view, Texture2D* shadowMap, float blurScale);
 
@@ -591,6 +601,8 @@ private:
     bool reuseShadowMaps_{true};
     /// Dynamic instancing flag.
     bool dynamicInstancing_{true};
+    /// Radix sort batches flag.
+    bool radixSortBatches_{true};
     /// Number of extra instancing data elements.
     int numExtraInstancingBufferElements_{};
     /// Threaded occlusion rendering flag.
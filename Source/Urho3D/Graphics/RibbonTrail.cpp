@@ -173,16 +173,15 @@ void RibbonTrail::OnSetEnabled()
     if (scene)
     {
         if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(RibbonTrail, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, &RibbonTrail::HandleScenePostUpdate);
         else
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
     }
 }
 
-void RibbonTrail::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void RibbonTrail::HandleScenePostUpdate(const SceneUpdate::Data& eventData)
 {
-    using namespace ScenePostUpdate;
-    lastTimeStep_ = eventData[P_TIMESTEP].GetFloat();
+    lastTimeStep_ = eventData.timeStep_;
 
     // Update if frame has changed
     if (updateInvisible_ || viewFrameNumber_ != lastUpdateFrameNumber_)
@@ -424,7 +423,7 @@ void RibbonTrail::OnSceneSet(Scene* scene)
     Drawable::OnSceneSet(scene);
 
     if (scene && IsEnabledEffective())
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(RibbonTrail, HandleScenePostUpdate));
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, &RibbonTrail::HandleScenePostUpdate);
     else if (!scene)
          UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
 }
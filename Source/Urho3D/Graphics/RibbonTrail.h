@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
+
 enum TrailType
 {
     TT_FACE_CAMERA = 0,
@@ -189,7 +191,7 @@ protected:
 
 private:
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const SceneUpdate::Data& eventData);
 
     /// Resize RibbonTrail vertex and index buffers.
     void UpdateBufferSize();
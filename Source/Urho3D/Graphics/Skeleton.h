@@ -92,6 +92,25 @@ struct Bone
     WeakPtr<Node> node_;
 };
 
+/// Local-space bone transforms of a skeleton, stored as separate arrays indexed by bone.
+struct SkeletonPose
+{
+    /// Resize to the specified number of bones.
+    void Resize(unsigned numBones)
+    {
+        positions_.resize(numBones);
+        rotations_.resize(numBones);
+        scales_.resize(numBones);
+    }
+
+    /// Bone positions.
+    ea::vector<Vector3> positions_;
+    /// Bone rotations.
+    ea::vector<Quaternion> rotations_;
+    /// Bone scales.
+    ea::vector<Vector3> scales_;
+};
+
 /// Hierarchical collection of bones.
 class URHO3D_API Skeleton
 {
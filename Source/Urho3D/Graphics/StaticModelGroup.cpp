@@ -22,6 +22,8 @@
 
 #include "../Precompiled.h"
 
+#include <EASTL/algorithm.h>
+
 #include "../Core/Context.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Camera.h"
@@ -40,6 +42,9 @@ namespace Urho3D
 
 extern const char* GEOMETRY_CATEGORY;
 
+/// Average number of instances per cluster when the cluster size is chosen automatically.
+static const unsigned DEFAULT_INSTANCES_PER_CLUSTER = 64;
+
 static const StringVector instanceNodesStructureElementNames =
 {
     "Instance Count",
@@ -63,6 +68,8 @@ void StaticModelGroup::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Instance Nodes", GetNodeIDsAttr, SetNodeIDsAttr,
         VariantVector, Variant::emptyVariantVector, AM_DEFAULT | AM_NODEIDVECTOR)
         .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, instanceNodesStructureElementNames);
+    URHO3D_ACCESSOR_ATTRIBUTE("Cluster Size", GetClusterSize, SetClusterSize, float, 0.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Shadow Cull Distance", GetShadowCullDistance, SetShadowCullDistance, float, 0.0f, AM_DEFAULT);
 }
 
 void StaticModelGroup::ApplyAttributes()
@@ -97,6 +104,7 @@ void StaticModelGroup::ApplyAttributes()
     }
 
     worldTransforms_.resize(instanceNodes_.size());
+    transformInstances_.resize(instanceNodes_.size());
     numWorldTransforms_ = 0; // Correct amount will be found during world bounding box update
     nodesDirty_ = false;
 
@@ -160,7 +168,7 @@ void StaticModelGroup::ProcessRayQuery(const RayOctreeQuery& query, ea::vector<R
             result.distance_ = distance;
             result.drawable_ = this;
             result.node_ = node_;
-            result.subObject_ = i;
+            result.subObject_ = transformInstances_[i];
             results.push_back(result);
         }
     }
@@ -168,28 +176,35 @@ void StaticModelGroup::ProcessRayQuery(const RayOctreeQuery& query, ea::vector<R
 
 void StaticModelGroup::UpdateBatches(const FrameInfo& frame)
 {
-    // Getting the world bounding box ensures the transforms are updated
+    // Getting the world bounding box ensures the transforms and clusters are updated
     const BoundingBox& worldBoundingBox = GetWorldBoundingBox();
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
-    distance_ = frame.camera_->GetDistance(worldBoundingBox.Center());
+
+    MutexLock lock(clusterMutex_);
+
+    const ViewInstances& instances = GetViewInstances(frame);
+    const unsigned numInstances = instances.worldTransforms_.size();
+    const Matrix3x4* instanceTransforms = numInstances ? instances.worldTransforms_.data() : &Matrix3x4::IDENTITY;
+    distance_ = numInstances ? instances.distance_ : frame.camera_->GetDistance(worldBoundingBox.Center());
 
     if (batches_.size() > 1)
     {
         for (unsigned i = 0; i < batches_.size(); ++i)
         {
             batches_[i].distance_ = frame.camera_->GetDistance(worldTransform * geometryData_[i].center_);
-            batches_[i].worldTransform_ = numWorldTransforms_ ? &worldTransforms_[0] : &Matrix3x4::IDENTITY;
-            batches_[i].numWorldTransforms_ = numWorldTransforms_;
+            batches_[i].worldTransform_ = instanceTransforms;
+            batches_[i].numWorldTransforms_ = numInstances;
         }
     }
     else if (batches_.size() == 1)
     {
         batches_[0].distance_ = distance_;
-        batches_[0].worldTransform_ = numWorldTransforms_ ? &worldTransforms_[0] : &Matrix3x4::IDENTITY;
-        batches_[0].numWorldTransforms_ = numWorldTransforms_;
+        batches_[0].worldTransform_ = instanceTransforms;
+        batches_[0].numWorldTransforms_ = numInstances;
     }
 
-    float scale = worldBoundingBox.Size().DotProduct(DOT_SCALE);
+    // Select LOD by the nearest visible cluster, so that near instances do not use a coarser LOD than separate models would
+    float scale = numInstances ? instances.lodScale_ : worldBoundingBox.Size().DotProduct(DOT_SCALE);
     float newLodDistance = frame.camera_->GetLodDistance(distance_, scale, lodBias_);
 
     if (newLodDistance != lodDistance_)
@@ -313,6 +328,19 @@ void StaticModelGroup::RemoveAllInstanceNodes()
     UpdateNumTransforms();
 }
 
+void StaticModelGroup::SetClusterSize(float size)
+{
+    clusterSize_ = Max(size, 0.0f);
+    OnMarkedDirty(GetNode());
+    MarkNetworkUpdate();
+}
+
+void StaticModelGroup::SetShadowCullDistance(float distance)
+{
+    shadowCullDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
 Node* StaticModelGroup::GetInstanceNode(unsigned index) const
 {
     return index < instanceNodes_.size() ? instanceNodes_[index].Get() : nullptr;
@@ -368,6 +396,7 @@ void StaticModelGroup::OnNodeSetEnabled(Node* node)
 void StaticModelGroup::OnWorldBoundingBoxUpdate()
 {
     // Update transforms and bounding box at the same time to have to go through the objects only once
+    MutexLock lock(clusterMutex_);
     unsigned index = 0;
 
     BoundingBox worldBox;
@@ -379,6 +408,7 @@ void StaticModelGroup::OnWorldBoundingBoxUpdate()
             continue;
 
         const Matrix3x4& worldTransform = node->GetWorldTransform();
+        transformInstances_[index] = i;
         worldTransforms_[index++] = worldTransform;
         worldBox.Merge(boundingBox_.Transformed(worldTransform));
     }
@@ -388,11 +418,151 @@ void StaticModelGroup::OnWorldBoundingBoxUpdate()
     // Store the amount of valid instances we found instead of resizing worldTransforms_. This is because this function may be
     // called from multiple worker threads simultaneously
     numWorldTransforms_ = index;
+
+    UpdateClusters();
+}
+
+void StaticModelGroup::UpdateClusters()
+{
+    clusters_.clear();
+    clusterBounds_.Clear();
+    clusteredTransforms_.clear();
+
+    const unsigned numInstances = numWorldTransforms_;
+    if (!numInstances)
+        return;
+
+    // Bucket the instances by position into a grid on the XZ plane
+    Vector3 minPosition(M_INFINITY, M_INFINITY, M_INFINITY);
+    Vector3 maxPosition(-M_INFINITY, -M_INFINITY, -M_INFINITY);
+    for (unsigned i = 0; i < numInstances; ++i)
+    {
+        const Vector3 position = worldTransforms_[i].Translation();
+        minPosition = VectorMin(minPosition, position);
+        maxPosition = VectorMax(maxPosition, position);
+    }
+
+    const Vector3 extent = maxPosition - minPosition;
+    float cellSize = clusterSize_;
+    if (cellSize <= 0.0f)
+    {
+        const unsigned numCells = (numInstances + DEFAULT_INSTANCES_PER_CLUSTER - 1) / DEFAULT_INSTANCES_PER_CLUSTER;
+        cellSize = sqrtf(extent.x_ * extent.z_ / (float)numCells);
+        if (cellSize < M_EPSILON)
+            cellSize = Max(extent.x_, extent.z_) / (float)numCells;
+    }
+    cellSize = Max(cellSize, M_EPSILON);
+
+    // There should be no more cells than instances
+    while ((floorf(extent.x_ / cellSize) + 1.0f) * (floorf(extent.z_ / cellSize) + 1.0f) > (float)numInstances)
+        cellSize *= 2.0f;
+
+    const auto numCellsX = (unsigned)(extent.x_ / cellSize) + 1;
+    const auto numCellsZ = (unsigned)(extent.z_ / cellSize) + 1;
+    ea::vector<unsigned> instanceCells(numInstances);
+    ea::vector<unsigned> cellStarts(numCellsX * numCellsZ + 1);
+    for (unsigned i = 0; i < numInstances; ++i)
+    {
+        const Vector3 position = worldTransforms_[i].Translation() - minPosition;
+        const unsigned x = Min((unsigned)(position.x_ / cellSize), numCellsX - 1);
+        const unsigned z = Min((unsigned)(position.z_ / cellSize), numCellsZ - 1);
+        instanceCells[i] = z * numCellsX + x;
+        ++cellStarts[instanceCells[i] + 1];
+    }
+    for (unsigned i = 1; i < cellStarts.size(); ++i)
+        cellStarts[i] += cellStarts[i - 1];
+
+    // Sort a copy of the transforms so that each cluster is contiguous. The world transforms stay in instance node order
+    clusteredTransforms_.resize(numInstances);
+    ea::vector<unsigned> cellEnds(cellStarts.begin(), cellStarts.end() - 1);
+    for (unsigned i = 0; i < numInstances; ++i)
+        clusteredTransforms_[cellEnds[instanceCells[i]]++] = worldTransforms_[i];
+
+    for (unsigned i = 0; i + 1 < cellStarts.size(); ++i)
+    {
+        const unsigned first = cellStarts[i];
+        const unsigned count = cellStarts[i + 1] - first;
+        if (!count)
+            continue;
+
+        BoundingBox box;
+        for (unsigned j = first; j < first + count; ++j)
+            box.Merge(boundingBox_.Transformed(clusteredTransforms_[j]));
+
+        const float lodScale = boundingBox_.Transformed(clusteredTransforms_[first]).Size().DotProduct(DOT_SCALE);
+        clusters_.push_back({first, count, box.Center(), lodScale});
+        clusterBounds_.Push(box);
+    }
+}
+
+const StaticModelGroup::ViewInstances& StaticModelGroup::GetViewInstances(const FrameInfo& frame)
+{
+    // Reuse the instances culled for the same camera this frame. Otherwise reuse storage from a previous frame
+    ViewInstances* instances = nullptr;
+    for (auto& viewInstances : viewInstances_)
+    {
+        if (viewInstances->frameNumber_ == frame.frameNumber_)
+        {
+            if (viewInstances->camera_ == frame.camera_)
+                return *viewInstances;
+        }
+        else if (!instances)
+            instances = viewInstances.get();
+    }
+
+    if (!instances)
+    {
+        viewInstances_.push_back(ea::make_unique<ViewInstances>());
+        instances = viewInstances_.back().get();
+    }
+
+    instances->camera_ = frame.camera_;
+    instances->frameNumber_ = frame.frameNumber_;
+    instances->worldTransforms_.clear();
+    instances->distance_ = M_INFINITY;
+    instances->lodScale_ = 0.0f;
+
+    // The batches are also used for the shadow maps of the view. Shadow casting clusters outside the frustum may still
+    // cast shadows into it, so they are culled only against the frustum extended by the shadow cull distance, if set
+    const bool frustumCulling = !castShadows_ || shadowCullDistance_ > 0.0f;
+    if (frustumCulling)
+    {
+        Frustum frustum = frame.camera_->GetFrustum();
+        if (castShadows_)
+        {
+            for (Plane& plane : frustum.planes_)
+                plane.d_ += shadowCullDistance_;
+        }
+        clusterBounds_.TestFrustum(frustum, clusterVisibility_);
+    }
+
+    for (unsigned i = 0; i < clusters_.size(); ++i)
+    {
+        if (frustumCulling && !clusterVisibility_[i])
+            continue;
+
+        const InstanceCluster& cluster = clusters_[i];
+        const float distance = frame.camera_->GetDistance(cluster.center_);
+        if (drawDistance_ > 0.0f && distance > drawDistance_)
+            continue;
+
+        if (distance < instances->distance_)
+        {
+            instances->distance_ = distance;
+            instances->lodScale_ = cluster.lodScale_;
+        }
+
+        instances->worldTransforms_.insert(instances->worldTransforms_.end(), clusteredTransforms_.begin() + cluster.first_,
+            clusteredTransforms_.begin() + cluster.first_ + cluster.count_);
+    }
+
+    return *instances;
 }
 
 void StaticModelGroup::UpdateNumTransforms()
 {
     worldTransforms_.resize(instanceNodes_.size());
+    transformInstances_.resize(instanceNodes_.size());
     numWorldTransforms_ = 0; // Correct amount will be during world bounding box update
     nodeIDsDirty_ = true;
 
@@ -22,12 +22,17 @@
 
 #pragma once
 
+#include <EASTL/unique_ptr.h>
+
+#include "../Core/Mutex.h"
+#include "../Graphics/OctreeQuery.h"
 #include "../Graphics/StaticModel.h"
 
 namespace Urho3D
 {
 
-/// Renders several object instances while culling and receiving light as one unit. Can be used as a CPU-side optimization, but note that also regular StaticModels will use instanced rendering if possible.
+/// Renders several object instances while receiving light as one unit. Instances are grouped into spatial clusters, which are culled and select LOD separately for each camera. Can be used as a CPU-side optimization, but note that also regular StaticModels will use instanced rendering if possible.
+/// The instances culled for a camera are also used for the shadow maps of that view. Therefore a shadow casting group does not cull clusters outside the view frustum at all, unless a shadow cull distance is set (see SetShadowCullDistance()).
 class URHO3D_API StaticModelGroup : public StaticModel
 {
     URHO3D_OBJECT(StaticModelGroup, StaticModel);
@@ -42,7 +47,7 @@ public:
 
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     void ApplyAttributes() override;
-    /// Process octree raycast. May be called from a worker thread.
+    /// Process octree raycast. May be called from a worker thread. The sub object of the results is the instance node index.
     void ProcessRayQuery(const RayOctreeQuery& query, ea::vector<RayQueryResult>& results) override;
     /// Calculate distance and prepare batches for rendering. May be called from worker thread(s), possibly re-entrantly.
     void UpdateBatches(const FrameInfo& frame) override;
@@ -57,6 +62,19 @@ public:
     void RemoveInstanceNode(Node* node);
     /// Remove all instance scene nodes.
     void RemoveAllInstanceNodes();
+    /// Set size of the instance clusters on the XZ plane. Zero (default) sizes them automatically for about 64 instances each.
+    void SetClusterSize(float size);
+    /// Set how far outside the view frustum the clusters of a shadow casting group are kept, so that they still cast shadows into the view. Zero (default) disables frustum culling for shadow casting groups.
+    void SetShadowCullDistance(float distance);
+
+    /// Return size of the instance clusters.
+    float GetClusterSize() const { return clusterSize_; }
+
+    /// Return how far outside the view frustum the clusters of a shadow casting group are kept.
+    float GetShadowCullDistance() const { return shadowCullDistance_; }
+
+    /// Return number of instance clusters.
+    unsigned GetNumClusters() const { return clusters_.size(); }
 
     /// Return number of instance nodes.
     unsigned GetNumInstanceNodes() const { return instanceNodes_.size(); }
@@ -77,6 +95,38 @@ protected:
     void OnWorldBoundingBoxUpdate() override;
 
 private:
+    /// Spatial cluster of instances.
+    struct InstanceCluster
+    {
+        /// Index of the first clustered world transform.
+        unsigned first_;
+        /// Number of clustered world transforms.
+        unsigned count_;
+        /// Bounding box center.
+        Vector3 center_;
+        /// LOD scale of the first instance.
+        float lodScale_;
+    };
+
+    /// Instances visible to a camera.
+    struct ViewInstances
+    {
+        /// Camera.
+        Camera* camera_{};
+        /// Frame number.
+        unsigned frameNumber_{M_MAX_UNSIGNED};
+        /// World transforms of the instances in the visible clusters.
+        ea::vector<Matrix3x4> worldTransforms_;
+        /// Distance to the nearest visible cluster.
+        float distance_{};
+        /// LOD scale of the nearest visible cluster.
+        float lodScale_{};
+    };
+
+    /// Sort a copy of the world transforms into clusters.
+    void UpdateClusters();
+    /// Return instances visible to the camera of the frame. Culled once per camera and frame.
+    const ViewInstances& GetViewInstances(const FrameInfo& frame);
     /// Ensure proper size of world transforms when nodes are added/removed. Also mark node IDs dirty.
     void UpdateNumTransforms();
     /// Update node IDs attribute from the actual nodes.
@@ -84,12 +134,30 @@ private:
 
     /// Instance nodes.
     ea::vector<WeakPtr<Node> > instanceNodes_;
-    /// World transforms of valid (existing and visible) instances.
+    /// World transforms of valid (existing and visible) instances, in instance node order.
     ea::vector<Matrix3x4> worldTransforms_;
+    /// Instance node indices of the world transforms.
+    ea::vector<unsigned> transformInstances_;
+    /// World transforms sorted so that each cluster is contiguous.
+    ea::vector<Matrix3x4> clusteredTransforms_;
     /// IDs of instance nodes for serialization.
     mutable VariantVector nodeIDsAttr_;
     /// Number of valid instance node transforms.
     unsigned numWorldTransforms_{};
+    /// Instance clusters.
+    ea::vector<InstanceCluster> clusters_;
+    /// Bounding boxes of the instance clusters.
+    BoundingBoxArray clusterBounds_;
+    /// Frustum test results of the instance clusters.
+    ea::vector<unsigned char> clusterVisibility_;
+    /// Visible instances per camera. Kept for the whole frame, as the batches of each view refer to them until rendered.
+    ea::vector<ea::unique_ptr<ViewInstances> > viewInstances_;
+    /// Size of the instance clusters.
+    float clusterSize_{};
+    /// Distance outside the view frustum to keep the clusters of a shadow casting group.
+    float shadowCullDistance_{};
+    /// Mutex for the clusters and visible instances, as batches may be updated from several threads.
+    Mutex clusterMutex_;
     /// Whether node IDs have been set and nodes should be searched for during ApplyAttributes.
     mutable bool nodesDirty_{};
     /// Whether nodes have been manipulated by the API and node ID attribute should be refreshed.
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DrawableEvents.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/IndexBuffer.h"
@@ -56,6 +57,11 @@ static const unsigned STITCH_NORTH = 1;
 static const unsigned STITCH_SOUTH = 2;
 static const unsigned STITCH_WEST = 4;
 static const unsigned STITCH_EAST = 8;
+static const unsigned FLOATS_PER_VERTEX = 12;
+/// Number of patches whose vertex data is generated before uploading.
+static const unsigned PATCH_GENERATION_BATCH_SIZE = 64;
+/// Number of patches generated at once by a thread.
+static const unsigned PATCH_GENERATION_GRAIN_SIZE = 2;
 
 inline void GrowUpdateRegion(IntRect& updateRegion, int x, int y)
 {
@@ -657,109 +663,120 @@ void Terrain::CreatePatchGeometry(TerrainPatch* patch)
 {
     URHO3D_PROFILE("CreatePatchGeometry");
 
-    auto row = (unsigned)(patchSize_ + 1);
-    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
-    Geometry* geometry = patch->GetGeometry();
-    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
-    Geometry* occlusionGeometry = patch->GetOcclusionGeometry();
-
-    if (vertexBuffer->GetVertexCount() != row * row)
-        vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT);
+    PatchVertexData data;
+    GeneratePatchVertexData(patch->GetCoordinates(), data);
+    ApplyPatchVertexData(patch, data);
+}
 
-    ea::shared_array<unsigned char> cpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
-    ea::shared_array<unsigned char> occlusionCpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
+void Terrain::GeneratePatchVertexData(const IntVector2& coords, PatchVertexData& data) const
+{
+    auto row = (unsigned)(patchSize_ + 1);
+    data.vertexData_.resize(row * row * FLOATS_PER_VERTEX);
+    data.cpuVertexData_.reset(new unsigned char[row * row * sizeof(Vector3)]);
+    data.occlusionCpuVertexData_.reset(new unsigned char[row * row * sizeof(Vector3)]);
+    data.box_.Clear();
 
-    auto* vertexData = (float*)vertexBuffer->Lock(0, vertexBuffer->GetVertexCount());
-    auto* positionData = (float*)cpuVertexData.get();
-    auto* occlusionData = (float*)occlusionCpuVertexData.get();
-    BoundingBox box;
+    float* vertexData = data.vertexData_.data();
+    auto* positionData = (float*)data.cpuVertexData_.get();
+    auto* occlusionData = (float*)data.occlusionCpuVertexData_.get();
 
     unsigned occlusionLevel = occlusionLodLevel_;
     if (occlusionLevel > numLodLevels_ - 1)
         occlusionLevel = numLodLevels_ - 1;
 
-    if (vertexData)
-    {
-        const IntVector2& coords = patch->GetCoordinates();
-        unsigned lodExpand = (1u << (occlusionLevel)) - 1;
-        unsigned halfLodExpand = (1u << (occlusionLevel)) / 2;
+    unsigned lodExpand = (1u << (occlusionLevel)) - 1;
+    unsigned halfLodExpand = (1u << (occlusionLevel)) / 2;
 
-        for (unsigned z = 0; z <= patchSize_; ++z)
+    for (unsigned z = 0; z <= patchSize_; ++z)
+    {
+        for (unsigned x = 0; x <= patchSize_; ++x)
         {
-            for (unsigned x = 0; x <= patchSize_; ++x)
+            int xPos = coords.x_ * patchSize_ + x;
+            int zPos = coords.y_ * patchSize_ + z;
+
+            // Position
+            Vector3 position((float)x * spacing_.x_, GetRawHeight(xPos, zPos), (float)z * spacing_.z_);
+            *vertexData++ = position.x_;
+            *vertexData++ = position.y_;
+            *vertexData++ = position.z_;
+            *positionData++ = position.x_;
+            *positionData++ = position.y_;
+            *positionData++ = position.z_;
+
+            data.box_.Merge(position);
+
+            // For vertices that are part of the occlusion LOD, calculate the minimum height in the neighborhood
+            // to prevent false positive occlusion due to inaccuracy between occlusion LOD & visible LOD
+            float minHeight = position.y_;
+            if (halfLodExpand > 0 && (x & lodExpand) == 0 && (z & lodExpand) == 0)
             {
-                int xPos = coords.x_ * patchSize_ + x;
-                int zPos = coords.y_ * patchSize_ + z;
-
-                // Position
-                Vector3 position((float)x * spacing_.x_, GetRawHeight(xPos, zPos), (float)z * spacing_.z_);
-                *vertexData++ = position.x_;
-                *vertexData++ = position.y_;
-                *vertexData++ = position.z_;
-                *positionData++ = position.x_;
-                *positionData++ = position.y_;
-                *positionData++ = position.z_;
-
-                box.Merge(position);
-
-                // For vertices that are part of the occlusion LOD, calculate the minimum height in the neighborhood
-                // to prevent false positive occlusion due to inaccuracy between occlusion LOD & visible LOD
-                float minHeight = position.y_;
-                if (halfLodExpand > 0 && (x & lodExpand) == 0 && (z & lodExpand) == 0)
+                int minX = Max(xPos - halfLodExpand, 0);
+                int maxX = Min(xPos + halfLodExpand, numVertices_.x_ - 1);
+                int minZ = Max(zPos - halfLodExpand, 0);
+                int maxZ = Min(zPos + halfLodExpand, numVertices_.y_ - 1);
+                for (int nZ = minZ; nZ <= maxZ; ++nZ)
                 {
-                    int minX = Max(xPos - halfLodExpand, 0);
-                    int maxX = Min(xPos + halfLodExpand, numVertices_.x_ - 1);
-                    int minZ = Max(zPos - halfLodExpand, 0);
-                    int maxZ = Min(zPos + halfLodExpand, numVertices_.y_ - 1);
-                    for (int nZ = minZ; nZ <= maxZ; ++nZ)
-                    {
-                        for (int nX = minX; nX <= maxX; ++nX)
-                            minHeight = Min(minHeight, GetRawHeight(nX, nZ));
-                    }
+                    for (int nX = minX; nX <= maxX; ++nX)
+                        minHeight = Min(minHeight, GetRawHeight(nX, nZ));
                 }
-                *occlusionData++ = position.x_;
-                *occlusionData++ = minHeight;
-                *occlusionData++ = position.z_;
-
-                // Normal
-                Vector3 normal = GetRawNormal(xPos, zPos);
-                *vertexData++ = normal.x_;
-                *vertexData++ = normal.y_;
-                *vertexData++ = normal.z_;
-
-                // Texture coordinate
-                Vector2 texCoord((float)xPos / (float)(numVertices_.x_ - 1), 1.0f - (float)zPos / (float)(numVertices_.y_ - 1));
-                *vertexData++ = texCoord.x_;
-                *vertexData++ = texCoord.y_;
-
-                // Tangent
-                Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
-                *vertexData++ = xyz.x_;
-                *vertexData++ = xyz.y_;
-                *vertexData++ = xyz.z_;
-                *vertexData++ = 1.0f;
             }
+            *occlusionData++ = position.x_;
+            *occlusionData++ = minHeight;
+            *occlusionData++ = position.z_;
+
+            // Normal
+            Vector3 normal = GetRawNormal(xPos, zPos);
+            *vertexData++ = normal.x_;
+            *vertexData++ = normal.y_;
+            *vertexData++ = normal.z_;
+
+            // Texture coordinate
+            Vector2 texCoord((float)xPos / (float)(numVertices_.x_ - 1), 1.0f - (float)zPos / (float)(numVertices_.y_ - 1));
+            *vertexData++ = texCoord.x_;
+            *vertexData++ = texCoord.y_;
+
+            // Tangent
+            Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
+            *vertexData++ = xyz.x_;
+            *vertexData++ = xyz.y_;
+            *vertexData++ = xyz.z_;
+            *vertexData++ = 1.0f;
         }
+    }
+}
+
+void Terrain::ApplyPatchVertexData(TerrainPatch* patch, PatchVertexData& data)
+{
+    auto row = (unsigned)(patchSize_ + 1);
+    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
+    Geometry* geometry = patch->GetGeometry();
+    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
+    Geometry* occlusionGeometry = patch->GetOcclusionGeometry();
 
-        vertexBuffer->Unlock();
+    if (vertexBuffer->GetVertexCount() != row * row)
+        vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT);
+
+    if (vertexBuffer->SetData(data.vertexData_.data()))
         vertexBuffer->ClearDataLost();
-    }
 
-    patch->SetBoundingBox(box);
+    patch->SetBoundingBox(data.box_);
 
     if (drawRanges_.size())
     {
+        unsigned occlusionLevel = occlusionLodLevel_;
+        if (occlusionLevel > numLodLevels_ - 1)
+            occlusionLevel = numLodLevels_ - 1;
         unsigned occlusionDrawRange = occlusionLevel << 4u;
 
         geometry->SetIndexBuffer(indexBuffer_);
         geometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first, drawRanges_[0].second, false);
-        geometry->SetRawVertexData(cpuVertexData, MASK_POSITION);
+        geometry->SetRawVertexData(data.cpuVertexData_, MASK_POSITION);
         maxLodGeometry->SetIndexBuffer(indexBuffer_);
         maxLodGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first, drawRanges_[0].second, false);
-        maxLodGeometry->SetRawVertexData(cpuVertexData, MASK_POSITION);
+        maxLodGeometry->SetRawVertexData(data.cpuVertexData_, MASK_POSITION);
         occlusionGeometry->SetIndexBuffer(indexBuffer_);
         occlusionGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[occlusionDrawRange].first, drawRanges_[occlusionDrawRange].second, false);
-        occlusionGeometry->SetRawVertexData(occlusionCpuVertexData, MASK_POSITION);
+        occlusionGeometry->SetRawVertexData(data.occlusionCpuVertexData_, MASK_POSITION);
     }
 
     patch->ResetLod();
@@ -850,65 +867,60 @@ ResourceRef Terrain::GetHeightMapAttr() const
     return GetResourceRef(heightMap_, Image::GetTypeStatic());
 }
 
-void Terrain::CreateGeometry()
+void Terrain::GenerateGeometryData(Image* image)
 {
-    recreateTerrain_ = false;
+    URHO3D_PROFILE("GenerateTerrainGeometry");
 
-    if (!node_)
+    generatedGeometry_.reset();
+    if (!image || image->IsCompressed())
         return;
 
-    URHO3D_PROFILE("CreateTerrainGeometry");
+    auto generated = ea::make_unique<GeneratedGeometry>();
+    generated->heightMap_ = image;
+    generated->smoothing_ = smoothing_;
 
-    unsigned prevNumPatches = patches_.size();
+    // The terrain is not in use by anything else, so the height data can be updated in place
+    lastPatchSize_ = 0;
+    ea::vector<bool> dirtyPatches;
+    UpdateHeightData(image, dirtyPatches);
 
-    // Determine number of LOD levels
-    auto lodSize = (unsigned)patchSize_;
-    numLodLevels_ = 1;
-    while (lodSize > MIN_PATCH_SIZE && numLodLevels_ < maxLodLevels_)
+    generated->patches_.resize(dirtyPatches.size());
+    for (unsigned i = 0; i < generated->patches_.size(); ++i)
     {
-        lodSize >>= 1;
-        ++numLodLevels_;
+        const IntVector2 coords(i % numPatches_.x_, i / numPatches_.x_);
+        GeneratePatchVertexData(coords, generated->patches_[i]);
+        CalculateLodErrors(coords, generated->patches_[i].lodErrors_);
     }
 
-    // Determine total terrain size
-    patchWorldSize_ = Vector2(spacing_.x_ * (float)patchSize_, spacing_.z_ * (float)patchSize_);
-    bool updateAll = false;
+    generatedGeometry_ = ea::move(generated);
+}
 
-    if (heightMap_)
-    {
-        numPatches_ = IntVector2((heightMap_->GetWidth() - 1) / patchSize_, (heightMap_->GetHeight() - 1) / patchSize_);
-        numVertices_ = IntVector2(numPatches_.x_ * patchSize_ + 1, numPatches_.y_ * patchSize_ + 1);
-        patchWorldOrigin_ =
-            Vector2(-0.5f * (float)numPatches_.x_ * patchWorldSize_.x_, -0.5f * (float)numPatches_.y_ * patchWorldSize_.y_);
-        if (numVertices_ != lastNumVertices_ || lastSpacing_ != spacing_ || patchSize_ != lastPatchSize_)
-            updateAll = true;
-        auto newDataSize = (unsigned)(numVertices_.x_ * numVertices_.y_);
+void Terrain::CreateGeometry()
+{
+    recreateTerrain_ = false;
 
-        // Create new height data if terrain size changed
-        if (!heightData_ || updateAll)
-            heightData_ = new float[newDataSize];
+    if (!node_)
+        return;
 
-        // Ensure that the source (unsmoothed) data exists if smoothing is active
-        if (smoothing_ && (!sourceHeightData_ || updateAll))
-        {
-            sourceHeightData_ = new float[newDataSize];
-            updateAll = true;
-        }
-        else if (!smoothing_)
-            sourceHeightData_.reset();
-    }
-    else
+    URHO3D_PROFILE("CreateTerrainGeometry");
+
+    unsigned prevNumPatches = patches_.size();
+
+    // Use the geometry generated ahead of time, unless the heightmap or settings have changed since
+    ea::unique_ptr<GeneratedGeometry> generated = ea::move(generatedGeometry_);
+    if (generated && (!heightMap_ || generated->heightMap_ != heightMap_ || generated->smoothing_ != smoothing_ ||
+        lastPatchSize_ != patchSize_ || lastSpacing_ != spacing_))
     {
-        numPatches_ = IntVector2::ZERO;
-        numVertices_ = IntVector2::ZERO;
-        patchWorldOrigin_ = Vector2::ZERO;
-        heightData_.reset();
-        sourceHeightData_.reset();
+        generated.reset();
+        lastPatchSize_ = 0; // Force full recreate
     }
 
-    lastNumVertices_ = numVertices_;
-    lastPatchSize_ = patchSize_;
-    lastSpacing_ = spacing_;
+    bool updateAll = true;
+    ea::vector<bool> dirtyPatches;
+    if (generated)
+        dirtyPatches.resize((unsigned)(numPatches_.x_ * numPatches_.y_), true);
+    else
+        updateAll = UpdateHeightData(heightMap_, dirtyPatches);
 
     // Remove old patch nodes which are not needed
     if (updateAll)
@@ -934,96 +946,10 @@ void Terrain::CreateGeometry()
         }
     }
 
-    // Keep track of which patches actually need an update
-    ea::vector<bool> dirtyPatches((unsigned)(numPatches_.x_ * numPatches_.y_));
-    for (unsigned i = 0; i < dirtyPatches.size(); ++i)
-        dirtyPatches[i] = updateAll;
-
     patches_.clear();
 
     if (heightMap_)
     {
-        // Copy heightmap data
-        const unsigned char* src = heightMap_->GetData();
-        float* dest = smoothing_ ? sourceHeightData_.get() : heightData_.get();
-        unsigned imgComps = heightMap_->GetComponents();
-        unsigned imgRow = heightMap_->GetWidth() * imgComps;
-        IntRect updateRegion(-1, -1, -1, -1);
-
-        if (imgComps == 1)
-        {
-            URHO3D_PROFILE("CopyHeightData");
-
-            for (int z = 0; z < numVertices_.y_; ++z)
-            {
-                for (int x = 0; x < numVertices_.x_; ++x)
-                {
-                    float newHeight = (float)src[imgRow * (numVertices_.y_ - 1 - z) + x] * spacing_.y_;
-
-                    if (updateAll)
-                        *dest = newHeight;
-                    else
-                    {
-                        if (*dest != newHeight)
-                        {
-                            *dest = newHeight;
-                            GrowUpdateRegion(updateRegion, x, z);
-                        }
-                    }
-
-                    ++dest;
-                }
-            }
-        }
-        else
-        {
-            URHO3D_PROFILE("CopyHeightData");
-
-            // If more than 1 component, use the green channel for more accuracy
-            for (int z = 0; z < numVertices_.y_; ++z)
-            {
-                for (int x = 0; x < numVertices_.x_; ++x)
-                {
-                    float newHeight = ((float)src[imgRow * (numVertices_.y_ - 1 - z) + imgComps * x] +
-                                       (float)src[imgRow * (numVertices_.y_ - 1 - z) + imgComps * x + 1] / 256.0f) * spacing_.y_;
-
-                    if (updateAll)
-                        *dest = newHeight;
-                    else
-                    {
-                        if (*dest != newHeight)
-                        {
-                            *dest = newHeight;
-                            GrowUpdateRegion(updateRegion, x, z);
-                        }
-                    }
-
-                    ++dest;
-                }
-            }
-        }
-
-        // If updating a region of the heightmap, check which patches change
-        if (!updateAll)
-        {
-            int lodExpand = 1u << (numLodLevels_ - 1);
-            // Expand the right & bottom 1 pixel more, as patches share vertices at the edge
-            updateRegion.left_ -= lodExpand;
-            updateRegion.right_ += lodExpand + 1;
-            updateRegion.top_ -= lodExpand;
-            updateRegion.bottom_ += lodExpand + 1;
-
-            int sX = Max(updateRegion.left_ / patchSize_, 0);
-            int eX = Min(updateRegion.right_ / patchSize_, numPatches_.x_ - 1);
-            int sY = Max(updateRegion.top_ / patchSize_, 0);
-            int eY = Min(updateRegion.bottom_ / patchSize_, numPatches_.y_ - 1);
-            for (int y = sY; y <= eY; ++y)
-            {
-                for (int x = sX; x <= eX; ++x)
-                    dirtyPatches[y * numPatches_.x_ + x] = true;
-            }
-        }
-
         patches_.reserve((unsigned) (numPatches_.x_ * numPatches_.y_));
 
         bool enabled = IsEnabledEffective();
@@ -1083,51 +1009,61 @@ void Terrain::CreateGeometry()
         if (updateAll)
             CreateIndexData();
 
-        // Create vertex data for patches. First update smoothing to ensure normals are calculated correctly across patch borders
-        if (smoothing_)
+        if (generated)
         {
-            URHO3D_PROFILE("UpdateSmoothing");
+            URHO3D_PROFILE("UploadPatches");
 
+            for (unsigned i = 0; i < patches_.size(); ++i)
+            {
+                TerrainPatch* patch = patches_[i];
+                patch->GetLodErrors().swap(generated->patches_[i].lodErrors_);
+                ApplyPatchVertexData(patch, generated->patches_[i]);
+            }
+        }
+        else
+        {
+            ea::vector<unsigned> dirtyPatchIndices;
             for (unsigned i = 0; i < patches_.size(); ++i)
             {
                 if (dirtyPatches[i])
+                    dirtyPatchIndices.push_back(i);
+            }
+
+            // Generate vertex data and LOD errors on worker threads, then upload on the main thread. Batches limit the amount of
+            // vertex data waiting for upload
+            auto* queue = GetSubsystem<WorkQueue>();
+            ea::vector<PatchVertexData> vertexData(Min((unsigned)dirtyPatchIndices.size(), PATCH_GENERATION_BATCH_SIZE));
+            for (unsigned batchStart = 0; batchStart < dirtyPatchIndices.size(); batchStart += PATCH_GENERATION_BATCH_SIZE)
+            {
+                const unsigned batchSize = Min((unsigned)dirtyPatchIndices.size() - batchStart, PATCH_GENERATION_BATCH_SIZE);
+                const auto generatePatches = [&](unsigned begin, unsigned end, unsigned /*threadIndex*/)
                 {
-                    TerrainPatch* patch = patches_[i];
-                    const IntVector2& coords = patch->GetCoordinates();
-                    int startX = coords.x_ * patchSize_;
-                    int endX = startX + patchSize_;
-                    int startZ = coords.y_ * patchSize_;
-                    int endZ = startZ + patchSize_;
-
-                    for (int z = startZ; z <= endZ; ++z)
+                    for (unsigned i = begin; i < end; ++i)
                     {
-                        for (int x = startX; x <= endX; ++x)
-                        {
-                            float smoothedHeight = (
-                                GetSourceHeight(x - 1, z - 1) + GetSourceHeight(x, z - 1) * 2.0f + GetSourceHeight(x + 1, z - 1) +
-                                GetSourceHeight(x - 1, z) * 2.0f + GetSourceHeight(x, z) * 4.0f + GetSourceHeight(x + 1, z) * 2.0f +
-                                GetSourceHeight(x - 1, z + 1) + GetSourceHeight(x, z + 1) * 2.0f + GetSourceHeight(x + 1, z + 1)
-                            ) / 16.0f;
-
-                            heightData_[z * numVertices_.x_ + x] = smoothedHeight;
-                        }
+                        TerrainPatch* patch = patches_[dirtyPatchIndices[batchStart + i]];
+                        GeneratePatchVertexData(patch->GetCoordinates(), vertexData[i]);
+                        CalculateLodErrors(patch->GetCoordinates(), patch->GetLodErrors());
                     }
+                };
+
+                {
+                    URHO3D_PROFILE("GeneratePatches");
+
+                    if (queue)
+                        queue->ParallelFor(0, batchSize, PATCH_GENERATION_GRAIN_SIZE, generatePatches);
+                    else
+                        generatePatches(0, batchSize, 0);
                 }
-            }
-        }
 
-        for (unsigned i = 0; i < patches_.size(); ++i)
-        {
-            TerrainPatch* patch = patches_[i];
+                URHO3D_PROFILE("UploadPatches");
 
-            if (dirtyPatches[i])
-            {
-                CreatePatchGeometry(patch);
-                CalculateLodErrors(patch);
+                for (unsigned i = 0; i < batchSize; ++i)
+                    ApplyPatchVertexData(patches_[dirtyPatchIndices[batchStart + i]], vertexData[i]);
             }
-
-            SetPatchNeighbors(patch);
         }
+
+        for (unsigned i = 0; i < patches_.size(); ++i)
+            SetPatchNeighbors(patches_[i]);
     }
 
     // Send event only if new geometry was generated, or the old was cleared
@@ -1141,6 +1077,179 @@ void Terrain::CreateGeometry()
     }
 }
 
+bool Terrain::UpdateHeightData(Image* image, ea::vector<bool>& dirtyPatches)
+{
+    // Determine number of LOD levels
+    auto lodSize = (unsigned)patchSize_;
+    numLodLevels_ = 1;
+    while (lodSize > MIN_PATCH_SIZE && numLodLevels_ < maxLodLevels_)
+    {
+        lodSize >>= 1;
+        ++numLodLevels_;
+    }
+
+    // Determine total terrain size
+    patchWorldSize_ = Vector2(spacing_.x_ * (float)patchSize_, spacing_.z_ * (float)patchSize_);
+    bool updateAll = false;
+
+    if (image)
+    {
+        numPatches_ = IntVector2((image->GetWidth() - 1) / patchSize_, (image->GetHeight() - 1) / patchSize_);
+        numVertices_ = IntVector2(numPatches_.x_ * patchSize_ + 1, numPatches_.y_ * patchSize_ + 1);
+        patchWorldOrigin_ =
+            Vector2(-0.5f * (float)numPatches_.x_ * patchWorldSize_.x_, -0.5f * (float)numPatches_.y_ * patchWorldSize_.y_);
+        if (numVertices_ != lastNumVertices_ || lastSpacing_ != spacing_ || patchSize_ != lastPatchSize_)
+            updateAll = true;
+        auto newDataSize = (unsigned)(numVertices_.x_ * numVertices_.y_);
+
+        // Create new height data if terrain size changed
+        if (!heightData_ || updateAll)
+            heightData_ = new float[newDataSize];
+
+        // Ensure that the source (unsmoothed) data exists if smoothing is active
+        if (smoothing_ && (!sourceHeightData_ || updateAll))
+        {
+            sourceHeightData_ = new float[newDataSize];
+            updateAll = true;
+        }
+        else if (!smoothing_)
+            sourceHeightData_.reset();
+    }
+    else
+    {
+        numPatches_ = IntVector2::ZERO;
+        numVertices_ = IntVector2::ZERO;
+        patchWorldOrigin_ = Vector2::ZERO;
+        heightData_.reset();
+        sourceHeightData_.reset();
+    }
+
+    lastNumVertices_ = numVertices_;
+    lastPatchSize_ = patchSize_;
+    lastSpacing_ = spacing_;
+
+    // Keep track of which patches actually need an update
+    dirtyPatches.clear();
+    dirtyPatches.resize((unsigned)(numPatches_.x_ * numPatches_.y_), updateAll);
+
+    if (!image)
+        return updateAll;
+
+    // Copy heightmap data
+    const unsigned char* src = image->GetData();
+    float* dest = smoothing_ ? sourceHeightData_.get() : heightData_.get();
+    unsigned imgComps = image->GetComponents();
+    unsigned imgRow = image->GetWidth() * imgComps;
+    IntRect updateRegion(-1, -1, -1, -1);
+
+    if (imgComps == 1)
+    {
+        URHO3D_PROFILE("CopyHeightData");
+
+        for (int z = 0; z < numVertices_.y_; ++z)
+        {
+            for (int x = 0; x < numVertices_.x_; ++x)
+            {
+                float newHeight = (float)src[imgRow * (numVertices_.y_ - 1 - z) + x] * spacing_.y_;
+
+                if (updateAll)
+                    *dest = newHeight;
+                else
+                {
+                    if (*dest != newHeight)
+                    {
+                        *dest = newHeight;
+                        GrowUpdateRegion(updateRegion, x, z);
+                    }
+                }
+
+                ++dest;
+            }
+        }
+    }
+    else
+    {
+        URHO3D_PROFILE("CopyHeightData");
+
+        // If more than 1 component, use the green channel for more accuracy
+        for (int z = 0; z < numVertices_.y_; ++z)
+        {
+            for (int x = 0; x < numVertices_.x_; ++x)
+            {
+                float newHeight = ((float)src[imgRow * (numVertices_.y_ - 1 - z) + imgComps * x] +
+                                   (float)src[imgRow * (numVertices_.y_ - 1 - z) + imgComps * x + 1] / 256.0f) * spacing_.y_;
+
+                if (updateAll)
+                    *dest = newHeight;
+                else
+                {
+                    if (*dest != newHeight)
+                    {
+                        *dest = newHeight;
+                        GrowUpdateRegion(updateRegion, x, z);
+                    }
+                }
+
+                ++dest;
+            }
+        }
+    }
+
+    // If updating a region of the heightmap, check which patches change
+    if (!updateAll)
+    {
+        int lodExpand = 1u << (numLodLevels_ - 1);
+        // Expand the right & bottom 1 pixel more, as patches share vertices at the edge
+        updateRegion.left_ -= lodExpand;
+        updateRegion.right_ += lodExpand + 1;
+        updateRegion.top_ -= lodExpand;
+        updateRegion.bottom_ += lodExpand + 1;
+
+        int sX = Max(updateRegion.left_ / patchSize_, 0);
+        int eX = Min(updateRegion.right_ / patchSize_, numPatches_.x_ - 1);
+        int sY = Max(updateRegion.top_ / patchSize_, 0);
+        int eY = Min(updateRegion.bottom_ / patchSize_, numPatches_.y_ - 1);
+        for (int y = sY; y <= eY; ++y)
+        {
+            for (int x = sX; x <= eX; ++x)
+                dirtyPatches[y * numPatches_.x_ + x] = true;
+        }
+    }
+
+    // Update smoothing to ensure normals are calculated correctly across patch borders
+    if (smoothing_)
+    {
+        URHO3D_PROFILE("UpdateSmoothing");
+
+        for (unsigned i = 0; i < dirtyPatches.size(); ++i)
+        {
+            if (dirtyPatches[i])
+            {
+                int startX = (int)(i % numPatches_.x_) * patchSize_;
+                int endX = startX + patchSize_;
+                int startZ = (int)(i / numPatches_.x_) * patchSize_;
+                int endZ = startZ + patchSize_;
+
+                for (int z = startZ; z <= endZ; ++z)
+                {
+                    for (int x = startX; x <= endX; ++x)
+                    {
+                        float smoothedHeight = (
+                            GetSourceHeight(x - 1, z - 1) + GetSourceHeight(x, z - 1) * 2.0f + GetSourceHeight(x + 1, z - 1) +
+                            GetSourceHeight(x - 1, z) * 2.0f + GetSourceHeight(x, z) * 4.0f + GetSourceHeight(x + 1, z) * 2.0f +
+                            GetSourceHeight(x - 1, z + 1) + GetSourceHeight(x, z + 1) * 2.0f + GetSourceHeight(x + 1, z + 1)
+                        ) / 16.0f;
+
+                        heightData_[z * numVertices_.x_ + x] = smoothedHeight;
+                    }
+                }
+            }
+        }
+    }
+
+    return updateAll;
+}
+
 void Terrain::CreateIndexData()
 {
     URHO3D_PROFILE("CreateIndexData");
@@ -1369,12 +1478,10 @@ Vector3 Terrain::GetRawNormal(int x, int z) const
             Vector3(nwSlope, up, nwSlope)).Normalized();
 }
 
-void Terrain::CalculateLodErrors(TerrainPatch* patch)
+void Terrain::CalculateLodErrors(const IntVector2& coords, ea::vector<float>& lodErrors) const
 {
     URHO3D_PROFILE("CalculateLodErrors");
 
-    const IntVector2& coords = patch->GetCoordinates();
-    ea::vector<float>& lodErrors = patch->GetLodErrors();
     lodErrors.clear();
     lodErrors.reserve(numLodLevels_);
 
@@ -22,6 +22,10 @@
 
 #pragma once
 
+#include <EASTL/shared_array.h>
+#include <EASTL/unique_ptr.h>
+
+#include "../Math/BoundingBox.h"
 #include "../Scene/Component.h"
 
 namespace Urho3D
@@ -65,6 +69,8 @@ public:
     void SetSmoothing(bool enable);
     /// Set heightmap image. Dimensions should be a power of two + 1. Uses 8-bit grayscale, or optionally red as MSB and green as LSB for 16-bit accuracy. Return true if successful.
     bool SetHeightMap(Image* image);
+    /// Generate the height data and patch vertex data of a heightmap image ahead of time. A following SetHeightMap() with the same image and settings then only creates the patches and uploads the data. Does not access the scene or GPU resources, so may be called from a worker thread while nothing else uses the terrain, for example before it is added to a node.
+    void GenerateGeometryData(Image* image);
     /// Set material.
     void SetMaterial(Material* material);
     /// Set north (positive Z) neighbor terrain for seamless LOD changes across terrains.
@@ -215,8 +221,36 @@ public:
     ResourceRef GetMaterialAttr() const;
 
 private:
+    /// Vertex data of a terrain patch, generated before it is uploaded.
+    struct PatchVertexData
+    {
+        /// Interleaved vertex buffer data.
+        ea::vector<float> vertexData_;
+        /// Positions for raycasts.
+        ea::shared_array<unsigned char> cpuVertexData_;
+        /// Positions for occlusion, lowered to the neighborhood minimum height.
+        ea::shared_array<unsigned char> occlusionCpuVertexData_;
+        /// Bounding box.
+        BoundingBox box_;
+        /// LOD errors. Only used for geometry generated ahead of time.
+        ea::vector<float> lodErrors_;
+    };
+
+    /// Geometry generated ahead of time by GenerateGeometryData().
+    struct GeneratedGeometry
+    {
+        /// Heightmap the geometry was generated from. Only compared against.
+        const Image* heightMap_{};
+        /// Smoothing flag at the time of generation.
+        bool smoothing_{};
+        /// Vertex data and LOD errors of all patches.
+        ea::vector<PatchVertexData> patches_;
+    };
+
     /// Regenerate terrain geometry.
     void CreateGeometry();
+    /// Update terrain size and copy the height data from the heightmap image, including smoothing. Mark the patches whose heights changed. Return true if all patches must be recreated.
+    bool UpdateHeightData(Image* image, ea::vector<bool>& dirtyPatches);
     /// Create index data shared by all patches.
     void CreateIndexData();
     /// Return an uninterpolated terrain height value, clamping to edges.
@@ -227,8 +261,12 @@ private:
     float GetLodHeight(int x, int z, unsigned lodLevel) const;
     /// Get slope-based terrain normal at position.
     Vector3 GetRawNormal(int x, int z) const;
-    /// Calculate LOD errors for a patch.
-    void CalculateLodErrors(TerrainPatch* patch);
+    /// Generate vertex data of a patch. Only reads the height data, so may be called from worker threads.
+    void GeneratePatchVertexData(const IntVector2& coords, PatchVertexData& data) const;
+    /// Upload generated vertex data into the patch vertex buffer and geometries.
+    void ApplyPatchVertexData(TerrainPatch* patch, PatchVertexData& data);
+    /// Calculate LOD errors of a patch. Only reads the height data, so may be called from worker threads.
+    void CalculateLodErrors(const IntVector2& coords, ea::vector<float>& lodErrors) const;
     /// Set neighbors for a patch.
     void SetPatchNeighbors(TerrainPatch* patch);
     /// Set heightmap image and optionally recreate the geometry immediately. Return true if successful.
@@ -252,6 +290,8 @@ private:
     ea::shared_array<float> heightData_;
     /// Source height data for smoothing.
     ea::shared_array<float> sourceHeightData_;
+    /// Geometry generated ahead of time, waiting for the heightmap to be set.
+    ea::unique_ptr<GeneratedGeometry> generatedGeometry_;
     /// Material.
     SharedPtr<Material> material_;
     /// Terrain patches.
@@ -0,0 +1,807 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include <EASTL/sort.h>
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/Camera.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Renderer.h"
+#include "../Graphics/Terrain.h"
+#include "../Graphics/TerrainPager.h"
+#include "../Graphics/Viewport.h"
+#include "../IO/Log.h"
+#include "../Resource/Image.h"
+#include "../Resource/ResourceCache.h"
+#include "../Resource/ResourceEvents.h"
+#include "../Scene/Node.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* GEOMETRY_CATEGORY;
+
+static const int DEFAULT_PAGE_VERTICES = 1025;
+static const Vector3 DEFAULT_PAGE_SPACING(1.0f, 0.25f, 1.0f);
+static const int DEFAULT_PAGE_PATCH_SIZE = 32;
+static const unsigned DEFAULT_PAGE_LOD_LEVELS = 4;
+static const float DEFAULT_LOAD_DISTANCE = 2048.0f;
+static const float DEFAULT_UNLOAD_DISTANCE = 3072.0f;
+static const unsigned DEFAULT_MEMORY_BUDGET = 1024;
+/// Page coordinates with distance from the observer.
+using PageDistance = ea::pair<float, IntVector2>;
+
+/// Compare pages by distance.
+static bool ComparePageDistances(const PageDistance& lhs, const PageDistance& rhs)
+{
+    return lhs.first < rhs.first;
+}
+
+/// Bytes per vertex of the page geometry: heights, interleaved vertex data, and positions for raycasts and occlusion.
+static const unsigned PAGE_BYTES_PER_VERTEX = sizeof(float) + 12 * sizeof(float) + 2 * sizeof(Vector3);
+
+TerrainPager::TerrainPager(Context* context) :
+    Component(context),
+    pageVertices_(DEFAULT_PAGE_VERTICES),
+    numPages_(IntVector2::ZERO),
+    spacing_(DEFAULT_PAGE_SPACING),
+    patchSize_(DEFAULT_PAGE_PATCH_SIZE),
+    maxLodLevels_(DEFAULT_PAGE_LOD_LEVELS),
+    smoothing_(false),
+    drawDistance_(0.0f),
+    lodBias_(1.0f),
+    castShadows_(false),
+    occluder_(false),
+    loadDistance_(DEFAULT_LOAD_DISTANCE),
+    unloadDistance_(DEFAULT_UNLOAD_DISTANCE),
+    memoryBudget_(DEFAULT_MEMORY_BUDGET),
+    maxPageCreations_(1),
+    observerID_(0),
+    observerDirty_(false),
+    pagesDirty_(false)
+{
+}
+
+TerrainPager::~TerrainPager()
+{
+    // Work items refer to the pending terrains and heightmaps, so wait for them
+    CompletePageGeneration();
+}
+
+void TerrainPager::RegisterObject(Context* context)
+{
+    context->RegisterFactory<TerrainPager>(GEOMETRY_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Height Map Pattern", GetHeightMapPattern, SetHeightMapPattern, ea::string, EMPTY_STRING, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Page Vertices", GetPageVertices, SetPageVertices, int, DEFAULT_PAGE_VERTICES, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Num Pages", GetNumPages, SetNumPages, IntVector2, IntVector2::ZERO, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Vertex Spacing", GetSpacing, SetSpacing, Vector3, DEFAULT_PAGE_SPACING, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Patch Size", GetPatchSize, SetPatchSize, int, DEFAULT_PAGE_PATCH_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max LOD Levels", GetMaxLodLevels, SetMaxLodLevels, unsigned, DEFAULT_PAGE_LOD_LEVELS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Smooth Height Map", GetSmoothing, SetSmoothing, bool, false, AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Material", GetMaterialAttr, SetMaterialAttr, ResourceRef, ResourceRef(Material::GetTypeStatic()),
+        AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Draw Distance", GetDrawDistance, SetDrawDistance, float, 0.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Cast Shadows", GetCastShadows, SetCastShadows, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Occluder", IsOccluder, SetOccluder, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Load Distance", GetLoadDistance, SetLoadDistance, float, DEFAULT_LOAD_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Unload Distance", GetUnloadDistance, SetUnloadDistance, float, DEFAULT_UNLOAD_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Memory Budget", GetMemoryBudget, SetMemoryBudget, unsigned, DEFAULT_MEMORY_BUDGET, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max Page Creations", GetMaxPageCreations, SetMaxPageCreations, unsigned, 1, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("Observer NodeID", unsigned, observerID_, MarkObserverDirty, 0, AM_DEFAULT | AM_NODEID);
+}
+
+void TerrainPager::ApplyAttributes()
+{
+    if (observerDirty_)
+    {
+        Scene* scene = GetScene();
+        observer_ = scene ? scene->GetNode(observerID_) : nullptr;
+        observerDirty_ = false;
+    }
+}
+
+void TerrainPager::OnSetEnabled()
+{
+    Scene* scene = GetScene();
+    if (scene)
+    {
+        if (IsEnabledEffective())
+            SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(TerrainPager, HandleSceneUpdate));
+        else
+            UnsubscribeFromEvent(scene, E_SCENEUPDATE);
+    }
+}
+
+void TerrainPager::SetHeightMapPattern(const ea::string& pattern)
+{
+    if (pattern != heightMapPattern_)
+    {
+        heightMapPattern_ = pattern;
+        pagesDirty_ = true;
+        MarkNetworkUpdate();
+    }
+}
+
+void TerrainPager::SetPageVertices(int vertices)
+{
+    if (vertices < 2 || !IsPowerOfTwo((unsigned)(vertices - 1)))
+    {
+        URHO3D_LOGERROR("Terrain page vertices must be a power of two + 1");
+        return;
+    }
+
+    if (vertices != pageVertices_)
+    {
+        pageVertices_ = vertices;
+        pagesDirty_ = true;
+        MarkNetworkUpdate();
+    }
+}
+
+void TerrainPager::SetNumPages(const IntVector2& numPages)
+{
+    if (numPages != numPages_)
+    {
+        numPages_ = numPages;
+        pagesDirty_ = true;
+        MarkNetworkUpdate();
+    }
+}
+
+void TerrainPager::SetSpacing(const Vector3& spacing)
+{
+    if (spacing != spacing_)
+    {
+        spacing_ = spacing;
+        pagesDirty_ = true;
+        MarkNetworkUpdate();
+    }
+}
+
+void TerrainPager::SetPatchSize(int size)
+{
+    if (size != patchSize_)
+    {
+        patchSize_ = size;
+        pagesDirty_ = true;
+        MarkNetworkUpdate();
+    }
+}
+
+void TerrainPager::SetMaxLodLevels(unsigned levels)
+{
+    if (levels != maxLodLevels_)
+    {
+        maxLodLevels_ = levels;
+        pagesDirty_ = true;
+        MarkNetworkUpdate();
+    }
+}
+
+void TerrainPager::SetSmoothing(bool enable)
+{
+    if (enable != smoothing_)
+    {
+        smoothing_ = enable;
+        pagesDirty_ = true;
+        MarkNetworkUpdate();
+    }
+}
+
+void TerrainPager::SetMaterial(Material* material)
+{
+    material_ = material;
+    ApplyPageSettings();
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::SetDrawDistance(float distance)
+{
+    drawDistance_ = distance;
+    ApplyPageSettings();
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::SetLodBias(float bias)
+{
+    lodBias_ = bias;
+    ApplyPageSettings();
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::SetCastShadows(bool enable)
+{
+    castShadows_ = enable;
+    ApplyPageSettings();
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::SetOccluder(bool enable)
+{
+    occluder_ = enable;
+    ApplyPageSettings();
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::SetLoadDistance(float distance)
+{
+    loadDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::SetUnloadDistance(float distance)
+{
+    unloadDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::SetMemoryBudget(unsigned megabytes)
+{
+    memoryBudget_ = megabytes;
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::SetMaxPageCreations(unsigned num)
+{
+    maxPageCreations_ = Max(num, 1u);
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::SetObserver(Node* observer)
+{
+    observer_ = observer;
+    observerID_ = observer ? observer->GetID() : 0;
+    MarkNetworkUpdate();
+}
+
+void TerrainPager::UnloadAllPages()
+{
+    ea::vector<IntVector2> coords;
+    for (const auto& item : pages_)
+        coords.push_back(item.first);
+
+    for (const IntVector2& pageCoords : coords)
+        UnloadPage(pageCoords);
+}
+
+Material* TerrainPager::GetMaterial() const
+{
+    return material_;
+}
+
+IntVector2 TerrainPager::WorldToPage(const Vector3& worldPosition) const
+{
+    const float pageSize = GetPageSize();
+    if (!node_ || pageSize <= 0.0f)
+        return IntVector2::ZERO;
+
+    const Vector3 position = node_->WorldToLocal(worldPosition);
+    return IntVector2(FloorToInt(position.x_ / pageSize), FloorToInt(position.z_ / pageSize));
+}
+
+Terrain* TerrainPager::GetPage(const IntVector2& coords) const
+{
+    return GetCreatedTerrain(coords);
+}
+
+unsigned TerrainPager::GetNumLoadedPages() const
+{
+    unsigned num = 0;
+    for (const auto& item : pages_)
+    {
+        if (item.second.state_ == PAGE_CREATED)
+            ++num;
+    }
+    return num;
+}
+
+unsigned TerrainPager::GetNumLoadingPages() const
+{
+    unsigned num = 0;
+    for (const auto& item : pages_)
+    {
+        if (item.second.state_ == PAGE_LOADING || item.second.state_ == PAGE_READY || item.second.state_ == PAGE_GENERATING)
+            ++num;
+    }
+    return num;
+}
+
+unsigned long long TerrainPager::GetMemoryUse() const
+{
+    // Cancelled pages can not be evicted to make room, but are released as soon as they finish loading
+    unsigned long long memoryUse = 0;
+    for (const auto& item : pages_)
+    {
+        if (item.second.state_ != PAGE_CANCELLED)
+            memoryUse += item.second.memoryUse_;
+    }
+    return memoryUse;
+}
+
+float TerrainPager::GetHeight(const Vector3& worldPosition) const
+{
+    Terrain* terrain = GetCreatedTerrain(WorldToPage(worldPosition));
+    return terrain ? terrain->GetHeight(worldPosition) : 0.0f;
+}
+
+void TerrainPager::SetMaterialAttr(const ResourceRef& value)
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+    SetMaterial(cache->GetResource<Material>(value.name_));
+}
+
+ResourceRef TerrainPager::GetMaterialAttr() const
+{
+    return GetResourceRef(material_, Material::GetTypeStatic());
+}
+
+void TerrainPager::OnSceneSet(Scene* scene)
+{
+    if (scene)
+    {
+        if (IsEnabledEffective())
+            SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(TerrainPager, HandleSceneUpdate));
+        SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(TerrainPager, HandleResourceBackgroundLoaded));
+    }
+    else
+    {
+        UnsubscribeFromEvent(E_SCENEUPDATE);
+        UnsubscribeFromEvent(E_RESOURCEBACKGROUNDLOADED);
+        CompletePageGeneration();
+        UnloadAllPages();
+    }
+}
+
+void TerrainPager::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+{
+    UpdatePages();
+}
+
+void TerrainPager::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    auto i = loadingPages_.find(eventData[P_RESOURCENAME].GetString());
+    if (i == loadingPages_.end())
+        return;
+
+    const IntVector2 coords = i->second;
+    const ea::string name = i->first;
+    loadingPages_.erase(i);
+
+    auto j = pages_.find(coords);
+    if (j == pages_.end() || j->second.heightMapName_ != name)
+        return;
+
+    Page& page = j->second;
+    auto* image = dynamic_cast<Image*>(eventData[P_RESOURCE].GetPtr());
+    if (page.state_ == PAGE_CANCELLED)
+    {
+        pages_.erase(j);
+        GetSubsystem<ResourceCache>()->ReleaseResource<Image>(name);
+    }
+    else if (!eventData[P_SUCCESS].GetBool() || !image)
+    {
+        pages_.erase(j);
+        missingPages_.insert(coords);
+    }
+    else
+    {
+        page.heightMap_ = image;
+        page.memoryUse_ = EstimatePageMemory(image);
+        page.state_ = PAGE_READY;
+    }
+}
+
+void TerrainPager::UpdatePages()
+{
+    URHO3D_PROFILE("UpdateTerrainPages");
+
+    if (pagesDirty_)
+    {
+        UnloadAllPages();
+        missingPages_.clear();
+        pagesDirty_ = false;
+    }
+
+    ReleaseCancelledPages();
+
+    const float pageSize = GetPageSize();
+    Vector3 position;
+    if (heightMapPattern_.empty() || pageSize <= 0.0f || !GetObserverPosition(position))
+        return;
+
+    // Unload pages beyond the unload distance
+    const float unloadDistance = Max(unloadDistance_, loadDistance_);
+    ea::vector<IntVector2> unloads;
+    for (const auto& item : pages_)
+    {
+        if (item.second.state_ != PAGE_CANCELLED && GetPageDistance(item.first, position) > unloadDistance)
+            unloads.push_back(item.first);
+    }
+    for (const IntVector2& coords : unloads)
+        UnloadPage(coords);
+
+    // Find pages to load within the load distance, nearest first
+    ea::vector<PageDistance> candidates;
+    const IntVector2 center(FloorToInt(position.x_ / pageSize), FloorToInt(position.z_ / pageSize));
+    const int range = CeilToInt(loadDistance_ / pageSize);
+    for (int z = center.y_ - range; z <= center.y_ + range; ++z)
+    {
+        for (int x = center.x_ - range; x <= center.x_ + range; ++x)
+        {
+            const IntVector2 coords(x, z);
+            if (!IsValidPage(coords) || missingPages_.count(coords))
+                continue;
+
+            auto i = pages_.find(coords);
+            if (i != pages_.end() && i->second.state_ != PAGE_CANCELLED)
+                continue;
+
+            const float distance = GetPageDistance(coords, position);
+            if (distance <= loadDistance_)
+                candidates.emplace_back(distance, coords);
+        }
+    }
+    ea::sort(candidates.begin(), candidates.end(), ComparePageDistances);
+
+    // Keep within the memory budget by unloading the farthest pages, but only for pages nearer than them
+    const unsigned long long budget = (unsigned long long)memoryBudget_ * 1024 * 1024;
+    const unsigned long long estimate = EstimatePageMemory(nullptr);
+    unsigned long long memoryUse = GetMemoryUse();
+    for (const auto& candidate : candidates)
+    {
+        while (budget && memoryUse + estimate > budget)
+        {
+            IntVector2 farthestCoords;
+            float farthestDistance = candidate.first;
+            const Page* farthest = nullptr;
+            for (const auto& item : pages_)
+            {
+                if (item.second.state_ == PAGE_CANCELLED)
+                    continue;
+
+                const float distance = GetPageDistance(item.first, position);
+                if (distance > farthestDistance)
+                {
+                    farthestCoords = item.first;
+                    farthestDistance = distance;
+                    farthest = &item.second;
+                }
+            }
+
+            if (!farthest)
+                break;
+
+            memoryUse -= Min(memoryUse, farthest->memoryUse_);
+            UnloadPage(farthestCoords);
+        }
+
+        if (budget && memoryUse + estimate > budget)
+            break;
+
+        LoadPage(candidate.second);
+        memoryUse += estimate;
+    }
+
+    // Add the pages whose geometry has been generated, nearest first. Only the upload happens on the main thread
+    ea::vector<PageDistance> readyPages;
+    ea::vector<PageDistance> generatedPages;
+    unsigned numGenerating = 0;
+    for (const auto& item : pages_)
+    {
+        const Page& page = item.second;
+        if (page.state_ == PAGE_READY)
+            readyPages.emplace_back(GetPageDistance(item.first, position), item.first);
+        else if (page.state_ == PAGE_GENERATING && (!page.item_ || page.item_->completed_))
+            generatedPages.emplace_back(GetPageDistance(item.first, position), item.first);
+        else if (page.state_ == PAGE_GENERATING)
+            ++numGenerating;
+    }
+    ea::sort(generatedPages.begin(), generatedPages.end(), ComparePageDistances);
+
+    for (unsigned i = 0; i < generatedPages.size() && i < maxPageCreations_; ++i)
+        CreatePage(generatedPages[i].second, pages_[generatedPages[i].second]);
+
+    // Generate the geometry of loaded pages, nearest first, keeping each worker thread busy with one page
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    const unsigned maxGenerating = workQueue ? Max(workQueue->GetNumThreads(), 1u) : 1;
+    ea::sort(readyPages.begin(), readyPages.end(), ComparePageDistances);
+
+    for (unsigned i = 0; i < readyPages.size() && numGenerating < maxGenerating; ++i, ++numGenerating)
+        GeneratePage(pages_[readyPages[i].second]);
+}
+
+bool TerrainPager::GetObserverPosition(Vector3& position) const
+{
+    Node* observer = observer_;
+    if (!observer)
+    {
+        auto* renderer = GetSubsystem<Renderer>();
+        Viewport* viewport = renderer ? renderer->GetViewport(0) : nullptr;
+        Camera* camera = viewport ? viewport->GetCamera() : nullptr;
+        if (camera && camera->GetScene() == GetScene())
+            observer = camera->GetNode();
+    }
+
+    if (!observer || !node_)
+        return false;
+
+    position = node_->WorldToLocal(observer->GetWorldPosition());
+    return true;
+}
+
+float TerrainPager::GetPageDistance(const IntVector2& coords, const Vector3& position) const
+{
+    const float pageSize = GetPageSize();
+    const float minX = (float)coords.x_ * pageSize;
+    const float minZ = (float)coords.y_ * pageSize;
+    const float dx = Max(Max(minX - position.x_, position.x_ - (minX + pageSize)), 0.0f);
+    const float dz = Max(Max(minZ - position.z_, position.z_ - (minZ + pageSize)), 0.0f);
+    return sqrtf(dx * dx + dz * dz);
+}
+
+bool TerrainPager::IsValidPage(const IntVector2& coords) const
+{
+    if (numPages_.x_ > 0 && (coords.x_ < 0 || coords.x_ >= numPages_.x_))
+        return false;
+    if (numPages_.y_ > 0 && (coords.y_ < 0 || coords.y_ >= numPages_.y_))
+        return false;
+    return true;
+}
+
+ea::string TerrainPager::GetHeightMapName(const IntVector2& coords) const
+{
+    const ea::string name = heightMapPattern_.replaced("{x}", ea::to_string(coords.x_).c_str())
+        .replaced("{z}", ea::to_string(coords.y_).c_str());
+    return GetSubsystem<ResourceCache>()->SanitateResourceName(name);
+}
+
+unsigned long long TerrainPager::EstimatePageMemory(Image* heightMap) const
+{
+    // Before loading, assume a 16-bit heightmap stored as RGB
+    const auto numVertices = (unsigned long long)(pageVertices_ * pageVertices_);
+    const unsigned long long heightMapBytes = heightMap ? heightMap->GetMemoryUse() : numVertices * 3;
+    const unsigned long long smoothingBytes = smoothing_ ? numVertices * sizeof(float) : 0;
+    return heightMapBytes + smoothingBytes + numVertices * PAGE_BYTES_PER_VERTEX;
+}
+
+void TerrainPager::LoadPage(const IntVector2& coords)
+{
+    const ea::string name = GetHeightMapName(coords);
+
+    auto i = pages_.find(coords);
+    if (i != pages_.end())
+    {
+        // A cancelled load can be resumed if it is still for the same heightmap. A cancelled generation may have used settings
+        // which have changed since, so the page is released once it completes and loaded again
+        if (i->second.state_ == PAGE_CANCELLED && !i->second.item_ && i->second.heightMapName_ == name)
+            i->second.state_ = PAGE_LOADING;
+        return;
+    }
+
+    auto* cache = GetSubsystem<ResourceCache>();
+    if (!cache->Exists(name))
+    {
+        missingPages_.insert(coords);
+        return;
+    }
+
+    Page& page = pages_[coords];
+    page.heightMapName_ = name;
+    page.memoryUse_ = EstimatePageMemory(nullptr);
+    loadingPages_[name] = coords;
+
+    // Falls back to a synchronous load without threading. The heightmap may also be loaded already
+    cache->BackgroundLoadResource<Image>(name);
+    if (Image* image = cache->GetExistingResource<Image>(name))
+    {
+        loadingPages_.erase(name);
+        page.heightMap_ = image;
+        page.memoryUse_ = EstimatePageMemory(image);
+        page.state_ = PAGE_READY;
+    }
+}
+
+void TerrainPager::GeneratePage(Page& page)
+{
+    // The terrain is not part of the scene until its geometry has been generated, so the worker thread is its only user
+    page.pendingTerrain_ = MakeShared<Terrain>(context_);
+    page.pendingTerrain_->SetSpacing(spacing_);
+    page.pendingTerrain_->SetPatchSize(patchSize_);
+    page.pendingTerrain_->SetMaxLodLevels(maxLodLevels_);
+    page.pendingTerrain_->SetSmoothing(smoothing_);
+    page.state_ = PAGE_GENERATING;
+
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    if (!workQueue)
+    {
+        page.pendingTerrain_->GenerateGeometryData(page.heightMap_);
+        return;
+    }
+
+    page.item_ = workQueue->GetFreeItem();
+    page.item_->start_ = page.pendingTerrain_.Get();
+    page.item_->aux_ = page.heightMap_.Get();
+    page.item_->workFunction_ = [](const WorkItem* item, unsigned /*threadIndex*/)
+    {
+        static_cast<Terrain*>(item->start_)->GenerateGeometryData(static_cast<Image*>(item->aux_));
+    };
+    workQueue->AddWorkItem(page.item_);
+}
+
+void TerrainPager::CreatePage(const IntVector2& coords, Page& page)
+{
+    URHO3D_PROFILE("CreateTerrainPage");
+
+    const float pageSize = GetPageSize();
+    Node* pageNode = node_->CreateTemporaryChild("TerrainPage " + coords.ToString(), LOCAL);
+    pageNode->SetPosition(Vector3(((float)coords.x_ + 0.5f) * pageSize, 0.0f, ((float)coords.y_ + 0.5f) * pageSize));
+
+    // Uses the geometry generated on the worker thread, so only creates the patches and uploads their vertex data
+    Terrain* terrain = page.pendingTerrain_;
+    pageNode->AddComponent(terrain, 0, LOCAL);
+    ApplyPageSettings(terrain);
+    if (!terrain->SetHeightMap(page.heightMap_))
+        URHO3D_LOGWARNING("Failed to create terrain page from " + page.heightMapName_);
+
+    page.pendingTerrain_.Reset();
+    page.item_.Reset();
+    page.node_ = pageNode;
+    page.terrain_ = terrain;
+    page.state_ = PAGE_CREATED;
+
+    // Link with the adjacent pages so that LOD changes are stitched across page edges
+    Terrain* north = GetCreatedTerrain(coords + IntVector2(0, 1));
+    Terrain* south = GetCreatedTerrain(coords - IntVector2(0, 1));
+    Terrain* west = GetCreatedTerrain(coords - IntVector2(1, 0));
+    Terrain* east = GetCreatedTerrain(coords + IntVector2(1, 0));
+    terrain->SetNeighbors(north, south, west, east);
+    if (north)
+        north->SetSouthNeighbor(terrain);
+    if (south)
+        south->SetNorthNeighbor(terrain);
+    if (west)
+        west->SetEastNeighbor(terrain);
+    if (east)
+        east->SetWestNeighbor(terrain);
+}
+
+void TerrainPager::UnloadPage(const IntVector2& coords)
+{
+    auto i = pages_.find(coords);
+    if (i == pages_.end())
+        return;
+
+    Page& page = i->second;
+    if (page.state_ == PAGE_LOADING)
+    {
+        // The load can not be aborted, so the heightmap is released once it completes
+        page.state_ = PAGE_CANCELLED;
+        return;
+    }
+    if (page.state_ == PAGE_CANCELLED)
+        return;
+    if (page.state_ == PAGE_GENERATING && page.item_ && !page.item_->completed_ &&
+        !GetSubsystem<WorkQueue>()->RemoveWorkItem(page.item_))
+    {
+        // The generation is already running, so the page is released once it completes
+        page.state_ = PAGE_CANCELLED;
+        return;
+    }
+
+    if (page.terrain_)
+    {
+        if (Terrain* north = GetCreatedTerrain(coords + IntVector2(0, 1)))
+            north->SetSouthNeighbor(nullptr);
+        if (Terrain* south = GetCreatedTerrain(coords - IntVector2(0, 1)))
+            south->SetNorthNeighbor(nullptr);
+        if (Terrain* west = GetCreatedTerrain(coords - IntVector2(1, 0)))
+            west->SetEastNeighbor(nullptr);
+        if (Terrain* east = GetCreatedTerrain(coords + IntVector2(1, 0)))
+            east->SetWestNeighbor(nullptr);
+    }
+
+    if (page.node_)
+        page.node_->Remove();
+
+    const ea::string name = page.heightMapName_;
+    pages_.erase(i);
+
+    if (auto* cache = GetSubsystem<ResourceCache>())
+        cache->ReleaseResource<Image>(name);
+}
+
+void TerrainPager::ReleaseCancelledPages()
+{
+    for (auto i = pages_.begin(); i != pages_.end();)
+    {
+        const Page& page = i->second;
+        if (page.state_ != PAGE_CANCELLED || !page.item_ || !page.item_->completed_)
+        {
+            ++i;
+            continue;
+        }
+
+        const ea::string name = page.heightMapName_;
+        i = pages_.erase(i);
+        GetSubsystem<ResourceCache>()->ReleaseResource<Image>(name);
+    }
+}
+
+void TerrainPager::CompletePageGeneration()
+{
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    for (const auto& item : pages_)
+    {
+        const SharedPtr<WorkItem>& workItem = item.second.item_;
+        if (!workItem || workItem->completed_)
+            continue;
+
+        // A removed item never completes, so mark it completed instead
+        if (workQueue && workQueue->RemoveWorkItem(workItem))
+            workItem->completed_ = true;
+        while (!workItem->completed_)
+            Time::Sleep(0);
+    }
+
+    ReleaseCancelledPages();
+}
+
+void TerrainPager::ApplyPageSettings(Terrain* terrain) const
+{
+    terrain->SetMaterial(material_);
+    terrain->SetDrawDistance(drawDistance_);
+    terrain->SetLodBias(lodBias_);
+    terrain->SetCastShadows(castShadows_);
+    terrain->SetOccluder(occluder_);
+}
+
+void TerrainPager::ApplyPageSettings()
+{
+    for (const auto& item : pages_)
+    {
+        if (Terrain* terrain = item.second.terrain_)
+            ApplyPageSettings(terrain);
+    }
+}
+
+Terrain* TerrainPager::GetCreatedTerrain(const IntVector2& coords) const
+{
+    auto i = pages_.find(coords);
+    return i != pages_.end() ? i->second.terrain_.Get() : nullptr;
+}
+
+}
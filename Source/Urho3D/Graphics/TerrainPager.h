@@ -0,0 +1,272 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <EASTL/unordered_map.h>
+#include <EASTL/unordered_set.h>
+
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+class Image;
+class Material;
+class Terrain;
+struct WorkItem;
+
+/// Streams a large terrain as a grid of Terrain pages around an observer. Heightmap tiles are loaded and page geometry is generated in the background, distant pages are unloaded, and adjacent pages are linked as neighbors for seamless LOD changes.
+class URHO3D_API TerrainPager : public Component
+{
+    URHO3D_OBJECT(TerrainPager, Component);
+
+public:
+    /// Construct.
+    explicit TerrainPager(Context* context);
+    /// Destruct.
+    ~TerrainPager() override;
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
+    void ApplyAttributes() override;
+    /// Handle enabled/disabled state change.
+    void OnSetEnabled() override;
+
+    /// Set heightmap resource name pattern. {x} and {z} are replaced with the page coordinates, which increase towards east and north. Adjacent heightmaps must share their edge pixels.
+    void SetHeightMapPattern(const ea::string& pattern);
+    /// Set heightmap size in pixels. Must be a power of two + 1.
+    void SetPageVertices(int vertices);
+    /// Set number of pages along X and Z. Zero allows any page coordinates that have a heightmap.
+    void SetNumPages(const IntVector2& numPages);
+    /// Set vertex (XZ) and height (Y) spacing of the pages.
+    void SetSpacing(const Vector3& spacing);
+    /// Set patch quads per side of the pages. Must be a power of two.
+    void SetPatchSize(int size);
+    /// Set maximum number of LOD levels of the pages.
+    void SetMaxLodLevels(unsigned levels);
+    /// Set smoothing of the page heightmaps.
+    void SetSmoothing(bool enable);
+    /// Set material of the pages.
+    void SetMaterial(Material* material);
+    /// Set draw distance of the pages.
+    void SetDrawDistance(float distance);
+    /// Set LOD bias of the pages.
+    void SetLodBias(float bias);
+    /// Set shadowcaster flag of the pages.
+    void SetCastShadows(bool enable);
+    /// Set occluder flag of the pages.
+    void SetOccluder(bool enable);
+    /// Set distance from the observer within which pages are loaded.
+    void SetLoadDistance(float distance);
+    /// Set distance from the observer beyond which pages are unloaded. Should be larger than the load distance to avoid reloading pages near the boundary.
+    void SetUnloadDistance(float distance);
+    /// Set memory budget of the loaded pages in megabytes. When exceeded, the farthest pages are unloaded first. Zero is unlimited.
+    void SetMemoryBudget(unsigned megabytes);
+    /// Set maximum number of pages whose generated geometry is uploaded and added to the scene per frame.
+    void SetMaxPageCreations(unsigned num);
+    /// Set node around which pages are loaded. If null, the camera of the first viewport is used.
+    void SetObserver(Node* observer);
+    /// Unload all pages. They are loaded again on the next update as necessary.
+    void UnloadAllPages();
+
+    /// Return heightmap resource name pattern.
+    const ea::string& GetHeightMapPattern() const { return heightMapPattern_; }
+    /// Return heightmap size in pixels.
+    int GetPageVertices() const { return pageVertices_; }
+    /// Return number of pages along X and Z.
+    const IntVector2& GetNumPages() const { return numPages_; }
+    /// Return vertex and height spacing of the pages.
+    const Vector3& GetSpacing() const { return spacing_; }
+    /// Return patch quads per side of the pages.
+    int GetPatchSize() const { return patchSize_; }
+    /// Return maximum number of LOD levels of the pages.
+    unsigned GetMaxLodLevels() const { return maxLodLevels_; }
+    /// Return whether smoothing is in use.
+    bool GetSmoothing() const { return smoothing_; }
+    /// Return material of the pages.
+    Material* GetMaterial() const;
+    /// Return draw distance of the pages.
+    float GetDrawDistance() const { return drawDistance_; }
+    /// Return LOD bias of the pages.
+    float GetLodBias() const { return lodBias_; }
+    /// Return shadowcaster flag of the pages.
+    bool GetCastShadows() const { return castShadows_; }
+    /// Return occluder flag of the pages.
+    bool IsOccluder() const { return occluder_; }
+    /// Return load distance.
+    float GetLoadDistance() const { return loadDistance_; }
+    /// Return unload distance.
+    float GetUnloadDistance() const { return unloadDistance_; }
+    /// Return memory budget in megabytes.
+    unsigned GetMemoryBudget() const { return memoryBudget_; }
+    /// Return maximum number of pages whose generated geometry is uploaded and added to the scene per frame.
+    unsigned GetMaxPageCreations() const { return maxPageCreations_; }
+    /// Return observer node.
+    Node* GetObserver() const { return observer_; }
+    /// Return size of a page in local space.
+    float GetPageSize() const { return spacing_.x_ * (float)(pageVertices_ - 1); }
+    /// Return page coordinates containing a world position.
+    IntVector2 WorldToPage(const Vector3& worldPosition) const;
+    /// Return the terrain of a page, or null if not loaded.
+    Terrain* GetPage(const IntVector2& coords) const;
+    /// Return number of pages which have terrain geometry.
+    unsigned GetNumLoadedPages() const;
+    /// Return number of pages waiting for their heightmap or geometry.
+    unsigned GetNumLoadingPages() const;
+    /// Return estimated memory use of the pages in bytes. Pages whose loading was cancelled are not included, as they are released as soon as their load completes.
+    unsigned long long GetMemoryUse() const;
+    /// Return height at world coordinates, or zero if the page is not loaded.
+    float GetHeight(const Vector3& worldPosition) const;
+
+    /// Set material attribute.
+    void SetMaterialAttr(const ResourceRef& value);
+    /// Return material attribute.
+    ResourceRef GetMaterialAttr() const;
+
+private:
+    /// Page loading state.
+    enum PageState
+    {
+        /// Heightmap is loading in the background.
+        PAGE_LOADING,
+        /// Heightmap or geometry is loading, but the page is no longer needed.
+        PAGE_CANCELLED,
+        /// Heightmap has been loaded and the geometry is waiting to be generated.
+        PAGE_READY,
+        /// Geometry is being generated on a worker thread, or waits to be added to the scene.
+        PAGE_GENERATING,
+        /// Terrain has been added to the scene.
+        PAGE_CREATED
+    };
+
+    /// Terrain page.
+    struct Page
+    {
+        /// Loading state.
+        PageState state_{PAGE_LOADING};
+        /// Heightmap resource name.
+        ea::string heightMapName_;
+        /// Heightmap.
+        SharedPtr<Image> heightMap_;
+        /// Page node.
+        WeakPtr<Node> node_;
+        /// Terrain component.
+        WeakPtr<Terrain> terrain_;
+        /// Terrain whose geometry is being generated, before it is added to the page node.
+        SharedPtr<Terrain> pendingTerrain_;
+        /// Work item generating the geometry.
+        SharedPtr<WorkItem> item_;
+        /// Estimated memory use in bytes.
+        unsigned long long memoryUse_{};
+    };
+
+    /// Handle node being assigned.
+    void OnSceneSet(Scene* scene) override;
+    /// Handle scene update event.
+    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle background loaded heightmap.
+    void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+    /// Mark observer attribute dirty.
+    void MarkObserverDirty() { observerDirty_ = true; }
+    /// Load, create and unload pages around the observer.
+    void UpdatePages();
+    /// Return observer position in local space, or false if there is no observer.
+    bool GetObserverPosition(Vector3& position) const;
+    /// Return distance from a local space position to the nearest point of a page on the XZ plane.
+    float GetPageDistance(const IntVector2& coords, const Vector3& position) const;
+    /// Return whether page coordinates are within the page grid.
+    bool IsValidPage(const IntVector2& coords) const;
+    /// Return heightmap resource name of a page.
+    ea::string GetHeightMapName(const IntVector2& coords) const;
+    /// Return estimated memory use of a page in bytes.
+    unsigned long long EstimatePageMemory(Image* heightMap) const;
+    /// Start loading a page.
+    void LoadPage(const IntVector2& coords);
+    /// Start generating the geometry of a loaded page on a worker thread.
+    void GeneratePage(Page& page);
+    /// Add the terrain of a generated page to the scene and link it with the adjacent pages.
+    void CreatePage(const IntVector2& coords, Page& page);
+    /// Unload a page.
+    void UnloadPage(const IntVector2& coords);
+    /// Release cancelled pages whose geometry generation has completed.
+    void ReleaseCancelledPages();
+    /// Wait until the geometry generation of all pages has completed.
+    void CompletePageGeneration();
+    /// Apply page settings to a terrain.
+    void ApplyPageSettings(Terrain* terrain) const;
+    /// Apply page settings to all created terrains.
+    void ApplyPageSettings();
+    /// Return the terrain of a created page, or null.
+    Terrain* GetCreatedTerrain(const IntVector2& coords) const;
+
+    /// Heightmap resource name pattern.
+    ea::string heightMapPattern_;
+    /// Heightmap size in pixels.
+    int pageVertices_;
+    /// Number of pages along X and Z.
+    IntVector2 numPages_;
+    /// Vertex and height spacing.
+    Vector3 spacing_;
+    /// Patch quads per side.
+    int patchSize_;
+    /// Maximum number of LOD levels.
+    unsigned maxLodLevels_;
+    /// Smoothing flag.
+    bool smoothing_;
+    /// Material.
+    SharedPtr<Material> material_;
+    /// Draw distance.
+    float drawDistance_;
+    /// LOD bias.
+    float lodBias_;
+    /// Shadowcaster flag.
+    bool castShadows_;
+    /// Occluder flag.
+    bool occluder_;
+    /// Load distance.
+    float loadDistance_;
+    /// Unload distance.
+    float unloadDistance_;
+    /// Memory budget in megabytes.
+    unsigned memoryBudget_;
+    /// Maximum number of page creations per frame.
+    unsigned maxPageCreations_;
+    /// Observer node.
+    WeakPtr<Node> observer_;
+    /// Observer node ID attribute.
+    unsigned observerID_;
+    /// Pages by coordinates.
+    ea::unordered_map<IntVector2, Page> pages_;
+    /// Pages by heightmap resource name while loading.
+    ea::unordered_map<ea::string, IntVector2> loadingPages_;
+    /// Pages without a heightmap.
+    ea::unordered_set<IntVector2> missingPages_;
+    /// Observer attribute dirty flag.
+    bool observerDirty_;
+    /// Page settings or layout changed, so pages must be recreated.
+    bool pagesDirty_;
+};
+
+}
@@ -162,12 +162,9 @@ public:
     OcclusionBuffer* buffer_;
 };
 
-void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
+void CheckVisibilityWork(View* view, Drawable** start, Drawable** end, unsigned threadIndex)
 {
     URHO3D_PROFILE("CheckVisibilityWork");
-    auto* view = reinterpret_cast<View*>(item->aux_);
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
     OcclusionBuffer* buffer = view->occlusionBuffer_;
     const Matrix3x4& viewMatrix = view->cullCamera_->GetView();
     Vector3 viewZ = Vector3(viewMatrix.m20_, viewMatrix.m21_, viewMatrix.m22_);
@@ -232,21 +229,9 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
-void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
-{
-    URHO3D_PROFILE("ProcessLightWork");
-    auto* view = reinterpret_cast<View*>(item->aux_);
-    auto* query = reinterpret_cast<LightQueryResult*>(item->start_);
-
-    view->ProcessLight(*query, threadIndex);
-}
-
-void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
+void UpdateDrawableGeometriesWork(const FrameInfo& frame, Drawable** start, Drawable** end)
 {
     URHO3D_PROFILE("UpdateDrawableGeometriesWork");
-    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
 
     while (start != end)
     {
@@ -257,34 +242,30 @@ void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
-void SortBatchQueueFrontToBackWork(const WorkItem* item, unsigned threadIndex)
+void SortBatchQueueFrontToBackWork(BatchQueue* queue)
 {
     URHO3D_PROFILE("SortBatchQueueFrontToBackWork");
-    auto* queue = reinterpret_cast<BatchQueue*>(item->start_);
 
     queue->SortFrontToBack();
 }
 
-void SortBatchQueueBackToFrontWork(const WorkItem* item, unsigned threadIndex)
+void SortBatchQueueBackToFrontWork(BatchQueue* queue)
 {
     URHO3D_PROFILE("SortBatchQueueBackToFrontWork");
-    auto* queue = reinterpret_cast<BatchQueue*>(item->start_);
 
     queue->SortBackToFront();
 }
 
-void SortLightQueueWork(const WorkItem* item, unsigned threadIndex)
+void SortLightQueueWork(LightBatchQueue* start)
 {
     URHO3D_PROFILE("SortLightQueueWork");
-    auto* start = reinterpret_cast<LightBatchQueue*>(item->start_);
     start->litBaseBatches_.SortFrontToBack();
     start->litBatches_.SortFrontToBack();
 }
 
-void SortShadowQueueWork(const WorkItem* item, unsigned threadIndex)
+void SortShadowQueueWork(LightBatchQueue* start)
 {
     URHO3D_PROFILE("SortShadowQueueWork");
-    auto* start = reinterpret_cast<LightBatchQueue*>(item->start_);
     for (unsigned i = 0; i < start->shadowSplits_.size(); ++i)
         start->shadowSplits_[i].shadowBatches_.SortFrontToBack();
 }
@@ -548,6 +529,7 @@ void View::Update(const FrameInfo& frame)
     SendViewEvent(E_BEGINVIEWUPDATE);
 
     int maxSortedInstances = renderer_->GetMaxSortedInstances();
+    bool radixSortBatches = renderer_->GetRadixSortBatches();
 
     // Clear buffers, geometry, light, occluder & batch list
     renderTargets_.clear();
@@ -558,7 +540,7 @@ void View::Update(const FrameInfo& frame)
     activeOccluders_ = 0;
     vertexLightQueues_.clear();
     for (auto i = batchQueues_.begin(); i != batchQueues_.end(); ++i)
-        i->second.Clear(maxSortedInstances);
+        i->second.Clear(maxSortedInstances, radixSortBatches);
 
     if (hasScenePasses_ && (!cullCamera_ || !octree_))
     {
@@ -897,21 +879,14 @@ void View::GetDrawables()
         int drawablesPerItem = tempDrawables.size() / numWorkItems;
 
         auto start = tempDrawables.begin();
-        // Create a work item for each thread
+        // Create a task for each thread
         for (int i = 0; i < numWorkItems; ++i)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
             auto end = tempDrawables.end();
             if (i < numWorkItems - 1 && end - start > drawablesPerItem)
                 end = start + drawablesPerItem;
 
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
+            queue->AddTask([this, start, end](unsigned threadIndex) { CheckVisibilityWork(this, start, end, threadIndex); });
 
             start = end;
         }
@@ -983,16 +958,14 @@ void View::ProcessLights()
 
     for (unsigned i = 0; i < lightQueryResults_.size(); ++i)
     {
-        SharedPtr<WorkItem> item = queue->GetFreeItem();
-        item->priority_ = M_MAX_UNSIGNED;
-        item->workFunction_ = ProcessLightWork;
-        item->aux_ = this;
-
         LightQueryResult& query = lightQueryResults_[i];
         query.light_ = lights_[i];
 
-        item->start_ = &query;
-        queue->AddWorkItem(item);
+        queue->AddTask([this, &query](unsigned threadIndex)
+        {
+            URHO3D_PROFILE("ProcessLightWork");
+            ProcessLight(query, threadIndex);
+        });
     }
 
     // Ensure all lights have been processed before proceeding
@@ -1020,6 +993,7 @@ void View::GetLightBatches()
         lightQueues_.resize(numLightQueues);
         maxLightsDrawables_.clear();
         auto maxSortedInstances = (unsigned)renderer_->GetMaxSortedInstances();
+        bool radixSortBatches = renderer_->GetRadixSortBatches();
 
         for (auto i = lightQueryResults_.begin(); i != lightQueryResults_.end(); ++i)
         {
@@ -1042,8 +1016,8 @@ void View::GetLightBatches()
                 lightQueue.light_ = light;
                 lightQueue.negative_ = light->IsNegative();
                 lightQueue.shadowMap_ = nullptr;
-                lightQueue.litBaseBatches_.Clear(maxSortedInstances);
-                lightQueue.litBatches_.Clear(maxSortedInstances);
+                lightQueue.litBaseBatches_.Clear(maxSortedInstances, radixSortBatches);
+                lightQueue.litBatches_.Clear(maxSortedInstances, radixSortBatches);
                 if (forwardLightsCommand_)
                 {
                     SetQueueShaderDefines(lightQueue.litBaseBatches_, *forwardLightsCommand_);
@@ -1074,7 +1048,7 @@ void View::GetLightBatches()
                     shadowQueue.shadowCamera_ = shadowCamera;
                     shadowQueue.nearSplit_ = query.shadowNearSplits_[j];
                     shadowQueue.farSplit_ = query.shadowFarSplits_[j];
-                    shadowQueue.shadowBatches_.Clear(maxSortedInstances);
+                    shadowQueue.shadowBatches_.Clear(maxSortedInstances, radixSortBatches);
 
                     // Setup the shadow split viewport and finalize shadow camera parameters
                     shadowQueue.shadowViewport_ = GetShadowMapViewport(light, j, lightQueue.shadowMap_);
@@ -1303,31 +1277,21 @@ void View::UpdateGeometries()
 
             if (command.type_ == CMD_SCENEPASS)
             {
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ =
-                    command.sortMode_ == SORT_FRONTTOBACK ? SortBatchQueueFrontToBackWork : SortBatchQueueBackToFrontWork;
-                item->start_ = &batchQueues_[command.passIndex_];
-                queue->AddWorkItem(item);
+                BatchQueue* batchQueue = &batchQueues_[command.passIndex_];
+                if (command.sortMode_ == SORT_FRONTTOBACK)
+                    queue->AddTask([batchQueue](unsigned) { SortBatchQueueFrontToBackWork(batchQueue); });
+                else
+                    queue->AddTask([batchQueue](unsigned) { SortBatchQueueBackToFrontWork(batchQueue); });
             }
         }
 
         for (auto i = lightQueues_.begin(); i != lightQueues_.end(); ++i)
         {
-            SharedPtr<WorkItem> lightItem = queue->GetFreeItem();
-            lightItem->priority_ = M_MAX_UNSIGNED;
-            lightItem->workFunction_ = SortLightQueueWork;
-            lightItem->start_ = &(*i);
-            queue->AddWorkItem(lightItem);
+            LightBatchQueue* lightQueue = &(*i);
+            queue->AddTask([lightQueue](unsigned) { SortLightQueueWork(lightQueue); });
 
             if (i->shadowSplits_.size())
-            {
-                SharedPtr<WorkItem> shadowItem = queue->GetFreeItem();
-                shadowItem->priority_ = M_MAX_UNSIGNED;
-                shadowItem->workFunction_ = SortShadowQueueWork;
-                shadowItem->start_ = &(*i);
-                queue->AddWorkItem(shadowItem);
-            }
+                queue->AddTask([lightQueue](unsigned) { SortShadowQueueWork(lightQueue); });
         }
     }
 
@@ -1357,13 +1321,7 @@ void View::UpdateGeometries()
                 if (i < numWorkItems - 1 && end - start > drawablesPerItem)
                     end = start + drawablesPerItem;
 
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = UpdateDrawableGeometriesWork;
-                item->aux_ = const_cast<FrameInfo*>(&frame_);
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
+                queue->AddTask([this, start, end](unsigned) { UpdateDrawableGeometriesWork(frame_, start, end); });
 
                 start = end;
             }
@@ -1378,6 +1336,25 @@ void View::UpdateGeometries()
     // Finally ensure all threaded work has completed
     queue->Complete(M_MAX_UNSIGNED);
     geometriesUpdated_ = true;
+
+    // Collect batch sorting statistics
+    batchSortTime_ = 0;
+    numReusedBatchGroups_ = 0;
+    for (auto i = batchQueues_.begin(); i != batchQueues_.end(); ++i)
+        AddBatchSortStats(i->second);
+    for (auto i = lightQueues_.begin(); i != lightQueues_.end(); ++i)
+    {
+        AddBatchSortStats(i->litBaseBatches_);
+        AddBatchSortStats(i->litBatches_);
+        for (auto j = i->shadowSplits_.begin(); j != i->shadowSplits_.end(); ++j)
+            AddBatchSortStats(j->shadowBatches_);
+    }
+}
+
+void View::AddBatchSortStats(const BatchQueue& queue)
+{
+    batchSortTime_ += queue.sortTime_;
+    numReusedBatchGroups_ += queue.numReusedBatchGroups_;
 }
 
 void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue)
@@ -2916,26 +2893,35 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
     {
         BatchGroupKey key(batch);
 
+        // Groups are kept between frames, so a group may exist already but not be used yet during this frame
         auto i = queue.batchGroups_.find(key);
         if (i == queue.batchGroups_.end())
+            i = queue.batchGroups_.insert(ea::make_pair(key, BatchGroup())).first;
+        else if (!i->second.used_)
+            ++queue.numReusedBatchGroups_;
+
+        BatchGroup& group = i->second;
+        if (!group.used_)
         {
-            // Create a new group based on the batch
+            // Initialize the group based on the batch
             // In case the group remains below the instancing limit, do not enable instancing shaders yet
-            BatchGroup newGroup(batch);
-            newGroup.geometryType_ = GEOM_STATIC;
-            renderer_->SetBatchShaders(newGroup, tech, allowShadows, queue);
-            newGroup.CalculateSortKey();
-            i = queue.batchGroups_.insert(ea::make_pair(key, newGroup)).first;
+            static_cast<Batch&>(group) = batch;
+            group.geometryType_ = GEOM_STATIC;
+            group.startIndex_ = M_MAX_UNSIGNED;
+            group.used_ = true;
+            renderer_->SetBatchShaders(group, tech, allowShadows, queue);
+            group.CalculateSortKey();
+            queue.sortedBatchGroups_.push_back(&group);
         }
 
-        int oldSize = i->second.instances_.size();
-        i->second.AddTransforms(batch);
+        int oldSize = group.instances_.size();
+        group.AddTransforms(batch);
         // Convert to using instancing shaders when the instancing limit is reached
-        if (oldSize < minInstances_ && (int) i->second.instances_.size() >= minInstances_)
+        if (oldSize < minInstances_ && (int) group.instances_.size() >= minInstances_)
         {
-            i->second.geometryType_ = GEOM_INSTANCED;
-            renderer_->SetBatchShaders(i->second, tech, allowShadows, queue);
-            i->second.CalculateSortKey();
+            group.geometryType_ = GEOM_INSTANCED;
+            renderer_->SetBatchShaders(group, tech, allowShadows, queue);
+            group.CalculateSortKey();
         }
     }
     else
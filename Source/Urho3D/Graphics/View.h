@@ -49,7 +49,6 @@ class Texture2D;
 class Viewport;
 class Zone;
 struct RenderPathCommand;
-struct WorkItem;
 
 /// Intermediate light processing result.
 struct LightQueryResult
@@ -109,8 +108,7 @@ static const unsigned MAX_VIEWPORT_TEXTURES = 2;
 /// Internal structure for 3D rendering work. Created for each backbuffer and texture viewport, but not for shadow cameras.
 class URHO3D_API View : public Object
 {
-    friend void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex);
-    friend void ProcessLightWork(const WorkItem* item, unsigned threadIndex);
+    friend void CheckVisibilityWork(View* view, Drawable** start, Drawable** end, unsigned threadIndex);
 
     URHO3D_OBJECT(View, Object);
 
@@ -175,6 +173,12 @@ public:
     /// Return number of occluders that were actually rendered. Occluders may be rejected if running out of triangles or if behind other occluders.
     unsigned GetNumActiveOccluders() const { return activeOccluders_; }
 
+    /// Return time spent sorting batches in microseconds. Sorting is threaded, so this is the sum over all batch queues.
+    long long GetBatchSortTime() const { return batchSortTime_; }
+
+    /// Return number of instanced batch groups reused from the previous frame.
+    unsigned GetNumReusedBatchGroups() const { return numReusedBatchGroups_; }
+
     /// Return the source view that was already prepared. Used when viewports specify the same culling camera.
     View* GetSourceView() const;
 
@@ -206,6 +210,8 @@ private:
     void GetBaseBatches();
     /// Update geometries and sort batches.
     void UpdateGeometries();
+    /// Add sorting statistics of a batch queue.
+    void AddBatchSortStats(const BatchQueue& queue);
     /// Get pixel lit batches for a certain light and drawable.
     void GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue);
     /// Execute render commands.
@@ -400,6 +406,10 @@ private:
     ea::vector<Light*> lights_;
     /// Number of active occluders.
     unsigned activeOccluders_{};
+    /// Time spent sorting batches in microseconds.
+    long long batchSortTime_{};
+    /// Number of batch groups reused from the previous frame.
+    unsigned numReusedBatchGroups_{};
 
     /// Drawables that limit their maximum light count.
     ea::hash_set<Drawable*> maxLightsDrawables_;
@@ -50,6 +50,8 @@ public:
     virtual unsigned GetChecksum();
     /// Return whether the end of stream has been reached.
     virtual bool IsEof() const { return position_ >= size_; }
+    /// Return the whole stream contents if they are directly addressable in memory, null if the stream must be read.
+    virtual const unsigned char* GetData() const { return nullptr; }
 
     /// Set position relative to current position. Return actual new position.
     unsigned SeekRelative(int delta);
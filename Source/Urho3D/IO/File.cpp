@@ -136,6 +136,33 @@ bool File::Open(PackageFile* package, const ea::string& fileName)
     if (!entry)
         return false;
 
+    if (package->IsMemoryMapped())
+    {
+        // Uncompressed data is read straight from the mapping, so the whole entry must lie within it. Compressed blocks are
+        // checked as they are read
+        const unsigned totalSize = package->GetTotalSize();
+        if (entry->offset_ > totalSize || (!package->IsCompressed() && entry->size_ > totalSize - entry->offset_))
+        {
+            URHO3D_LOGERROR("Package entry " + fileName + " outside package file " + package->GetName());
+            return false;
+        }
+
+        // Read straight from the mapping, no file handle is needed
+        Close();
+        package_ = package;
+        fileName_ = fileName;
+        mode_ = FILE_READ;
+        position_ = 0;
+        offset_ = entry->offset_;
+        checksum_ = entry->checksum_;
+        size_ = entry->size_;
+        compressed_ = package->IsCompressed();
+        readSyncNeeded_ = false;
+        writeSyncNeeded_ = false;
+        SeekMapped(0);
+        return true;
+    }
+
     bool success = OpenInternal(package->GetName(), FILE_READ, true);
     if (!success)
     {
@@ -173,6 +200,9 @@ unsigned File::Read(void* dest, unsigned size)
     if (!size)
         return 0;
 
+    if (package_)
+        return ReadMapped(dest, size);
+
 #ifdef __ANDROID__
     if (assetHandle_ && !compressed_)
     {
@@ -281,6 +311,9 @@ unsigned File::Seek(unsigned position)
     if (mode_ == FILE_READ && position > size_)
         position = size_;
 
+    if (package_)
+        return SeekMapped(position);
+
     if (compressed_)
     {
         // Start over from the beginning
@@ -351,6 +384,11 @@ unsigned File::Write(const void* data, unsigned size)
     return size;
 }
 
+const unsigned char* File::GetData() const
+{
+    return package_ && !compressed_ ? package_->GetMappedData() + offset_ : nullptr;
+}
+
 unsigned File::GetChecksum()
 {
     if (offset_ || checksum_)
@@ -393,6 +431,17 @@ void File::Close()
     readBuffer_.reset();
     inputBuffer_.reset();
 
+    if (package_)
+    {
+        package_.Reset();
+        position_ = 0;
+        size_ = 0;
+        offset_ = 0;
+        checksum_ = 0;
+        readBufferOffset_ = 0;
+        readBufferSize_ = 0;
+    }
+
     if (handle_)
     {
         fclose((FILE*)handle_);
@@ -418,9 +467,9 @@ void File::SetName(const ea::string& name)
 bool File::IsOpen() const
 {
 #ifdef __ANDROID__
-    return handle_ != 0 || assetHandle_ != 0;
+    return handle_ != 0 || assetHandle_ != 0 || package_ != nullptr;
 #else
-    return handle_ != nullptr;
+    return handle_ != nullptr || package_ != nullptr;
 #endif
 }
 
@@ -549,6 +598,100 @@ void File::SeekInternal(unsigned newPosition)
         fseek((FILE*)handle_, newPosition, SEEK_SET);
 }
 
+unsigned File::ReadMapped(void* dest, unsigned size)
+{
+    if (!compressed_)
+    {
+        memcpy(dest, package_->GetMappedData() + offset_ + position_, size);
+        position_ += size;
+        return size;
+    }
+
+    unsigned sizeLeft = size;
+    auto* destPtr = (unsigned char*)dest;
+
+    while (sizeLeft)
+    {
+        if (!readBuffer_ || readBufferOffset_ >= readBufferSize_)
+        {
+            if (!ReadMappedBlock())
+            {
+                URHO3D_LOGERROR("Error while reading from file " + GetName());
+                return size - sizeLeft;
+            }
+        }
+
+        unsigned copySize = Min((readBufferSize_ - readBufferOffset_), sizeLeft);
+        memcpy(destPtr, readBuffer_.get() + readBufferOffset_, copySize);
+        destPtr += copySize;
+        sizeLeft -= copySize;
+        readBufferOffset_ += copySize;
+        position_ += copySize;
+    }
+
+    return size;
+}
+
+unsigned File::SeekMapped(unsigned position)
+{
+    if (!compressed_)
+    {
+        position_ = position;
+        return position_;
+    }
+
+    // Walk the block headers from the start of the file. Only the block that contains the new position is
+    // decompressed, so unlike regular compressed reads seeking backward is also supported
+    const unsigned char* data = package_->GetMappedData();
+    const unsigned packageSize = package_->GetTotalSize();
+    unsigned blockStart = 0;
+    blockOffset_ = offset_;
+    readBuffer_.reset();
+    readBufferOffset_ = 0;
+    readBufferSize_ = 0;
+
+    while (blockOffset_ + 4 <= packageSize)
+    {
+        MemoryBuffer blockHeader(data + blockOffset_, 4);
+        unsigned unpackedSize = blockHeader.ReadUShort();
+        unsigned packedSize = blockHeader.ReadUShort();
+        if (!unpackedSize || position < blockStart + unpackedSize)
+            break;
+
+        blockStart += unpackedSize;
+        blockOffset_ += 4 + packedSize;
+    }
+
+    position_ = blockStart;
+    if (position > blockStart && ReadMappedBlock())
+    {
+        readBufferOffset_ = position - blockStart;
+        position_ = position;
+    }
+
+    return position_;
+}
+
+bool File::ReadMappedBlock()
+{
+    if (blockOffset_ + 4 > package_->GetTotalSize())
+        return false;
+
+    MemoryBuffer blockHeader(package_->GetMappedData() + blockOffset_, 4);
+    unsigned unpackedSize = blockHeader.ReadUShort();
+    unsigned packedSize = blockHeader.ReadUShort();
+
+    ea::shared_array<unsigned char> block = package_->GetDecompressedBlock(blockOffset_ + 4, unpackedSize, packedSize);
+    if (!block)
+        return false;
+
+    readBuffer_ = block;
+    readBufferSize_ = unpackedSize;
+    readBufferOffset_ = 0;
+    blockOffset_ += 4 + packedSize;
+    return true;
+}
+
 void File::ReadText(ea::string& text)
 {
     text.clear();
@@ -85,6 +85,8 @@ public:
 
     /// Return a checksum of the file contents using the SDBM hash algorithm.
     unsigned GetChecksum() override;
+    /// Return the file contents if opened uncompressed from a memory-mapped package file, null otherwise.
+    const unsigned char* GetData() const override;
 
     /// Open a filesystem file. Return true if successful.
     bool Open(const ea::string& fileName, FileMode mode = FILE_READ);
@@ -109,6 +111,9 @@ public:
     /// Return whether the file originates from a package.
     bool IsPackaged() const { return offset_ != 0; }
 
+    /// Return whether the file is read from a memory-mapped package file.
+    bool IsMemoryMapped() const { return package_ != nullptr; }
+
     /// Reads a text file, ensuring data from file is 0 terminated
     virtual void ReadText(ea::string& text);
 
@@ -126,6 +131,12 @@ private:
     bool ReadInternal(void* dest, unsigned size);
     /// Seek in file internally using either C standard IO functions or SDL RWops for Android asset files.
     void SeekInternal(unsigned newPosition);
+    /// Read from a memory-mapped package file. Return number of bytes actually read.
+    unsigned ReadMapped(void* dest, unsigned size);
+    /// Seek in a memory-mapped package file. Return actual new position.
+    unsigned SeekMapped(unsigned position);
+    /// Fetch the compressed block at the block offset of a memory-mapped package file. Return true if successful.
+    bool ReadMappedBlock();
 
     /// File name.
     ea::string fileName_;
@@ -147,6 +158,10 @@ private:
     unsigned readBufferSize_;
     /// Start position within a package file, 0 for regular files.
     unsigned offset_;
+    /// Memory-mapped package file the file is read from, null for regular file reads.
+    SharedPtr<PackageFile> package_;
+    /// Position of the next compressed block header within a memory-mapped package file.
+    unsigned blockOffset_{};
     /// Content checksum.
     unsigned checksum_;
     /// Compression flag.
@@ -22,6 +22,8 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Allocator.h"
+#include "../Core/Condition.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/ProcessUtils.h"
@@ -41,6 +43,7 @@
 
 #include <mutex>
 #include <cstdio>
+#include <thread>
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -49,7 +52,6 @@
 extern "C" void SDL_IOS_LogMessage(const char* message);
 #endif
 
-#include "../DebugNew.h"
 #include "Log.h"
 
 
@@ -58,6 +60,8 @@ namespace Urho3D
 
 static Log* logInstance = nullptr;
 
+std::atomic<int> Logger::minLevel_{LOG_TRACE};
+
 #if defined(IOS) || defined(TVOS)
 template<typename Mutex>
 class IOSSink : public spdlog::sinks::base_sink<Mutex>
@@ -136,16 +140,296 @@ protected:
 using MessageForwarderSink_mt = MessageForwarderSink<std::mutex>;
 using MessageForwarderSink_st = MessageForwarderSink<spdlog::details::null_mutex>;
 
+/// Asynchronous log message which was already formatted by the calling thread.
+struct AsyncLogMessageRecord : public AsyncLogRecord
+{
+    /// Construct.
+    explicit AsyncLogMessageRecord(const ea::string& message) :
+        message_(message)
+    {
+        formatFunction_ = [](AsyncLogRecord* record, ea::string& message)
+        {
+            message = static_cast<AsyncLogMessageRecord*>(record)->message_;
+        };
+        destroyFunction_ = [](AsyncLogRecord* record) { static_cast<AsyncLogMessageRecord*>(record)->~AsyncLogMessageRecord(); };
+    }
+
+    /// Message text.
+    ea::string message_;
+};
+
+static_assert(sizeof(AsyncLogMessageRecord) <= ASYNC_LOG_SLOT_SIZE, "Asynchronous log record does not fit a slot");
+
+/// Asynchronous log queue slot. Cache line sized to avoid false sharing between producers.
+struct alignas(64) AsyncLogSlot
+{
+    /// Allocate slots aligned to the cache line. Operator new does not respect the alignment before C++17.
+    static void* operator new[](size_t size) { return AllocateAligned(size, alignof(AsyncLogSlot)); }
+    /// Free slots allocated with the aligned operator new.
+    static void operator delete[](void* ptr) { FreeAligned(ptr); }
+
+    /// Sequence number. Equals to the enqueue position when the slot is free and to the position plus one when it holds a record.
+    std::atomic<unsigned> sequence_;
+    /// Record storage.
+    alignas(ASYNC_LOG_SLOT_ALIGNMENT) unsigned char data_[ASYNC_LOG_SLOT_SIZE];
+};
+
+/// Whether the calling thread is the log thread. Messages logged by the log thread itself are written synchronously.
+static thread_local bool isLogThread = false;
+
+/// Bounded lock-free queue of log records with multiple producers and the log thread as the single consumer.
+class AsyncLogQueue : public Thread
+{
+public:
+    /// Construct. Size must be a power of two.
+    AsyncLogQueue(unsigned size, LogOverflowPolicy policy) :
+        Thread("LogThread"),
+        slots_(new AsyncLogSlot[size]),
+        mask_(size - 1),
+        policy_(policy)
+    {
+        for (unsigned i = 0; i < size; ++i)
+            slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+
+    /// Acquire a slot for writing. Return null if the queue is full and the overflow policy is to drop.
+    AsyncLogSlot* Acquire()
+    {
+        for (;;)
+        {
+            unsigned position = enqueuePosition_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                AsyncLogSlot& slot = slots_[position & mask_];
+                const unsigned sequence = slot.sequence_.load(std::memory_order_acquire);
+                const int difference = static_cast<int>(sequence - position);
+                if (difference == 0)
+                {
+                    if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        return &slot;
+                }
+                else if (difference < 0)
+                    break;
+                else
+                    position = enqueuePosition_.load(std::memory_order_relaxed);
+            }
+
+            // Queue is full
+            if (policy_ == LOG_OVERFLOW_DROP)
+            {
+                numDropped_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            Wake();
+            std::this_thread::yield();
+        }
+    }
+
+    /// Publish a filled slot to the log thread.
+    void Commit(AsyncLogSlot* slot)
+    {
+        const unsigned sequence = slot->sequence_.load(std::memory_order_relaxed);
+        slot->sequence_.store(sequence + 1, std::memory_order_release);
+
+        // Pairs with the fence in the log thread so that either the record is seen or the log thread is woken up
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed))
+            Wake();
+    }
+
+    /// Wait until all records committed before the call are written.
+    void Flush()
+    {
+        const unsigned target = enqueuePosition_.load(std::memory_order_acquire);
+        while (static_cast<int>(dequeuePosition_.load(std::memory_order_acquire) - target) < 0)
+        {
+            Wake();
+            std::this_thread::yield();
+        }
+    }
+
+    /// Write the remaining records and stop the log thread.
+    void Shutdown()
+    {
+        Flush();
+        exiting_.store(true, std::memory_order_seq_cst);
+        Wake();
+        Stop();
+    }
+
+    /// Process records until stopped.
+    void ThreadFunction() override
+    {
+        isLogThread = true;
+
+        while (!exiting_.load(std::memory_order_relaxed))
+        {
+            if (ProcessRecords())
+                continue;
+
+            sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!HasRecord() && !exiting_.load(std::memory_order_relaxed))
+                wakeEvent_.Wait();
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+
+        ProcessRecords();
+    }
+
+    /// Return overflow policy.
+    LogOverflowPolicy GetPolicy() const { return policy_; }
+    /// Return queue size.
+    unsigned GetSize() const { return mask_ + 1; }
+    /// Return number of dropped messages.
+    unsigned GetNumDropped() const { return numDropped_.load(std::memory_order_relaxed); }
+
+private:
+    /// Return whether the next record is ready.
+    bool HasRecord() const
+    {
+        const unsigned position = dequeuePosition_.load(std::memory_order_relaxed);
+        return slots_[position & mask_].sequence_.load(std::memory_order_acquire) == position + 1;
+    }
+
+    /// Format and write all ready records. Return whether any were processed.
+    bool ProcessRecords()
+    {
+        bool processed = false;
+        unsigned position = dequeuePosition_.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            AsyncLogSlot& slot = slots_[position & mask_];
+            if (slot.sequence_.load(std::memory_order_acquire) != position + 1)
+                break;
+
+            auto* record = reinterpret_cast<AsyncLogRecord*>(slot.data_);
+            WriteRecord(record);
+            record->destroyFunction_(record);
+
+            slot.sequence_.store(position + mask_ + 1, std::memory_order_release);
+            dequeuePosition_.store(++position, std::memory_order_release);
+            processed = true;
+        }
+
+        return processed;
+    }
+
+    /// Format the record and pass it to the sinks of its logger.
+    void WriteRecord(AsyncLogRecord* record)
+    {
+        auto* logger = reinterpret_cast<spdlog::logger*>(record->logger_);
+        const spdlog::level::level_enum level = ConvertLogLevel(record->level_);
+        if (!logger->should_log(level))
+            return;
+
+        message_.clear();
+        try
+        {
+            record->formatFunction_(record, message_);
+        }
+        catch (const std::exception& e)
+        {
+            message_ = ea::string("Failed to format log message: ") + e.what();
+        }
+
+        spdlog::details::log_msg msg(&logger->name(), level, spdlog::string_view_t(message_.data(), message_.size()));
+        msg.time = record->time_;
+        for (auto& sink : logger->sinks())
+        {
+            if (sink->should_log(level))
+                sink->log(msg);
+        }
+    }
+
+    /// Wake the log thread.
+    void Wake() { wakeEvent_.Set(); }
+
+    /// Slots.
+    ea::unique_ptr<AsyncLogSlot[]> slots_;
+    /// Index mask.
+    const unsigned mask_;
+    /// Overflow policy.
+    const LogOverflowPolicy policy_;
+    /// Position of the next slot to be acquired by producers.
+    alignas(64) std::atomic<unsigned> enqueuePosition_{};
+    /// Position of the next slot to be read by the log thread.
+    alignas(64) std::atomic<unsigned> dequeuePosition_{};
+    /// Number of dropped messages.
+    std::atomic<unsigned> numDropped_{};
+    /// Whether the log thread is about to wait for the wake event.
+    std::atomic<bool> sleeping_{};
+    /// Whether the log thread should exit.
+    std::atomic<bool> exiting_{};
+    /// Event used to wake the log thread.
+    Condition wakeEvent_;
+    /// Formatted message buffer. Accessed only by the log thread.
+    ea::string message_;
+};
+
+/// Asynchronous log queue. Null when messages are written synchronously.
+static std::atomic<AsyncLogQueue*> asyncLogQueue{};
+/// Number of threads which may be using the asynchronous log queue. The queue is not destroyed until it drops to zero.
+alignas(64) static std::atomic<unsigned> asyncLogWriters{};
+
 Logger::Logger(void* logger)
     : logger_(logger)
 {
 }
 
+bool Logger::AcquireAsyncSlot(void*& queue, void*& slot)
+{
+    if (asyncLogQueue.load(std::memory_order_relaxed) == nullptr || logger_ == nullptr || isLogThread)
+        return false;
+
+    // Register as a writer before reading the queue pointer. Log::SetAsync clears the pointer before waiting
+    // for writers, so the queue is either not seen at all or stays alive until the slot is committed
+    asyncLogWriters.fetch_add(1, std::memory_order_seq_cst);
+    auto* asyncQueue = asyncLogQueue.load(std::memory_order_seq_cst);
+    if (asyncQueue == nullptr)
+    {
+        asyncLogWriters.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    AsyncLogSlot* asyncSlot = asyncQueue->Acquire();
+    if (!asyncSlot)
+        asyncLogWriters.fetch_sub(1, std::memory_order_release);
+
+    queue = asyncQueue;
+    slot = asyncSlot ? asyncSlot->data_ : nullptr;
+    return true;
+}
+
+void Logger::CommitAsyncSlot(void* queue, void* slot)
+{
+    static_cast<AsyncLogQueue*>(queue)->Commit(
+        reinterpret_cast<AsyncLogSlot*>(static_cast<unsigned char*>(slot) - offsetof(AsyncLogSlot, data_)));
+    asyncLogWriters.fetch_sub(1, std::memory_order_release);
+}
+
 void Logger::WriteFormatted(LogLevel level, const ea::string& message)
 {
-    if (logger_ == nullptr)
+    if (logger_ == nullptr || !IsEnabled(level))
         return;
 
+    void* queue;
+    void* slot;
+    if (level < LOG_NONE && AcquireAsyncSlot(queue, slot))
+    {
+        if (slot)
+        {
+            auto* record = new(slot) AsyncLogMessageRecord(message);
+            record->logger_ = logger_;
+            record->time_ = std::chrono::system_clock::now();
+            record->level_ = level;
+            CommitAsyncSlot(queue, slot);
+        }
+        return;
+    }
+
     auto* logger = reinterpret_cast<spdlog::logger*>(logger_);
 
     switch (level)
@@ -212,6 +496,10 @@ public:
 #endif
     /// Sink that forwards messages to all other sinks.
     std::shared_ptr<spdlog::sinks::dist_sink_mt> sinkProxy_;
+    /// Default logger, cached to avoid registry lookups.
+    void* mainLogger_{};
+    /// Asynchronous log queue and thread.
+    ea::unique_ptr<AsyncLogQueue> asyncQueue_;
 };
 
 Log::Log(Context* context) :
@@ -219,12 +507,14 @@ Log::Log(Context* context) :
     impl_(new LogImpl(context))
 {
     logInstance = this;
+    impl_->mainLogger_ = GetLogger().logger_;
 
     SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(Log, HandleEndFrame));
 }
 
 Log::~Log()
 {
+    SetAsync(false);
     logInstance = nullptr;
 }
 
@@ -247,6 +537,8 @@ void Log::Open(const ea::string& fileName)
 
 void Log::Close()
 {
+    Flush();
+
     if (impl_->fileSink_)
     {
         impl_->sinkProxy_->remove_sink(impl_->fileSink_);
@@ -263,9 +555,60 @@ void Log::SetLevel(LogLevel level)
     }
 
     level_ = level;
+    Logger::minLevel_.store(level, std::memory_order_relaxed);
     spdlog::set_level(ConvertLogLevel(level));
 }
 
+void Log::SetAsync(bool enable, unsigned queueSize, LogOverflowPolicy policy)
+{
+    if (impl_->asyncQueue_)
+    {
+        if (enable && impl_->asyncQueue_->GetSize() == NextPowerOfTwo(Max(queueSize, 2U)) &&
+            impl_->asyncQueue_->GetPolicy() == policy)
+            return;
+
+        // Stop routing new messages to the queue and wait for the threads that are still filling slots.
+        // The log thread keeps running meanwhile, so writers blocked on a full queue make progress
+        asyncLogQueue.store(nullptr, std::memory_order_seq_cst);
+        while (asyncLogWriters.load(std::memory_order_seq_cst) != 0)
+            std::this_thread::yield();
+
+        // Write out what is already there
+        impl_->asyncQueue_->Shutdown();
+        impl_->asyncQueue_.reset();
+        impl_->sinkProxy_->flush();
+    }
+
+    if (enable)
+    {
+        impl_->asyncQueue_ = ea::make_unique<AsyncLogQueue>(NextPowerOfTwo(Max(queueSize, 2U)), policy);
+        if (!impl_->asyncQueue_->Run())
+        {
+            impl_->asyncQueue_.reset();
+            URHO3D_LOGERROR("Failed to start log thread, logging synchronously");
+            return;
+        }
+        asyncLogQueue.store(impl_->asyncQueue_.get(), std::memory_order_release);
+    }
+}
+
+void Log::Flush()
+{
+    if (impl_->asyncQueue_)
+        impl_->asyncQueue_->Flush();
+    impl_->sinkProxy_->flush();
+}
+
+bool Log::IsAsync() const
+{
+    return impl_->asyncQueue_ != nullptr;
+}
+
+unsigned Log::GetNumDroppedMessages() const
+{
+    return impl_->asyncQueue_ ? impl_->asyncQueue_->GetNumDropped() : 0;
+}
+
 void Log::SetQuiet(bool quiet)
 {
     quiet_ = quiet;
@@ -287,7 +630,11 @@ void Log::SetLogFormat(const ea::string& format)
 Logger Log::GetLogger(const char* name)
 {
     if (name == nullptr)
+    {
+        if (logInstance != nullptr && logInstance->impl_->mainLogger_ != nullptr)
+            return Logger(logInstance->impl_->mainLogger_);
         name = "main";
+    }
 
     if (logInstance != nullptr)
     {
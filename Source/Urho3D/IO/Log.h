@@ -24,6 +24,11 @@
 
 #include <EASTL/list.h>
 
+#include <chrono>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
 #include "../Core/StringUtils.h"
@@ -65,8 +70,91 @@ static const char* logLevelNames[] =
     nullptr
 };
 
+/// Behavior of asynchronous logging when the message queue is full.
+enum LogOverflowPolicy
+{
+    /// Wait until the log thread frees space in the queue.
+    LOG_OVERFLOW_BLOCK = 0,
+    /// Drop the message.
+    LOG_OVERFLOW_DROP,
+};
+
+/// Size of one asynchronous log queue slot in bytes. Messages with larger captured arguments are formatted by the calling thread.
+static const unsigned ASYNC_LOG_SLOT_SIZE = 240;
+/// Alignment of asynchronous log queue slots.
+static const unsigned ASYNC_LOG_SLOT_ALIGNMENT = 16;
+/// Default number of slots in the asynchronous log queue.
+static const unsigned DEFAULT_ASYNC_LOG_QUEUE_SIZE = 4096;
+
 class File;
 
+/// Log message waiting in the asynchronous log queue. Message is formatted from the captured arguments by the log thread.
+struct AsyncLogRecord
+{
+    /// Format the message.
+    void (* formatFunction_)(AsyncLogRecord* record, ea::string& message){};
+    /// Destroy the captured arguments.
+    void (* destroyFunction_)(AsyncLogRecord* record){};
+    /// Logger instance.
+    void* logger_{};
+    /// Time when the message was logged.
+    std::chrono::system_clock::time_point time_;
+    /// Message level.
+    LogLevel level_{};
+};
+
+/// Type used for capturing a log message argument. Arguments are stored by value.
+template <class T> struct AsyncLogArgument
+{
+    using Type = T;
+    static const T& Capture(const T& value) { return value; }
+};
+
+/// Capture of an argument which does not own its characters. The characters are copied, as the argument may be gone by the time the message is formatted.
+template <class T, class String> struct AsyncLogStringArgument
+{
+    using Type = String;
+    static Type Capture(const T& value) { return Type(value.data(), value.size()); }
+};
+
+template <> struct AsyncLogArgument<const char*>
+{
+    using Type = ea::string;
+    static Type Capture(const char* value) { return Type(value ? value : "(null)"); }
+};
+template <> struct AsyncLogArgument<char*> : public AsyncLogArgument<const char*> {};
+template <class C> struct AsyncLogArgument<ea::basic_string_view<C>> :
+    public AsyncLogStringArgument<ea::basic_string_view<C>, ea::basic_string<C>> {};
+template <class C> struct AsyncLogArgument<fmt::basic_string_view<C>> :
+    public AsyncLogStringArgument<fmt::basic_string_view<C>, ea::basic_string<C>> {};
+
+/// Asynchronous log message with captured format string and arguments.
+template <class... Args> struct AsyncLogRecordImpl : public AsyncLogRecord
+{
+    /// Construct.
+    explicit AsyncLogRecordImpl(const char* format, const Args&... args) :
+        format_(format),
+        args_(AsyncLogArgument<typename std::decay<Args>::type>::Capture(args)...)
+    {
+        formatFunction_ = [](AsyncLogRecord* record, ea::string& message)
+        {
+            static_cast<AsyncLogRecordImpl*>(record)->Format(message, std::index_sequence_for<Args...>());
+        };
+        destroyFunction_ = [](AsyncLogRecord* record) { static_cast<AsyncLogRecordImpl*>(record)->~AsyncLogRecordImpl(); };
+    }
+
+    /// Format the message.
+    template <size_t... I> void Format(ea::string& message, std::index_sequence<I...>) const
+    {
+        fmt::format_to(std::back_inserter(message), format_.c_str(), std::get<I>(args_)...);
+    }
+
+    /// Format string.
+    ea::string format_;
+    /// Captured arguments.
+    std::tuple<typename AsyncLogArgument<typename std::decay<Args>::type>::Type...> args_;
+};
+
 /// Stored log message from another thread.
 struct StoredLogMessage
 {
@@ -110,7 +198,15 @@ public:
     template<typename... Args> void Info(const char* format, Args... args)    { Write(LOG_INFO, format, args...); }
     template<typename... Args> void Warning(const char* format, Args... args) { Write(LOG_WARNING, format, args...); }
     template<typename... Args> void Error(const char* format, Args... args)   { Write(LOG_ERROR, format, args...); }
-    template<typename... Args> void Write(LogLevel level, const char* format, Args... args) { WriteFormatted(level, Format(format, args...)); }
+    template<typename... Args> void Write(LogLevel level, const char* format, Args... args)
+    {
+        if (!IsEnabled(level))
+            return;
+
+        using Record = AsyncLogRecordImpl<Args...>;
+        WriteRecord<Record>(level, std::integral_constant<bool, sizeof(Record) <= ASYNC_LOG_SLOT_SIZE &&
+            alignof(Record) <= ASYNC_LOG_SLOT_ALIGNMENT>(), format, args...);
+    }
 
     template<typename... Args> void Trace(const ea::string& message)   { Write(LOG_TRACE, message.c_str()); }
     template<typename... Args> void Debug(const ea::string& message)   { Write(LOG_DEBUG, message.c_str()); }
@@ -120,9 +216,49 @@ public:
 
     void WriteFormatted(LogLevel level, const ea::string& message);
 
+    /// Return whether messages of the level pass the level filter.
+    static bool IsEnabled(LogLevel level) { return level >= minLevel_.load(std::memory_order_relaxed); }
+
 protected:
+    /// Capture the message into the asynchronous log queue if it fits a queue slot, otherwise format it immediately.
+    template <class Record, typename... Args> void WriteRecord(LogLevel level, std::true_type, const char* format, const Args&... args)
+    {
+        void* queue;
+        void* slot;
+        if (!AcquireAsyncSlot(queue, slot))
+        {
+            WriteFormatted(level, Format(format, args...));
+            return;
+        }
+
+        // Slot is null if the queue was full and the message was dropped
+        if (slot)
+        {
+            auto* record = new(slot) Record(format, args...);
+            record->logger_ = logger_;
+            record->time_ = std::chrono::system_clock::now();
+            record->level_ = level;
+            CommitAsyncSlot(queue, slot);
+        }
+    }
+
+    /// Format the message immediately, as the captured arguments do not fit a queue slot.
+    template <class Record, typename... Args> void WriteRecord(LogLevel level, std::false_type, const char* format, const Args&... args)
+    {
+        WriteFormatted(level, Format(format, args...));
+    }
+
+    /// Acquire a slot in the asynchronous log queue. Return false if asynchronous logging is not enabled. Slot is null if the message should be dropped. A non-null slot keeps the queue alive until it is committed.
+    bool AcquireAsyncSlot(void*& queue, void*& slot);
+    /// Pass a filled slot to the log thread.
+    void CommitAsyncSlot(void* queue, void* slot);
+
     /// Instance of spdlog logger.
     void* logger_;
+    /// Minimum level of messages which are written.
+    static std::atomic<int> minLevel_;
+
+    friend class LogImpl;
 };
 
 /// Logging subsystem.
@@ -148,6 +284,10 @@ public:
     void SetLogFormat(const ea::string& format);
     /// Set quiet mode ie. only print error entries to standard error stream (which is normally redirected to console also). Output to log file is not affected by this mode.
     void SetQuiet(bool quiet);
+    /// Set asynchronous mode. When enabled, message arguments are captured into a lock-free queue of the specified size, and messages are formatted and written by a background thread.
+    void SetAsync(bool enable, unsigned queueSize = DEFAULT_ASYNC_LOG_QUEUE_SIZE, LogOverflowPolicy policy = LOG_OVERFLOW_BLOCK);
+    /// Wait until the log thread has written all queued messages.
+    void Flush();
 
     /// Return logging level.
     LogLevel GetLevel() const { return level_; }
@@ -155,6 +295,11 @@ public:
     /// Return whether log is in quiet mode (only errors printed to standard error stream).
     bool IsQuiet() const { return quiet_; }
 
+    /// Return whether asynchronous mode is enabled.
+    bool IsAsync() const;
+    /// Return number of messages dropped because the asynchronous log queue was full.
+    unsigned GetNumDroppedMessages() const;
+
     /// Returns a logger with specified name.
     static Logger GetLogger(const char* name=nullptr);
 
@@ -186,17 +331,17 @@ private:
 };
 
 #ifdef URHO3D_LOGGING
-#define URHO3D_LOGTRACE(message, ...) Urho3D::Log::GetLogger().Trace(message, ##__VA_ARGS__)
-#define URHO3D_LOGDEBUG(message, ...) Urho3D::Log::GetLogger().Debug(message, ##__VA_ARGS__)
-#define URHO3D_LOGINFO(message, ...) Urho3D::Log::GetLogger().Info(message, ##__VA_ARGS__)
-#define URHO3D_LOGWARNING(message, ...) Urho3D::Log::GetLogger().Warning(message, ##__VA_ARGS__)
-#define URHO3D_LOGERROR(message, ...) Urho3D::Log::GetLogger().Error(message, ##__VA_ARGS__)
+#define URHO3D_LOGTRACE(message, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_TRACE) ? Urho3D::Log::GetLogger().Trace(message, ##__VA_ARGS__) : (void)0)
+#define URHO3D_LOGDEBUG(message, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_DEBUG) ? Urho3D::Log::GetLogger().Debug(message, ##__VA_ARGS__) : (void)0)
+#define URHO3D_LOGINFO(message, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_INFO) ? Urho3D::Log::GetLogger().Info(message, ##__VA_ARGS__) : (void)0)
+#define URHO3D_LOGWARNING(message, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_WARNING) ? Urho3D::Log::GetLogger().Warning(message, ##__VA_ARGS__) : (void)0)
+#define URHO3D_LOGERROR(message, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_ERROR) ? Urho3D::Log::GetLogger().Error(message, ##__VA_ARGS__) : (void)0)
 #define URHO3D_LOGRAW(message, ...)
-#define URHO3D_LOGTRACEF(format, ...) Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_TRACE, Urho3D::ToString(format, ##__VA_ARGS__))
-#define URHO3D_LOGDEBUGF(format, ...) Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_DEBUG, Urho3D::ToString(format, ##__VA_ARGS__))
-#define URHO3D_LOGINFOF(format, ...) Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_INFO, Urho3D::ToString(format, ##__VA_ARGS__))
-#define URHO3D_LOGWARNINGF(format, ...) Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_WARNING, Urho3D::ToString(format, ##__VA_ARGS__))
-#define URHO3D_LOGERRORF(format, ...) Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_ERROR, Urho3D::ToString(format, ##__VA_ARGS__))
+#define URHO3D_LOGTRACEF(format, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_TRACE) ? Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_TRACE, Urho3D::ToString(format, ##__VA_ARGS__)) : (void)0)
+#define URHO3D_LOGDEBUGF(format, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_DEBUG) ? Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_DEBUG, Urho3D::ToString(format, ##__VA_ARGS__)) : (void)0)
+#define URHO3D_LOGINFOF(format, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_INFO) ? Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_INFO, Urho3D::ToString(format, ##__VA_ARGS__)) : (void)0)
+#define URHO3D_LOGWARNINGF(format, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_WARNING) ? Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_WARNING, Urho3D::ToString(format, ##__VA_ARGS__)) : (void)0)
+#define URHO3D_LOGERRORF(format, ...) (Urho3D::Logger::IsEnabled(Urho3D::LOG_ERROR) ? Urho3D::Log::GetLogger().WriteFormatted(Urho3D::LOG_ERROR, Urho3D::ToString(format, ##__VA_ARGS__)) : (void)0)
 #define URHO3D_LOGRAWF(format, ...)
 #else
 #define URHO3D_LOGTRACE(...) ((void)0)
@@ -49,6 +49,8 @@ public:
 
     /// Return memory area.
     unsigned char* GetData() { return buffer_; }
+    /// Return memory area.
+    const unsigned char* GetData() const override { return buffer_; }
 
     /// Return whether buffer is read-only.
     bool IsReadOnly() { return readOnly_; }
@@ -27,6 +27,16 @@
 #include "../IO/PackageFile.h"
 #include "../IO/FileSystem.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <LZ4/lz4.h>
+
 namespace Urho3D
 {
 
@@ -39,20 +49,25 @@ PackageFile::PackageFile(Context* context) :
 {
 }
 
-PackageFile::PackageFile(Context* context, const ea::string& fileName, unsigned startOffset) :
+PackageFile::PackageFile(Context* context, const ea::string& fileName, unsigned startOffset, bool memoryMapped) :
     Object(context),
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
     compressed_(false)
 {
-    Open(fileName, startOffset);
+    Open(fileName, startOffset, memoryMapped);
 }
 
-PackageFile::~PackageFile() = default;
+PackageFile::~PackageFile()
+{
+    UnmapFile();
+}
 
-bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
+bool PackageFile::Open(const ea::string& fileName, unsigned startOffset, bool memoryMapped)
 {
+    UnmapFile();
+
     SharedPtr<File> file(new File(context_, fileName));
     if (!file->IsOpen())
         return false;
@@ -108,6 +123,9 @@ bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
             entries_[entryName] = newEntry;
     }
 
+    if (memoryMapped && !MapFile())
+        URHO3D_LOGWARNING("Could not map package file " + fileName + " to memory, using file reads instead");
+
     return true;
 }
 
@@ -187,4 +205,125 @@ void PackageFile::Scan(ea::vector<ea::string>& result, const ea::string& pathNam
     }
 }
 
+ea::shared_array<unsigned char> PackageFile::GetDecompressedBlock(unsigned offset, unsigned unpackedSize, unsigned packedSize)
+{
+    if (!mappedData_ || offset > mappedSize_ || packedSize > mappedSize_ - offset)
+        return ea::shared_array<unsigned char>();
+
+    {
+        MutexLock lock(blockCacheMutex_);
+        auto i = blockCache_.find(offset);
+        if (i != blockCache_.end())
+        {
+            blockCacheLru_.splice(blockCacheLru_.end(), blockCacheLru_, i->second.lruIterator_);
+            return i->second.data_;
+        }
+    }
+
+    // Decompress outside the lock so that loader threads do not serialize on each other. The packed data comes
+    // straight from the mapping, so no input buffer is needed
+    ea::shared_array<unsigned char> data(new unsigned char[unpackedSize]);
+    if (LZ4_decompress_safe((const char*)mappedData_ + offset, (char*)data.get(), (int)packedSize, (int)unpackedSize) !=
+        (int)unpackedSize)
+    {
+        URHO3D_LOGERROR("Corrupt compressed block in package file " + fileName_);
+        return ea::shared_array<unsigned char>();
+    }
+
+    MutexLock lock(blockCacheMutex_);
+    // Another thread may have decompressed the same block meanwhile
+    auto i = blockCache_.find(offset);
+    if (i != blockCache_.end())
+        return i->second.data_;
+
+    if (unpackedSize <= blockCacheSize_)
+    {
+        TrimBlockCache(blockCacheSize_ - unpackedSize);
+        CachedBlock& block = blockCache_[offset];
+        block.data_ = data;
+        block.size_ = unpackedSize;
+        block.lruIterator_ = blockCacheLru_.insert(blockCacheLru_.end(), offset);
+        blockCacheUse_ += unpackedSize;
+    }
+
+    return data;
+}
+
+void PackageFile::SetBlockCacheSize(unsigned size)
+{
+    MutexLock lock(blockCacheMutex_);
+    blockCacheSize_ = size;
+    TrimBlockCache(size);
+}
+
+void PackageFile::TrimBlockCache(unsigned size)
+{
+    // Files that are reading an evicted block keep it alive through their own reference
+    while (blockCacheUse_ > size && !blockCacheLru_.empty())
+    {
+        auto i = blockCache_.find(blockCacheLru_.front());
+        blockCacheUse_ -= i->second.size_;
+        blockCache_.erase(i);
+        blockCacheLru_.pop_front();
+    }
+}
+
+bool PackageFile::MapFile()
+{
+#ifdef __ANDROID__
+    if (URHO3D_IS_ASSET(fileName_))
+        return false;
+#endif
+
+    void* data = nullptr;
+#if defined(_WIN32)
+    HANDLE fileHandle = CreateFileW(GetWideNativePath(fileName_).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+    // The view keeps the mapping object and the file open until it is unmapped
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(fileHandle);
+    if (!mappingHandle)
+        return false;
+    data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, totalSize_);
+    CloseHandle(mappingHandle);
+#elif !defined(__EMSCRIPTEN__)
+    int fd = open(GetNativePath(fileName_).c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    data = mmap(nullptr, totalSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (data == MAP_FAILED)
+        data = nullptr;
+#endif
+    if (!data)
+        return false;
+
+    mappedData_ = static_cast<unsigned char*>(data);
+    mappedSize_ = totalSize_;
+    return true;
+}
+
+void PackageFile::UnmapFile()
+{
+    {
+        MutexLock lock(blockCacheMutex_);
+        TrimBlockCache(0);
+    }
+
+    if (!mappedData_)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(mappedData_);
+#elif !defined(__EMSCRIPTEN__)
+    munmap(mappedData_, mappedSize_);
+#endif
+
+    mappedData_ = nullptr;
+    mappedSize_ = 0;
+}
+
 }
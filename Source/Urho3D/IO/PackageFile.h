@@ -22,6 +22,10 @@
 
 #pragma once
 
+#include <EASTL/list.h>
+#include <EASTL/shared_array.h>
+
+#include "../Core/Mutex.h"
 #include "../Core/Object.h"
 
 namespace Urho3D
@@ -46,13 +50,13 @@ class URHO3D_API PackageFile : public Object
 public:
     /// Construct.
     explicit PackageFile(Context* context);
-    /// Construct and open.
-    PackageFile(Context* context, const ea::string& fileName, unsigned startOffset = 0);
+    /// Construct and open. Optionally map the package file to memory.
+    PackageFile(Context* context, const ea::string& fileName, unsigned startOffset = 0, bool memoryMapped = false);
     /// Destruct.
     ~PackageFile() override;
 
-    /// Open the package file. Return true if successful.
-    bool Open(const ea::string& fileName, unsigned startOffset = 0);
+    /// Open the package file. Optionally map the package file to memory, falling back to regular file reads if mapping is not possible. Return true if successful.
+    bool Open(const ea::string& fileName, unsigned startOffset = 0, bool memoryMapped = false);
     /// Check if a file exists within the package file. This will be case-insensitive on Windows and case-sensitive on other platforms.
     bool Exists(const ea::string& fileName) const;
     /// Return the file entry corresponding to the name, or null if not found. This will be case-insensitive on Windows and case-sensitive on other platforms.
@@ -100,7 +104,36 @@ public:
     /// Scan package for specified files.
     void Scan(ea::vector<ea::string>& result, const ea::string& pathName, const ea::string& filter, bool recursive) const;
 
+    /// Return whether the package file is mapped to memory.
+    bool IsMemoryMapped() const { return mappedData_ != nullptr; }
+    /// Return the mapped package file contents, or null if not mapped to memory.
+    const unsigned char* GetMappedData() const { return mappedData_; }
+    /// Return a decompressed block of a memory-mapped compressed package. Offset is the position of the packed data within the package file. Blocks are shared between all files opened from the package and kept in a size-bounded cache. Return null on error.
+    ea::shared_array<unsigned char> GetDecompressedBlock(unsigned offset, unsigned unpackedSize, unsigned packedSize);
+    /// Set maximum total size of decompressed blocks kept in the block cache.
+    void SetBlockCacheSize(unsigned size);
+    /// Return maximum total size of decompressed blocks kept in the block cache.
+    unsigned GetBlockCacheSize() const { return blockCacheSize_; }
+
 private:
+    /// Decompressed block cache entry.
+    struct CachedBlock
+    {
+        /// Decompressed data.
+        ea::shared_array<unsigned char> data_;
+        /// Decompressed size.
+        unsigned size_;
+        /// Position in the least recently used list.
+        ea::list<unsigned>::iterator lruIterator_;
+    };
+
+    /// Map the package file to memory. Return true if successful.
+    bool MapFile();
+    /// Unmap the package file.
+    void UnmapFile();
+    /// Evict least recently used blocks until the block cache fits the given size. Called with the block cache mutex held.
+    void TrimBlockCache(unsigned size);
+
     /// File entries.
     ea::unordered_map<ea::string, PackageEntry> entries_;
     /// File name.
@@ -115,6 +148,20 @@ private:
     unsigned checksum_;
     /// Compressed flag.
     bool compressed_;
+    /// Mapped package file contents.
+    unsigned char* mappedData_{};
+    /// Size of the mapped area.
+    unsigned mappedSize_{};
+    /// Decompressed blocks by packed data offset.
+    ea::unordered_map<unsigned, CachedBlock> blockCache_;
+    /// Block cache offsets from least to most recently used.
+    ea::list<unsigned> blockCacheLru_;
+    /// Total size of the decompressed blocks in the block cache.
+    unsigned blockCacheUse_{};
+    /// Maximum total size of the block cache.
+    unsigned blockCacheSize_{4 * 1024 * 1024};
+    /// Block cache mutex.
+    Mutex blockCacheMutex_;
 };
 
 }
@@ -62,7 +62,7 @@ public:
     void Resize(unsigned size);
 
     /// Return data.
-    const unsigned char* GetData() const { return size_ ? &buffer_[0] : nullptr; }
+    const unsigned char* GetData() const override { return size_ ? &buffer_[0] : nullptr; }
 
     /// Return non-const data.
     unsigned char* GetModifiableData() { return size_ ? &buffer_[0] : nullptr; }
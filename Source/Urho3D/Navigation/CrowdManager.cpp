@@ -408,6 +408,13 @@ void CrowdManager::FindPath(ea::vector<Vector3>& dest, const Vector3& start, con
         navigationMesh_->FindPath(dest, start, end, Vector3(crowd_->getQueryExtents()), crowd_->getFilter(queryFilterType));
 }
 
+unsigned CrowdManager::RequestPath(const Vector3& start, const Vector3& end, int queryFilterType, const NavigationPathCallback& callback)
+{
+    if (crowd_ && navigationMesh_)
+        return navigationMesh_->RequestPath(start, end, callback, Vector3(crowd_->getQueryExtents()), crowd_->getFilter(queryFilterType));
+    return 0;
+}
+
 Vector3 CrowdManager::GetRandomPoint(int queryFilterType, dtPolyRef* randomRef)
 {
     if (randomRef)
@@ -649,7 +656,7 @@ void CrowdManager::OnSceneSet(Scene* scene)
             return;
         }
 
-        SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, URHO3D_HANDLER(CrowdManager, HandleSceneSubsystemUpdate));
+        SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, &CrowdManager::HandleSceneSubsystemUpdate);
 
         // Attempt to auto discover a NavigationMesh component (or its derivative) under the scene node
         if (navigationMeshId_ == 0)
@@ -692,15 +699,13 @@ const dtQueryFilter* CrowdManager::GetDetourQueryFilter(unsigned queryFilterType
     return crowd_ ? crowd_->getFilter(queryFilterType) : nullptr;
 }
 
-void CrowdManager::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
+void CrowdManager::HandleSceneSubsystemUpdate(const SceneUpdate::Data& eventData)
 {
     // Perform update tick as long as the crowd is initialized and the associated navmesh has not been removed
     if (crowd_ && navigationMesh_)
     {
-        using namespace SceneSubsystemUpdate;
-
         if (IsEnabledEffective())
-            Update(eventData[P_TIMESTEP].GetFloat());
+            Update(eventData.timeStep_);
     }
 }
 
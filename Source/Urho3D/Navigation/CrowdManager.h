@@ -22,23 +22,16 @@
 
 #pragma once
 
-#include "../Scene/Component.h"
-
-#ifdef DT_POLYREF64
-using dtPolyRef = uint64_t;
-#else
-using dtPolyRef = unsigned int;
-#endif
+#include "../Navigation/NavigationMesh.h"
 
 class dtCrowd;
-class dtQueryFilter;
 struct dtCrowdAgent;
 
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
 class CrowdAgent;
-class NavigationMesh;
 
 /// Parameter structure for obstacle avoidance params (copied from DetourObstacleAvoidance.h in order to hide Detour header from Urho3D library users).
 struct CrowdObstacleAvoidanceParams
@@ -110,6 +103,8 @@ public:
     Vector3 MoveAlongSurface(const Vector3& start, const Vector3& end, int queryFilterType, int maxVisited = 3);
     /// Find a path between world space points using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type. Return non-empty list of points if successful.
     void FindPath(ea::vector<Vector3>& dest, const Vector3& start, const Vector3& end, int queryFilterType);
+    /// Queue a path request between world space points using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type. The result is delivered by the callback, or by E_NAVIGATION_PATH_RESULT from the navigation mesh if there is no callback. Return request ID, or 0 if the crowd is not initialized.
+    unsigned RequestPath(const Vector3& start, const Vector3& end, int queryFilterType, const NavigationPathCallback& callback = nullptr);
     /// Return a random point on the navigation mesh using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type.
     Vector3 GetRandomPoint(int queryFilterType, dtPolyRef* randomRef = nullptr);
     /// Return a random point on the navigation mesh within a circle using the crowd initialized query extent (based on maxAgentRadius) and the specified query filter type. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -173,7 +168,7 @@ protected:
 
 private:
     /// Handle the scene subsystem update event.
-    void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneSubsystemUpdate(const SceneUpdate::Data& eventData);
     /// Handle navigation mesh changed event. It can be navmesh being rebuilt or being removed from its node.
     void HandleNavMeshChanged(StringHash eventType, VariantMap& eventData);
     /// Handle component added in the scene to check for late addition of the navmesh.
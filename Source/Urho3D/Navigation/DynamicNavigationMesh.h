@@ -37,6 +37,7 @@ struct dtTileCachePolyMesh;
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
 class OffMeshConnection;
 class Obstacle;
 
@@ -101,12 +102,10 @@ public:
     bool GetDrawObstacles() const { return drawObstacles_; }
 
 protected:
-    struct TileCacheData;
-
     /// Subscribe to events when assigned to a scene.
     void OnSceneSet(Scene* scene) override;
     /// Trigger the tile cache to make updates to the nav mesh if necessary.
-    void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneSubsystemUpdate(const SceneUpdate::Data& eventData);
 
     /// Used by Obstacle class to add itself to the tile cache, if 'silent' an event will not be raised.
     void AddObstacle(Obstacle* obstacle, bool silent = false);
@@ -115,10 +114,12 @@ protected:
     /// Used by Obstacle class to remove itself from the tile cache, if 'silent' an event will not be raised.
     void RemoveObstacle(Obstacle* obstacle, bool silent = false);
 
-    /// Build one tile of the navigation mesh. Return true if successful.
-    int BuildTile(ea::vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData* tiles);
-    /// Build tiles in the rectangular area. Return number of built tiles.
-    unsigned BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
+    /// Create empty build data.
+    NavBuildData* CreateBuildData() const override;
+    /// Build tile cache layers from the gathered geometry. Does not modify the tile cache and may be called on worker threads.
+    void BuildTileData(NavBuildData* build, NavTileData& tileData) const override;
+    /// Replace the tile cache layers of the tile with the built data and rebuild the navigation mesh tile. Return number of layers added.
+    unsigned AddTileData(NavTileData& tileData) override;
     /// Off-mesh connections to be rebuilt in the mesh processor.
     ea::vector<OffMeshConnection*> CollectOffMeshConnections(const BoundingBox& bounds);
     /// Release the navigation mesh, query, and tile cache.
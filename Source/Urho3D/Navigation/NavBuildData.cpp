@@ -26,6 +26,7 @@
 
 #include "../Navigation/NavBuildData.h"
 
+#include <Detour/DetourAlloc.h>
 #include <DetourTileCache/DetourTileCacheBuilder.h>
 #include <Recast/Recast.h>
 
@@ -49,6 +50,17 @@ NavBuildData::~NavBuildData()
     compactHeightField_ = nullptr;
 }
 
+NavTileData::NavTileData() :
+    success_(false)
+{
+}
+
+NavTileData::~NavTileData()
+{
+    for (auto& layer : layers_)
+        dtFree(layer.first);
+}
+
 SimpleNavBuildData::SimpleNavBuildData() :
     NavBuildData(),
     contourSet_(nullptr),
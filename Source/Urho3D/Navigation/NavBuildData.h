@@ -25,6 +25,7 @@
 #include <EASTL/vector.h>
 
 #include "../Math/BoundingBox.h"
+#include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 
 class rcContext;
@@ -85,6 +86,26 @@ struct URHO3D_API NavBuildData
     ea::vector<NavAreaStub> navAreas_;
 };
 
+/// Navigation mesh tile data built on a worker thread, to be added to the navigation mesh on the main thread.
+struct URHO3D_API NavTileData
+{
+    /// Construct.
+    NavTileData();
+    /// Destruct. Free data not passed to the navigation mesh.
+    ~NavTileData();
+    /// Prevent copy construction.
+    NavTileData(const NavTileData& rhs) = delete;
+    /// Prevent assignment.
+    NavTileData& operator =(const NavTileData& rhs) = delete;
+
+    /// Tile index.
+    IntVector2 tile_;
+    /// Data allocated by Detour and its size, one item per layer. Set to null when ownership passes to the navigation mesh.
+    ea::vector<ea::pair<unsigned char*, int> > layers_;
+    /// Whether the build succeeded.
+    bool success_;
+};
+
 struct URHO3D_API SimpleNavBuildData : public NavBuildData
 {
     /// Constructor.
@@ -43,6 +43,25 @@ URHO3D_EVENT(E_NAVIGATION_AREA_REBUILT, NavigationAreaRebuilt)
     URHO3D_PARAM(P_BOUNDSMAX, BoundsMax); // Vector3
 }
 
+/// Asynchronous navigation mesh build has added tiles. Sent last when all tiles are finished.
+URHO3D_EVENT(E_NAVIGATION_BUILD_PROGRESS, NavigationBuildProgress)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    URHO3D_PARAM(P_TILESFINISHED, TilesFinished); // int
+    URHO3D_PARAM(P_TILESTOTAL, TilesTotal); // int
+    URHO3D_PARAM(P_PROGRESS, Progress); // float
+}
+
+/// Queued path request without a callback has finished.
+URHO3D_EVENT(E_NAVIGATION_PATH_RESULT, NavigationPathResult)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    URHO3D_PARAM(P_REQUESTID, RequestID); // unsigned
+    URHO3D_PARAM(P_PATH, Path); // VariantVector of Vector3, empty if no path was found
+}
+
 /// Mesh tile is added to navigation mesh.
 URHO3D_EVENT(E_NAVIGATION_TILE_ADDED, NavigationTileAdded)
 {
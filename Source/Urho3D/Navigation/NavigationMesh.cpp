@@ -23,7 +23,10 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Geometry.h"
@@ -46,6 +49,7 @@
 #include "../Physics/CollisionShape.h"
 #endif
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 
 #include <cfloat>
 #include <Detour/DetourNavMesh.h>
@@ -82,6 +86,8 @@ static const float DEFAULT_DETAIL_SAMPLE_DISTANCE = 6.0f;
 static const float DEFAULT_DETAIL_SAMPLE_MAX_ERROR = 1.0f;
 
 static const int MAX_POLYS = 2048;
+/// Interval of path request throughput measurement in milliseconds.
+static const unsigned PATH_STATISTICS_INTERVAL = 1000;
 
 
 /// Temporary data for finding a path.
@@ -97,6 +103,137 @@ struct FindPathData
     unsigned char pathFlags_[MAX_POLYS]{};
 };
 
+/// Tile being built by a work item during an asynchronous build.
+struct NavigationAsyncTile
+{
+    /// Work item.
+    SharedPtr<WorkItem> item_;
+    /// Geometry gathered on the main thread. Released by the work item.
+    ea::unique_ptr<NavBuildData> build_;
+    /// Built tile data.
+    NavTileData tileData_;
+};
+
+/// Asynchronous navigation mesh build state.
+struct NavigationAsyncBuild
+{
+    /// Geometry to build from.
+    ea::vector<NavigationGeometryInfo> geometryList_;
+    /// Geometry components, to detect removal between frames.
+    ea::vector<WeakPtr<Component> > geometryComponents_;
+    /// Tiles to build.
+    ea::vector<IntVector2> tiles_;
+    /// Tiles being built.
+    ea::vector<ea::unique_ptr<NavigationAsyncTile> > activeTiles_;
+    /// Index of the next tile to start.
+    unsigned nextTile_{};
+    /// Number of finished tiles.
+    unsigned numFinished_{};
+};
+
+/// Path request queued for solving on worker threads.
+struct NavigationPathRequest
+{
+    /// Request ID.
+    unsigned id_{};
+    /// World space start point.
+    Vector3 start_;
+    /// World space end point.
+    Vector3 end_;
+    /// Start point in navigation mesh space.
+    Vector3 localStart_;
+    /// End point in navigation mesh space.
+    Vector3 localEnd_;
+    /// Search extents.
+    Vector3 extents_;
+    /// Query filter.
+    const dtQueryFilter* filter_{};
+    /// Result callback.
+    NavigationPathCallback callback_;
+    /// Query holding the sliced search state, assigned while the search is in progress.
+    dtNavMeshQuery* query_{};
+    /// End polygon.
+    dtPolyRef endRef_{};
+    /// Search started flag.
+    bool started_{};
+    /// Search finished flag.
+    bool finished_{};
+    /// Path points in navigation mesh space.
+    ea::vector<Vector3> points_;
+    /// Path point flags.
+    ea::vector<unsigned char> flags_;
+};
+
+/// Path request queue. Each worker thread takes a query from the pool for the request it is solving; a search that does not finish within the frame keeps its query until the next frame.
+struct NavigationPathQueue
+{
+    /// Destruct. Free the queries.
+    ~NavigationPathQueue()
+    {
+        ReleaseQueries();
+    }
+
+    /// Take a query from the pool or create a new one. Return null on failure. Called from worker threads.
+    dtNavMeshQuery* AcquireQuery(dtNavMesh* navMesh)
+    {
+        {
+            SpinLockGuard lock(queryLock_);
+            if (!queries_.empty())
+            {
+                dtNavMeshQuery* query = queries_.back();
+                queries_.pop_back();
+                return query;
+            }
+        }
+
+        dtNavMeshQuery* query = dtAllocNavMeshQuery();
+        if (query && dtStatusFailed(query->init(navMesh, MAX_POLYS)))
+        {
+            dtFreeNavMeshQuery(query);
+            query = nullptr;
+        }
+        return query;
+    }
+
+    /// Return a query to the pool. Called from worker threads.
+    void ReturnQuery(dtNavMeshQuery* query)
+    {
+        SpinLockGuard lock(queryLock_);
+        queries_.push_back(query);
+    }
+
+    /// Free all queries and restart the searches in progress. Called when the navigation mesh is released.
+    void ReleaseQueries()
+    {
+        for (const auto& request : requests_)
+        {
+            dtFreeNavMeshQuery(request->query_);
+            request->query_ = nullptr;
+            request->started_ = false;
+        }
+        for (dtNavMeshQuery* query : queries_)
+            dtFreeNavMeshQuery(query);
+        queries_.clear();
+    }
+
+    /// Queued requests in submission order.
+    ea::vector<ea::unique_ptr<NavigationPathRequest> > requests_;
+    /// Free queries.
+    ea::vector<dtNavMeshQuery*> queries_;
+    /// Query pool lock.
+    SpinLock queryLock_;
+    /// Per-thread temporary path data. The last entry is for a thread not managed by the work queue.
+    ea::vector<ea::unique_ptr<FindPathData> > threadData_;
+    /// Next request ID.
+    unsigned nextID_{1};
+    /// Requests solved during the current measurement interval.
+    unsigned numSolved_{};
+    /// Processing time during the current measurement interval in microseconds.
+    long long processTime_{};
+    /// Measurement interval timer.
+    Timer statisticsTimer_;
+};
+
 NavigationMesh::NavigationMesh(Context* context) :
     Component(context),
     navMesh_(nullptr),
@@ -122,7 +259,12 @@ NavigationMesh::NavigationMesh(Context* context) :
     partitionType_(NAVMESH_PARTITION_WATERSHED),
     keepInterResults_(false),
     drawOffMeshConnections_(false),
-    drawNavAreas_(false)
+    drawNavAreas_(false),
+    pathQueue_(new NavigationPathQueue()),
+    maxPathRequests_(0),
+    pathSearchIterations_(0),
+    pathRequestsPerSecond_(0.0f),
+    logPathStatistics_(false)
 {
 }
 
@@ -709,32 +851,242 @@ void NavigationMesh::FindPath(ea::vector<NavigationPathPoint>& dest, const Vecto
         NavigationPathPoint pt;
         pt.position_ = transform * pathData_->pathPoints_[i];
         pt.flag_ = (NavigationPathPointFlag)pathData_->pathFlags_[i];
+        pt.areaID_ = GetNavAreaID(pt.position_);
 
-        // Walk through all NavAreas and find nearest
-        unsigned nearestNavAreaID = 0;       // 0 is the default nav area ID
-        float nearestDistance = M_LARGE_VALUE;
-        for (unsigned j = 0; j < areas_.size(); j++)
+        dest.push_back(pt);
+    }
+}
+
+unsigned NavigationMesh::RequestPath(const Vector3& start, const Vector3& end, const NavigationPathCallback& callback,
+    const Vector3& extents, const dtQueryFilter* filter)
+{
+    auto request = ea::make_unique<NavigationPathRequest>();
+    request->id_ = pathQueue_->nextID_++;
+    if (!pathQueue_->nextID_)
+        pathQueue_->nextID_ = 1;
+    request->start_ = start;
+    request->end_ = end;
+    request->extents_ = extents;
+    request->filter_ = filter ? filter : queryFilter_.get();
+    request->callback_ = callback;
+
+    if (Scene* scene = GetScene())
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, &NavigationMesh::HandlePathRequestUpdate);
+
+    const unsigned requestID = request->id_;
+    pathQueue_->requests_.push_back(ea::move(request));
+    return requestID;
+}
+
+void NavigationMesh::CancelPathRequest(unsigned requestID)
+{
+    auto& requests = pathQueue_->requests_;
+    for (auto i = requests.begin(); i != requests.end(); ++i)
+    {
+        if ((*i)->id_ == requestID)
         {
-            NavArea* area = areas_[j];
-            if (area && area->IsEnabledEffective())
+            if ((*i)->query_)
+                pathQueue_->ReturnQuery((*i)->query_);
+            requests.erase(i);
+            return;
+        }
+    }
+}
+
+void NavigationMesh::ProcessPathRequests()
+{
+    URHO3D_PROFILE("ProcessPathRequests");
+
+    NavigationPathQueue& queue = *pathQueue_;
+    if (queue.requests_.empty())
+        return;
+
+    HiresTimer processTimer;
+    const auto numQueued = (unsigned)queue.requests_.size();
+    const unsigned numActive = maxPathRequests_ ? Min(maxPathRequests_, numQueued) : numQueued;
+
+    if (InitializeQuery())
+    {
+        // Transform the end points of new requests to local space on the main thread
+        const Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
+        for (unsigned i = 0; i < numActive; ++i)
+        {
+            NavigationPathRequest& request = *queue.requests_[i];
+            if (!request.started_)
+            {
+                request.localStart_ = inverse * request.start_;
+                request.localEnd_ = inverse * request.end_;
+            }
+        }
+
+        // One buffer per thread, and a last one for a calling thread not managed by the work queue
+        auto* workQueue = GetSubsystem<WorkQueue>();
+        const unsigned numThreads = workQueue ? workQueue->GetNumThreads() + 1 : 1;
+        while (queue.threadData_.size() < numThreads + 1)
+            queue.threadData_.emplace_back(new FindPathData());
+
+        const auto solveRequests = [this, &queue, numThreads](unsigned begin, unsigned end, unsigned threadIndex)
+        {
+            FindPathData& data = *queue.threadData_[threadIndex < numThreads ? threadIndex : numThreads];
+            for (unsigned i = begin; i < end; ++i)
             {
-                BoundingBox bb = area->GetWorldBoundingBox();
-                if (bb.IsInside(pt.position_) == INSIDE)
+                NavigationPathRequest& request = *queue.requests_[i];
+                if (!request.query_)
+                    request.query_ = queue.AcquireQuery(navMesh_);
+                dtNavMeshQuery* query = request.query_;
+                if (!query)
+                {
+                    request.finished_ = true;
+                    continue;
+                }
+
+                int numPolys = 0;
+                if (!request.started_)
                 {
-                    Vector3 areaWorldCenter = area->GetNode()->GetWorldPosition();
-                    float distance = (areaWorldCenter - pt.position_).LengthSquared();
-                    if (distance < nearestDistance)
+                    dtPolyRef startRef = 0;
+                    query->findNearestPoly(&request.localStart_.x_, &request.extents_.x_, request.filter_, &startRef, nullptr);
+                    query->findNearestPoly(&request.localEnd_.x_, &request.extents_.x_, request.filter_, &request.endRef_, nullptr);
+                    if (startRef && request.endRef_)
                     {
-                        nearestDistance = distance;
-                        nearestNavAreaID = area->GetAreaID();
+                        // Without an iteration limit search in one go, otherwise begin a sliced search
+                        if (!pathSearchIterations_)
+                        {
+                            query->findPath(startRef, request.endRef_, &request.localStart_.x_, &request.localEnd_.x_,
+                                request.filter_, data.polys_, &numPolys, MAX_POLYS);
+                        }
+                        else
+                        {
+                            request.started_ = !dtStatusFailed(query->initSlicedFindPath(startRef, request.endRef_,
+                                &request.localStart_.x_, &request.localEnd_.x_, request.filter_));
+                        }
                     }
                 }
+
+                if (request.started_)
+                {
+                    const int maxIterations = pathSearchIterations_ ? (int)pathSearchIterations_ : M_MAX_INT;
+                    const dtStatus status = query->updateSlicedFindPath(maxIterations, nullptr);
+                    if (dtStatusInProgress(status))
+                        continue;
+                    if (dtStatusSucceed(status))
+                        query->finalizeSlicedFindPath(data.polys_, &numPolys, MAX_POLYS);
+                }
+
+                if (numPolys)
+                {
+                    // If full path was not found, clamp end point to the end polygon
+                    Vector3 actualLocalEnd = request.localEnd_;
+                    if (data.polys_[numPolys - 1] != request.endRef_)
+                        query->closestPointOnPoly(data.polys_[numPolys - 1], &request.localEnd_.x_, &actualLocalEnd.x_, nullptr);
+
+                    int numPathPoints = 0;
+                    query->findStraightPath(&request.localStart_.x_, &actualLocalEnd.x_, data.polys_, numPolys,
+                        &data.pathPoints_[0].x_, data.pathFlags_, data.pathPolys_, &numPathPoints, MAX_POLYS);
+                    request.points_.assign(data.pathPoints_, data.pathPoints_ + numPathPoints);
+                    request.flags_.assign(data.pathFlags_, data.pathFlags_ + numPathPoints);
+                }
+
+                queue.ReturnQuery(query);
+                request.query_ = nullptr;
+                request.finished_ = true;
             }
+        };
+
+        if (workQueue)
+            workQueue->ParallelFor(0, numActive, 1, solveRequests);
+        else
+            solveRequests(0, numActive, 0);
+    }
+    else
+    {
+        // No navigation data, fail the requests
+        for (unsigned i = 0; i < numActive; ++i)
+            queue.requests_[i]->finished_ = true;
+    }
+
+    // Take the finished requests out of the queue first, as callbacks may queue or cancel requests
+    ea::vector<ea::unique_ptr<NavigationPathRequest> > finished;
+    unsigned numRemaining = 0;
+    for (unsigned i = 0; i < queue.requests_.size(); ++i)
+    {
+        if (queue.requests_[i]->finished_)
+            finished.push_back(ea::move(queue.requests_[i]));
+        else
+            queue.requests_[numRemaining++] = ea::move(queue.requests_[i]);
+    }
+    queue.requests_.resize(numRemaining);
+
+    queue.numSolved_ += (unsigned)finished.size();
+    queue.processTime_ += processTimer.GetUSec(false);
+    if (queue.statisticsTimer_.GetMSec(false) >= PATH_STATISTICS_INTERVAL)
+    {
+        pathRequestsPerSecond_ = queue.processTime_ ? (float)queue.numSolved_ * 1000000.0f / (float)queue.processTime_ : 0.0f;
+        if (logPathStatistics_)
+        {
+            URHO3D_LOGINFOF("Solved %u path requests in %.3f ms, %.0f requests/s, %u queued", queue.numSolved_,
+                queue.processTime_ / 1000.0f, pathRequestsPerSecond_, (unsigned)queue.requests_.size());
         }
-        pt.areaID_ = (unsigned char)nearestNavAreaID;
+        queue.numSolved_ = 0;
+        queue.processTime_ = 0;
+        queue.statisticsTimer_.Reset();
+    }
 
-        dest.push_back(pt);
+    // Transform the paths back to world space and deliver them
+    const Matrix3x4 transform = node_ ? node_->GetWorldTransform() : Matrix3x4::IDENTITY;
+    ea::vector<NavigationPathPoint> path;
+    for (const auto& request : finished)
+    {
+        path.clear();
+        for (unsigned i = 0; i < request->points_.size(); ++i)
+        {
+            NavigationPathPoint pt;
+            pt.position_ = transform * request->points_[i];
+            pt.flag_ = (NavigationPathPointFlag)request->flags_[i];
+            pt.areaID_ = GetNavAreaID(pt.position_);
+            path.push_back(pt);
+        }
+
+        if (request->callback_)
+            request->callback_(request->id_, path);
+        else
+        {
+            VariantVector points;
+            points.reserve(path.size());
+            for (const NavigationPathPoint& pt : path)
+                points.push_back(pt.position_);
+
+            using namespace NavigationPathResult;
+            VariantMap& eventData = GetContext()->GetEventDataMap();
+            eventData[P_NODE] = node_;
+            eventData[P_MESH] = this;
+            eventData[P_REQUESTID] = request->id_;
+            eventData[P_PATH] = points;
+            SendEvent(E_NAVIGATION_PATH_RESULT, eventData);
+        }
     }
+
+    if (pathQueue_->requests_.empty())
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+void NavigationMesh::SetMaxPathRequests(unsigned maxRequests)
+{
+    maxPathRequests_ = maxRequests;
+}
+
+void NavigationMesh::SetPathSearchIterations(unsigned iterations)
+{
+    pathSearchIterations_ = iterations;
+}
+
+void NavigationMesh::SetLogPathStatistics(bool enable)
+{
+    logPathStatistics_ = enable;
+}
+
+unsigned NavigationMesh::GetNumPathRequests() const
+{
+    return pathQueue_->requests_.size();
 }
 
 Vector3 NavigationMesh::GetRandomPoint(const dtQueryFilter* filter, dtPolyRef* randomRef)
@@ -1301,16 +1653,67 @@ bool NavigationMesh::ReadTile(Deserializer& source, bool silent)
 
 bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList, int x, int z)
 {
-    URHO3D_PROFILE("BuildNavigationMeshTile");
+    NavTileData tileData;
+    tileData.tile_ = IntVector2(x, z);
+    {
+        ea::unique_ptr<NavBuildData> build = PrepareTileBuild(geometryList, tileData.tile_);
+        BuildTileData(build.get(), tileData);
+    }
 
-    // Remove previous tile (if any)
-    navMesh_->removeTile(navMesh_->getTileRefAt(x, z, 0), nullptr, nullptr);
+    AddTileData(tileData);
+    return tileData.success_;
+}
 
-    const BoundingBox tileBoundingBox = GetTileBoundingBox(IntVector2(x, z));
+unsigned NavigationMesh::BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
+{
+    ea::vector<NavTileData> tiles(Max(to.x_ - from.x_ + 1, 0) * Max(to.y_ - from.y_ + 1, 0));
+    unsigned index = 0;
+    for (int z = from.y_; z <= to.y_; ++z)
+    {
+        for (int x = from.x_; x <= to.x_; ++x)
+            tiles[index++].tile_ = IntVector2(x, z);
+    }
 
-    SimpleNavBuildData build;
+    // Worker threads only read world transforms, so make sure that they are up to date
+    node_->GetWorldTransform();
+    for (const NavigationGeometryInfo& info : geometryList)
+    {
+        info.component_->GetNode()->GetWorldTransform();
+        if (info.component_->GetType() == OffMeshConnection::GetTypeStatic())
+        {
+            Node* endPoint = static_cast<OffMeshConnection*>(info.component_)->GetEndPoint();
+            if (endPoint)
+                endPoint->GetWorldTransform();
+        }
+    }
+
+    // Build the tiles in parallel, each with its own Recast context
+    const auto buildTiles = [&](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+    {
+        for (unsigned i = begin; i < end; ++i)
+        {
+            ea::unique_ptr<NavBuildData> build = PrepareTileBuild(geometryList, tiles[i].tile_);
+            BuildTileData(build.get(), tiles[i]);
+        }
+    };
+
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    if (workQueue && tiles.size() > 1)
+        workQueue->ParallelFor(0, tiles.size(), 1, buildTiles);
+    else
+        buildTiles(0, tiles.size(), 0);
+
+    // Modify the navigation mesh and send events on the main thread
+    unsigned numTiles = 0;
+    for (NavTileData& tileData : tiles)
+        numTiles += AddTileData(tileData);
+    return numTiles;
+}
+
+void NavigationMesh::GetTileConfig(rcConfig& cfg, const IntVector2& tile) const
+{
+    const BoundingBox tileBoundingBox = GetTileBoundingBox(tile);
 
-    rcConfig cfg;       // NOLINT(hicpp-member-init)
     memset(&cfg, 0, sizeof cfg);
     cfg.cs = cellSize_;
     cfg.ch = cellHeight_;
@@ -1336,25 +1739,52 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
     cfg.bmin[2] -= cfg.borderSize * cfg.cs;
     cfg.bmax[0] += cfg.borderSize * cfg.cs;
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
+}
+
+ea::unique_ptr<NavBuildData> NavigationMesh::PrepareTileBuild(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& tile)
+{
+    ea::unique_ptr<NavBuildData> build(CreateBuildData());
+
+    rcConfig cfg;       // NOLINT(hicpp-member-init)
+    GetTileConfig(cfg, tile);
 
     BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    GetTileGeometry(build.get(), geometryList, expandedBox);
+    return build;
+}
+
+NavBuildData* NavigationMesh::CreateBuildData() const
+{
+    return new SimpleNavBuildData();
+}
+
+void NavigationMesh::BuildTileData(NavBuildData* buildData, NavTileData& tileData) const
+{
+    URHO3D_PROFILE("BuildNavigationMeshTile");
+
+    auto& build = *static_cast<SimpleNavBuildData*>(buildData);
+
+    rcConfig cfg;       // NOLINT(hicpp-member-init)
+    GetTileConfig(cfg, tileData.tile_);
 
     if (build.vertices_.empty() || build.indices_.empty())
-        return true; // Nothing to do
+    {
+        tileData.success_ = true;
+        return; // Nothing to do
+    }
 
     build.heightField_ = rcAllocHeightfield();
     if (!build.heightField_)
     {
         URHO3D_LOGERROR("Could not allocate heightfield");
-        return false;
+        return;
     }
 
     if (!rcCreateHeightfield(build.ctx_, *build.heightField_, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs,
         cfg.ch))
     {
         URHO3D_LOGERROR("Could not create heightfield");
-        return false;
+        return;
     }
 
     unsigned numTriangles = build.indices_.size() / 3;
@@ -1374,18 +1804,18 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
     if (!build.compactHeightField_)
     {
         URHO3D_LOGERROR("Could not allocate create compact heightfield");
-        return false;
+        return;
     }
     if (!rcBuildCompactHeightfield(build.ctx_, cfg.walkableHeight, cfg.walkableClimb, *build.heightField_,
         *build.compactHeightField_))
     {
         URHO3D_LOGERROR("Could not build compact heightfield");
-        return false;
+        return;
     }
     if (!rcErodeWalkableArea(build.ctx_, cfg.walkableRadius, *build.compactHeightField_))
     {
         URHO3D_LOGERROR("Could not erode compact heightfield");
-        return false;
+        return;
     }
 
     // Mark area volumes
@@ -1398,13 +1828,13 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
         if (!rcBuildDistanceField(build.ctx_, *build.compactHeightField_))
         {
             URHO3D_LOGERROR("Could not build distance field");
-            return false;
+            return;
         }
         if (!rcBuildRegions(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea,
             cfg.mergeRegionArea))
         {
             URHO3D_LOGERROR("Could not build regions");
-            return false;
+            return;
         }
     }
     else
@@ -1412,7 +1842,7 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
         if (!rcBuildRegionsMonotone(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
         {
             URHO3D_LOGERROR("Could not build monotone regions");
-            return false;
+            return;
         }
     }
 
@@ -1420,38 +1850,38 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
     if (!build.contourSet_)
     {
         URHO3D_LOGERROR("Could not allocate contour set");
-        return false;
+        return;
     }
     if (!rcBuildContours(build.ctx_, *build.compactHeightField_, cfg.maxSimplificationError, cfg.maxEdgeLen,
         *build.contourSet_))
     {
         URHO3D_LOGERROR("Could not create contours");
-        return false;
+        return;
     }
 
     build.polyMesh_ = rcAllocPolyMesh();
     if (!build.polyMesh_)
     {
         URHO3D_LOGERROR("Could not allocate poly mesh");
-        return false;
+        return;
     }
     if (!rcBuildPolyMesh(build.ctx_, *build.contourSet_, cfg.maxVertsPerPoly, *build.polyMesh_))
     {
         URHO3D_LOGERROR("Could not triangulate contours");
-        return false;
+        return;
     }
 
     build.polyMeshDetail_ = rcAllocPolyMeshDetail();
     if (!build.polyMeshDetail_)
     {
         URHO3D_LOGERROR("Could not allocate detail mesh");
-        return false;
+        return;
     }
     if (!rcBuildPolyMeshDetail(build.ctx_, *build.polyMesh_, *build.compactHeightField_, cfg.detailSampleDist,
         cfg.detailSampleMaxError, *build.polyMeshDetail_))
     {
         URHO3D_LOGERROR("Could not build detail mesh");
-        return false;
+        return;
     }
 
     // Set polygon flags
@@ -1482,8 +1912,8 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
     params.walkableHeight = agentHeight_;
     params.walkableRadius = agentRadius_;
     params.walkableClimb = agentMaxClimb_;
-    params.tileX = x;
-    params.tileY = z;
+    params.tileX = tileData.tile_.x_;
+    params.tileY = tileData.tile_.y_;
     rcVcopy(params.bmin, build.polyMesh_->bmin);
     rcVcopy(params.bmax, build.polyMesh_->bmax);
     params.cs = cfg.cs;
@@ -1504,18 +1934,37 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
     if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
     {
         URHO3D_LOGERROR("Could not build navigation mesh tile data");
-        return false;
+        return;
     }
 
-    if (dtStatusFailed(navMesh_->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, nullptr)))
+    tileData.layers_.emplace_back(navData, navDataSize);
+    tileData.success_ = true;
+}
+
+unsigned NavigationMesh::AddTileData(NavTileData& tileData)
+{
+    // Remove previous tile (if any)
+    navMesh_->removeTile(navMesh_->getTileRefAt(tileData.tile_.x_, tileData.tile_.y_, 0), nullptr, nullptr);
+
+    if (!tileData.success_)
+        return 0;
+
+    for (auto& layer : tileData.layers_)
     {
-        URHO3D_LOGERROR("Failed to add navigation mesh tile");
-        dtFree(navData);
-        return false;
+        if (dtStatusFailed(navMesh_->addTile(layer.first, layer.second, DT_TILE_FREE_DATA, 0, nullptr)))
+        {
+            URHO3D_LOGERROR("Failed to add navigation mesh tile");
+            tileData.success_ = false;
+            return 0;
+        }
+        layer.first = nullptr;
     }
 
     // Send a notification of the rebuild of this tile to anyone interested
+    if (!tileData.layers_.empty())
     {
+        const BoundingBox tileBoundingBox = GetTileBoundingBox(tileData.tile_);
+
         using namespace NavigationAreaRebuilt;
         VariantMap& eventData = GetContext()->GetEventDataMap();
         eventData[P_NODE] = GetNode();
@@ -1524,22 +1973,142 @@ bool NavigationMesh::BuildTile(ea::vector<NavigationGeometryInfo>& geometryList,
         eventData[P_BOUNDSMAX] = Variant(tileBoundingBox.max_);
         SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
     }
-    return true;
+    return 1;
 }
 
-unsigned NavigationMesh::BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
+bool NavigationMesh::BuildAsync(const IntVector2& from, const IntVector2& to)
 {
-    unsigned numTiles = 0;
+    URHO3D_PROFILE("BuildNavigationMeshAsync");
+
+    if (!node_)
+        return false;
+
+    if (!navMesh_)
+    {
+        URHO3D_LOGERROR("Navigation mesh must first be built or allocated before it can be built asynchronously");
+        return false;
+    }
+
+    CancelAsyncBuild();
+
+    // Without the work queue there are no worker threads to build on, so build synchronously
+    if (!GetSubsystem<WorkQueue>())
+        return Build(from, to);
+
+    asyncBuild_ = ea::make_unique<NavigationAsyncBuild>();
+    NavigationAsyncBuild& build = *asyncBuild_;
+    CollectGeometries(build.geometryList_);
+    for (const NavigationGeometryInfo& info : build.geometryList_)
+        build.geometryComponents_.emplace_back(info.component_);
 
     for (int z = from.y_; z <= to.y_; ++z)
     {
         for (int x = from.x_; x <= to.x_; ++x)
+            build.tiles_.emplace_back(x, z);
+    }
+
+    SubscribeToEvent(E_UPDATE, &NavigationMesh::HandleAsyncBuildUpdate);
+    return true;
+}
+
+void NavigationMesh::CancelAsyncBuild()
+{
+    if (!asyncBuild_)
+        return;
+
+    // Tiles being built refer to the navigation mesh, so wait for them
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    for (const auto& tile : asyncBuild_->activeTiles_)
+    {
+        if (workQueue && workQueue->RemoveWorkItem(tile->item_))
+            continue;
+        while (!tile->item_->completed_)
+            Time::Sleep(0);
+    }
+
+    asyncBuild_.reset();
+    UnsubscribeFromEvent(E_UPDATE);
+}
+
+void NavigationMesh::HandleAsyncBuildUpdate(const Update::Data& eventData)
+{
+    URHO3D_PROFILE("UpdateNavigationMeshAsync");
+
+    NavigationAsyncBuild& build = *asyncBuild_;
+
+    // Add the finished tiles
+    unsigned numFinished = 0;
+    for (unsigned i = 0; i < build.activeTiles_.size();)
+    {
+        NavigationAsyncTile& tile = *build.activeTiles_[i];
+        if (!tile.item_->completed_)
         {
-            if (BuildTile(geometryList, x, z))
-                ++numTiles;
+            ++i;
+            continue;
         }
+
+        AddTileData(tile.tileData_);
+        build.activeTiles_.erase_unsorted(build.activeTiles_.begin() + i);
+        ++numFinished;
+    }
+    build.numFinished_ += numFinished;
+
+    // Forget geometry removed from the scene since the build started
+    for (unsigned i = 0; i < build.geometryComponents_.size();)
+    {
+        if (build.geometryComponents_[i])
+        {
+            ++i;
+            continue;
+        }
+
+        build.geometryComponents_.erase_unsorted(build.geometryComponents_.begin() + i);
+        build.geometryList_.erase_unsorted(build.geometryList_.begin() + i);
+    }
+
+    // Gather geometry of new tiles on the main thread, and keep twice the number of threads busy with Recast
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    const unsigned maxActiveTiles = Max(workQueue->GetNumThreads(), 1u) * 2;
+    while (build.activeTiles_.size() < maxActiveTiles && build.nextTile_ < build.tiles_.size())
+    {
+        auto tile = ea::make_unique<NavigationAsyncTile>();
+        tile->tileData_.tile_ = build.tiles_[build.nextTile_++];
+        tile->build_ = PrepareTileBuild(build.geometryList_, tile->tileData_.tile_);
+
+        tile->item_ = workQueue->GetFreeItem();
+        tile->item_->start_ = this;
+        tile->item_->aux_ = tile.get();
+        tile->item_->workFunction_ = [](const WorkItem* item, unsigned /*threadIndex*/)
+        {
+            auto* mesh = static_cast<NavigationMesh*>(item->start_);
+            auto* tile = static_cast<NavigationAsyncTile*>(item->aux_);
+            mesh->BuildTileData(tile->build_.get(), tile->tileData_);
+            tile->build_.reset();
+        };
+        workQueue->AddWorkItem(tile->item_);
+        build.activeTiles_.push_back(ea::move(tile));
+    }
+
+    const bool completed = build.numFinished_ == build.tiles_.size();
+    if (numFinished || completed)
+    {
+        using namespace NavigationBuildProgress;
+        VariantMap& buildEventParams = GetContext()->GetEventDataMap();
+        buildEventParams[P_NODE] = node_;
+        buildEventParams[P_MESH] = this;
+        buildEventParams[P_TILESFINISHED] = (int)build.numFinished_;
+        buildEventParams[P_TILESTOTAL] = (int)build.tiles_.size();
+        buildEventParams[P_PROGRESS] = build.tiles_.empty() ? 1.0f : (float)build.numFinished_ / (float)build.tiles_.size();
+        SendEvent(E_NAVIGATION_BUILD_PROGRESS, buildEventParams);
+    }
+
+    // Event handlers may have cancelled the build
+    if (completed && asyncBuild_)
+    {
+        URHO3D_LOGDEBUG("Built " + ea::to_string(asyncBuild_->tiles_.size()) + " tiles of the navigation mesh asynchronously");
+        asyncBuild_.reset();
+        UnsubscribeFromEvent(E_UPDATE);
     }
-    return numTiles;
 }
 
 bool NavigationMesh::InitializeQuery()
@@ -1568,17 +2137,53 @@ bool NavigationMesh::InitializeQuery()
 
 void NavigationMesh::ReleaseNavigationMesh()
 {
+    CancelAsyncBuild();
+
     dtFreeNavMesh(navMesh_);
     navMesh_ = nullptr;
 
     dtFreeNavMeshQuery(navMeshQuery_);
     navMeshQuery_ = nullptr;
 
+    // Queued path requests are kept and searched again on the new navigation mesh
+    pathQueue_->ReleaseQueries();
+
     numTilesX_ = 0;
     numTilesZ_ = 0;
     boundingBox_.Clear();
 }
 
+void NavigationMesh::HandlePathRequestUpdate(const SceneUpdate::Data& eventData)
+{
+    ProcessPathRequests();
+}
+
+unsigned char NavigationMesh::GetNavAreaID(const Vector3& position) const
+{
+    // Walk through all NavAreas and find nearest
+    unsigned nearestNavAreaID = 0;       // 0 is the default nav area ID
+    float nearestDistance = M_LARGE_VALUE;
+    for (unsigned j = 0; j < areas_.size(); j++)
+    {
+        NavArea* area = areas_[j];
+        if (area && area->IsEnabledEffective())
+        {
+            BoundingBox bb = area->GetWorldBoundingBox();
+            if (bb.IsInside(position) == INSIDE)
+            {
+                Vector3 areaWorldCenter = area->GetNode()->GetWorldPosition();
+                float distance = (areaWorldCenter - position).LengthSquared();
+                if (distance < nearestDistance)
+                {
+                    nearestDistance = distance;
+                    nearestNavAreaID = area->GetAreaID();
+                }
+            }
+        }
+    }
+    return (unsigned char)nearestNavAreaID;
+}
+
 void NavigationMesh::SetPartitionType(NavmeshPartitionType partitionType)
 {
     partitionType_ = partitionType;
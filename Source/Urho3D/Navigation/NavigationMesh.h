@@ -23,6 +23,7 @@
 #pragma once
 
 #include <EASTL/unique_ptr.h>
+#include <functional>
 
 #include "../Math/BoundingBox.h"
 #include "../Math/Matrix3x4.h"
@@ -37,10 +38,14 @@ using dtPolyRef = unsigned int;
 class dtNavMesh;
 class dtNavMeshQuery;
 class dtQueryFilter;
+struct rcConfig;
 
 namespace Urho3D
 {
 
+namespace Update { struct Data; }
+namespace SceneUpdate { struct Data; }
+
 enum NavmeshPartitionType
 {
     NAVMESH_PARTITION_WATERSHED = 0,
@@ -52,6 +57,9 @@ class NavArea;
 
 struct FindPathData;
 struct NavBuildData;
+struct NavTileData;
+struct NavigationAsyncBuild;
+struct NavigationPathQueue;
 
 /// Description of a navigation mesh geometry component, with transform and bounds information.
 struct NavigationGeometryInfo
@@ -86,6 +94,9 @@ struct URHO3D_API NavigationPathPoint
     unsigned char areaID_;
 };
 
+/// Path request callback. Called on the main thread with the request ID and the path, which is empty if no path was found.
+using NavigationPathCallback = std::function<void(unsigned requestID, const ea::vector<NavigationPathPoint>& path)>;
+
 /// Navigation mesh component. Collects the navigation geometry from child nodes with the Navigable component and responds to path queries.
 class URHO3D_API NavigationMesh : public Component
 {
@@ -142,6 +153,12 @@ public:
     virtual bool Build(const BoundingBox& boundingBox);
     /// Rebuild part of the navigation mesh in the rectangular area. Return true if successful.
     virtual bool Build(const IntVector2& from, const IntVector2& to);
+    /// Rebuild part of the navigation mesh in the rectangular area on worker threads. Tiles are added as they finish over the following frames, and E_NAVIGATION_BUILD_PROGRESS is sent. The navigation mesh must be built or allocated first. Builds synchronously without the work queue subsystem. Return true if started.
+    bool BuildAsync(const IntVector2& from, const IntVector2& to);
+    /// Cancel the asynchronous build. Tiles added so far are kept.
+    void CancelAsyncBuild();
+    /// Return whether an asynchronous build is in progress.
+    bool IsBuildingAsync() const { return asyncBuild_ != nullptr; }
     /// Return tile data.
     virtual ea::vector<unsigned char> GetTileData(const IntVector2& tile) const;
     /// Add tile to navigation mesh.
@@ -169,6 +186,19 @@ public:
     void FindPath
         (ea::vector<NavigationPathPoint>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
             const dtQueryFilter* filter = nullptr);
+    /// Queue a path request between world space points. Requests are solved on worker threads after the scene update, and the result is delivered by the callback or by E_NAVIGATION_PATH_RESULT if there is no callback. Query filter must stay valid until the result is delivered. Return request ID.
+    unsigned RequestPath(const Vector3& start, const Vector3& end, const NavigationPathCallback& callback = nullptr,
+        const Vector3& extents = Vector3::ONE, const dtQueryFilter* filter = nullptr);
+    /// Cancel a queued path request. Its result will not be delivered.
+    void CancelPathRequest(unsigned requestID);
+    /// Solve queued path requests and deliver finished results now. Called automatically after the scene update.
+    void ProcessPathRequests();
+    /// Set maximum number of path requests to work on in one frame. 0 = all queued requests.
+    void SetMaxPathRequests(unsigned maxRequests);
+    /// Set maximum number of search iterations per path request per frame. Longer searches continue on the next frame. 0 = unlimited.
+    void SetPathSearchIterations(unsigned iterations);
+    /// Set whether to log path request throughput once per second.
+    void SetLogPathStatistics(bool enable);
     /// Return a random point on the navigation mesh.
     Vector3 GetRandomPoint(const dtQueryFilter* filter = nullptr, dtPolyRef* randomRef = nullptr);
     /// Return a random point on the navigation mesh within a circle. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -255,6 +285,21 @@ public:
     /// Return Partition Type.
     NavmeshPartitionType GetPartitionType() const { return partitionType_; }
 
+    /// Return number of queued path requests.
+    unsigned GetNumPathRequests() const;
+
+    /// Return maximum number of path requests to work on in one frame.
+    unsigned GetMaxPathRequests() const { return maxPathRequests_; }
+
+    /// Return maximum number of search iterations per path request per frame.
+    unsigned GetPathSearchIterations() const { return pathSearchIterations_; }
+
+    /// Return whether to log path request throughput.
+    bool GetLogPathStatistics() const { return logPathStatistics_; }
+
+    /// Return path requests solved per second of processing time, measured over the last second.
+    float GetPathRequestsPerSecond() const { return pathRequestsPerSecond_; }
+
     /// Set navigation data attribute.
     virtual void SetNavigationDataAttr(const ea::vector<unsigned char>& value);
     /// Return navigation data attribute.
@@ -273,6 +318,12 @@ public:
     bool GetDrawNavAreas() const { return drawNavAreas_; }
 
 private:
+    /// Handle frame update for the asynchronous build. Add finished tiles and start new ones.
+    void HandleAsyncBuildUpdate(const Update::Data& eventData);
+    /// Handle scene post-update. Process the path requests.
+    void HandlePathRequestUpdate(const SceneUpdate::Data& eventData);
+    /// Return ID of the nearest enabled NavArea containing the world space position, or 0 if none.
+    unsigned char GetNavAreaID(const Vector3& position) const;
     /// Write tile data.
     void WriteTile(Serializer& dest, int x, int z) const;
     /// Read tile data to the navigation mesh.
@@ -289,8 +340,18 @@ protected:
     void AddTriMeshGeometry(NavBuildData* build, Geometry* geometry, const Matrix3x4& transform);
     /// Build one tile of the navigation mesh. Return true if successful.
     virtual bool BuildTile(ea::vector<NavigationGeometryInfo>& geometryList, int x, int z);
-    /// Build tiles in the rectangular area. Return number of built tiles.
+    /// Build tiles in the rectangular area on worker threads and add them to the navigation mesh. Return number of built tiles.
     unsigned BuildTiles(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
+    /// Return Recast configuration for building a tile.
+    void GetTileConfig(rcConfig& cfg, const IntVector2& tile) const;
+    /// Create build data and gather the geometry of a tile. Called on the main thread, or on worker threads while the main thread waits for them.
+    ea::unique_ptr<NavBuildData> PrepareTileBuild(ea::vector<NavigationGeometryInfo>& geometryList, const IntVector2& tile);
+    /// Create empty build data.
+    virtual NavBuildData* CreateBuildData() const;
+    /// Build tile data from the gathered geometry. Does not modify the navigation mesh and may be called on worker threads.
+    virtual void BuildTileData(NavBuildData* build, NavTileData& tileData) const;
+    /// Replace the tile in the navigation mesh with the built data and send the rebuild event. Return number of tiles or layers added.
+    virtual unsigned AddTileData(NavTileData& tileData);
     /// Ensure that the navigation mesh query is initialized. Return true if successful.
     bool InitializeQuery();
     /// Release the navigation mesh and the query.
@@ -350,6 +411,18 @@ protected:
     bool drawNavAreas_;
     /// NavAreas for this NavMesh
     ea::vector<WeakPtr<NavArea> > areas_;
+    /// Asynchronous build in progress.
+    ea::unique_ptr<NavigationAsyncBuild> asyncBuild_;
+    /// Queued path requests.
+    ea::unique_ptr<NavigationPathQueue> pathQueue_;
+    /// Maximum number of path requests to work on in one frame.
+    unsigned maxPathRequests_;
+    /// Maximum number of search iterations per path request per frame.
+    unsigned pathSearchIterations_;
+    /// Path requests solved per second of processing time.
+    float pathRequestsPerSecond_;
+    /// Log path request throughput flag.
+    bool logPathStatistics_;
 };
 
 /// Register Navigation library objects.
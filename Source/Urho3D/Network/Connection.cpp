@@ -22,6 +22,8 @@
 
 #include "../Precompiled.h"
 
+#include <EASTL/sort.h>
+
 #include "Container/Utility.h"
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
@@ -74,12 +76,16 @@ PackageUpload::PackageUpload() :
 Connection::Connection(Context* context) :
     Object(context),
     timeStamp_(0),
+    lastSnapshot_(0),
     peer_(nullptr),
     sendMode_(OPSM_NONE),
     isClient_(false),
     connectPending_(false),
     sceneLoaded_(false),
     logStatistics_(false),
+    sendSnapshots_(false),
+    hasSnapshot_(false),
+    snapshotAckPending_(false),
     address_(nullptr)
 {
 }
@@ -262,6 +268,8 @@ void Connection::SendServerUpdate()
     if (!scene_ || !sceneLoaded_)
         return;
 
+    sendSnapshots_ = GetSubsystem<Network>()->GetSnapshotReplication();
+
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
     unsigned sceneID = scene_->GetID();
@@ -270,6 +278,20 @@ void Connection::SendServerUpdate()
 
     // Then go through all dirtied nodes
     nodesToProcess_.insert(sceneState_.dirtyNodes_.begin(), sceneState_.dirtyNodes_.end());
+
+    // Nodes under interest management are not in the dirty set. Add the changed ones near the observer
+    const InterestGrid& interestGrid = scene_->GetInterestGrid();
+    if (interestGrid.IsEnabled())
+    {
+        interestGrid.Query(position_, relevantNodes_);
+        for (unsigned nodeID : relevantNodes_)
+        {
+            auto i = sceneState_.nodeStates_.find(nodeID);
+            if (i != sceneState_.nodeStates_.end() && i->second.markedDirty_)
+                nodesToProcess_.insert(nodeID);
+        }
+    }
+
     nodesToProcess_.erase(sceneID); // Do not process the root node twice
 
     while (nodesToProcess_.size())
@@ -277,6 +299,9 @@ void Connection::SendServerUpdate()
         unsigned nodeID = *nodesToProcess_.begin();
         ProcessNode(nodeID);
     }
+
+    if (sendSnapshots_)
+        SendSnapshot();
 }
 
 void Connection::SendClientUpdate()
@@ -296,6 +321,14 @@ void Connection::SendClientUpdate()
         msg_.WritePackedQuaternion(rotation_);
     SendMessage(MSG_CONTROLS, false, false, msg_, CONTROLS_CONTENT_ID);
 
+    if (snapshotAckPending_)
+    {
+        msg_.Clear();
+        msg_.WriteUShort(lastSnapshot_);
+        SendMessage(MSG_SNAPSHOTACK, false, false, msg_);
+        snapshotAckPending_ = false;
+    }
+
     ++timeStamp_;
 }
 
@@ -455,9 +488,14 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& msg)
     case MSG_COMPONENTDELTAUPDATE:
     case MSG_COMPONENTLATESTDATA:
     case MSG_REMOVECOMPONENT:
+    case MSG_SNAPSHOT:
         ProcessSceneUpdate(msgID, msg);
         break;
 
+    case MSG_SNAPSHOTACK:
+        ProcessSnapshotAck(msgID, msg);
+        break;
+
     case MSG_REMOTEEVENT:
     case MSG_REMOTENODEEVENT:
         ProcessRemoteEvent(msgID, msg);
@@ -505,6 +543,17 @@ void Connection::ProcessLoadScene(int msgID, MemoryBuffer& msg)
     componentLatestData_.clear();
     downloads_.clear();
 
+    // Snapshots of the previous scene can not be used as baselines
+    for (ReceivedSnapshot& snapshot : receivedSnapshots_)
+    {
+        snapshot.state_.clear();
+        snapshot.valid_ = false;
+    }
+    appliedSnapshot_.clear();
+    pendingSnapshotTransforms_.clear();
+    hasSnapshot_ = false;
+    snapshotAckPending_ = false;
+
     // In case we have joined other scenes in this session, remove first all downloaded package files from the resource system
     // to prevent resource conflicts
     auto* cache = GetSubsystem<ResourceCache>();
@@ -571,8 +620,15 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
                 node->CreateComponent<SmoothedTransform>(LOCAL);
             }
 
-            // Read initial attributes, then snap the motion smoothing immediately to the end
+            // Read initial attributes, and apply a newer transform if a snapshot has arrived before the node.
+            // Then snap the motion smoothing immediately to the end
             node->ReadDeltaUpdate(msg);
+            auto pending = pendingSnapshotTransforms_.find(nodeID);
+            if (pending != pendingSnapshotTransforms_.end())
+            {
+                ApplySnapshotTransform(node, pending->second.first, pending->second.second);
+                pendingSnapshotTransforms_.erase(pending);
+            }
             auto* transform = node->GetComponent<SmoothedTransform>();
             if (transform)
                 transform->Update(1.0f, 0.0f);
@@ -667,6 +723,7 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             if (node)
                 node->Remove();
             nodeLatestData_.erase(nodeID);
+            pendingSnapshotTransforms_.erase(nodeID);
         }
         break;
 
@@ -747,6 +804,10 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
         }
         break;
 
+    case MSG_SNAPSHOT:
+        ProcessSnapshot(msg);
+        break;
+
     default: break;
     }
 }
@@ -1271,6 +1332,10 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             return;
     }
 
+    // Position and rotation are sent in the snapshot
+    if (sendSnapshots_ && nodeState.dirtyAttributes_.Count())
+        ClearTransformDirtyBits(node->GetNetworkAttributes(), nodeState.dirtyAttributes_);
+
     // Check if attributes have changed
     if (nodeState.dirtyAttributes_.Count() || nodeState.dirtyVars_.size())
     {
@@ -1427,6 +1492,211 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     sceneState_.dirtyNodes_.erase(node->GetID());
 }
 
+void Connection::ClearTransformDirtyBits(const ea::vector<AttributeInfo>* attributes, DirtyBits& dirtyAttributes)
+{
+    // All nodes share the attribute list of their type, so the indices are looked up by name only when the list changes
+    if (attributes != transformAttributes_)
+    {
+        transformAttributes_ = attributes;
+        transformAttributeIndices_[0] = transformAttributeIndices_[1] = M_MAX_UNSIGNED;
+        for (unsigned i = 0; i < attributes->size(); ++i)
+        {
+            const ea::string& name = attributes->at(i).name_;
+            if (name == "Network Position")
+                transformAttributeIndices_[0] = i;
+            else if (name == "Network Rotation")
+                transformAttributeIndices_[1] = i;
+        }
+    }
+
+    // Out of range indices are ignored
+    dirtyAttributes.Clear(transformAttributeIndices_[0]);
+    dirtyAttributes.Clear(transformAttributeIndices_[1]);
+}
+
+void Connection::SendSnapshot()
+{
+    URHO3D_PROFILE("SendSnapshot");
+
+    auto* network = GetSubsystem<Network>();
+    const float positionPrecision = network->GetSnapshotPositionPrecision();
+    const unsigned rotationBits = network->GetSnapshotRotationBits();
+
+    // Baselines quantized with different settings can not be used
+    if (positionPrecision != sceneState_.snapshotPositionPrecision_ || rotationBits != sceneState_.snapshotRotationBits_)
+    {
+        sceneState_.snapshotPositionPrecision_ = positionPrecision;
+        sceneState_.snapshotRotationBits_ = rotationBits;
+        sceneState_.snapshotResetSequence_ = sceneState_.snapshotSequence_ + 1;
+        sceneState_.hasSnapshotAcked_ = false;
+        for (auto& item : sceneState_.nodeStates_)
+            item.second.snapshotHistory_.Clear();
+    }
+
+    const unsigned sequence = ++sceneState_.snapshotSequence_;
+    const unsigned baselineSequence = sceneState_.snapshotAcked_;
+    const bool hasBaseline = sceneState_.hasSnapshotAcked_ && sequence - baselineSequence < SNAPSHOT_HISTORY_SIZE;
+
+    // Record what the client will have for every node after this snapshot, so that it can serve as a baseline later
+    snapshotEntries_.clear();
+    for (auto& item : sceneState_.nodeStates_)
+    {
+        NodeReplicationState& nodeState = item.second;
+        NodeSnapshotHistory& history = nodeState.snapshotHistory_;
+        const QuantizedTransform* baseline = hasBaseline ? history.Find(baselineSequence) : nullptr;
+
+        // When interest management holds the node back, it stays marked dirty. Keep sending the latest transform so that
+        // the client does not revert to the baseline
+        Node* node = nodeState.node_;
+        QuantizedTransform transform;
+        if (node && !nodeState.markedDirty_)
+            transform = network->GetSnapshotTransform(node);
+        else if (const QuantizedTransform* latest = history.GetLatest())
+            transform = *latest;
+        else
+        {
+            history.Push(sequence, baseline);
+            continue;
+        }
+
+        if (baseline && *baseline == transform)
+        {
+            history.Push(sequence, baseline);
+            continue;
+        }
+
+        SnapshotEntry entry;
+        entry.nodeID_ = item.first;
+        entry.transform_ = transform;
+        entry.hasBaseline_ = baseline != nullptr;
+        if (baseline)
+            entry.baseline_ = *baseline;
+        snapshotEntries_.push_back(entry);
+
+        history.Push(sequence, &transform);
+    }
+
+    ea::sort(snapshotEntries_.begin(), snapshotEntries_.end(),
+        [](const SnapshotEntry& lhs, const SnapshotEntry& rhs) { return lhs.nodeID_ < rhs.nodeID_; });
+
+    msg_.Clear();
+    msg_.WriteUShort(static_cast<unsigned short>(sequence));
+    msg_.WriteUByte(static_cast<unsigned char>(hasBaseline ? sequence - baselineSequence : 0));
+    msg_.WriteFloat(positionPrecision);
+    msg_.WriteUByte(static_cast<unsigned char>(rotationBits));
+    msg_.WriteVLE(snapshotEntries_.size());
+    WriteSnapshotEntries(msg_, snapshotEntries_, rotationBits);
+
+    SendMessage(MSG_SNAPSHOT, false, true, msg_);
+}
+
+void Connection::ProcessSnapshot(MemoryBuffer& msg)
+{
+    const unsigned short sequence = msg.ReadUShort();
+    const unsigned baselineOffset = msg.ReadUByte();
+    const float positionPrecision = msg.ReadFloat();
+    const unsigned rotationBits = msg.ReadUByte();
+    const unsigned numEntries = msg.ReadVLE();
+
+    if (rotationBits < MIN_SNAPSHOT_ROTATION_BITS || rotationBits > MAX_SNAPSHOT_ROTATION_BITS || positionPrecision <= 0.0f ||
+        baselineOffset >= SNAPSHOT_HISTORY_SIZE)
+    {
+        URHO3D_LOGWARNING("Received malformed snapshot");
+        return;
+    }
+
+    // Discard snapshots received out of order
+    if (hasSnapshot_ && static_cast<short>(sequence - lastSnapshot_) <= 0)
+        return;
+
+    const SnapshotState* baseline = nullptr;
+    if (baselineOffset)
+    {
+        const auto baselineSequence = static_cast<unsigned short>(sequence - baselineOffset);
+        const ReceivedSnapshot& baselineSnapshot = receivedSnapshots_[baselineSequence & (SNAPSHOT_HISTORY_SIZE - 1)];
+        if (!baselineSnapshot.valid_ || baselineSnapshot.sequence_ != baselineSequence)
+        {
+            // Server will fall back to sending full transforms once the acknowledged snapshot becomes too old
+            URHO3D_LOGDEBUG("Received snapshot with unknown baseline");
+            return;
+        }
+        baseline = &baselineSnapshot.state_;
+    }
+
+    ReceivedSnapshot& snapshot = receivedSnapshots_[sequence & (SNAPSHOT_HISTORY_SIZE - 1)];
+    snapshot.valid_ = ReadSnapshotEntries(msg.GetData() + msg.GetPosition(), msg.GetSize() - msg.GetPosition(), numEntries,
+        baseline, rotationBits, snapshot.state_);
+    if (!snapshot.valid_)
+    {
+        URHO3D_LOGWARNING("Received malformed snapshot");
+        return;
+    }
+
+    snapshot.sequence_ = sequence;
+    lastSnapshot_ = sequence;
+    hasSnapshot_ = true;
+    snapshotAckPending_ = true;
+
+    // Nodes left out of the snapshot have their baseline transforms, which may differ from the previous snapshot
+    DiffSnapshotStates(appliedSnapshot_, snapshot.state_, snapshotChanges_);
+
+    for (const auto& change : snapshotChanges_)
+    {
+        const Vector3 position = DequantizePosition(change.second, positionPrecision);
+        const Quaternion rotation = DequantizeRotation(change.second, rotationBits);
+
+        // Snapshots may be received before the reliable node creation message, so cache if necessary
+        Node* node = scene_->GetNode(change.first);
+        if (node)
+            ApplySnapshotTransform(node, position, rotation);
+        else
+            pendingSnapshotTransforms_[change.first] = ea::make_pair(position, rotation);
+    }
+
+    // Transforms of removed nodes would be carried over from the baseline by every later snapshot. Drop them, but keep the
+    // nodes whose creation message has not arrived yet
+    SnapshotState& state = snapshot.state_;
+    state.erase(ea::remove_if(state.begin(), state.end(), [this](const ea::pair<unsigned, QuantizedTransform>& item)
+        { return !scene_->GetNode(item.first) && !pendingSnapshotTransforms_.count(item.first); }), state.end());
+    appliedSnapshot_ = state;
+}
+
+void Connection::ProcessSnapshotAck(int msgID, MemoryBuffer& msg)
+{
+    if (!IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected SnapshotAck message from server");
+        return;
+    }
+
+    if (sceneState_.snapshotSequence_ < sceneState_.snapshotResetSequence_)
+        return;
+
+    // Expand the 16-bit sequence number relative to the latest sent snapshot
+    const unsigned age = static_cast<unsigned short>(static_cast<unsigned short>(sceneState_.snapshotSequence_) - msg.ReadUShort());
+    if (age > sceneState_.snapshotSequence_ - sceneState_.snapshotResetSequence_)
+        return;
+
+    const unsigned acked = sceneState_.snapshotSequence_ - age;
+    if (!sceneState_.hasSnapshotAcked_ || acked > sceneState_.snapshotAcked_)
+    {
+        sceneState_.snapshotAcked_ = acked;
+        sceneState_.hasSnapshotAcked_ = true;
+    }
+}
+
+void Connection::ApplySnapshotTransform(Node* node, const Vector3& position, const Quaternion& rotation)
+{
+    auto* transform = node->GetComponent<SmoothedTransform>();
+    if (transform)
+    {
+        transform->SetTargetPosition(position);
+        transform->SetTargetRotation(rotation);
+    }
+    else
+        node->SetTransform(position, rotation);
+}
+
 bool Connection::RequestNeededPackages(unsigned numPackages, MemoryBuffer& msg)
 {
     auto* cache = GetSubsystem<ResourceCache>();
@@ -28,6 +28,7 @@
 #include "../Core/Timer.h"
 #include "../Input/Controls.h"
 #include "../IO/VectorBuffer.h"
+#include "../Network/Snapshot.h"
 #include "../Scene/ReplicationState.h"
 
 namespace SLNet
@@ -97,6 +98,17 @@ struct PackageUpload
     unsigned totalFragments_;
 };
 
+/// Node transform snapshot received by the client.
+struct ReceivedSnapshot
+{
+    /// Node transforms after the snapshot.
+    SnapshotState state_;
+    /// Sequence number.
+    unsigned short sequence_{};
+    /// Whether the snapshot was received and decoded successfully.
+    bool valid_{};
+};
+
 /// Send modes for observer position/rotation. Activated by the client setting either position or rotation.
 enum ObserverPositionSendMode
 {
@@ -251,6 +263,12 @@ private:
     void ProcessSceneChecksumError(int msgID, MemoryBuffer& msg);
     /// Process a scene update message from the server. Called by Network.
     void ProcessSceneUpdate(int msgID, MemoryBuffer& msg);
+    /// Process a node transform snapshot from the server.
+    void ProcessSnapshot(MemoryBuffer& msg);
+    /// Process a snapshot acknowledgement from the client. Called by Network.
+    void ProcessSnapshotAck(int msgID, MemoryBuffer& msg);
+    /// Apply transform received in a snapshot to a node.
+    void ApplySnapshotTransform(Node* node, const Vector3& position, const Quaternion& rotation);
     /// Process package download related messages. Called by Network.
     void ProcessPackageDownload(int msgID, MemoryBuffer& msg);
     /// Process an Identity message from the client. Called by Network.
@@ -267,6 +285,10 @@ private:
     void ProcessNewNode(Node* node);
     /// Process a node that the client has already received.
     void ProcessExistingNode(Node* node, NodeReplicationState& nodeState);
+    /// Clear dirty bits of the node transform attributes, which are replicated in snapshots instead.
+    void ClearTransformDirtyBits(const ea::vector<AttributeInfo>* attributes, DirtyBits& dirtyAttributes);
+    /// Send transforms of the replicated nodes as a snapshot delta-compressed against the last acknowledged one.
+    void SendSnapshot();
     /// Process a SyncPackagesInfo message from server.
     void ProcessPackageInfo(int msgID, MemoryBuffer& msg);
     /// Check a package list received from server and initiate package downloads as necessary. Return true on success, or false if failed to initialze downloads (cache dir not set)
@@ -296,6 +318,24 @@ private:
     ea::unordered_map<unsigned, ea::vector<unsigned char> > componentLatestData_;
     /// Node ID's to process during a replication update.
     ea::hash_set<unsigned> nodesToProcess_;
+    /// Reusable list of nodes found through the interest grid.
+    ea::vector<unsigned> relevantNodes_;
+    /// Reusable list of node transforms to send in a snapshot.
+    ea::vector<SnapshotEntry> snapshotEntries_;
+    /// Network attribute list whose transform attribute indices are cached.
+    const ea::vector<AttributeInfo>* transformAttributes_{};
+    /// Indices of the network position and rotation attributes in the cached attribute list. M_MAX_UNSIGNED if not found.
+    unsigned transformAttributeIndices_[2]{};
+    /// Recently received snapshots, indexed by sequence number.
+    ReceivedSnapshot receivedSnapshots_[SNAPSHOT_HISTORY_SIZE];
+    /// Node transforms after the latest received snapshot.
+    SnapshotState appliedSnapshot_;
+    /// Reusable list of node transforms changed by a received snapshot.
+    SnapshotState snapshotChanges_;
+    /// Snapshot transforms for not yet received nodes.
+    ea::unordered_map<unsigned, ea::pair<Vector3, Quaternion> > pendingSnapshotTransforms_;
+    /// Sequence number of the latest received snapshot.
+    unsigned short lastSnapshot_;
     /// Reusable message buffer.
     VectorBuffer msg_;
     /// Queued remote events.
@@ -320,6 +360,12 @@ private:
     bool sceneLoaded_;
     /// Show statistics flag.
     bool logStatistics_;
+    /// Whether node transforms are sent as snapshots during the current server update.
+    bool sendSnapshots_;
+    /// Whether any snapshot has been received in the current scene.
+    bool hasSnapshot_;
+    /// Whether the latest received snapshot should be acknowledged.
+    bool snapshotAckPending_;
     /// Address of this connection.
     SLNet::AddressOrGUID* address_;
     /// Raknet peer object.
@@ -200,6 +200,10 @@ Network::Network(Context* context) :
     simulatedPacketLoss_(0.0f),
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
     updateAcc_(0.0f),
+    snapshotPositionPrecision_(DEFAULT_SNAPSHOT_POSITION_PRECISION),
+    snapshotRotationBits_(DEFAULT_SNAPSHOT_ROTATION_BITS),
+    serverUpdateTime_(0),
+    snapshotReplication_(false),
     isServer_(false),
     scene_(nullptr),
     natPunchServerAddress_(nullptr),
@@ -220,7 +224,7 @@ Network::Network(Context* context) :
     RegisterNetworkLibrary(context_);
 
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(Network, HandleBeginFrame));
-    SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Network, HandleRenderUpdate));
+    SubscribeToEvent(E_RENDERUPDATE, &Network::HandleRenderUpdate);
 
     // Blacklist remote events which are not to be allowed to be registered in any case
     blacklistedRemoteEvents_.insert(E_CONSOLECOMMAND);
@@ -597,6 +601,32 @@ void Network::SetSimulatedPacketLoss(float probability)
     ConfigureNetworkSimulator();
 }
 
+void Network::SetSnapshotReplication(bool enable)
+{
+    snapshotReplication_ = enable;
+}
+
+void Network::SetSnapshotPositionPrecision(float precision)
+{
+    snapshotPositionPrecision_ = Max(precision, M_EPSILON);
+}
+
+void Network::SetSnapshotRotationBits(unsigned bits)
+{
+    snapshotRotationBits_ = Clamp(bits, MIN_SNAPSHOT_ROTATION_BITS, MAX_SNAPSHOT_ROTATION_BITS);
+}
+
+const QuantizedTransform& Network::GetSnapshotTransform(Node* node)
+{
+    auto result = snapshotTransforms_.insert(node);
+    if (result.second)
+    {
+        result.first->second = QuantizeTransform(node->GetPosition(), node->GetRotation(), snapshotPositionPrecision_,
+            snapshotRotationBits_);
+    }
+    return result.first->second;
+}
+
 void Network::RegisterRemoteEvent(StringHash eventType)
 {
     if (blacklistedRemoteEvents_.find(eventType) != blacklistedRemoteEvents_.end())
@@ -929,6 +959,8 @@ void Network::PostUpdate(float timeStep)
 
         if (IsServerRunning())
         {
+            HiresTimer serverUpdateTimer;
+
             // Collect and prepare all networked scenes
             {
                 URHO3D_PROFILE("PrepareServerUpdate");
@@ -948,6 +980,9 @@ void Network::PostUpdate(float timeStep)
             {
                 URHO3D_PROFILE("SendServerUpdate");
 
+                // Nodes may have moved since the last update, so quantize their transforms again
+                snapshotTransforms_.clear();
+
                 // Then send server updates for each client connection
                 for (auto i = clientConnections_.begin(); i != clientConnections_.end(); ++i)
                 {
@@ -956,6 +991,8 @@ void Network::PostUpdate(float timeStep)
                     i->second->SendPackages();
                 }
             }
+
+            serverUpdateTime_ = serverUpdateTimer.GetUSec(false);
         }
 
         if (serverConnection_)
@@ -977,11 +1014,9 @@ void Network::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
     Update(eventData[P_TIMESTEP].GetFloat());
 }
 
-void Network::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Network::HandleRenderUpdate(const Update::Data& eventData)
 {
-    using namespace RenderUpdate;
-
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(eventData.timeStep_);
 }
 
 void Network::OnServerConnected(const SLNet::AddressOrGUID& address)
@@ -31,6 +31,7 @@
 namespace Urho3D
 {
 
+namespace Update { struct Data; }
 class HttpRequest;
 class MemoryBuffer;
 class Scene;
@@ -91,6 +92,12 @@ public:
     void SetSimulatedLatency(int ms);
     /// Set simulated packet loss probability between 0.0 - 1.0.
     void SetSimulatedPacketLoss(float probability);
+    /// Set whether the server replicates node positions and rotations as quantized, delta-compressed snapshots instead of latest data attribute updates. Default false.
+    void SetSnapshotReplication(bool enable);
+    /// Set snapshot position precision in world units. Default 0.001.
+    void SetSnapshotPositionPrecision(float precision);
+    /// Set number of bits per quantized snapshot rotation component, between 6 and 16. Default 12.
+    void SetSnapshotRotationBits(unsigned bits);
     /// Register a remote event as allowed to be received. There is also a fixed blacklist of events that can not be allowed in any case, such as ConsoleCommand.
     void RegisterRemoteEvent(StringHash eventType);
     /// Unregister a remote event as allowed to received.
@@ -114,6 +121,20 @@ public:
     /// Return simulated packet loss probability.
     float GetSimulatedPacketLoss() const { return simulatedPacketLoss_; }
 
+    /// Return whether node transforms are replicated as snapshots.
+    bool GetSnapshotReplication() const { return snapshotReplication_; }
+
+    /// Return snapshot position precision in world units.
+    float GetSnapshotPositionPrecision() const { return snapshotPositionPrecision_; }
+
+    /// Return number of bits per quantized snapshot rotation component.
+    unsigned GetSnapshotRotationBits() const { return snapshotRotationBits_; }
+    /// Return node transform quantized for the snapshots of the current network update. Quantized once per update and shared by all client connections.
+    const QuantizedTransform& GetSnapshotTransform(Node* node);
+
+    /// Return microseconds spent in the last server update, including scene preparation and interest management.
+    long long GetServerUpdateTime() const { return serverUpdateTime_; }
+
     /// Return a client or server connection by RakNet connection address, or null if none exist.
     Connection* GetConnection(const SLNet::AddressOrGUID& connection) const;
     /// Return the connection to the server. Null if not connected.
@@ -137,7 +158,7 @@ private:
     /// Handle begin frame event.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     /// Handle render update frame event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const Update::Data& eventData);
     /// Handle server connection.
     void OnServerConnected(const SLNet::AddressOrGUID& address);
     /// Handle server disconnection.
@@ -173,6 +194,16 @@ private:
     float updateInterval_;
     /// Update time accumulator.
     float updateAcc_;
+    /// Snapshot position precision.
+    float snapshotPositionPrecision_;
+    /// Snapshot rotation component bits.
+    unsigned snapshotRotationBits_;
+    /// Node transforms quantized during the current network update.
+    ea::unordered_map<Node*, QuantizedTransform> snapshotTransforms_;
+    /// Microseconds spent in the last server update.
+    long long serverUpdateTime_;
+    /// Snapshot replication flag.
+    bool snapshotReplication_;
     /// Package cache directory.
     ea::string packageCacheDir_;
     /// Whether we started as server or not.
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Network/NetworkPriority.h"
+#include "../Scene/Scene.h"
 
 #include "../DebugNew.h"
 
@@ -37,16 +38,29 @@ static const float DEFAULT_DISTANCE_FACTOR = 0.0f;
 static const float DEFAULT_MIN_PRIORITY = 0.0f;
 static const float UPDATE_THRESHOLD = 100.0f;
 
+static const char* interestModeNames[] =
+{
+    "Always",
+    "Distance",
+    "Owner",
+    nullptr
+};
+
 NetworkPriority::NetworkPriority(Context* context) :
     Component(context),
     basePriority_(DEFAULT_BASE_PRIORITY),
     distanceFactor_(DEFAULT_DISTANCE_FACTOR),
     minPriority_(DEFAULT_MIN_PRIORITY),
-    alwaysUpdateOwner_(true)
+    alwaysUpdateOwner_(true),
+    interestMode_(INTEREST_DISTANCE),
+    interestNodeID_(0)
 {
 }
 
-NetworkPriority::~NetworkPriority() = default;
+NetworkPriority::~NetworkPriority()
+{
+    UpdateInterestGrid(nullptr);
+}
 
 void NetworkPriority::RegisterObject(Context* context)
 {
@@ -56,6 +70,7 @@ void NetworkPriority::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Distance Factor", float, distanceFactor_, DEFAULT_DISTANCE_FACTOR, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Minimum Priority", float, minPriority_, DEFAULT_MIN_PRIORITY, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Always Update Owner", bool, alwaysUpdateOwner_, true, AM_DEFAULT);
+    URHO3D_ENUM_ACCESSOR_ATTRIBUTE("Interest Mode", GetInterestMode, SetInterestMode, InterestMode, interestModeNames, INTEREST_DISTANCE, AM_DEFAULT);
 }
 
 void NetworkPriority::SetBasePriority(float priority)
@@ -82,6 +97,13 @@ void NetworkPriority::SetAlwaysUpdateOwner(bool enable)
     MarkNetworkUpdate();
 }
 
+void NetworkPriority::SetInterestMode(InterestMode mode)
+{
+    interestMode_ = mode;
+    UpdateInterestGrid(GetScene());
+    MarkNetworkUpdate();
+}
+
 bool NetworkPriority::CheckUpdate(float distance, float& accumulator)
 {
     float currentPriority = Max(basePriority_ - distanceFactor_ * distance, minPriority_);
@@ -95,4 +117,40 @@ bool NetworkPriority::CheckUpdate(float distance, float& accumulator)
         return false;
 }
 
+void NetworkPriority::OnNodeSet(Node* node)
+{
+    if (node)
+        node->AddListener(this);
+}
+
+void NetworkPriority::OnSceneSet(Scene* scene)
+{
+    UpdateInterestGrid(scene);
+}
+
+void NetworkPriority::OnMarkedDirty(Node* node)
+{
+    if (interestScene_ && node == node_)
+        interestScene_->GetInterestGrid().MarkDirty(interestNodeID_);
+}
+
+void NetworkPriority::UpdateInterestGrid(Scene* scene)
+{
+    // The node may already have lost its ID when removed from the scene, so remove with the ID it was added with
+    if (interestScene_)
+        interestScene_->GetInterestGrid().RemoveNode(interestNodeID_);
+
+    if (scene && node_ && node_->IsReplicated())
+    {
+        interestScene_ = scene;
+        interestNodeID_ = node_->GetID();
+        scene->GetInterestGrid().SetNode(interestNodeID_, interestMode_);
+    }
+    else
+    {
+        interestScene_.Reset();
+        interestNodeID_ = 0;
+    }
+}
+
 }
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Scene/Component.h"
+#include "../Scene/InterestGrid.h"
 
 namespace Urho3D
 {
@@ -48,6 +49,8 @@ public:
     void SetMinPriority(float priority);
     /// Set whether updates to owner should be sent always at full rate. Default true.
     void SetAlwaysUpdateOwner(bool enable);
+    /// Set interest mode used when the scene's interest grid is enabled. Default distance.
+    void SetInterestMode(InterestMode mode);
 
     /// Return base priority.
     float GetBasePriority() const { return basePriority_; }
@@ -61,10 +64,24 @@ public:
     /// Return whether updates to owner should be sent always at full rate.
     bool GetAlwaysUpdateOwner() const { return alwaysUpdateOwner_; }
 
+    /// Return interest mode.
+    InterestMode GetInterestMode() const { return interestMode_; }
+
     /// Increment and check priority accumulator. Return true if should update. Called by Connection.
     bool CheckUpdate(float distance, float& accumulator);
 
+protected:
+    /// Handle scene node being assigned at creation.
+    void OnNodeSet(Node* node) override;
+    /// Handle scene being assigned.
+    void OnSceneSet(Scene* scene) override;
+    /// Handle scene node transform dirtied.
+    void OnMarkedDirty(Node* node) override;
+
 private:
+    /// Add node to the interest grid of the scene, or remove from the previous one.
+    void UpdateInterestGrid(Scene* scene);
+
     /// Base priority.
     float basePriority_;
     /// Priority reduction distance factor.
@@ -73,6 +90,12 @@ private:
     float minPriority_;
     /// Update owner at full rate flag.
     bool alwaysUpdateOwner_;
+    /// Interest mode.
+    InterestMode interestMode_;
+    /// Scene whose interest grid the node was added to.
+    WeakPtr<Scene> interestScene_;
+    /// ID the node was added to the interest grid with.
+    unsigned interestNodeID_;
 };
 
 }
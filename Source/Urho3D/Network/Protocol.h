@@ -63,6 +63,10 @@ static const int MSG_REMOTEEVENT = 0x96;
 static const int MSG_REMOTENODEEVENT = 0x97;
 /// Server->client: info about package.
 static const int MSG_PACKAGEINFO = 0x98;
+/// Server->client: quantized and delta-compressed node transform snapshot.
+static const int MSG_SNAPSHOT = 0x99;
+/// Client->server: latest received snapshot.
+static const int MSG_SNAPSHOTACK = 0x9A;
 
 /// Fixed content ID for client controls update.
 static const unsigned CONTROLS_CONTENT_ID = 1;
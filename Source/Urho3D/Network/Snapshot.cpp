@@ -0,0 +1,410 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../IO/Serializer.h"
+#include "../Network/Snapshot.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Largest quantized position magnitude. Keeps deltas within 32 bits.
+static const int MAX_QUANTIZED_POSITION = 0x3fffffff;
+/// Bits used to store the bit width of position deltas.
+static const unsigned POSITION_WIDTH_BITS = 6;
+/// Bits used to store the bit width of rotation deltas.
+static const unsigned ROTATION_WIDTH_BITS = 5;
+/// Bits used to store the bit width of node ID deltas.
+static const unsigned NODE_ID_WIDTH_BITS = 5;
+/// Largest magnitude of the three smallest components of a normalized quaternion.
+static const float MAX_SMALLEST_COMPONENT = 0.70710678f;
+
+/// Packs values of arbitrary bit width into bytes.
+class BitWriter
+{
+public:
+    /// Write the lowest bits of a value.
+    void Write(unsigned value, unsigned numBits)
+    {
+        if (!numBits)
+            return;
+        if (numBits < 32)
+            value &= (1u << numBits) - 1;
+        accumulator_ |= static_cast<unsigned long long>(value) << numAccumulated_;
+        numAccumulated_ += numBits;
+        while (numAccumulated_ >= 8)
+        {
+            data_.push_back(static_cast<unsigned char>(accumulator_));
+            accumulator_ >>= 8;
+            numAccumulated_ -= 8;
+        }
+    }
+
+    /// Write a single bit.
+    void WriteBit(bool value) { Write(value ? 1u : 0u, 1); }
+
+    /// Write the pending bits and return packed data.
+    const ea::vector<unsigned char>& Finish()
+    {
+        if (numAccumulated_)
+        {
+            data_.push_back(static_cast<unsigned char>(accumulator_));
+            accumulator_ = 0;
+            numAccumulated_ = 0;
+        }
+        return data_;
+    }
+
+private:
+    /// Packed bytes.
+    ea::vector<unsigned char> data_;
+    /// Bits not yet written to bytes.
+    unsigned long long accumulator_{};
+    /// Number of bits in the accumulator.
+    unsigned numAccumulated_{};
+};
+
+/// Unpacks values of arbitrary bit width from bytes.
+class BitReader
+{
+public:
+    /// Construct.
+    BitReader(const unsigned char* data, unsigned size) :
+        data_(data),
+        size_(size)
+    {
+    }
+
+    /// Read a value of the specified bit width.
+    unsigned Read(unsigned numBits)
+    {
+        if (!numBits)
+            return 0;
+        while (numAccumulated_ < numBits)
+        {
+            if (position_ >= size_)
+            {
+                overrun_ = true;
+                return 0;
+            }
+            accumulator_ |= static_cast<unsigned long long>(data_[position_++]) << numAccumulated_;
+            numAccumulated_ += 8;
+        }
+        const auto value = static_cast<unsigned>(accumulator_ & ((1ull << numBits) - 1));
+        accumulator_ >>= numBits;
+        numAccumulated_ -= numBits;
+        return value;
+    }
+
+    /// Read a single bit.
+    bool ReadBit() { return Read(1) != 0; }
+
+    /// Return whether tried to read past the end of data.
+    bool IsOverrun() const { return overrun_; }
+
+private:
+    /// Packed bytes.
+    const unsigned char* data_;
+    /// Number of packed bytes.
+    unsigned size_;
+    /// Next byte to read.
+    unsigned position_{};
+    /// Bits read from bytes but not yet returned.
+    unsigned long long accumulator_{};
+    /// Number of bits in the accumulator.
+    unsigned numAccumulated_{};
+    /// Overrun flag.
+    bool overrun_{};
+};
+
+/// Return the quantized value of the largest smaller rotation component. Even, so that a zero component is exactly in the middle of the range.
+static float GetMaxRotationValue(unsigned rotationBits)
+{
+    return static_cast<float>((1u << rotationBits) - 2);
+}
+
+/// Map signed value to unsigned so that small magnitudes stay small.
+static unsigned ZigZagEncode(int value)
+{
+    return (static_cast<unsigned>(value) << 1u) ^ static_cast<unsigned>(value >> 31);
+}
+
+/// Map zigzag-encoded value back to signed.
+static int ZigZagDecode(unsigned value)
+{
+    return static_cast<int>(value >> 1u) ^ -static_cast<int>(value & 1u);
+}
+
+/// Return number of bits needed to store the value.
+static unsigned GetNumBits(unsigned value)
+{
+    unsigned numBits = 0;
+    while (value)
+    {
+        ++numBits;
+        value >>= 1u;
+    }
+    return numBits;
+}
+
+/// Write signed deltas with a shared bit width.
+template <class T> static void WriteDeltas(BitWriter& writer, const T* values, const T* baseline, unsigned widthBits)
+{
+    unsigned encoded[3];
+    unsigned numBits = 0;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        encoded[i] = ZigZagEncode(static_cast<int>(values[i]) - (baseline ? static_cast<int>(baseline[i]) : 0));
+        numBits = Max(numBits, GetNumBits(encoded[i]));
+    }
+
+    writer.Write(numBits, widthBits);
+    for (unsigned i = 0; i < 3; ++i)
+        writer.Write(encoded[i], numBits);
+}
+
+/// Read signed deltas with a shared bit width.
+template <class T> static void ReadDeltas(BitReader& reader, T* values, const T* baseline, unsigned widthBits)
+{
+    const unsigned numBits = reader.Read(widthBits);
+    for (unsigned i = 0; i < 3; ++i)
+        values[i] = static_cast<T>(ZigZagDecode(reader.Read(numBits)) + (baseline ? static_cast<int>(baseline[i]) : 0));
+}
+
+QuantizedTransform QuantizeTransform(const Vector3& position, const Quaternion& rotation, float positionPrecision, unsigned rotationBits)
+{
+    QuantizedTransform result;
+
+    // Clamp in double precision, as the limit is not representable as a float and would round up past it
+    const double invPrecision = 1.0 / positionPrecision;
+    const double limit = MAX_QUANTIZED_POSITION;
+    result.position_[0] = RoundToInt(Clamp(position.x_ * invPrecision, -limit, limit));
+    result.position_[1] = RoundToInt(Clamp(position.y_ * invPrecision, -limit, limit));
+    result.position_[2] = RoundToInt(Clamp(position.z_ * invPrecision, -limit, limit));
+
+    // Smallest three encoding: omit the largest component and make it positive so that it can be reconstructed
+    const Quaternion normalized = rotation.Normalized();
+    const float components[4] = { normalized.w_, normalized.x_, normalized.y_, normalized.z_ };
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+
+    const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    const float maxValue = GetMaxRotationValue(rotationBits);
+    unsigned index = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        // The smaller components are within [-1/sqrt(2), 1/sqrt(2)]
+        const float normalizedComponent = Clamp((components[i] * sign / MAX_SMALLEST_COMPONENT + 1.0f) * 0.5f, 0.0f, 1.0f);
+        result.rotation_[index++] = static_cast<unsigned short>(RoundToInt(normalizedComponent * maxValue));
+    }
+    result.rotationLargest_ = static_cast<unsigned char>(largest);
+
+    return result;
+}
+
+Vector3 DequantizePosition(const QuantizedTransform& transform, float positionPrecision)
+{
+    return Vector3(static_cast<float>(transform.position_[0]), static_cast<float>(transform.position_[1]),
+        static_cast<float>(transform.position_[2])) * positionPrecision;
+}
+
+Quaternion DequantizeRotation(const QuantizedTransform& transform, unsigned rotationBits)
+{
+    const float maxValue = GetMaxRotationValue(rotationBits);
+    const float invMaxValue = 1.0f / maxValue;
+    float components[4];
+    float sumSquares = 0.0f;
+    unsigned index = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i == transform.rotationLargest_)
+            continue;
+        components[i] = (transform.rotation_[index++] * 2.0f - maxValue) * invMaxValue * MAX_SMALLEST_COMPONENT;
+        sumSquares += components[i] * components[i];
+    }
+
+    // The reconstructed rotation is already normalized, unless rounding pushed the smaller components past unit length.
+    // Avoid Quaternion::Normalized() otherwise, as its SSE path is approximate and would add error to exact rotations
+    if (sumSquares > 1.0f)
+    {
+        const float invLength = 1.0f / sqrtf(sumSquares);
+        for (unsigned i = 0; i < 4; ++i)
+            components[i] *= invLength;
+        components[transform.rotationLargest_] = 0.0f;
+    }
+    else
+        components[transform.rotationLargest_] = sqrtf(1.0f - sumSquares);
+
+    return Quaternion(components[0], components[1], components[2], components[3]);
+}
+
+void WriteSnapshotEntries(Serializer& dest, const ea::vector<SnapshotEntry>& entries, unsigned rotationBits)
+{
+    BitWriter writer;
+    unsigned previousID = 0;
+
+    for (const SnapshotEntry& entry : entries)
+    {
+        const unsigned idDelta = entry.nodeID_ - previousID;
+        const unsigned idBits = GetNumBits(idDelta);
+        writer.Write(idBits, NODE_ID_WIDTH_BITS);
+        writer.Write(idDelta, idBits);
+        previousID = entry.nodeID_;
+
+        const QuantizedTransform& value = entry.transform_;
+        const QuantizedTransform* baseline = entry.hasBaseline_ ? &entry.baseline_ : nullptr;
+        writer.WriteBit(baseline != nullptr);
+
+        if (!baseline)
+        {
+            WriteDeltas(writer, value.position_, static_cast<const int*>(nullptr), POSITION_WIDTH_BITS);
+            writer.Write(value.rotationLargest_, 2);
+            for (unsigned i = 0; i < 3; ++i)
+                writer.Write(value.rotation_[i], rotationBits);
+            continue;
+        }
+
+        const bool positionChanged = memcmp(value.position_, baseline->position_, sizeof value.position_) != 0;
+        const bool rotationChanged = value.rotationLargest_ != baseline->rotationLargest_ ||
+            memcmp(value.rotation_, baseline->rotation_, sizeof value.rotation_) != 0;
+        writer.WriteBit(positionChanged);
+        writer.WriteBit(rotationChanged);
+
+        if (positionChanged)
+            WriteDeltas(writer, value.position_, baseline->position_, POSITION_WIDTH_BITS);
+
+        if (rotationChanged)
+        {
+            const bool sameLargest = value.rotationLargest_ == baseline->rotationLargest_;
+            writer.WriteBit(sameLargest);
+            if (sameLargest)
+                WriteDeltas(writer, value.rotation_, baseline->rotation_, ROTATION_WIDTH_BITS);
+            else
+            {
+                writer.Write(value.rotationLargest_, 2);
+                for (unsigned i = 0; i < 3; ++i)
+                    writer.Write(value.rotation_[i], rotationBits);
+            }
+        }
+    }
+
+    const ea::vector<unsigned char>& data = writer.Finish();
+    if (!data.empty())
+        dest.Write(data.data(), data.size());
+}
+
+bool ReadSnapshotEntries(const unsigned char* data, unsigned size, unsigned numEntries, const SnapshotState* baseline,
+    unsigned rotationBits, SnapshotState& state)
+{
+    BitReader reader(data, size);
+    state.clear();
+
+    unsigned nodeID = 0;
+    unsigned baselineIndex = 0;
+    const unsigned baselineSize = baseline ? baseline->size() : 0;
+
+    for (unsigned i = 0; i < numEntries; ++i)
+    {
+        const unsigned idDelta = reader.Read(reader.Read(NODE_ID_WIDTH_BITS));
+        if (!idDelta)
+            return false;
+        nodeID += idDelta;
+
+        // Carry over unchanged transforms of the baseline
+        while (baselineIndex < baselineSize && (*baseline)[baselineIndex].first < nodeID)
+            state.push_back((*baseline)[baselineIndex++]);
+
+        const QuantizedTransform* previous = nullptr;
+        if (baselineIndex < baselineSize && (*baseline)[baselineIndex].first == nodeID)
+            previous = &(*baseline)[baselineIndex++].second;
+
+        QuantizedTransform value;
+        if (!reader.ReadBit())
+        {
+            ReadDeltas(reader, value.position_, static_cast<const int*>(nullptr), POSITION_WIDTH_BITS);
+            value.rotationLargest_ = static_cast<unsigned char>(reader.Read(2));
+            for (unsigned j = 0; j < 3; ++j)
+                value.rotation_[j] = static_cast<unsigned short>(reader.Read(rotationBits));
+        }
+        else
+        {
+            if (!previous)
+                return false;
+
+            value = *previous;
+            const bool positionChanged = reader.ReadBit();
+            const bool rotationChanged = reader.ReadBit();
+
+            if (positionChanged)
+                ReadDeltas(reader, value.position_, previous->position_, POSITION_WIDTH_BITS);
+
+            if (rotationChanged)
+            {
+                if (reader.ReadBit())
+                    ReadDeltas(reader, value.rotation_, previous->rotation_, ROTATION_WIDTH_BITS);
+                else
+                {
+                    value.rotationLargest_ = static_cast<unsigned char>(reader.Read(2));
+                    for (unsigned j = 0; j < 3; ++j)
+                        value.rotation_[j] = static_cast<unsigned short>(reader.Read(rotationBits));
+                }
+            }
+        }
+
+        if (reader.IsOverrun())
+            return false;
+
+        state.emplace_back(nodeID, value);
+    }
+
+    while (baselineIndex < baselineSize)
+        state.push_back((*baseline)[baselineIndex++]);
+
+    return true;
+}
+
+void DiffSnapshotStates(const SnapshotState& previous, const SnapshotState& current, SnapshotState& changes)
+{
+    changes.clear();
+
+    auto previousIter = previous.begin();
+    for (const auto& item : current)
+    {
+        while (previousIter != previous.end() && previousIter->first < item.first)
+            ++previousIter;
+
+        if (previousIter == previous.end() || previousIter->first != item.first || previousIter->second != item.second)
+            changes.push_back(item);
+    }
+}
+
+}
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Math/Quaternion.h"
+#include "../Scene/ReplicationState.h"
+
+namespace Urho3D
+{
+
+class Serializer;
+
+/// Default snapshot replication position precision in world units.
+static const float DEFAULT_SNAPSHOT_POSITION_PRECISION = 0.001f;
+/// Default number of bits per quantized snapshot rotation component.
+static const unsigned DEFAULT_SNAPSHOT_ROTATION_BITS = 12;
+/// Minimum number of bits per quantized snapshot rotation component.
+static const unsigned MIN_SNAPSHOT_ROTATION_BITS = 6;
+/// Maximum number of bits per quantized snapshot rotation component.
+static const unsigned MAX_SNAPSHOT_ROTATION_BITS = 16;
+/// Number of received snapshots the client keeps as delta compression baselines. Must be a power of two.
+static const unsigned SNAPSHOT_HISTORY_SIZE = 32;
+static_assert(SNAPSHOT_NODE_HISTORY_SIZE >= SNAPSHOT_HISTORY_SIZE, "Node snapshot history must cover the snapshot history");
+
+/// Node transforms the client has after a snapshot, sorted by node ID.
+using SnapshotState = ea::vector<ea::pair<unsigned, QuantizedTransform> >;
+
+/// Node transform to be written into a snapshot.
+struct SnapshotEntry
+{
+    /// Node ID.
+    unsigned nodeID_;
+    /// Current transform.
+    QuantizedTransform transform_;
+    /// Transform the client has in the baseline snapshot.
+    QuantizedTransform baseline_;
+    /// Whether to delta-encode against the baseline transform. Otherwise the transform is sent in full.
+    bool hasBaseline_;
+};
+
+/// Quantize node transform for snapshot replication.
+URHO3D_API QuantizedTransform QuantizeTransform(const Vector3& position, const Quaternion& rotation, float positionPrecision, unsigned rotationBits);
+/// Return position of a quantized transform.
+URHO3D_API Vector3 DequantizePosition(const QuantizedTransform& transform, float positionPrecision);
+/// Return rotation of a quantized transform.
+URHO3D_API Quaternion DequantizeRotation(const QuantizedTransform& transform, unsigned rotationBits);
+/// Bit-pack snapshot entries sorted by node ID, delta-encoding them against their baselines.
+URHO3D_API void WriteSnapshotEntries(Serializer& dest, const ea::vector<SnapshotEntry>& entries, unsigned rotationBits);
+/// Read bit-packed snapshot entries and merge them into the baseline state. Return false if the data is malformed or refers to transforms missing from the baseline.
+URHO3D_API bool ReadSnapshotEntries(const unsigned char* data, unsigned size, unsigned numEntries, const SnapshotState* baseline,
+    unsigned rotationBits, SnapshotState& state);
+/// Return transforms of the current state which are new or different from the previous state.
+URHO3D_API void DiffSnapshotStates(const SnapshotState& previous, const SnapshotState& current, SnapshotState& changes);
+
+}
@@ -27,11 +27,31 @@
 namespace Urho3D
 {
 
+class Component;
+class Node;
+class RigidBody;
+
 /// Physics world is about to be stepped.
 URHO3D_EVENT(E_PHYSICSPRESTEP, PhysicsPreStep)
 {
     URHO3D_PARAM(P_WORLD, World);                  // PhysicsWorld pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+
+    /// Typed payload, shared by the pre-step and post-step events.
+    struct Data
+    {
+        /// PhysicsWorld or PhysicsWorld2D.
+        Component* world_{};
+        /// Fixed timestep in seconds.
+        float timeStep_{};
+
+        /// List members for conversion from and to event parameters.
+        template <class Visitor> void Visit(Visitor& visitor)
+        {
+            visitor(P_WORLD, world_);
+            visitor(P_TIMESTEP, timeStep_);
+        }
+    };
 }
 
 /// Physics world has been stepped.
@@ -39,6 +59,7 @@ URHO3D_EVENT(E_PHYSICSPOSTSTEP, PhysicsPostStep)
 {
     URHO3D_PARAM(P_WORLD, World);                  // PhysicsWorld pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    using Data = PhysicsPreStep::Data;
 }
 
 /// Physics collision started. Global event sent by the PhysicsWorld.
@@ -51,6 +72,37 @@ URHO3D_EVENT(E_PHYSICSCOLLISIONSTART, PhysicsCollisionStart)
     URHO3D_PARAM(P_BODYB, BodyB);                  // RigidBody pointer
     URHO3D_PARAM(P_TRIGGER, Trigger);              // bool
     URHO3D_PARAM(P_CONTACTS, Contacts);            // Buffer containing position (Vector3), normal (Vector3), distance (float), impulse (float) for each contact
+
+    /// Typed payload, shared by the collision start and ongoing collision events.
+    struct Data
+    {
+        /// Physics world.
+        Component* world_{};
+        /// First node.
+        Node* nodeA_{};
+        /// Second node.
+        Node* nodeB_{};
+        /// First rigid body.
+        RigidBody* bodyA_{};
+        /// Second rigid body.
+        RigidBody* bodyB_{};
+        /// Whether either body is a trigger.
+        bool trigger_{};
+        /// Contact buffer, valid during the event.
+        const ea::vector<unsigned char>* contacts_{};
+
+        /// List members for conversion from and to event parameters.
+        template <class Visitor> void Visit(Visitor& visitor)
+        {
+            visitor(P_WORLD, world_);
+            visitor(P_NODEA, nodeA_);
+            visitor(P_NODEB, nodeB_);
+            visitor(P_BODYA, bodyA_);
+            visitor(P_BODYB, bodyB_);
+            visitor(P_TRIGGER, trigger_);
+            visitor(P_CONTACTS, contacts_);
+        }
+    };
 }
 
 /// Physics collision ongoing. Global event sent by the PhysicsWorld.
@@ -63,6 +115,7 @@ URHO3D_EVENT(E_PHYSICSCOLLISION, PhysicsCollision)
     URHO3D_PARAM(P_BODYB, BodyB);                  // RigidBody pointer
     URHO3D_PARAM(P_TRIGGER, Trigger);              // bool
     URHO3D_PARAM(P_CONTACTS, Contacts);            // Buffer containing position (Vector3), normal (Vector3), distance (float), impulse (float) for each contact
+    using Data = PhysicsCollisionStart::Data;
 }
 
 /// Physics collision ended. Global event sent by the PhysicsWorld.
@@ -84,6 +137,31 @@ URHO3D_EVENT(E_NODECOLLISIONSTART, NodeCollisionStart)
     URHO3D_PARAM(P_OTHERBODY, OtherBody);          // RigidBody pointer
     URHO3D_PARAM(P_TRIGGER, Trigger);              // bool
     URHO3D_PARAM(P_CONTACTS, Contacts);            // Buffer containing position (Vector3), normal (Vector3), distance (float), impulse (float) for each contact
+
+    /// Typed payload, shared by the node collision start and ongoing collision events.
+    struct Data
+    {
+        /// Rigid body of the node.
+        RigidBody* body_{};
+        /// Other node.
+        Node* otherNode_{};
+        /// Other rigid body.
+        RigidBody* otherBody_{};
+        /// Whether either body is a trigger.
+        bool trigger_{};
+        /// Contact buffer, valid during the event.
+        const ea::vector<unsigned char>* contacts_{};
+
+        /// List members for conversion from and to event parameters.
+        template <class Visitor> void Visit(Visitor& visitor)
+        {
+            visitor(P_BODY, body_);
+            visitor(P_OTHERNODE, otherNode_);
+            visitor(P_OTHERBODY, otherBody_);
+            visitor(P_TRIGGER, trigger_);
+            visitor(P_CONTACTS, contacts_);
+        }
+    };
 }
 
 /// Node's physics collision ongoing. Sent by scene nodes participating in a collision.
@@ -94,6 +172,7 @@ URHO3D_EVENT(E_NODECOLLISION, NodeCollision)
     URHO3D_PARAM(P_OTHERBODY, OtherBody);          // RigidBody pointer
     URHO3D_PARAM(P_TRIGGER, Trigger);              // bool
     URHO3D_PARAM(P_CONTACTS, Contacts);            // Buffer containing position (Vector3), normal (Vector3), distance (float), impulse (float) for each contact
+    using Data = NodeCollisionStart::Data;
 }
 
 /// Node's physics collision ended. Sent by scene nodes participating in a collision.
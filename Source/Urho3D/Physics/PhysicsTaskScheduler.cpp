@@ -0,0 +1,270 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include <EASTL/sort.h>
+
+#include "../Core/WorkQueue.h"
+#include "../Math/MathDefs.h"
+#include "../Physics/PhysicsTaskScheduler.h"
+
+#include <Bullet/BulletCollision/BroadphaseCollision/btOverlappingPairCache.h>
+#include <Bullet/BulletCollision/CollisionShapes/btCollisionShape.h>
+#include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
+#include <Bullet/BulletDynamics/Dynamics/btSimulationIslandManagerMt.h>
+#include <Bullet/LinearMath/btPoolAllocator.h>
+
+#include <atomic>
+
+extern int gNumManifold;
+
+namespace Urho3D
+{
+
+/// Minimum number of overlapping pairs to run the narrowphase in parallel.
+static const unsigned MIN_PARALLEL_PAIRS = 64;
+/// Number of overlapping pairs taken at once by a thread.
+static const unsigned PAIR_BATCH_SIZE = 16;
+
+/// Scheduler of the world currently solving constraints in this thread. Bullet passes no user data to the island dispatch.
+static thread_local PhysicsTaskScheduler* currentScheduler = nullptr;
+
+static void WorkQueueIslandDispatch(btAlignedObjectArray<btSimulationIslandManagerMt::Island*>* islandsPtr,
+    btSimulationIslandManagerMt::IslandCallback* callback)
+{
+    if (!currentScheduler)
+    {
+        btSimulationIslandManagerMt::defaultIslandDispatch(islandsPtr, callback);
+        return;
+    }
+
+    // Islands are sorted by decreasing size, so taking them one at a time balances the load
+    btAlignedObjectArray<btSimulationIslandManagerMt::Island*>& islands = *islandsPtr;
+    currentScheduler->ParallelFor((unsigned)islands.size(), 1, [&](unsigned begin, unsigned end)
+    {
+        for (unsigned i = begin; i < end; ++i)
+        {
+            btSimulationIslandManagerMt::Island* island = islands[i];
+            btPersistentManifold** manifolds = island->manifoldArray.size() ? &island->manifoldArray[0] : nullptr;
+            btTypedConstraint** constraints = island->constraintArray.size() ? &island->constraintArray[0] : nullptr;
+            callback->processIsland(&island->bodyArray[0], island->bodyArray.size(), manifolds, island->manifoldArray.size(),
+                constraints, island->constraintArray.size(), island->id);
+        }
+    });
+}
+
+PhysicsTaskScheduler::PhysicsTaskScheduler(WorkQueue* workQueue) :
+    workQueue_(workQueue)
+{
+}
+
+void PhysicsTaskScheduler::ParallelFor(unsigned count, unsigned batchSize, const PhysicsParallelFunction& function)
+{
+    if (!count)
+        return;
+
+    batchSize = Max(batchSize, 1u);
+    unsigned numThreads = GetNumSlots();
+    if (maxThreads_)
+        numThreads = Min(numThreads, maxThreads_);
+    numThreads = Min(numThreads, (count + batchSize - 1) / batchSize);
+
+    if (numThreads <= 1 || !workQueue_)
+    {
+        function(0, count);
+        return;
+    }
+
+    // Each thread keeps taking batches until the range is exhausted, so uneven batches do not stall the others
+    std::atomic<unsigned> nextIndex{0};
+    workQueue_->ParallelFor(0, numThreads, 1, [&](unsigned, unsigned, unsigned)
+    {
+        for (;;)
+        {
+            const unsigned begin = nextIndex.fetch_add(batchSize, std::memory_order_relaxed);
+            if (begin >= count)
+                break;
+            function(begin, Min(begin + batchSize, count));
+        }
+    });
+}
+
+unsigned PhysicsTaskScheduler::GetNumSlots() const
+{
+    return workQueue_ ? workQueue_->GetNumThreads() + 1 : 1;
+}
+
+unsigned PhysicsTaskScheduler::GetCurrentSlot()
+{
+    // Threads not managed by the work queue only step physics themselves, and never help a work queue thread
+    const unsigned threadIndex = WorkQueue::GetThreadIndex();
+    return threadIndex != M_MAX_UNSIGNED ? threadIndex : 0;
+}
+
+PhysicsCollisionDispatcher::PhysicsCollisionDispatcher(btCollisionConfiguration* collisionConfiguration,
+    PhysicsTaskScheduler* scheduler) :
+    btCollisionDispatcher(collisionConfiguration),
+    scheduler_(scheduler),
+    slots_(scheduler->GetNumSlots())
+{
+}
+
+btPersistentManifold* PhysicsCollisionDispatcher::getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1)
+{
+    if (!deferManifoldChanges_)
+        return btCollisionDispatcher::getNewManifold(body0, body1);
+
+    // Same as the base implementation, except that the manifold array is not touched. The pool allocator is thread-safe
+    const btScalar contactBreakingThreshold = (m_dispatcherFlags & CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD) ?
+        btMin(body0->getCollisionShape()->getContactBreakingThreshold(gContactBreakingThreshold),
+            body1->getCollisionShape()->getContactBreakingThreshold(gContactBreakingThreshold)) : gContactBreakingThreshold;
+    const btScalar contactProcessingThreshold = btMin(body0->getContactProcessingThreshold(), body1->getContactProcessingThreshold());
+
+    void* mem = m_persistentManifoldPoolAllocator->allocate(sizeof(btPersistentManifold));
+    if (!mem)
+    {
+        if (m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION)
+            return nullptr;
+        mem = btAlignedAlloc(sizeof(btPersistentManifold), 16);
+    }
+
+    auto* manifold = new(mem) btPersistentManifold(body0, body1, 0, contactBreakingThreshold, contactProcessingThreshold);
+    Slot& slot = slots_[PhysicsTaskScheduler::GetCurrentSlot()];
+    slot.created_.push_back({slot.pairIndex_, slot.sequence_++, manifold});
+    return manifold;
+}
+
+void PhysicsCollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
+{
+    if (!deferManifoldChanges_)
+    {
+        btCollisionDispatcher::releaseManifold(manifold);
+        return;
+    }
+
+    Slot& slot = slots_[PhysicsTaskScheduler::GetCurrentSlot()];
+    slot.released_.push_back({slot.pairIndex_, slot.sequence_++, manifold});
+}
+
+void PhysicsCollisionDispatcher::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo,
+    btDispatcher* dispatcher)
+{
+    const unsigned numPairs = (unsigned)pairCache->getNumOverlappingPairs();
+    // Continuous queries accumulate the time of impact into the dispatch info, so they stay serial
+    if (numPairs < MIN_PARALLEL_PAIRS || dispatchInfo.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE)
+    {
+        btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+        return;
+    }
+
+    btBroadphasePair* pairs = pairCache->getOverlappingPairArrayPtr();
+    btNearCallback nearCallback = getNearCallback();
+
+    deferManifoldChanges_ = true;
+    scheduler_->ParallelFor(numPairs, PAIR_BATCH_SIZE, [&](unsigned begin, unsigned end)
+    {
+        Slot& slot = slots_[PhysicsTaskScheduler::GetCurrentSlot()];
+        for (unsigned i = begin; i < end; ++i)
+        {
+            slot.pairIndex_ = i;
+            slot.sequence_ = 0;
+            nearCallback(pairs[i], *this, dispatchInfo);
+        }
+    });
+    deferManifoldChanges_ = false;
+
+    ApplyManifoldChanges();
+}
+
+void PhysicsCollisionDispatcher::ApplyManifoldChanges()
+{
+    // Add the new manifolds in the order a serial dispatch would have created them
+    changes_.clear();
+    for (Slot& slot : slots_)
+    {
+        changes_.insert(changes_.end(), slot.created_.begin(), slot.created_.end());
+        slot.created_.clear();
+    }
+    ea::sort(changes_.begin(), changes_.end());
+    for (const ManifoldChange& change : changes_)
+    {
+        change.manifold_->m_index1a = m_manifoldsPtr.size();
+        m_manifoldsPtr.push_back(change.manifold_);
+        ++gNumManifold;
+    }
+
+    changes_.clear();
+    for (Slot& slot : slots_)
+    {
+        changes_.insert(changes_.end(), slot.released_.begin(), slot.released_.end());
+        slot.released_.clear();
+    }
+    ea::sort(changes_.begin(), changes_.end());
+    for (const ManifoldChange& change : changes_)
+        btCollisionDispatcher::releaseManifold(change.manifold_);
+}
+
+PhysicsConstraintSolverPool::PhysicsConstraintSolverPool(unsigned numSolvers)
+{
+    for (unsigned i = 0; i < Max(numSolvers, 1u); ++i)
+        solvers_.push_back(ea::make_unique<btSequentialImpulseConstraintSolver>());
+}
+
+PhysicsConstraintSolverPool::~PhysicsConstraintSolverPool() = default;
+
+btScalar PhysicsConstraintSolverPool::solveGroup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds,
+    int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info,
+    btIDebugDraw* debugDrawer, btDispatcher* dispatcher)
+{
+    btSequentialImpulseConstraintSolver* solver = solvers_[PhysicsTaskScheduler::GetCurrentSlot()].get();
+    return solver->solveGroup(bodies, numBodies, manifolds, numManifolds, constraints, numConstraints, info, debugDrawer,
+        dispatcher);
+}
+
+void PhysicsConstraintSolverPool::reset()
+{
+    for (auto& solver : solvers_)
+        solver->reset();
+}
+
+PhysicsDynamicsWorld::PhysicsDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache,
+    btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration, PhysicsTaskScheduler* scheduler) :
+    btDiscreteDynamicsWorldMt(dispatcher, pairCache, constraintSolver, collisionConfiguration),
+    scheduler_(scheduler)
+{
+    static_cast<btSimulationIslandManagerMt*>(getSimulationIslandManager())->setIslandDispatchFunction(WorkQueueIslandDispatch);
+}
+
+void PhysicsDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
+{
+    // Minimum batch size may have been changed through the solver info since the previous step
+    static_cast<btSimulationIslandManagerMt*>(getSimulationIslandManager())->setMinimumSolverBatchSize(
+        solverInfo.m_minimumSolverBatchSize);
+
+    PhysicsTaskScheduler* previousScheduler = currentScheduler;
+    currentScheduler = scheduler_;
+    btDiscreteDynamicsWorldMt::solveConstraints(solverInfo);
+    currentScheduler = previousScheduler;
+}
+
+}
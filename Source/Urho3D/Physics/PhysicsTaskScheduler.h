@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <EASTL/unique_ptr.h>
+#include <EASTL/vector.h>
+#include <functional>
+
+#include "../Container/Ptr.h"
+
+#include <Bullet/BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+#include <Bullet/BulletDynamics/ConstraintSolver/btConstraintSolver.h>
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+
+class btSequentialImpulseConstraintSolver;
+
+namespace Urho3D
+{
+
+class WorkQueue;
+
+/// Parallel physics callback. Called with the begin and end of the index range.
+using PhysicsParallelFunction = std::function<void(unsigned begin, unsigned end)>;
+
+/// Runs physics simulation work on the work queue threads.
+class URHO3D_API PhysicsTaskScheduler
+{
+public:
+    /// Construct.
+    explicit PhysicsTaskScheduler(WorkQueue* workQueue);
+
+    /// Set maximum number of threads including the calling thread. 0 uses all work queue threads.
+    void SetMaxThreads(unsigned num) { maxThreads_ = num; }
+    /// Process the index range [0, count) in batches taken dynamically by up to the maximum number of threads. Calling thread participates.
+    void ParallelFor(unsigned count, unsigned batchSize, const PhysicsParallelFunction& function);
+
+    /// Return maximum number of threads.
+    unsigned GetMaxThreads() const { return maxThreads_; }
+    /// Return number of threads which may execute physics work, and therefore the number of per-thread slots needed.
+    unsigned GetNumSlots() const;
+    /// Return the per-thread slot of the calling thread.
+    static unsigned GetCurrentSlot();
+
+private:
+    /// Work queue.
+    WeakPtr<WorkQueue> workQueue_;
+    /// Maximum number of threads. 0 is unlimited.
+    unsigned maxThreads_{};
+};
+
+/// Collision dispatcher which runs the narrowphase of the overlapping pairs in parallel.
+class URHO3D_API PhysicsCollisionDispatcher : public btCollisionDispatcher
+{
+public:
+    /// Construct.
+    PhysicsCollisionDispatcher(btCollisionConfiguration* collisionConfiguration, PhysicsTaskScheduler* scheduler);
+
+    /// Create a manifold. During parallel dispatch, it is added to the manifold array only after all pairs are processed.
+    btPersistentManifold* getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1) override;
+    /// Release a manifold. During parallel dispatch, the release is deferred until all pairs are processed.
+    void releaseManifold(btPersistentManifold* manifold) override;
+    /// Process all overlapping pairs.
+    void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher) override;
+
+private:
+    /// Manifold created or released during parallel dispatch. Ordered by pair index and sequence so that the manifold array does not depend on thread timing.
+    struct ManifoldChange
+    {
+        /// Compare by pair index and sequence.
+        bool operator <(const ManifoldChange& rhs) const
+        {
+            return pairIndex_ != rhs.pairIndex_ ? pairIndex_ < rhs.pairIndex_ : sequence_ < rhs.sequence_;
+        }
+
+        /// Index of the overlapping pair being processed.
+        unsigned pairIndex_;
+        /// Order within the pair.
+        unsigned sequence_;
+        /// Manifold.
+        btPersistentManifold* manifold_;
+    };
+
+    /// Per-thread dispatch state.
+    struct Slot
+    {
+        /// Index of the overlapping pair being processed.
+        unsigned pairIndex_{};
+        /// Next sequence number within the pair.
+        unsigned sequence_{};
+        /// Created manifolds.
+        ea::vector<ManifoldChange> created_;
+        /// Released manifolds.
+        ea::vector<ManifoldChange> released_;
+    };
+
+    /// Apply the manifold changes recorded during parallel dispatch.
+    void ApplyManifoldChanges();
+
+    /// Task scheduler.
+    PhysicsTaskScheduler* scheduler_;
+    /// Per-thread dispatch states.
+    ea::vector<Slot> slots_;
+    /// Merged manifold changes.
+    ea::vector<ManifoldChange> changes_;
+    /// Whether a parallel dispatch is in progress.
+    bool deferManifoldChanges_{};
+};
+
+/// Constraint solver which keeps a sequential impulse solver per thread, so that simulation islands can be solved in parallel.
+class URHO3D_API PhysicsConstraintSolverPool : public btConstraintSolver
+{
+public:
+    /// Construct.
+    explicit PhysicsConstraintSolverPool(unsigned numSolvers);
+    /// Destruct.
+    ~PhysicsConstraintSolverPool() override;
+
+    /// Solve a simulation island with the solver of the calling thread.
+    btScalar solveGroup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds,
+        btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info, btIDebugDraw* debugDrawer,
+        btDispatcher* dispatcher) override;
+    /// Reset all solvers.
+    void reset() override;
+    /// Return solver type.
+    btConstraintSolverType getSolverType() const override { return BT_SEQUENTIAL_IMPULSE_SOLVER; }
+
+private:
+    /// Per-thread solvers.
+    ea::vector<ea::unique_ptr<btSequentialImpulseConstraintSolver> > solvers_;
+};
+
+/// Dynamics world which dispatches simulation islands to the work queue threads.
+ATTRIBUTE_ALIGNED16(class) PhysicsDynamicsWorld : public btDiscreteDynamicsWorldMt
+{
+public:
+    BT_DECLARE_ALIGNED_ALLOCATOR();
+
+    /// Construct.
+    PhysicsDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver,
+        btCollisionConfiguration* collisionConfiguration, PhysicsTaskScheduler* scheduler);
+
+protected:
+    /// Solve constraints of all simulation islands.
+    void solveConstraints(btContactSolverInfo& solverInfo) override;
+
+private:
+    /// Task scheduler.
+    PhysicsTaskScheduler* scheduler_;
+};
+
+}
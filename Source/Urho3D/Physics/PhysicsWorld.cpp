@@ -27,6 +27,7 @@
 #include "../Core/Context.h"
 #include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Model.h"
 #include "../IO/Log.h"
@@ -34,6 +35,7 @@
 #include "../Physics/CollisionShape.h"
 #include "../Physics/Constraint.h"
 #include "../Physics/PhysicsEvents.h"
+#include "../Physics/PhysicsTaskScheduler.h"
 #include "../Physics/PhysicsUtils.h"
 #include "../Physics/PhysicsWorld.h"
 #include "../Physics/RaycastVehicle.h"
@@ -60,10 +62,21 @@ const char* PHYSICS_CATEGORY = "Physics";
 extern const char* SUBSYSTEM_CATEGORY;
 
 static const int MAX_SOLVER_ITERATIONS = 256;
+static const int DEFAULT_SOLVER_BATCH_SIZE = 128;
 static const Vector3 DEFAULT_GRAVITY = Vector3(0.0f, -9.81f, 0.0f);
 
 PhysicsWorldConfig PhysicsWorld::config;
 
+/// Return whether an event sent by the object would reach any receiver.
+static bool HasEventReceivers(Context* context, Object* sender, StringHash eventType)
+{
+    EventReceiverGroup* group = context->GetEventReceivers(sender, eventType);
+    if (group && !group->receivers_.empty())
+        return true;
+    group = context->GetEventReceivers(eventType);
+    return group && !group->receivers_.empty();
+}
+
 static bool CompareRaycastResults(const PhysicsRaycastResult& lhs, const PhysicsRaycastResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
@@ -159,12 +172,30 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     else
         collisionConfiguration_ = new btDefaultCollisionConfiguration();
 
-    collisionDispatcher_ = ea::make_unique<btCollisionDispatcher>(collisionConfiguration_);
+    auto* workQueue = GetSubsystem<WorkQueue>();
+    if (PhysicsWorld::config.multithreaded_ && workQueue && workQueue->GetNumThreads())
+        taskScheduler_ = ea::make_unique<PhysicsTaskScheduler>(workQueue);
+
+    if (taskScheduler_)
+        collisionDispatcher_ = ea::make_unique<PhysicsCollisionDispatcher>(collisionConfiguration_, taskScheduler_.get());
+    else
+        collisionDispatcher_ = ea::make_unique<btCollisionDispatcher>(collisionConfiguration_);
     btGImpactCollisionAlgorithm::registerAlgorithm(static_cast<btCollisionDispatcher*>(collisionDispatcher_.get()));
 
     broadphase_ = ea::make_unique<btDbvtBroadphase>();
-    solver_ = ea::make_unique<btSequentialImpulseConstraintSolver>();
-    world_ = ea::make_unique<btDiscreteDynamicsWorld>(collisionDispatcher_.get(), broadphase_.get(), solver_.get(), collisionConfiguration_);
+    if (taskScheduler_)
+    {
+        // Each thread solving simulation islands needs its own solver
+        solver_ = ea::make_unique<PhysicsConstraintSolverPool>(taskScheduler_->GetNumSlots());
+        world_ = ea::make_unique<PhysicsDynamicsWorld>(collisionDispatcher_.get(), broadphase_.get(), solver_.get(),
+            collisionConfiguration_, taskScheduler_.get());
+    }
+    else
+    {
+        solver_ = ea::make_unique<btSequentialImpulseConstraintSolver>();
+        world_ = ea::make_unique<btDiscreteDynamicsWorld>(collisionDispatcher_.get(), broadphase_.get(), solver_.get(),
+            collisionConfiguration_);
+    }
 
     world_->setGravity(ToBtVector3(DEFAULT_GRAVITY));
     world_->getDispatchInfo().m_useContinuous = true;
@@ -194,6 +225,7 @@ PhysicsWorld::~PhysicsWorld()
     solver_.reset();
     broadphase_.reset();
     collisionDispatcher_.reset();
+    taskScheduler_.reset();
 
     // Delete configuration only if it was the default created by PhysicsWorld
     if (!PhysicsWorld::config.collisionConfig_)
@@ -213,6 +245,9 @@ void PhysicsWorld::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Interpolation", bool, interpolation_, true, AM_FILE);
     URHO3D_ATTRIBUTE("Internal Edge Utility", bool, internalEdge_, true, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Split Impulse", GetSplitImpulse, SetSplitImpulse, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max Threads", GetMaxThreads, SetMaxThreads, unsigned, 0, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Solver Batch Size", GetSolverBatchSize, SetSolverBatchSize, int, DEFAULT_SOLVER_BATCH_SIZE, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Contact Report Mask", GetContactReportMask, SetContactReportMask, unsigned, 0, AM_DEFAULT);
 }
 
 bool PhysicsWorld::isVisible(const btVector3& aabbMin, const btVector3& aabbMax)
@@ -372,6 +407,19 @@ void PhysicsWorld::SetMaxNetworkAngularVelocity(float velocity)
     MarkNetworkUpdate();
 }
 
+void PhysicsWorld::SetMaxThreads(unsigned num)
+{
+    maxThreads_ = num;
+    if (taskScheduler_)
+        taskScheduler_->SetMaxThreads(num);
+}
+
+void PhysicsWorld::SetSolverBatchSize(int size)
+{
+    // The multithreaded world passes this to its island manager before each solve
+    world_->getSolverInfo().m_minimumSolverBatchSize = Max(size, 1);
+}
+
 void PhysicsWorld::Raycast(ea::vector<PhysicsRaycastResult>& result, const Ray& ray, float maxDistance, unsigned collisionMask)
 {
     URHO3D_PROFILE("PhysicsRaycast");
@@ -718,6 +766,11 @@ bool PhysicsWorld::GetSplitImpulse() const
     return world_->getSolverInfo().m_splitImpulse != 0;
 }
 
+int PhysicsWorld::GetSolverBatchSize() const
+{
+    return world_->getSolverInfo().m_minimumSolverBatchSize;
+}
+
 void PhysicsWorld::AddRigidBody(RigidBody* body)
 {
     rigidBodies_.push_back(body);
@@ -785,30 +838,29 @@ void PhysicsWorld::OnSceneSet(Scene* scene)
     if (scene)
     {
         scene_ = GetScene();
-        SubscribeToEvent(scene_, E_SCENESUBSYSTEMUPDATE, URHO3D_HANDLER(PhysicsWorld, HandleSceneSubsystemUpdate));
+        SubscribeToEvent(scene_, E_SCENESUBSYSTEMUPDATE, &PhysicsWorld::HandleSceneSubsystemUpdate);
     }
     else
         UnsubscribeFromEvent(E_SCENESUBSYSTEMUPDATE);
 }
 
-void PhysicsWorld::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
+void PhysicsWorld::HandleSceneSubsystemUpdate(const SceneUpdate::Data& eventData)
 {
     if (!updateEnabled_)
         return;
 
-    using namespace SceneSubsystemUpdate;
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 void PhysicsWorld::PreStep(float timeStep)
 {
     // Send pre-step event
-    using namespace PhysicsPreStep;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_WORLD] = this;
-    eventData[P_TIMESTEP] = timeStep;
-    SendEvent(E_PHYSICSPRESTEP, eventData);
+    PhysicsPreStep::Data eventData;
+    eventData.world_ = this;
+    eventData.timeStep_ = timeStep;
+    SendTypedEvent(E_PHYSICSPRESTEP, eventData);
+    if (GetFixedUpdateSource() == this)
+        GetScene()->UpdateLogicComponents(LUP_FIXEDUPDATE, timeStep);
 
     // Start profiling block for the actual simulation step
     // URHO3D_PROFILE("PhysicsStepSimulation");
@@ -818,15 +870,101 @@ void PhysicsWorld::PostStep(float timeStep)
 {
     // URHO3D_PROFILE_END();
 
+    // Build the report after the collision event handlers, which may remove bodies from the world
     SendCollisionEvents();
+    UpdateContactReport();
 
     // Send post-step event
-    using namespace PhysicsPostStep;
+    PhysicsPostStep::Data eventData;
+    eventData.world_ = this;
+    eventData.timeStep_ = timeStep;
+    SendTypedEvent(E_PHYSICSPOSTSTEP, eventData);
+    if (GetFixedUpdateSource() == this)
+        GetScene()->UpdateLogicComponents(LUP_FIXEDPOSTUPDATE, timeStep);
+}
+
+void PhysicsWorld::UpdateContactReport()
+{
+    URHO3D_PROFILE("UpdateContactReport");
+
+    ea::swap(contactPairIndices_, previousContactPairIndices_);
+    contactPairIndices_.clear();
+    contactPairs_.clear();
+    contactPoints_.clear();
+    reportedManifolds_.clear();
+
+    const int numManifolds = collisionDispatcher_->getNumManifolds();
+    for (int i = 0; i < numManifolds; ++i)
+    {
+        btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
+        const int numContacts = contactManifold->getNumContacts();
+        if (!numContacts)
+            continue;
+
+        auto* bodyA = static_cast<RigidBody*>(contactManifold->getBody0()->getUserPointer());
+        auto* bodyB = static_cast<RigidBody*>(contactManifold->getBody1()->getUserPointer());
+        if (!bodyA || !bodyB)
+            continue;
+
+        // Bodies which are not listened to are rejected with a few flag checks
+        if (!bodyA->GetReportContacts() && !bodyB->GetReportContacts() &&
+            !((bodyA->GetCollisionLayer() | bodyB->GetCollisionLayer()) & contactReportMask_))
+            continue;
+
+        // Component IDs are not reused like addresses, so the previous frame's pairs stay valid when bodies are destroyed
+        const unsigned idA = bodyA->GetID();
+        const unsigned idB = bodyB->GetID();
+        const unsigned long long key = idA < idB ? ((unsigned long long)idA << 32u) | idB : ((unsigned long long)idB << 32u) | idA;
+
+        // A body pair may have several manifolds, e.g. with compound shapes. Merge them into one pair
+        auto result = contactPairIndices_.insert(ea::make_pair(key, contactPairs_.size()));
+        if (result.second)
+        {
+            PhysicsContactPair pair;
+            pair.bodyA_ = bodyA;
+            pair.bodyB_ = bodyB;
+            pair.firstContact_ = 0;
+            pair.numContacts_ = 0;
+            pair.trigger_ = bodyA->IsTrigger() || bodyB->IsTrigger();
+            pair.started_ = !previousContactPairIndices_.contains(key);
+            contactPairs_.push_back(pair);
+        }
+
+        const unsigned pairIndex = result.first->second;
+        contactPairs_[pairIndex].numContacts_ += numContacts;
+        reportedManifolds_.emplace_back(contactManifold, pairIndex);
+    }
+
+    if (reportedManifolds_.empty())
+        return;
+
+    // Lay out the contact points of each pair contiguously, then fill them in manifold order
+    unsigned numPoints = 0;
+    for (PhysicsContactPair& pair : contactPairs_)
+    {
+        pair.firstContact_ = numPoints;
+        numPoints += pair.numContacts_;
+        pair.numContacts_ = 0;
+    }
+    contactPoints_.resize(numPoints);
+
+    for (const auto& reportedManifold : reportedManifolds_)
+    {
+        btPersistentManifold* contactManifold = reportedManifold.first;
+        PhysicsContactPair& pair = contactPairs_[reportedManifold.second];
+        // Contacts are given on body B of the pair, so they are flipped if the manifold has the bodies the other way around
+        const bool flipped = contactManifold->getBody0() != pair.bodyA_->GetBody();
 
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_WORLD] = this;
-    eventData[P_TIMESTEP] = timeStep;
-    SendEvent(E_PHYSICSPOSTSTEP, eventData);
+        for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+        {
+            const btManifoldPoint& point = contactManifold->getContactPoint(j);
+            PhysicsContactPoint& contact = contactPoints_[pair.firstContact_ + pair.numContacts_++];
+            contact.position_ = ToVector3(flipped ? point.m_positionWorldOnA : point.m_positionWorldOnB);
+            contact.normal_ = flipped ? -ToVector3(point.m_normalWorldOnB) : ToVector3(point.m_normalWorldOnB);
+            contact.distance_ = point.m_distance1;
+            contact.impulse_ = point.m_appliedImpulse;
+        }
+    }
 }
 
 void PhysicsWorld::SendCollisionEvents()
@@ -841,7 +979,9 @@ void PhysicsWorld::SendCollisionEvents()
 
     if (numManifolds)
     {
-        physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
+        PhysicsCollision::Data physicsCollisionData;
+        physicsCollisionData.world_ = this;
+        NodeCollision::Data nodeCollisionData;
 
         for (int i = 0; i < numManifolds; ++i)
         {
@@ -886,6 +1026,10 @@ void PhysicsWorld::SendCollisionEvents()
             }
         }
 
+        // Contacts are only gathered for pairs somebody listens to
+        const bool sendPhysicsCollisionStart = HasEventReceivers(context_, this, E_PHYSICSCOLLISIONSTART);
+        const bool sendPhysicsCollision = HasEventReceivers(context_, this, E_PHYSICSCOLLISION);
+
         for (auto i = currentCollisions_.begin();
              i != currentCollisions_.end(); ++i)
         {
@@ -896,125 +1040,147 @@ void PhysicsWorld::SendCollisionEvents()
 
             Node* nodeA = bodyA->GetNode();
             Node* nodeB = bodyB->GetNode();
-            WeakPtr<Node> nodeWeakA(nodeA);
-            WeakPtr<Node> nodeWeakB(nodeB);
 
             bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
             bool newCollision = !previousCollisions_.contains(i->first);
 
-            physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
-            physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
-            physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
-            physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
-            physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
+            const bool sendPhysics = (newCollision && sendPhysicsCollisionStart) || sendPhysicsCollision;
+            const bool sendNodeA = (newCollision && HasEventReceivers(context_, nodeA, E_NODECOLLISIONSTART)) ||
+                HasEventReceivers(context_, nodeA, E_NODECOLLISION);
+            const bool sendNodeB = (newCollision && HasEventReceivers(context_, nodeB, E_NODECOLLISIONSTART)) ||
+                HasEventReceivers(context_, nodeB, E_NODECOLLISION);
+            if (!sendPhysics && !sendNodeA && !sendNodeB)
+                continue;
 
-            contacts_.Clear();
+            WeakPtr<Node> nodeWeakA(nodeA);
+            WeakPtr<Node> nodeWeakB(nodeB);
 
-            // "Pointers not flipped"-manifold, send unmodified normals
-            btPersistentManifold* contactManifold = i->second.manifold_;
-            if (contactManifold)
+            if (sendPhysics || sendNodeA)
             {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                contacts_.Clear();
+
+                // "Pointers not flipped"-manifold, send unmodified normals
+                btPersistentManifold* contactManifold = i->second.manifold_;
+                if (contactManifold)
                 {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
+                    for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                    {
+                        btManifoldPoint& point = contactManifold->getContactPoint(j);
+                        contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
+                        contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
+                        contacts_.WriteFloat(point.m_distance1);
+                        contacts_.WriteFloat(point.m_appliedImpulse);
+                    }
                 }
-            }
-            // "Pointers flipped"-manifold, flip normals also
-            contactManifold = i->second.flippedManifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                // "Pointers flipped"-manifold, flip normals also
+                contactManifold = i->second.flippedManifold_;
+                if (contactManifold)
                 {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
+                    for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                    {
+                        btManifoldPoint& point = contactManifold->getContactPoint(j);
+                        contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
+                        contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
+                        contacts_.WriteFloat(point.m_distance1);
+                        contacts_.WriteFloat(point.m_appliedImpulse);
+                    }
                 }
             }
 
-            physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
-
-            // Send separate collision start event if collision is new
-            if (newCollision)
+            if (sendPhysics)
             {
-                SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
-                // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+                physicsCollisionData.nodeA_ = nodeA;
+                physicsCollisionData.nodeB_ = nodeB;
+                physicsCollisionData.bodyA_ = bodyA;
+                physicsCollisionData.bodyB_ = bodyB;
+                physicsCollisionData.trigger_ = trigger;
+                physicsCollisionData.contacts_ = &contacts_.GetBuffer();
+
+                // Send separate collision start event if collision is new
+                if (newCollision)
+                {
+                    SendTypedEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData);
+                    // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+                    if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
+                        continue;
+                }
+
+                // Then send the ongoing collision event
+                SendTypedEvent(E_PHYSICSCOLLISION, physicsCollisionData);
                 if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
                     continue;
             }
 
-            // Then send the ongoing collision event
-            SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
-                continue;
-
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
+            nodeCollisionData.trigger_ = trigger;
 
-            if (newCollision)
+            if (sendNodeA)
             {
-                nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                nodeCollisionData.body_ = bodyA;
+                nodeCollisionData.otherNode_ = nodeB;
+                nodeCollisionData.otherBody_ = bodyB;
+                nodeCollisionData.contacts_ = &contacts_.GetBuffer();
+
+                if (newCollision)
+                {
+                    nodeA->SendTypedEvent(E_NODECOLLISIONSTART, nodeCollisionData);
+                    if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
+                        continue;
+                }
+
+                nodeA->SendTypedEvent(E_NODECOLLISION, nodeCollisionData);
                 if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
                     continue;
             }
 
-            nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
-                continue;
-
-            // Flip perspective to body B
-            contacts_.Clear();
-            contactManifold = i->second.manifold_;
-            if (contactManifold)
+            if (sendNodeB)
             {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                // Flip perspective to body B
+                contacts_.Clear();
+                btPersistentManifold* contactManifold = i->second.manifold_;
+                if (contactManifold)
                 {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
+                    for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                    {
+                        btManifoldPoint& point = contactManifold->getContactPoint(j);
+                        contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
+                        contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
+                        contacts_.WriteFloat(point.m_distance1);
+                        contacts_.WriteFloat(point.m_appliedImpulse);
+                    }
                 }
-            }
-            contactManifold = i->second.flippedManifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                contactManifold = i->second.flippedManifold_;
+                if (contactManifold)
                 {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
+                    for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                    {
+                        btManifoldPoint& point = contactManifold->getContactPoint(j);
+                        contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
+                        contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
+                        contacts_.WriteFloat(point.m_distance1);
+                        contacts_.WriteFloat(point.m_appliedImpulse);
+                    }
                 }
-            }
 
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
+                nodeCollisionData.body_ = bodyB;
+                nodeCollisionData.otherNode_ = nodeA;
+                nodeCollisionData.otherBody_ = bodyA;
+                nodeCollisionData.contacts_ = &contacts_.GetBuffer();
 
-            if (newCollision)
-            {
-                nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
-                    continue;
-            }
+                if (newCollision)
+                {
+                    nodeB->SendTypedEvent(E_NODECOLLISIONSTART, nodeCollisionData);
+                    if (!nodeWeakA || !nodeWeakB || !i->first.first || !i->first.second)
+                        continue;
+                }
 
-            nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+                nodeB->SendTypedEvent(E_NODECOLLISION, nodeCollisionData);
+            }
         }
     }
 
     // Send collision end events as applicable
     {
+        const bool sendPhysicsCollisionEnd = HasEventReceivers(context_, this, E_PHYSICSCOLLISIONEND);
         physicsCollisionData_[PhysicsCollisionEnd::P_WORLD] = this;
 
         for (auto
@@ -1040,6 +1206,10 @@ void PhysicsWorld::SendCollisionEvents()
 
                 Node* nodeA = bodyA->GetNode();
                 Node* nodeB = bodyB->GetNode();
+                if (!sendPhysicsCollisionEnd && !HasEventReceivers(context_, nodeA, E_NODECOLLISIONEND) &&
+                    !HasEventReceivers(context_, nodeB, E_NODECOLLISIONEND))
+                    continue;
+
                 WeakPtr<Node> nodeWeakA(nodeA);
                 WeakPtr<Node> nodeWeakB(nodeB);
 
@@ -44,8 +44,10 @@ class btPersistentManifold;
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
 class CollisionShape;
 class Deserializer;
+class PhysicsTaskScheduler;
 class Constraint;
 class Model;
 class Node;
@@ -107,16 +109,49 @@ struct ManifoldPair
     btPersistentManifold* flippedManifold_;
 };
 
+/// Contact point in the physics world contact report.
+struct PhysicsContactPoint
+{
+    /// World position on body B.
+    Vector3 position_;
+    /// World normal on body B, pointing towards body A.
+    Vector3 normal_;
+    /// Distance between the bodies. Negative when penetrating.
+    float distance_;
+    /// Impulse applied by the constraint solver.
+    float impulse_;
+};
+
+/// Colliding rigid body pair in the physics world contact report.
+struct PhysicsContactPair
+{
+    /// First rigid body. Null if the body has been destroyed since the report was built.
+    WeakPtr<RigidBody> bodyA_;
+    /// Second rigid body. Null if the body has been destroyed since the report was built.
+    WeakPtr<RigidBody> bodyB_;
+    /// Index of the first contact point in the contact point array.
+    unsigned firstContact_;
+    /// Number of contact points.
+    unsigned numContacts_;
+    /// Whether either body is a trigger.
+    bool trigger_;
+    /// Whether the bodies were not in contact on the previous simulation step.
+    bool started_;
+};
+
 /// Custom overrides of physics internals. To use overrides, must be set before the physics component is created.
 struct PhysicsWorldConfig
 {
     PhysicsWorldConfig() :
-        collisionConfig_(nullptr)
+        collisionConfig_(nullptr),
+        multithreaded_(false)
     {
     }
 
     /// Override for the collision configuration (default btDefaultCollisionConfiguration).
     btCollisionConfiguration* collisionConfig_;
+    /// Whether to run collision detection and constraint solving on the work queue threads. Has no effect if there are no worker threads.
+    bool multithreaded_;
 };
 
 static const int DEFAULT_FPS = 60;
@@ -184,6 +219,12 @@ public:
     void SetSplitImpulse(bool enable);
     /// Set maximum angular velocity for network replication.
     void SetMaxNetworkAngularVelocity(float velocity);
+    /// Set maximum number of threads used by a multithreaded world, including the calling thread. 0 (default) uses all worker threads.
+    void SetMaxThreads(unsigned num);
+    /// Set minimum solver batch cost of a multithreaded world. Smaller simulation islands are merged into one batch before solving in parallel.
+    void SetSolverBatchSize(int size);
+    /// Set collision layers included in the contact report. Contacts of bodies with report contacts enabled are included regardless. 0 (default) reports no layers.
+    void SetContactReportMask(unsigned mask) { contactReportMask_ = mask; }
     /// Perform a physics world raycast and return all hits.
     void Raycast
         (ea::vector<PhysicsRaycastResult>& result, const Ray& ray, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
@@ -239,6 +280,24 @@ public:
     /// Return maximum angular velocity for network replication.
     float GetMaxNetworkAngularVelocity() const { return maxNetworkAngularVelocity_; }
 
+    /// Return whether the world runs on the work queue threads.
+    bool IsMultithreaded() const { return taskScheduler_ != nullptr; }
+
+    /// Return maximum number of threads used by a multithreaded world.
+    unsigned GetMaxThreads() const { return maxThreads_; }
+
+    /// Return minimum solver batch cost of a multithreaded world.
+    int GetSolverBatchSize() const;
+
+    /// Return collision layers included in the contact report.
+    unsigned GetContactReportMask() const { return contactReportMask_; }
+
+    /// Return colliding rigid body pairs reported on the last simulation step. Valid from the post-step event until the next step. Bodies are held weakly, so bodies destroyed since read as null.
+    const ea::vector<PhysicsContactPair>& GetContactPairs() const { return contactPairs_; }
+
+    /// Return contact points of the reported rigid body pairs. Indexed by the pairs.
+    const ea::vector<PhysicsContactPoint>& GetContactPoints() const { return contactPoints_; }
+
     /// Add a rigid body to keep track of. Called by RigidBody.
     void AddRigidBody(RigidBody* body);
     /// Remove a rigid body. Called by RigidBody.
@@ -293,14 +352,18 @@ protected:
 
 private:
     /// Handle the scene subsystem update event, step simulation here.
-    void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneSubsystemUpdate(const SceneUpdate::Data& eventData);
     /// Trigger update before each physics simulation step.
     void PreStep(float timeStep);
     /// Trigger update after each physics simulation step.
     void PostStep(float timeStep);
+    /// Collect the contact report of the last simulation step.
+    void UpdateContactReport();
     /// Send accumulated collision events.
     void SendCollisionEvents();
 
+    /// Task scheduler of a multithreaded world.
+    ea::unique_ptr<PhysicsTaskScheduler> taskScheduler_;
     /// Bullet collision configuration.
     btCollisionConfiguration* collisionConfiguration_{};
     /// Bullet collision dispatcher.
@@ -323,6 +386,16 @@ private:
     ea::unordered_map<ea::pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair> currentCollisions_;
     /// Collision pairs on the previous frame. Used to check if a collision is "new." Manifolds are not guaranteed to exist anymore.
     ea::unordered_map<ea::pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair> previousCollisions_;
+    /// Reported contact pairs on this frame.
+    ea::vector<PhysicsContactPair> contactPairs_;
+    /// Reported contact points on this frame.
+    ea::vector<PhysicsContactPoint> contactPoints_;
+    /// Reported manifolds and their contact pair indices on this frame.
+    ea::vector<ea::pair<btPersistentManifold*, unsigned> > reportedManifolds_;
+    /// Contact pair indices by rigid body component ID pair on this frame.
+    ea::unordered_map<unsigned long long, unsigned> contactPairIndices_;
+    /// Contact pair indices by rigid body component ID pair on the previous frame. Used to check if a contact is new.
+    ea::unordered_map<unsigned long long, unsigned> previousContactPairIndices_;
     /// Delayed (parented) world transform assignments.
     ea::unordered_map<RigidBody*, DelayedWorldTransform> delayedWorldTransforms_;
     /// Cache for trimesh geometry data by model and LOD level.
@@ -345,6 +418,10 @@ private:
     float timeAcc_{};
     /// Maximum angular velocity for network replication.
     float maxNetworkAngularVelocity_{DEFAULT_MAX_NETWORK_ANGULAR_VELOCITY};
+    /// Maximum number of threads of a multithreaded world. 0 uses all worker threads.
+    unsigned maxThreads_{};
+    /// Collision layers included in the contact report.
+    unsigned contactReportMask_{};
     /// Automatic simulation update enabled flag.
     bool updateEnabled_{true};
     /// Interpolation flag.
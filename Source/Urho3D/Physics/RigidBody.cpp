@@ -74,6 +74,7 @@ RigidBody::RigidBody(Context* context) :
     kinematic_(false),
     trigger_(false),
     useGravity_(true),
+    reportContacts_(false),
     readdBody_(false),
     inWorld_(false),
     enableMassUpdate_(true),
@@ -122,6 +123,7 @@ void RigidBody::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Network Angular Velocity", GetNetAngularVelocityAttr, SetNetAngularVelocityAttr, ea::vector<unsigned char>,
         Variant::emptyBuffer, AM_NET | AM_LATESTDATA | AM_NOEDIT);
     URHO3D_ENUM_ATTRIBUTE_EX("Collision Event Mode", collisionEventMode_, MarkBodyDirty, collisionEventModeNames, COLLISION_ACTIVE, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Report Contacts", bool, reportContacts_, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Use Gravity", GetUseGravity, SetUseGravity, bool, true, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Is Kinematic", bool, kinematic_, MarkBodyDirty, false, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Is Trigger", bool, trigger_, MarkBodyDirty, false, AM_DEFAULT);
@@ -510,6 +512,12 @@ void RigidBody::SetCollisionEventMode(CollisionEventMode mode)
     MarkNetworkUpdate();
 }
 
+void RigidBody::SetReportContacts(bool enable)
+{
+    reportContacts_ = enable;
+    MarkNetworkUpdate();
+}
+
 void RigidBody::ApplyForce(const Vector3& force)
 {
     if (body_ && force != Vector3::ZERO)
@@ -124,6 +124,8 @@ public:
     void SetCollisionLayerAndMask(unsigned layer, unsigned mask);
     /// Set collision event signaling mode. Default is to signal when rigid bodies are active.
     void SetCollisionEventMode(CollisionEventMode mode);
+    /// Set whether the contacts of this body are included in the physics world contact report regardless of its collision layer.
+    void SetReportContacts(bool enable);
     /// Apply force to center of mass.
     void ApplyForce(const Vector3& force);
     /// Apply force at local position.
@@ -223,6 +225,9 @@ public:
     /// Return collision event signaling mode.
     CollisionEventMode GetCollisionEventMode() const { return collisionEventMode_; }
 
+    /// Return whether the contacts of this body are always included in the physics world contact report.
+    bool GetReportContacts() const { return reportContacts_; }
+
     /// Return colliding rigid bodies from the last simulation step. Only returns collisions that were sent as events (depends on collision event mode) and excludes e.g. static-static collisions.
     void GetCollidingBodies(ea::vector<RigidBody*>& result) const;
 
@@ -299,6 +304,8 @@ private:
     bool trigger_;
     /// Use gravity flag.
     bool useGravity_;
+    /// Contact report flag.
+    bool reportContacts_;
     /// Readd body to world flag.
     bool readdBody_;
     /// Body exists in world flag.
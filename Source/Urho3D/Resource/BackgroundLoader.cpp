@@ -26,6 +26,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 #include "../Resource/BackgroundLoader.h"
 #include "../Resource/ResourceCache.h"
@@ -43,8 +44,19 @@ BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
 
 BackgroundLoader::~BackgroundLoader()
 {
+    shutDown_ = true;
+    Stop();
+
+    // Loaders which have not started yet are removed, the running ones exit after their current resource
+    if (WorkQueue* workQueue = workQueue_)
+        numActiveLoaders_ -= workQueue->RemoveWorkItems(loaders_);
+    while (numActiveLoaders_ > 0)
+        Time::Sleep(1);
+
     MutexLock lock(backgroundLoadMutex_);
 
+    loadQueue_.clear();
+    finishQueue_.clear();
     backgroundLoadQueue_.clear();
 }
 
@@ -52,59 +64,8 @@ void BackgroundLoader::ThreadFunction()
 {
     while (shouldRun_)
     {
-        backgroundLoadMutex_.Acquire();
-
-        // Search for a queued resource that has not been loaded yet
-        auto i = backgroundLoadQueue_.begin();
-        while (i != backgroundLoadQueue_.end())
-        {
-            if (i->second.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
-                break;
-            else
-                ++i;
-        }
-
-        if (i == backgroundLoadQueue_.end())
-        {
-            // No resources to load found
-            backgroundLoadMutex_.Release();
+        if (!LoadNextResource())
             Time::Sleep(5);
-        }
-        else
-        {
-            BackgroundLoadItem& item = i->second;
-            Resource* resource = item.resource_;
-            // We can be sure that the item is not removed from the queue as long as it is in the
-            // "queued" or "loading" state
-            backgroundLoadMutex_.Release();
-
-            bool success = false;
-            SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
-            if (file)
-            {
-                resource->SetAsyncLoadState(ASYNC_LOADING);
-                success = resource->BeginLoad(*file);
-            }
-
-            // Process dependencies now
-            // Need to lock the queue again when manipulating other entries
-            ea::pair<StringHash, StringHash> key = ea::make_pair(resource->GetType(), resource->GetNameHash());
-            backgroundLoadMutex_.Acquire();
-            if (item.dependents_.size())
-            {
-                for (auto i = item.dependents_.begin(); i != item.dependents_.end(); ++i)
-                {
-                    auto j = backgroundLoadQueue_.find(*i);
-                    if (j != backgroundLoadQueue_.end())
-                        j->second.dependencies_.erase(key);
-                }
-
-                item.dependents_.clear();
-            }
-
-            resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
-            backgroundLoadMutex_.Release();
-        }
     }
 }
 
@@ -113,159 +74,301 @@ bool BackgroundLoader::QueueResource(StringHash type, const ea::string& name, bo
     StringHash nameHash(name);
     ea::pair<StringHash, StringHash> key = ea::make_pair(type, nameHash);
 
-    MutexLock lock(backgroundLoadMutex_);
-
-    // Check if already exists in the queue
-    if (backgroundLoadQueue_.find(key) != backgroundLoadQueue_.end())
-        return false;
+    {
+        MutexLock lock(backgroundLoadMutex_);
 
-    BackgroundLoadItem& item = backgroundLoadQueue_[key];
-    item.sendEventOnFailure_ = sendEventOnFailure;
+        // Check if already exists in the queue. The caller still has to wait for it
+        if (backgroundLoadQueue_.find(key) != backgroundLoadQueue_.end())
+        {
+            if (caller)
+                AddDependency(ea::make_pair(caller->GetType(), caller->GetNameHash()), key);
+            return false;
+        }
 
-    // Make sure the pointer is non-null and is a Resource subclass
-    item.resource_ = DynamicCast<Resource>(owner_->GetContext()->CreateObject(type));
-    if (!item.resource_)
-    {
-        URHO3D_LOGERROR("Could not load unknown resource type " + type.ToString());
+        BackgroundLoadItem& item = backgroundLoadQueue_[key];
+        item.sendEventOnFailure_ = sendEventOnFailure;
 
-        if (sendEventOnFailure && Thread::IsMainThread())
+        // Make sure the pointer is non-null and is a Resource subclass
+        item.resource_ = DynamicCast<Resource>(owner_->GetContext()->CreateObject(type));
+        if (!item.resource_)
         {
-            using namespace UnknownResourceType;
+            URHO3D_LOGERROR("Could not load unknown resource type " + type.ToString());
 
-            VariantMap& eventData = owner_->GetEventDataMap();
-            eventData[P_RESOURCETYPE] = type;
-            owner_->SendEvent(E_UNKNOWNRESOURCETYPE, eventData);
-        }
+            if (sendEventOnFailure && Thread::IsMainThread())
+            {
+                using namespace UnknownResourceType;
 
-        backgroundLoadQueue_.erase(key);
-        return false;
-    }
+                VariantMap& eventData = owner_->GetEventDataMap();
+                eventData[P_RESOURCETYPE] = type;
+                owner_->SendEvent(E_UNKNOWNRESOURCETYPE, eventData);
+            }
 
-    URHO3D_LOGDEBUG("Background loading resource " + name);
+            backgroundLoadQueue_.erase(key);
+            return false;
+        }
 
-    item.resource_->SetName(name);
-    item.resource_->SetAsyncLoadState(ASYNC_QUEUED);
+        URHO3D_LOGDEBUG("Background loading resource " + name);
 
-    // If this is a resource calling for the background load of more resources, mark the dependency as necessary
-    if (caller)
-    {
-        ea::pair<StringHash, StringHash> callerKey = ea::make_pair(caller->GetType(), caller->GetNameHash());
-        auto j = backgroundLoadQueue_.find(
-            callerKey);
-        if (j != backgroundLoadQueue_.end())
+        item.resource_->SetName(name);
+        item.resource_->SetAsyncLoadState(ASYNC_QUEUED);
+
+        // If this is a resource calling for the background load of more resources, mark the dependency as necessary
+        if (caller && !AddDependency(ea::make_pair(caller->GetType(), caller->GetNameHash()), key))
         {
-            BackgroundLoadItem& callerItem = j->second;
-            item.dependents_.insert(callerKey);
-            callerItem.dependencies_.insert(key);
-        }
-        else
             URHO3D_LOGWARNING("Resource " + caller->GetName() +
                        " requested for a background loaded resource but was not in the background load queue");
+        }
+
+        loadQueue_.push_back(&item);
     }
 
-    // Start the background loader thread now
-    if (!IsStarted())
-        Run();
+    // Resources queued from the loaders themselves are picked up by the running loaders. Others start new loaders
+    if (Thread::IsMainThread())
+        StartLoaders();
 
     return true;
 }
 
 void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
 {
+    ea::pair<StringHash, StringHash> key = ea::make_pair(type, nameHash);
+
     backgroundLoadMutex_.Acquire();
 
     // Check if the resource in question is being background loaded
-    ea::pair<StringHash, StringHash> key = ea::make_pair(type, nameHash);
-    auto i = backgroundLoadQueue_.find(
-        key);
-    if (i != backgroundLoadQueue_.end())
+    auto i = backgroundLoadQueue_.find(key);
+    if (i == backgroundLoadQueue_.end() || i->second.finishing_)
+    {
+        backgroundLoadMutex_.Release();
+        return;
+    }
+
+    BackgroundLoadItem& item = i->second;
+    Resource* resource = item.resource_;
+
+    // If no loader has taken the resource yet, load it right away in this thread instead of waiting
+    if (resource->GetAsyncLoadState() == ASYNC_QUEUED)
+    {
+        resource->SetAsyncLoadState(ASYNC_LOADING);
+        loadQueue_.erase(ea::find(loadQueue_.begin(), loadQueue_.end(), &item));
+        backgroundLoadMutex_.Release();
+
+        LoadResource(item);
+    }
+    else
     {
         backgroundLoadMutex_.Release();
 
+        HiresTimer waitTimer;
+        bool didWait = false;
+
+        while (resource->GetAsyncLoadState() == ASYNC_LOADING)
         {
-            Resource* resource = i->second.resource_;
-            HiresTimer waitTimer;
-            bool didWait = false;
+            didWait = true;
+            Time::Sleep(1);
+        }
+
+        if (didWait)
+            URHO3D_LOGDEBUG("Waited " + ea::to_string(waitTimer.GetUSec(false) / 1000) + " ms for background loaded resource " +
+                     resource->GetName());
+    }
 
-            for (;;)
+    // Finish the resources this one depends on first. Finishing a dependency removes it from the set
+    for (;;)
+    {
+        backgroundLoadMutex_.Acquire();
+        if (item.dependencies_.empty())
+        {
+            // Take the item out of the finish queue, it is finished now
+            if (item.finishQueued_)
             {
-                unsigned numDeps = i->second.dependencies_.size();
-                AsyncLoadState state = resource->GetAsyncLoadState();
-                if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
-                {
-                    didWait = true;
-                    Time::Sleep(1);
-                }
-                else
-                    break;
+                finishQueue_.erase(ea::find(finishQueue_.begin(), finishQueue_.end(), &item));
+                item.finishQueued_ = false;
             }
+            item.finishing_ = true;
+            backgroundLoadMutex_.Release();
+            break;
+        }
 
-            if (didWait)
-                URHO3D_LOGDEBUG("Waited " + ea::to_string(waitTimer.GetUSec(false) / 1000) + " ms for background loaded resource " +
-                         resource->GetName());
+        // A dependency which is already being finished further up the call stack counts as done
+        ea::pair<StringHash, StringHash> dependency = *item.dependencies_.begin();
+        auto j = backgroundLoadQueue_.find(dependency);
+        if (j == backgroundLoadQueue_.end() || j->second.finishing_)
+        {
+            item.dependencies_.erase(dependency);
+            backgroundLoadMutex_.Release();
+            continue;
         }
+        backgroundLoadMutex_.Release();
 
-        // This may take a long time and may potentially wait on other resources, so it is important we do not hold the mutex during this
-        FinishBackgroundLoading(i->second);
+        WaitForResource(dependency.first, dependency.second);
+    }
 
+    // This may take a long time and may potentially wait on other resources, so it is important we do not hold the mutex during this
+    FinishBackgroundLoading(item);
+}
+
+void BackgroundLoader::FinishResources(int maxMs)
+{
+    StartLoaders();
+
+    HiresTimer timer;
+
+    for (;;)
+    {
         backgroundLoadMutex_.Acquire();
-        backgroundLoadQueue_.erase(i);
+        if (finishQueue_.empty())
+        {
+            backgroundLoadMutex_.Release();
+            break;
+        }
+
+        BackgroundLoadItem& item = *finishQueue_.front();
+        finishQueue_.pop_front();
+        item.finishQueued_ = false;
+        item.finishing_ = true;
+
+        // Finishing a resource may need it to wait for other resources to load, in which case we can not
+        // hold on to the mutex
         backgroundLoadMutex_.Release();
+        FinishBackgroundLoading(item);
+
+        // Break when the time limit passed so that we keep sufficient FPS
+        if (timer.GetUSec(false) >= maxMs * 1000LL)
+            break;
     }
-    else
-        backgroundLoadMutex_.Release();
 }
 
-void BackgroundLoader::FinishResources(int maxMs)
+unsigned BackgroundLoader::GetNumQueuedResources() const
 {
-    if (IsStarted())
+    MutexLock lock(backgroundLoadMutex_);
+    return backgroundLoadQueue_.size();
+}
+
+void BackgroundLoader::StartLoaders()
+{
+    // Load on the worker threads when there are any. Use the loader thread otherwise, and keep using it once started
+    auto* workQueue = owner_->GetSubsystem<WorkQueue>();
+    if (!workQueue || !workQueue->GetNumThreads() || IsStarted())
     {
-        HiresTimer timer;
+        if (!IsStarted() && !shutDown_ && GetNumQueuedResources())
+            Run();
+        return;
+    }
+    workQueue_ = workQueue;
 
-        backgroundLoadMutex_.Acquire();
+    // Forget the loaders which have exited
+    loaders_.erase(ea::remove_if(loaders_.begin(), loaders_.end(),
+        [](const SharedPtr<WorkItem>& loader) { return loader->completed_.load(); }), loaders_.end());
 
-        for (auto i = backgroundLoadQueue_.begin();
-             i != backgroundLoadQueue_.end();)
+    unsigned numQueued;
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        numQueued = loadQueue_.size();
+    }
+
+    // Each loader keeps taking resources until the load queue is empty. Use at most half of the worker threads,
+    // so that a long load queue does not hold up the per-frame parallel work
+    const unsigned maxLoaders = Max(workQueue->GetNumThreads() / 2, 1U);
+    while (numActiveLoaders_ < Min(numQueued, maxLoaders))
+    {
+        ++numActiveLoaders_;
+        WorkItem* loader = workQueue->AddWorkItem([this]()
         {
-            Resource* resource = i->second.resource_;
-            unsigned numDeps = i->second.dependencies_.size();
-            AsyncLoadState state = resource->GetAsyncLoadState();
-            if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
-                ++i;
-            else
+            while (!shutDown_ && LoadNextResource())
             {
-                // Finishing a resource may need it to wait for other resources to load, in which case we can not
-                // hold on to the mutex
-                backgroundLoadMutex_.Release();
-                FinishBackgroundLoading(i->second);
-                backgroundLoadMutex_.Acquire();
-                i = backgroundLoadQueue_.erase(i);
             }
+            --numActiveLoaders_;
+        });
+        loaders_.emplace_back(loader);
+    }
+}
 
-            // Break when the time limit passed so that we keep sufficient FPS
-            if (timer.GetUSec(false) >= maxMs * 1000LL)
-                break;
-        }
+bool BackgroundLoader::AddDependency(const ea::pair<StringHash, StringHash>& callerKey, const ea::pair<StringHash, StringHash>& key)
+{
+    auto i = backgroundLoadQueue_.find(callerKey);
+    if (i == backgroundLoadQueue_.end())
+        return false;
 
-        backgroundLoadMutex_.Release();
+    auto j = backgroundLoadQueue_.find(key);
+    if (callerKey == key || j == backgroundLoadQueue_.end() || j->second.finishing_)
+        return true;
+
+    // Resources finish only after their dependencies, so an edge which would close a cycle is left out
+    ea::vector<ea::pair<StringHash, StringHash> > stack{key};
+    ea::hash_set<ea::pair<StringHash, StringHash> > visited;
+    while (!stack.empty())
+    {
+        const ea::pair<StringHash, StringHash> current = stack.back();
+        stack.pop_back();
+        if (current == callerKey)
+            return true;
+
+        auto k = backgroundLoadQueue_.find(current);
+        if (k != backgroundLoadQueue_.end() && visited.insert(current).second)
+            stack.insert(stack.end(), k->second.dependencies_.begin(), k->second.dependencies_.end());
     }
+
+    i->second.dependencies_.insert(key);
+    j->second.dependents_.insert(callerKey);
+    return true;
 }
 
-unsigned BackgroundLoader::GetNumQueuedResources() const
+bool BackgroundLoader::LoadNextResource()
 {
+    BackgroundLoadItem* item;
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        if (loadQueue_.empty())
+            return false;
+
+        // We can be sure that the item is not removed from the queue as long as it is in the
+        // "queued" or "loading" state
+        item = loadQueue_.front();
+        loadQueue_.pop_front();
+        item->resource_->SetAsyncLoadState(ASYNC_LOADING);
+    }
+
+    LoadResource(*item);
+    return true;
+}
+
+void BackgroundLoader::LoadResource(BackgroundLoadItem& item)
+{
+    Resource* resource = item.resource_;
+
+    bool success = false;
+    SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
+    if (file)
+    {
+        URHO3D_PROFILE("BackgroundLoadResource");
+        success = resource->BeginLoad(*file);
+    }
+
+    // The resource can be finished once the resources it depends on have been finished.
+    // Resources depended on by others are finished first
     MutexLock lock(backgroundLoadMutex_);
-    return backgroundLoadQueue_.size();
+    resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
+    if (item.dependencies_.empty() && !item.finishing_)
+    {
+        if (item.dependents_.empty())
+            finishQueue_.push_back(&item);
+        else
+            finishQueue_.push_front(&item);
+        item.finishQueued_ = true;
+    }
 }
 
 void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
 {
-    Resource* resource = item.resource_;
+    SharedPtr<Resource> resource = item.resource_;
 
     bool success = resource->GetAsyncLoadState() == ASYNC_SUCCESS;
     // If BeginLoad() phase was successful, call EndLoad() and get the final success/failure result
     if (success)
     {
-        URHO3D_PROFILE(ea::string("Finish" + resource->GetTypeName()).c_str());
+        URHO3D_PROFILE("FinishBackgroundLoading");
+        URHO3D_PROFILE_ZONENAME(("Finish" + resource->GetTypeName()).c_str(), resource->GetTypeName().length() + 6);
         URHO3D_LOGDEBUG("Finishing background loaded resource " + resource->GetName());
         success = resource->EndLoad();
     }
@@ -294,6 +397,32 @@ void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
         eventData[P_RESOURCE] = resource;
         owner_->SendEvent(E_RESOURCEBACKGROUNDLOADED, eventData);
     }
+
+    // Remove from the queue and release the resources which were waiting for this one. The item is destroyed here
+    {
+        MutexLock lock(backgroundLoadMutex_);
+
+        const ea::pair<StringHash, StringHash> key = ea::make_pair(resource->GetType(), resource->GetNameHash());
+        for (const auto& dependentKey : item.dependents_)
+        {
+            auto j = backgroundLoadQueue_.find(dependentKey);
+            if (j == backgroundLoadQueue_.end())
+                continue;
+
+            BackgroundLoadItem& dependent = j->second;
+            dependent.dependencies_.erase(key);
+
+            const AsyncLoadState state = dependent.resource_->GetAsyncLoadState();
+            if (dependent.dependencies_.empty() && !dependent.finishQueued_ && !dependent.finishing_ &&
+                (state == ASYNC_SUCCESS || state == ASYNC_FAIL))
+            {
+                finishQueue_.push_back(&dependent);
+                dependent.finishQueued_ = true;
+            }
+        }
+
+        backgroundLoadQueue_.erase(key);
+    }
 }
 
 }
@@ -22,8 +22,10 @@
 
 #pragma once
 
+#include <EASTL/deque.h>
 #include <EASTL/hash_set.h>
 #include <EASTL/unordered_map.h>
+#include <atomic>
 
 #include "../Core/Mutex.h"
 #include "../Container/RefCounted.h"
@@ -35,21 +37,27 @@ namespace Urho3D
 
 class Resource;
 class ResourceCache;
+class WorkQueue;
+struct WorkItem;
 
 /// Queue item for background loading of a resource.
 struct URHO3D_API BackgroundLoadItem
 {
     /// Resource.
     SharedPtr<Resource> resource_;
-    /// Resources depended on for loading.
+    /// Resources depended on for loading, which have not been finished yet.
     ea::hash_set<ea::pair<StringHash, StringHash> > dependencies_;
     /// Resources that depend on this resource's loading.
     ea::hash_set<ea::pair<StringHash, StringHash> > dependents_;
     /// Whether to send failure event.
     bool sendEventOnFailure_;
+    /// Whether the item is in the finish queue.
+    bool finishQueued_{};
+    /// Whether the item is being finished in the main thread.
+    bool finishing_{};
 };
 
-/// Background loader of resources. Owned by the ResourceCache.
+/// Background loader of resources. Owned by the ResourceCache. Loads resources on the work queue threads, or in its own thread if there are none.
 class URHO3D_API BackgroundLoader : public RefCounted, public Thread
 {
 public:
@@ -59,12 +67,12 @@ public:
     /// Destruct. Forcibly clear the load queue.
     ~BackgroundLoader() override;
 
-    /// Resource background loading loop.
+    /// Resource background loading loop, used when there are no worker threads.
     void ThreadFunction() override;
 
     /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Return true if queued (not a duplicate and resource was a known type).
     bool QueueResource(StringHash type, const ea::string& name, bool sendEventOnFailure, Resource* caller);
-    /// Wait and finish possible loading of a resource when being requested from the cache.
+    /// Wait and finish possible loading of a resource when being requested from the cache. Resources it depends on are finished first.
     void WaitForResource(StringHash type, StringHash nameHash);
     /// Process resources that are ready to finish.
     void FinishResources(int maxMs);
@@ -73,15 +81,35 @@ public:
     unsigned GetNumQueuedResources() const;
 
 private:
-    /// Finish one background loaded resource.
+    /// Start more loading work items or the loader thread as necessary. Called from the main thread.
+    void StartLoaders();
+    /// Make the caller resource finish only after the resource it requested. Return false if the caller is not in the queue. Called with the mutex held.
+    bool AddDependency(const ea::pair<StringHash, StringHash>& callerKey, const ea::pair<StringHash, StringHash>& key);
+    /// Begin loading the next queued resource. Return false if there were none.
+    bool LoadNextResource();
+    /// Begin loading a resource that has been taken from the load queue.
+    void LoadResource(BackgroundLoadItem& item);
+    /// Finish one background loaded resource and release resources which were waiting for it.
     void FinishBackgroundLoading(BackgroundLoadItem& item);
 
     /// Resource cache.
     ResourceCache* owner_;
+    /// Work queue the loading work items were added to.
+    WeakPtr<WorkQueue> workQueue_;
     /// Mutex for thread-safe access to the background load queue.
     mutable Mutex backgroundLoadMutex_;
     /// Resources that are queued for background loading.
     ea::unordered_map<ea::pair<StringHash, StringHash>, BackgroundLoadItem> backgroundLoadQueue_;
+    /// Items waiting for a loader to begin loading them, in queueing order.
+    ea::deque<BackgroundLoadItem*> loadQueue_;
+    /// Items whose resources and dependencies are loaded, in the order they should be finished.
+    ea::deque<BackgroundLoadItem*> finishQueue_;
+    /// Loading work items started on the work queue.
+    ea::vector<SharedPtr<WorkItem> > loaders_;
+    /// Number of loading work items which have not exited yet.
+    std::atomic<unsigned> numActiveLoaders_{};
+    /// Shutting down flag.
+    std::atomic<bool> shutDown_{};
 };
 
 }
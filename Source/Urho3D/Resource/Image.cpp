@@ -798,17 +798,22 @@ bool Image::BeginLoad(Deserializer& source)
             return false;
         }
 
-        // Read the file to buffer.
+        // Read the file to buffer, unless it is directly addressable.
         size_t dataSize(source.GetSize());
-        ea::shared_array<uint8_t> data(new uint8_t[dataSize]);
-
-        memset(data.get(), 0, sizeof(uint8_t) * dataSize);
-        source.Seek(0);
-        source.Read(data.get(), dataSize);
+        ea::shared_array<uint8_t> buffer;
+        const uint8_t* data = source.GetData();
+        if (!data)
+        {
+            buffer.reset(new uint8_t[dataSize]);
+            memset(buffer.get(), 0, sizeof(uint8_t) * dataSize);
+            source.Seek(0);
+            source.Read(buffer.get(), dataSize);
+            data = buffer.get();
+        }
 
         WebPBitstreamFeatures features;
 
-        if (WebPGetFeatures(data.get(), dataSize, &features) != VP8_STATUS_OK)
+        if (WebPGetFeatures(data, dataSize, &features) != VP8_STATUS_OK)
         {
             URHO3D_LOGERROR("Error reading WebP image: " + source.GetName());
             return false;
@@ -820,11 +825,11 @@ bool Image::BeginLoad(Deserializer& source)
         bool decodeError(false);
         if (features.has_alpha)
         {
-            decodeError = WebPDecodeRGBAInto(data.get(), dataSize, pixelData.get(), imgSize, 4 * features.width) == nullptr;
+            decodeError = WebPDecodeRGBAInto(data, dataSize, pixelData.get(), imgSize, 4 * features.width) == nullptr;
         }
         else
         {
-            decodeError = WebPDecodeRGBInto(data.get(), dataSize, pixelData.get(), imgSize, 3 * features.width) == nullptr;
+            decodeError = WebPDecodeRGBInto(data, dataSize, pixelData.get(), imgSize, 3 * features.width) == nullptr;
         }
         if (decodeError)
         {
@@ -2333,6 +2338,10 @@ unsigned char* Image::GetImageData(Deserializer& source, int& width, int& height
 {
     unsigned dataSize = source.GetSize();
 
+    // Decode directly from memory-mapped data when possible
+    if (const unsigned char* sourceData = source.GetData())
+        return stbi_load_from_memory(sourceData, dataSize, &width, &height, (int*)&components, 0);
+
     ea::shared_array<unsigned char> buffer(new unsigned char[dataSize]);
     source.Read(buffer.get(), dataSize);
     return stbi_load_from_memory(buffer.get(), dataSize, &width, &height, (int*)&components, 0);
@@ -127,6 +127,8 @@ public:
 
     /// Define whether when getting resources should check package files or directories first. True for packages, false for directories.
     void SetSearchPackagesFirst(bool value) { searchPackagesFirst_ = value; }
+    /// Define whether package files added by name are mapped to memory. Files opened from mapped packages expose their data through GetData() without copying if uncompressed. Default false.
+    void SetMemoryMapPackages(bool enable) { memoryMapPackages_ = enable; }
 
     /// Set how many milliseconds maximum per frame to spend on finishing background loaded resources.
     void SetFinishBackgroundResourcesMs(int ms) { finishBackgroundResourcesMs_ = Max(ms, 1); }
@@ -191,6 +193,8 @@ public:
 
     /// Return whether when getting resources should check package files or directories first.
     bool GetSearchPackagesFirst() const { return searchPackagesFirst_; }
+    /// Return whether package files added by name are mapped to memory.
+    bool GetMemoryMapPackages() const { return memoryMapPackages_; }
 
     /// Return how many milliseconds maximum to spend on finishing background loaded resources.
     int GetFinishBackgroundResourcesMs() const { return finishBackgroundResourcesMs_; }
@@ -270,6 +274,8 @@ private:
     bool returnFailedResources_;
     /// Search priority flag.
     bool searchPackagesFirst_;
+    /// Memory-mapped packages flag.
+    bool memoryMapPackages_{};
     /// Resource routing flag to prevent endless recursion.
     mutable bool isRouting_;
     /// How many milliseconds maximum per frame to spend on finishing background loaded resources.
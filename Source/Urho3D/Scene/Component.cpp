@@ -175,6 +175,7 @@ void Component::PrepareNetworkUpdate()
         return;
 
     unsigned numAttributes = attributes->size();
+    const InterestMode interestMode = GetScene()->GetInterestGrid().GetMode(node_->GetID());
 
     // Check for attribute changes
     for (unsigned i = 0; i < numAttributes; ++i)
@@ -197,13 +198,9 @@ void Component::PrepareNetworkUpdate()
                 auto* compState = static_cast<ComponentReplicationState*>(*j);
                 compState->dirtyAttributes_.Set(i);
 
-                // Add component's parent node to the dirty set if not added yet
+                // Add component's parent node to the dirty set if not added yet, unless interest management finds it later
                 NodeReplicationState* nodeState = compState->nodeState_;
-                if (!nodeState->markedDirty_)
-                {
-                    nodeState->markedDirty_ = true;
-                    nodeState->sceneState_->dirtyNodes_.insert(node_->GetID());
-                }
+                nodeState->MarkDirty(node_->GetID(), IsInterestImmediate(interestMode, node_->GetOwner(), nodeState->connection_));
             }
         }
     }
@@ -226,7 +223,7 @@ void Component::CleanupConnection(Connection* connection)
 void Component::OnAttributeAnimationAdded()
 {
     if (attributeAnimationInfos_.size() == 1)
-        SubscribeToEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE, URHO3D_HANDLER(Component, HandleAttributeAnimationUpdate));
+        SubscribeToEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE, &Component::HandleAttributeAnimationUpdate);
 }
 
 void Component::OnAttributeAnimationRemoved()
@@ -280,11 +277,9 @@ void Component::GetComponents(ea::vector<Component*>& dest, StringHash type) con
         dest.clear();
 }
 
-void Component::HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData)
+void Component::HandleAttributeAnimationUpdate(const SceneUpdate::Data& eventData)
 {
-    using namespace AttributeAnimationUpdate;
-
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
+    UpdateAttributeAnimations(eventData.timeStep_);
 }
 
 Component* Component::GetFixedUpdateSource()
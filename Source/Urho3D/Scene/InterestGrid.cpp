@@ -0,0 +1,212 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Timer.h"
+#include "../Scene/InterestGrid.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const float MIN_INTEREST_CELL_SIZE = 0.1f;
+
+/// Combine cell coordinates into a cell key.
+static inline unsigned long long MakeCellKey(int x, int z)
+{
+    return ((unsigned long long)(unsigned)x << 32u) | (unsigned)z;
+}
+
+InterestGrid::InterestGrid() :
+    cellSize_(DEFAULT_INTEREST_CELL_SIZE),
+    radius_(DEFAULT_INTEREST_RADIUS),
+    updateTime_(0),
+    enabled_(false)
+{
+}
+
+InterestGrid::~InterestGrid() = default;
+
+void InterestGrid::SetEnabled(bool enable)
+{
+    enabled_ = enable;
+}
+
+void InterestGrid::SetCellSize(float size)
+{
+    size = Max(size, MIN_INTEREST_CELL_SIZE);
+    if (size == cellSize_)
+        return;
+
+    cellSize_ = size;
+
+    // Reinsert all nodes with the new cell size
+    cells_.clear();
+    for (auto& item : nodes_)
+    {
+        if (item.second.inCell_)
+        {
+            item.second.inCell_ = false;
+            InsertToCell(item.first, item.second);
+        }
+    }
+}
+
+void InterestGrid::SetRadius(float radius)
+{
+    radius_ = Max(radius, 0.0f);
+}
+
+void InterestGrid::SetNode(unsigned nodeID, InterestMode mode)
+{
+    if (mode == INTEREST_ALWAYS)
+    {
+        RemoveNode(nodeID);
+        return;
+    }
+
+    NodeEntry& entry = nodes_[nodeID];
+    entry.mode_ = mode;
+    // Only distance-managed nodes need to be found by position
+    if (mode != INTEREST_DISTANCE)
+        RemoveFromCell(nodeID, entry);
+    MarkDirty(nodeID);
+}
+
+void InterestGrid::RemoveNode(unsigned nodeID)
+{
+    auto i = nodes_.find(nodeID);
+    if (i == nodes_.end())
+        return;
+
+    RemoveFromCell(nodeID, i->second);
+    nodes_.erase(i);
+}
+
+void InterestGrid::MarkDirty(unsigned nodeID)
+{
+    SpinLockGuard lock(dirtyLock_);
+    dirtyNodes_.insert(nodeID);
+}
+
+void InterestGrid::Update(Scene* scene)
+{
+    HiresTimer timer;
+
+    for (unsigned nodeID : dirtyNodes_)
+    {
+        auto i = nodes_.find(nodeID);
+        if (i == nodes_.end() || i->second.mode_ != INTEREST_DISTANCE)
+            continue;
+
+        Node* node = scene->GetNode(nodeID);
+        if (!node)
+            continue;
+
+        NodeEntry& entry = i->second;
+        entry.position_ = node->GetWorldPosition();
+        if (!entry.inCell_ || GetCellKey(entry.position_) != entry.cell_)
+        {
+            RemoveFromCell(nodeID, entry);
+            InsertToCell(nodeID, entry);
+        }
+    }
+    dirtyNodes_.clear();
+
+    updateTime_ = timer.GetUSec(false);
+}
+
+void InterestGrid::Query(const Vector3& position, ea::vector<unsigned>& result) const
+{
+    result.clear();
+
+    const int minX = FloorToInt((position.x_ - radius_) / cellSize_);
+    const int maxX = FloorToInt((position.x_ + radius_) / cellSize_);
+    const int minZ = FloorToInt((position.z_ - radius_) / cellSize_);
+    const int maxZ = FloorToInt((position.z_ + radius_) / cellSize_);
+    const float radiusSquared = radius_ * radius_;
+
+    for (int x = minX; x <= maxX; ++x)
+    {
+        for (int z = minZ; z <= maxZ; ++z)
+        {
+            auto i = cells_.find(MakeCellKey(x, z));
+            if (i == cells_.end())
+                continue;
+
+            for (unsigned nodeID : i->second)
+            {
+                const NodeEntry& entry = nodes_.find(nodeID)->second;
+                if ((entry.position_ - position).LengthSquared() <= radiusSquared)
+                    result.push_back(nodeID);
+            }
+        }
+    }
+}
+
+InterestMode InterestGrid::GetMode(unsigned nodeID) const
+{
+    if (!enabled_)
+        return INTEREST_ALWAYS;
+
+    auto i = nodes_.find(nodeID);
+    return i != nodes_.end() ? i->second.mode_ : INTEREST_ALWAYS;
+}
+
+unsigned long long InterestGrid::GetCellKey(const Vector3& position) const
+{
+    return MakeCellKey(FloorToInt(position.x_ / cellSize_), FloorToInt(position.z_ / cellSize_));
+}
+
+void InterestGrid::InsertToCell(unsigned nodeID, NodeEntry& entry)
+{
+    entry.cell_ = GetCellKey(entry.position_);
+    entry.inCell_ = true;
+    cells_[entry.cell_].push_back(nodeID);
+}
+
+void InterestGrid::RemoveFromCell(unsigned nodeID, NodeEntry& entry)
+{
+    if (!entry.inCell_)
+        return;
+
+    auto i = cells_.find(entry.cell_);
+    if (i != cells_.end())
+    {
+        ea::vector<unsigned>& cellNodes = i->second;
+        auto j = ea::find(cellNodes.begin(), cellNodes.end(), nodeID);
+        if (j != cellNodes.end())
+        {
+            *j = cellNodes.back();
+            cellNodes.pop_back();
+        }
+        if (cellNodes.empty())
+            cells_.erase(i);
+    }
+    entry.inCell_ = false;
+}
+
+}
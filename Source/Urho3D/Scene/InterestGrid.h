@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <EASTL/hash_set.h>
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+
+#include "../Core/Mutex.h"
+#include "../Math/Vector3.h"
+
+namespace Urho3D
+{
+
+class Connection;
+class Scene;
+
+/// Interest management mode of a replicated node.
+enum InterestMode
+{
+    /// Changes are always sent to all connections.
+    INTEREST_ALWAYS = 0,
+    /// Changes are sent to connections whose observer is within the interest radius.
+    INTEREST_DISTANCE,
+    /// Changes are sent to the owner connection only.
+    INTEREST_OWNER
+};
+
+/// Return whether changes to a node are sent to a connection without waiting for the node to be found through the interest grid.
+inline bool IsInterestImmediate(InterestMode mode, Connection* owner, Connection* connection)
+{
+    return mode == INTEREST_ALWAYS || (mode == INTEREST_OWNER && owner == connection);
+}
+
+/// Default interest grid cell size.
+static const float DEFAULT_INTEREST_CELL_SIZE = 32.0f;
+/// Default interest radius around the connection observer position.
+static const float DEFAULT_INTEREST_RADIUS = 100.0f;
+
+/// Uniform grid of replicated nodes on the XZ plane. Finds the nodes relevant to a connection by visiting only the cells near its observer position.
+class URHO3D_API InterestGrid
+{
+public:
+    /// Construct.
+    InterestGrid();
+    /// Destruct.
+    ~InterestGrid();
+
+    /// Set whether interest management is used. When disabled, all nodes are treated as always relevant. Default false.
+    void SetEnabled(bool enable);
+    /// Set cell size. Should be in the order of the interest radius.
+    void SetCellSize(float size);
+    /// Set interest radius around the connection observer position.
+    void SetRadius(float radius);
+    /// Add node or change its mode. Position is read on the next update.
+    void SetNode(unsigned nodeID, InterestMode mode);
+    /// Remove node.
+    void RemoveNode(unsigned nodeID);
+    /// Mark node moved. Position is read on the next update. May be called from worker threads.
+    void MarkDirty(unsigned nodeID);
+    /// Update cells of moved nodes. Called by Scene before sending the server update.
+    void Update(Scene* scene);
+    /// Return IDs of distance-managed nodes within the interest radius of a position.
+    void Query(const Vector3& position, ea::vector<unsigned>& result) const;
+
+    /// Return whether interest management is used.
+    bool IsEnabled() const { return enabled_; }
+
+    /// Return cell size.
+    float GetCellSize() const { return cellSize_; }
+
+    /// Return interest radius.
+    float GetRadius() const { return radius_; }
+
+    /// Return number of nodes with non-default mode.
+    unsigned GetNumNodes() const { return nodes_.size(); }
+
+    /// Return number of occupied cells.
+    unsigned GetNumCells() const { return cells_.size(); }
+
+    /// Return microseconds spent in the last update.
+    long long GetUpdateTime() const { return updateTime_; }
+
+    /// Return interest mode of a node. Nodes not added and all nodes when disabled are always relevant.
+    InterestMode GetMode(unsigned nodeID) const;
+
+private:
+    /// Node entry.
+    struct NodeEntry
+    {
+        /// Interest mode.
+        InterestMode mode_{INTEREST_ALWAYS};
+        /// World position at the last update.
+        Vector3 position_;
+        /// Key of the cell containing the node.
+        unsigned long long cell_{};
+        /// Whether the entry is in a cell.
+        bool inCell_{};
+    };
+
+    /// Return cell key of a position.
+    unsigned long long GetCellKey(const Vector3& position) const;
+    /// Insert node into the cell of its position.
+    void InsertToCell(unsigned nodeID, NodeEntry& entry);
+    /// Remove node from its current cell.
+    void RemoveFromCell(unsigned nodeID, NodeEntry& entry);
+
+    /// Node entries by ID.
+    ea::unordered_map<unsigned, NodeEntry> nodes_;
+    /// Node IDs by cell key.
+    ea::unordered_map<unsigned long long, ea::vector<unsigned> > cells_;
+    /// Nodes moved since the last update.
+    ea::hash_set<unsigned> dirtyNodes_;
+    /// Dirty set lock.
+    SpinLock dirtyLock_;
+    /// Cell size.
+    float cellSize_;
+    /// Interest radius.
+    float radius_;
+    /// Microseconds spent in the last update.
+    long long updateTime_;
+    /// Enabled flag.
+    bool enabled_;
+};
+
+}
@@ -23,12 +23,8 @@
 #include "../Precompiled.h"
 
 #include "../IO/Log.h"
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-#include "../Physics/PhysicsEvents.h"
-#endif
 #include "../Scene/LogicComponent.h"
 #include "../Scene/Scene.h"
-#include "../Scene/SceneEvents.h"
 
 namespace Urho3D
 {
@@ -37,11 +33,15 @@ LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
+    threadSafeUpdate_(false),
     delayedStartCalled_(false)
 {
 }
 
-LogicComponent::~LogicComponent() = default;
+LogicComponent::~LogicComponent()
+{
+    RemoveUpdatePhases();
+}
 
 void LogicComponent::OnSetEnabled()
 {
@@ -73,6 +73,17 @@ void LogicComponent::SetUpdateEventMask(UpdateEventFlags mask)
     }
 }
 
+void LogicComponent::SetThreadSafeUpdate(bool enable)
+{
+    if (threadSafeUpdate_ != enable)
+    {
+        // The scene keeps thread-safe components in separate lists, so re-add to all phases
+        RemoveUpdatePhases();
+        threadSafeUpdate_ = enable;
+        UpdateEventSubscription();
+    }
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -92,15 +103,7 @@ void LogicComponent::OnSceneSet(Scene* scene)
     if (scene)
         UpdateEventSubscription();
     else
-    {
-        UnsubscribeFromEvent(E_SCENEUPDATE);
-        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-        UnsubscribeFromEvent(E_PHYSICSPRESTEP);
-        UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
-#endif
-        currentEventMask_ = USE_NO_EVENT;
-    }
+        RemoveUpdatePhases();
 }
 
 void LogicComponent::UpdateEventSubscription()
@@ -109,119 +112,65 @@ void LogicComponent::UpdateEventSubscription()
     if (!scene)
         return;
 
-    bool enabled = IsEnabledEffective();
-
-    bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
-    if (needUpdate && !(currentEventMask_ & USE_UPDATE))
+    if (updateScene_ != scene)
     {
-        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(LogicComponent, HandleSceneUpdate));
-        currentEventMask_ |= USE_UPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEUPDATE);
-        currentEventMask_ &= ~USE_UPDATE;
+        RemoveUpdatePhases();
+        updateScene_ = scene;
     }
 
-    bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
-    if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(LogicComponent, HandleScenePostUpdate));
-        currentEventMask_ |= USE_POSTUPDATE;
-    }
-    else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
-        currentEventMask_ &= ~USE_POSTUPDATE;
-    }
+    bool enabled = IsEnabledEffective();
 
+    SetUpdatePhaseEnabled(scene, LUP_UPDATE, enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_));
+    SetUpdatePhaseEnabled(scene, LUP_POSTUPDATE, enabled && (updateEventMask_ & USE_POSTUPDATE));
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-    Component* world = GetFixedUpdateSource();
-    if (!world)
-        return;
-
-    bool needFixedUpdate = enabled && (updateEventMask_ & USE_FIXEDUPDATE);
-    if (needFixedUpdate && !(currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        SubscribeToEvent(world, E_PHYSICSPRESTEP, URHO3D_HANDLER(LogicComponent, HandlePhysicsPreStep));
-        currentEventMask_ |= USE_FIXEDUPDATE;
-    }
-    else if (!needFixedUpdate && (currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPRESTEP);
-        currentEventMask_ &= ~USE_FIXEDUPDATE;
-    }
+    // Fixed phases are dispatched by the scene's fixed update source, so they work also when the physics world is created later
+    SetUpdatePhaseEnabled(scene, LUP_FIXEDUPDATE, enabled && (updateEventMask_ & USE_FIXEDUPDATE));
+    SetUpdatePhaseEnabled(scene, LUP_FIXEDPOSTUPDATE, enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE));
+#endif
+}
 
-    bool needFixedPostUpdate = enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE);
-    if (needFixedPostUpdate && !(currentEventMask_ & USE_FIXEDPOSTUPDATE))
+void LogicComponent::SetUpdatePhaseEnabled(Scene* scene, LogicUpdatePhase phase, bool enable)
+{
+    const UpdateEvent flag = static_cast<UpdateEvent>(1u << phase);
+    if (enable && !(currentEventMask_ & flag))
     {
-        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, URHO3D_HANDLER(LogicComponent, HandlePhysicsPostStep));
-        currentEventMask_ |= USE_FIXEDPOSTUPDATE;
+        scene->AddLogicUpdate(this, phase);
+        currentEventMask_ |= flag;
     }
-    else if (!needFixedPostUpdate && (currentEventMask_ & USE_FIXEDPOSTUPDATE))
+    else if (!enable && (currentEventMask_ & flag))
     {
-        UnsubscribeFromEvent(world, E_PHYSICSPOSTSTEP);
-        currentEventMask_ &= ~USE_FIXEDPOSTUPDATE;
+        scene->RemoveLogicUpdate(this, phase);
+        currentEventMask_ &= ~flag;
     }
-#endif
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::RemoveUpdatePhases()
 {
-    using namespace SceneUpdate;
-
-    // Execute user-defined delayed start function before first update
-    if (!delayedStartCalled_)
+    // The scene may already be in its destructor, in which case the lists are going away anyway
+    if (Scene* scene = updateScene_)
     {
-        DelayedStart();
-        delayedStartCalled_ = true;
-
-        // If did not need actual update events, unsubscribe now
-        if (!(updateEventMask_ & USE_UPDATE))
-        {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
-            currentEventMask_ &= ~USE_UPDATE;
-            return;
-        }
+        for (unsigned phase = 0; phase < MAX_LOGIC_UPDATE_PHASES; ++phase)
+            SetUpdatePhaseEnabled(scene, static_cast<LogicUpdatePhase>(phase), false);
     }
 
-    // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    currentEventMask_ = USE_NO_EVENT;
+    updateScene_.Reset();
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+bool LogicComponent::CallDelayedStart()
 {
-    using namespace ScenePostUpdate;
+    WeakPtr<LogicComponent> self(this);
 
-    // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
-}
-
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-
-void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
-{
-    using namespace PhysicsPreStep;
-
-    // Execute user-defined delayed start function before first fixed update if not called yet
-    if (!delayedStartCalled_)
-    {
-        DelayedStart();
-        delayedStartCalled_ = true;
-    }
-
-    // Execute user-defined fixed update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
-}
+    // Execute user-defined delayed start function before first update
+    DelayedStart();
+    if (self.Expired())
+        return false;
 
-void LogicComponent::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
-{
-    using namespace PhysicsPostStep;
+    delayedStartCalled_ = true;
 
-    // Execute user-defined fixed post-update function
-    FixedPostUpdate(eventData[P_TIMESTEP].GetFloat());
+    // If did not need actual update events, remove from the update list now
+    UpdateEventSubscription();
+    return true;
 }
 
-#endif
-
 }
@@ -43,11 +43,23 @@ enum UpdateEvent : unsigned
 };
 URHO3D_FLAGSET(UpdateEvent, UpdateEventFlags);
 
-/// Helper base class for user-defined game logic components that hooks up to update events and forwards them to virtual functions similar to ScriptInstance class.
+/// Logic component update phase. The matching UpdateEvent bit is 1 << phase.
+enum LogicUpdatePhase
+{
+    LUP_UPDATE = 0,
+    LUP_POSTUPDATE,
+    LUP_FIXEDUPDATE,
+    LUP_FIXEDPOSTUPDATE,
+    MAX_LOGIC_UPDATE_PHASES
+};
+
+/// Helper base class for user-defined game logic components. The scene calls the virtual update functions directly from its update lists instead of sending events.
 class URHO3D_API LogicComponent : public Component
 {
     URHO3D_OBJECT(LogicComponent, Component);
 
+    friend class Scene;
+
     /// Construct.
     explicit LogicComponent(Context* context);
     /// Destruct.
@@ -80,6 +92,12 @@ class URHO3D_API LogicComponent : public Component
     /// Return what update events are subscribed to.
     UpdateEventFlags GetUpdateEventMask() const { return updateEventMask_; }
 
+    /// Set whether the update functions are thread-safe. Thread-safe components are updated in parallel on the work queue before the other components of the same phase. They may only modify their own node hierarchy and must not send events, create or remove scene objects, or change update subscriptions from the update functions. DelayedStart() is still called on the main thread. Like the update event mask, this is not an attribute.
+    void SetThreadSafeUpdate(bool enable);
+
+    /// Return whether the update functions are thread-safe.
+    bool IsThreadSafeUpdate() const { return threadSafeUpdate_; }
+
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
 
@@ -90,22 +108,25 @@ protected:
     void OnSceneSet(Scene* scene) override;
 
 private:
-    /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
+    /// Add to/remove from the scene update lists based on current enabled state and update event mask.
     void UpdateEventSubscription();
-    /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-    /// Handle physics pre-step event.
-    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
-    /// Handle physics post-step event.
-    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
-#endif
+    /// Add to or remove from the scene update list of one phase.
+    void SetUpdatePhaseEnabled(Scene* scene, LogicUpdatePhase phase, bool enable);
+    /// Remove from all scene update lists.
+    void RemoveUpdatePhases();
+    /// Call DelayedStart() and drop the update phase if it was only needed for the delayed start. Called by Scene on the main thread. Return false if the component was destroyed.
+    bool CallDelayedStart();
+
     /// Requested event subscription mask.
     UpdateEventFlags updateEventMask_;
     /// Current event subscription mask.
     UpdateEventFlags currentEventMask_;
+    /// Scene whose update lists the component is in.
+    WeakPtr<Scene> updateScene_;
+    /// Index in the scene update list of each phase. Maintained by Scene.
+    unsigned updateIndices_[MAX_LOGIC_UPDATE_PHASES]{};
+    /// Thread-safe update flag.
+    bool threadSafeUpdate_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
 };
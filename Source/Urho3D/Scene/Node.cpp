@@ -124,14 +124,15 @@ bool Node::Save(Serializer& dest) const
 
     // Write components
     dest.WriteVLE(GetNumPersistentComponents());
+    // Use a separate buffer to be able to skip failing components during deserialization. It is reused by all components
+    VectorBuffer compBuffer;
     for (unsigned i = 0; i < components_.size(); ++i)
     {
         Component* component = components_[i];
         if (component->IsTemporary())
             continue;
 
-        // Create a separate buffer to be able to skip failing components during deserialization
-        VectorBuffer compBuffer;
+        compBuffer.Clear();
         if (!component->Save(compBuffer))
             return false;
         dest.WriteVLE(compBuffer.GetSize());
@@ -1708,6 +1709,7 @@ void Node::PrepareNetworkUpdate()
 
     const ea::vector<AttributeInfo>* attributes = networkState_->attributes_;
     unsigned numAttributes = attributes->size();
+    const InterestMode interestMode = scene_->GetInterestGrid().GetMode(id_);
 
     // Check for attribute changes
     for (unsigned i = 0; i < numAttributes; ++i)
@@ -1730,12 +1732,8 @@ void Node::PrepareNetworkUpdate()
                 auto* nodeState = static_cast<NodeReplicationState*>(*j);
                 nodeState->dirtyAttributes_.Set(i);
 
-                // Add node to the dirty set if not added yet
-                if (!nodeState->markedDirty_)
-                {
-                    nodeState->markedDirty_ = true;
-                    nodeState->sceneState_->dirtyNodes_.insert(id_);
-                }
+                // Add node to the dirty set if not added yet, unless interest management finds it later
+                nodeState->MarkDirty(id_, IsInterestImmediate(interestMode, impl_->owner_, nodeState->connection_));
             }
         }
     }
@@ -1754,12 +1752,7 @@ void Node::PrepareNetworkUpdate()
             {
                 auto* nodeState = static_cast<NodeReplicationState*>(*j);
                 nodeState->dirtyVars_.insert(i->first);
-
-                if (!nodeState->markedDirty_)
-                {
-                    nodeState->markedDirty_ = true;
-                    nodeState->sceneState_->dirtyNodes_.insert(id_);
-                }
+                nodeState->MarkDirty(id_, IsInterestImmediate(interestMode, impl_->owner_, nodeState->connection_));
             }
         }
     }
@@ -1790,11 +1783,8 @@ void Node::MarkReplicationDirty()
              j != networkState_->replicationStates_.end(); ++j)
         {
             auto* nodeState = static_cast<NodeReplicationState*>(*j);
-            if (!nodeState->markedDirty_)
-            {
-                nodeState->markedDirty_ = true;
-                nodeState->sceneState_->dirtyNodes_.insert(id_);
-            }
+            // Structural changes are sent regardless of interest management
+            nodeState->MarkDirty(id_, true);
         }
     }
 }
@@ -1903,7 +1893,7 @@ void Node::SetTransformSilent(const Matrix3x4& matrix)
 void Node::OnAttributeAnimationAdded()
 {
     if (attributeAnimationInfos_.size() == 1)
-        SubscribeToEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE, URHO3D_HANDLER(Node, HandleAttributeAnimationUpdate));
+        SubscribeToEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE, &Node::HandleAttributeAnimationUpdate);
 }
 
 void Node::OnAttributeAnimationRemoved()
@@ -2260,11 +2250,9 @@ void Node::RemoveComponent(ea::vector<SharedPtr<Component> >::iterator i)
     components_.erase(i);
 }
 
-void Node::HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData)
+void Node::HandleAttributeAnimationUpdate(const SceneUpdate::Data& eventData)
 {
-    using namespace AttributeAnimationUpdate;
-
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
+    UpdateAttributeAnimations(eventData.timeStep_);
 }
 
 }
@@ -29,6 +29,7 @@
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
 class Component;
 class Connection;
 class Node;
@@ -662,7 +663,7 @@ private:
     /// Remove a component from this node with the specified iterator.
     void RemoveComponent(ea::vector<SharedPtr<Component> >::iterator i);
     /// Handle attribute animation update event.
-    void HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleAttributeAnimationUpdate(const SceneUpdate::Data& eventData);
 
     /// World-space transform matrix.
     mutable Matrix3x4 worldTransform_;
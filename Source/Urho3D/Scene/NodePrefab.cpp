@@ -0,0 +1,277 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../IO/Log.h"
+#include "../Scene/Component.h"
+#include "../Scene/NodePrefab.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const AttributeModeFlags ID_ATTRIBUTE_MODES = AM_NODEID | AM_COMPONENTID | AM_NODEIDVECTOR;
+
+static unsigned FindIndex(const ea::unordered_map<unsigned, unsigned>& indices, unsigned id)
+{
+    auto i = indices.find(id);
+    return i != indices.end() ? i->second : M_MAX_UNSIGNED;
+}
+
+NodePrefab::NodePrefab() = default;
+
+NodePrefab::~NodePrefab() = default;
+
+bool NodePrefab::Compile(Node* node)
+{
+    Clear();
+
+    if (!node)
+    {
+        URHO3D_LOGERROR("Null source node given for NodePrefab");
+        return false;
+    }
+
+    URHO3D_PROFILE("CompilePrefab");
+
+    ea::unordered_map<unsigned, unsigned> nodeIndices;
+    ea::unordered_map<unsigned, unsigned> componentIndices;
+    ea::vector<Component*> sourceComponents;
+    CompileNode(node, M_MAX_UNSIGNED, nodeIndices, componentIndices, sourceComponents);
+
+    // ID attributes can refer to any node or component of the hierarchy, so they are compiled last
+    for (unsigned i = 0; i < sourceComponents.size(); ++i)
+        CompileIDReferences(sourceComponents[i], i, nodeIndices, componentIndices);
+
+    return true;
+}
+
+void NodePrefab::Clear()
+{
+    nodes_.clear();
+    components_.clear();
+    attributes_.clear();
+    references_.clear();
+}
+
+Node* NodePrefab::Instantiate(Node* parent, const Vector3& position, const Quaternion& rotation, CreateMode mode) const
+{
+    if (!parent || nodes_.empty())
+        return nullptr;
+
+    URHO3D_PROFILE("InstantiatePrefab");
+
+    ea::vector<Node*> nodes(nodes_.size());
+    ea::vector<Component*> components(components_.size(), nullptr);
+
+    const auto applyAttributes = [this](Serializable* serializable, unsigned first, unsigned num)
+    {
+        const ea::vector<AttributeInfo>* attributes = serializable->GetAttributes();
+        if (!attributes)
+            return;
+
+        for (unsigned i = first; i < first + num; ++i)
+        {
+            const AttributeValue& value = attributes_[i];
+            if (value.index_ < attributes->size())
+                serializable->OnSetAttribute(attributes->at(value.index_), value.value_);
+        }
+    };
+
+    // Create in the same order as a scene load: node attributes, then components, then child nodes
+    for (unsigned i = 0; i < nodes_.size(); ++i)
+    {
+        const NodeEntry& entry = nodes_[i];
+        Node* nodeParent = i ? nodes[entry.parent_] : parent;
+        Node* node = nodeParent->CreateChild(0, (mode == REPLICATED && entry.replicated_) ? REPLICATED : LOCAL);
+        nodes[i] = node;
+        applyAttributes(node, entry.firstAttribute_, entry.numAttributes_);
+
+        for (unsigned j = entry.firstComponent_; j < entry.firstComponent_ + entry.numComponents_; ++j)
+        {
+            const ComponentEntry& componentEntry = components_[j];
+            Component* component = node->CreateComponent(componentEntry.type_,
+                (mode == REPLICATED && componentEntry.replicated_) ? REPLICATED : LOCAL);
+            components[j] = component;
+            if (component)
+                applyAttributes(component, componentEntry.firstAttribute_, componentEntry.numAttributes_);
+        }
+    }
+
+    // Remap ID attributes to the new nodes and components. References outside the prefab behave as in SceneResolver
+    for (const IDReference& reference : references_)
+    {
+        Component* component = components[reference.component_];
+        if (!component)
+            continue;
+
+        const ea::vector<AttributeInfo>* attributes = component->GetAttributes();
+        if (!attributes || reference.index_ >= attributes->size())
+            continue;
+
+        Variant value;
+        if (reference.mode_ & AM_NODEIDVECTOR)
+        {
+            VariantVector ids;
+            ids.reserve(reference.ids_.size() + 1);
+            ids.push_back((unsigned)reference.ids_.size());
+            for (unsigned target : reference.targets_)
+                ids.push_back(target != M_MAX_UNSIGNED ? nodes[target]->GetID() : 0);
+            value = ids;
+        }
+        else
+        {
+            const unsigned target = reference.targets_.front();
+            if (target == M_MAX_UNSIGNED)
+                value = reference.ids_.front();
+            else if (reference.mode_ & AM_NODEID)
+                value = nodes[target]->GetID();
+            else
+                value = components[target] ? components[target]->GetID() : 0;
+        }
+
+        component->OnSetAttribute(attributes->at(reference.index_), value);
+    }
+
+    Node* root = nodes.front();
+    root->SetTransform(position, rotation);
+    root->ApplyAttributes();
+    return root;
+}
+
+void NodePrefab::CompileNode(Node* node, unsigned parent, ea::unordered_map<unsigned, unsigned>& nodeIndices,
+    ea::unordered_map<unsigned, unsigned>& componentIndices, ea::vector<Component*>& sourceComponents)
+{
+    const unsigned index = nodes_.size();
+    nodeIndices[node->GetID()] = index;
+
+    NodeEntry entry;
+    entry.parent_ = parent;
+    entry.firstComponent_ = components_.size();
+    entry.numComponents_ = 0;
+    entry.replicated_ = node->IsReplicated();
+    CompileAttributes(node, entry.firstAttribute_, entry.numAttributes_);
+
+    for (Component* component : node->GetComponents())
+    {
+        if (component->IsTemporary())
+            continue;
+
+        componentIndices[component->GetID()] = components_.size();
+        sourceComponents.push_back(component);
+
+        ComponentEntry componentEntry;
+        componentEntry.type_ = component->GetType();
+        componentEntry.replicated_ = component->IsReplicated();
+        CompileAttributes(component, componentEntry.firstAttribute_, componentEntry.numAttributes_);
+        components_.push_back(componentEntry);
+        ++entry.numComponents_;
+    }
+
+    nodes_.push_back(entry);
+
+    for (Node* child : node->GetChildren())
+    {
+        if (!child->IsTemporary())
+            CompileNode(child, index, nodeIndices, componentIndices, sourceComponents);
+    }
+}
+
+void NodePrefab::CompileAttributes(Serializable* serializable, unsigned& first, unsigned& num)
+{
+    first = attributes_.size();
+
+    const ea::vector<AttributeInfo>* attributes = serializable->GetAttributes();
+    if (attributes)
+    {
+        for (unsigned i = 0; i < attributes->size(); ++i)
+        {
+            const AttributeInfo& attr = attributes->at(i);
+            // Do not copy network-only attributes, as they may have unintended side effects
+            if (!(attr.mode_ & AM_FILE) || (attr.mode_ & AM_FILEREADONLY) == AM_FILEREADONLY || (attr.mode_ & ID_ATTRIBUTE_MODES))
+                continue;
+
+            Variant value;
+            serializable->OnGetAttribute(attr, value);
+            // A new object already has the default values, as also assumed by XML serialization
+            if (value == serializable->GetAttributeDefault(i) && !serializable->SaveDefaultAttributes())
+                continue;
+
+            attributes_.push_back({i, value});
+        }
+    }
+
+    num = attributes_.size() - first;
+}
+
+void NodePrefab::CompileIDReferences(Component* component, unsigned componentIndex,
+    const ea::unordered_map<unsigned, unsigned>& nodeIndices, const ea::unordered_map<unsigned, unsigned>& componentIndices)
+{
+    const ea::vector<AttributeInfo>* attributes = component->GetAttributes();
+    if (!attributes)
+        return;
+
+    for (unsigned i = 0; i < attributes->size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->at(i);
+        if (!(attr.mode_ & AM_FILE) || !(attr.mode_ & ID_ATTRIBUTE_MODES))
+            continue;
+
+        Variant value;
+        component->OnGetAttribute(attr, value);
+
+        IDReference reference;
+        reference.component_ = componentIndex;
+        reference.index_ = i;
+        reference.mode_ = attr.mode_;
+
+        if (attr.mode_ & AM_NODEIDVECTOR)
+        {
+            // The first index stores the number of IDs redundantly
+            const VariantVector& ids = value.GetVariantVector();
+            if (ids.empty())
+                continue;
+
+            for (unsigned j = 1; j < ids.size(); ++j)
+            {
+                reference.ids_.push_back(ids[j].GetUInt());
+                reference.targets_.push_back(FindIndex(nodeIndices, ids[j].GetUInt()));
+            }
+        }
+        else
+        {
+            const unsigned id = value.GetUInt();
+            if (!id)
+                continue;
+
+            reference.ids_.push_back(id);
+            reference.targets_.push_back(FindIndex((attr.mode_ & AM_NODEID) ? nodeIndices : componentIndices, id));
+        }
+
+        references_.push_back(ea::move(reference));
+    }
+}
+
+}
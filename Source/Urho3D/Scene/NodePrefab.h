@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+
+#include "../Container/RefCounted.h"
+#include "../Core/Attribute.h"
+#include "../Core/Variant.h"
+#include "../Scene/Node.h"
+
+namespace Urho3D
+{
+
+/// Node hierarchy compiled into flat arrays of attribute values. Instantiating it does not parse data, read attributes from a source object or look up IDs.
+class URHO3D_API NodePrefab : public RefCounted
+{
+public:
+    /// Construct.
+    NodePrefab();
+    /// Destruct.
+    ~NodePrefab() override;
+
+    /// Compile from a node, its components and child nodes. Temporary nodes and components are skipped. Return true if successful.
+    bool Compile(Node* node);
+    /// Clear the compiled hierarchy.
+    void Clear();
+    /// Instantiate as a child node, with position and rotation in the parent's space. Return the root node if successful.
+    Node* Instantiate(Node* parent, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED) const;
+
+    /// Return whether nothing has been compiled.
+    bool IsEmpty() const { return nodes_.empty(); }
+    /// Return number of nodes.
+    unsigned GetNumNodes() const { return nodes_.size(); }
+    /// Return number of components.
+    unsigned GetNumComponents() const { return components_.size(); }
+
+private:
+    /// Attribute value which differs from the default.
+    struct AttributeValue
+    {
+        /// Attribute index.
+        unsigned index_;
+        /// Value.
+        Variant value_;
+    };
+
+    /// Compiled node.
+    struct NodeEntry
+    {
+        /// Index of the parent node. Unused for the root node.
+        unsigned parent_;
+        /// Index of the first attribute value.
+        unsigned firstAttribute_;
+        /// Number of attribute values.
+        unsigned numAttributes_;
+        /// Index of the first component.
+        unsigned firstComponent_;
+        /// Number of components.
+        unsigned numComponents_;
+        /// Replicated flag.
+        bool replicated_;
+    };
+
+    /// Compiled component.
+    struct ComponentEntry
+    {
+        /// Type.
+        StringHash type_;
+        /// Index of the first attribute value.
+        unsigned firstAttribute_;
+        /// Number of attribute values.
+        unsigned numAttributes_;
+        /// Replicated flag.
+        bool replicated_;
+    };
+
+    /// Node or component ID attribute. Assigned after the whole hierarchy has been created.
+    struct IDReference
+    {
+        /// Index of the component holding the attribute.
+        unsigned component_;
+        /// Attribute index.
+        unsigned index_;
+        /// Attribute mode, which tells whether the attribute is AM_NODEID, AM_COMPONENTID or AM_NODEIDVECTOR.
+        AttributeModeFlags mode_;
+        /// Original IDs.
+        ea::vector<unsigned> ids_;
+        /// Indices of the referred nodes or components within the prefab. M_MAX_UNSIGNED if outside the prefab.
+        ea::vector<unsigned> targets_;
+    };
+
+    /// Compile a node and its children recursively.
+    void CompileNode(Node* node, unsigned parent, ea::unordered_map<unsigned, unsigned>& nodeIndices,
+        ea::unordered_map<unsigned, unsigned>& componentIndices, ea::vector<Component*>& sourceComponents);
+    /// Compile non-default attribute values of an object, except for ID attributes.
+    void CompileAttributes(Serializable* serializable, unsigned& first, unsigned& num);
+    /// Compile the ID attributes of a component.
+    void CompileIDReferences(Component* component, unsigned componentIndex, const ea::unordered_map<unsigned, unsigned>& nodeIndices,
+        const ea::unordered_map<unsigned, unsigned>& componentIndices);
+
+    /// Nodes in depth-first order, so that parents precede their children.
+    ea::vector<NodeEntry> nodes_;
+    /// Components in node order.
+    ea::vector<ComponentEntry> components_;
+    /// Attribute values.
+    ea::vector<AttributeValue> attributes_;
+    /// ID attributes of the components.
+    ea::vector<IDReference> references_;
+};
+
+}
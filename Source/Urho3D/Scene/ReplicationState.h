@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <EASTL/hash_set.h>
 #include <EASTL/shared_ptr.h>
 #include <EASTL/unique_ptr.h>
 #include <EASTL/unordered_map.h>
@@ -35,6 +36,8 @@ namespace Urho3D
 {
 
 static const unsigned MAX_NETWORK_ATTRIBUTES = 64;
+/// Number of node transform changes remembered per client for snapshot delta compression. Covers the whole snapshot history, so that a node which moves every tick still has a baseline.
+static const unsigned SNAPSHOT_NODE_HISTORY_SIZE = 32;
 
 class Component;
 class Connection;
@@ -118,6 +121,100 @@ struct URHO3D_API DirtyBits
     unsigned char count_{};
 };
 
+/// Node transform quantized for snapshot replication.
+struct URHO3D_API QuantizedTransform
+{
+    /// Test for equality.
+    bool operator ==(const QuantizedTransform& rhs) const
+    {
+        return position_[0] == rhs.position_[0] && position_[1] == rhs.position_[1] && position_[2] == rhs.position_[2] &&
+            rotation_[0] == rhs.rotation_[0] && rotation_[1] == rhs.rotation_[1] && rotation_[2] == rhs.rotation_[2] &&
+            rotationLargest_ == rhs.rotationLargest_;
+    }
+
+    /// Test for inequality.
+    bool operator !=(const QuantizedTransform& rhs) const { return !(*this == rhs); }
+
+    /// Position in units of position precision.
+    int position_[3]{};
+    /// Three smallest rotation quaternion components.
+    unsigned short rotation_[3]{};
+    /// Index of the omitted largest rotation quaternion component.
+    unsigned char rotationLargest_{};
+};
+
+/// Transforms of a node as seen by one client in the snapshots sent to it. Only changes are recorded, so the transform in a given snapshot is that of the latest record not newer than it.
+struct URHO3D_API NodeSnapshotHistory
+{
+    /// Record of the transform the client has for the node since a snapshot.
+    struct Record
+    {
+        /// Transform.
+        QuantizedTransform transform_;
+        /// Snapshot sequence number.
+        unsigned sequence_{};
+        /// Whether the client has a transform for the node.
+        bool valid_{};
+    };
+
+    /// Record the transform the client has after a snapshot. Null transform means the client has none.
+    void Push(unsigned sequence, const QuantizedTransform* transform)
+    {
+        if (size_)
+        {
+            const Record& last = records_[(first_ + size_ - 1) % SNAPSHOT_NODE_HISTORY_SIZE];
+            if (transform ? (last.valid_ && last.transform_ == *transform) : !last.valid_)
+                return;
+        }
+        else if (!transform)
+            return;
+
+        if (size_ == SNAPSHOT_NODE_HISTORY_SIZE)
+        {
+            first_ = (first_ + 1) % SNAPSHOT_NODE_HISTORY_SIZE;
+            --size_;
+        }
+
+        Record& record = records_[(first_ + size_) % SNAPSHOT_NODE_HISTORY_SIZE];
+        record.sequence_ = sequence;
+        record.valid_ = transform != nullptr;
+        if (transform)
+            record.transform_ = *transform;
+        ++size_;
+    }
+
+    /// Return the transform the client has after a snapshot, or null if unknown.
+    const QuantizedTransform* Find(unsigned sequence) const
+    {
+        for (unsigned i = size_; i > 0; --i)
+        {
+            const Record& record = records_[(first_ + i - 1) % SNAPSHOT_NODE_HISTORY_SIZE];
+            if (record.sequence_ <= sequence)
+                return record.valid_ ? &record.transform_ : nullptr;
+        }
+        return nullptr;
+    }
+
+    /// Return the transform the client has after the latest snapshot, or null if none.
+    const QuantizedTransform* GetLatest() const
+    {
+        if (!size_)
+            return nullptr;
+        const Record& record = records_[(first_ + size_ - 1) % SNAPSHOT_NODE_HISTORY_SIZE];
+        return record.valid_ ? &record.transform_ : nullptr;
+    }
+
+    /// Forget all records.
+    void Clear() { first_ = size_ = 0; }
+
+    /// Records in a ring buffer.
+    Record records_[SNAPSHOT_NODE_HISTORY_SIZE];
+    /// Index of the oldest record.
+    unsigned char first_{};
+    /// Number of records.
+    unsigned char size_{};
+};
+
 /// Per-object attribute state for network replication, allocated on demand.
 struct URHO3D_API NetworkState
 {
@@ -168,8 +265,13 @@ struct URHO3D_API NodeReplicationState : public ReplicationState
     ea::unordered_map<unsigned, ComponentReplicationState> componentStates_;
     /// Interest management priority accumulator.
     float priorityAcc_{};
-    /// Whether exists in the SceneState's dirty set.
+    /// Transforms sent in snapshots, used as delta compression baselines.
+    NodeSnapshotHistory snapshotHistory_;
+    /// Whether has changes not sent yet. Nodes waiting to become relevant through the interest grid are not in the SceneState's dirty set.
     bool markedDirty_{};
+
+    /// Mark changes pending. Add to the dirty set unless the node is found through the interest grid.
+    inline void MarkDirty(unsigned nodeID, bool immediate);
 };
 
 /// Per-user scene network replication state.
@@ -179,12 +281,36 @@ struct URHO3D_API SceneReplicationState : public ReplicationState
     ea::unordered_map<unsigned, NodeReplicationState> nodeStates_;
     /// Dirty node IDs.
     ea::hash_set<unsigned> dirtyNodes_;
+    /// Sequence number of the latest sent snapshot.
+    unsigned snapshotSequence_{};
+    /// Sequence number of the latest snapshot acknowledged by the client.
+    unsigned snapshotAcked_{};
+    /// Sequence number of the first snapshot sent since the baselines were reset. Older acknowledgements are ignored.
+    unsigned snapshotResetSequence_{};
+    /// Whether any snapshot has been acknowledged since the baselines were reset.
+    bool hasSnapshotAcked_{};
+    /// Position precision the baselines were quantized with.
+    float snapshotPositionPrecision_{};
+    /// Rotation component bits the baselines were quantized with.
+    unsigned snapshotRotationBits_{};
 
     void Clear()
     {
         nodeStates_.clear();
         dirtyNodes_.clear();
+        snapshotResetSequence_ = snapshotSequence_ + 1;
+        hasSnapshotAcked_ = false;
     }
 };
 
+void NodeReplicationState::MarkDirty(unsigned nodeID, bool immediate)
+{
+    if (!markedDirty_ || immediate)
+    {
+        markedDirty_ = true;
+        if (immediate)
+            sceneState_->dirtyNodes_.insert(nodeID);
+    }
+}
+
 }
@@ -35,6 +35,7 @@
 #include "../Resource/JSONFile.h"
 #include "../Scene/CameraViewport.h"
 #include "../Scene/Component.h"
+#include "../Scene/NodePrefab.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
@@ -46,6 +47,8 @@
 #include "../Scene/UnknownComponent.h"
 #include "../Scene/ValueAnimation.h"
 
+#include <EASTL/sort.h>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -57,6 +60,7 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+static const unsigned LOGIC_UPDATE_GRAIN_SIZE = 64;
 
 Scene::Scene(Context* context) :
     Node(context),
@@ -78,7 +82,7 @@ Scene::Scene(Context* context) :
     SetID(GetFreeNodeID(REPLICATED));
     NodeAdded(this);
 
-    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(Scene, HandleUpdate));
+    SubscribeToEvent(E_UPDATE, &Scene::HandleUpdate);
     SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(Scene, HandleResourceBackgroundLoaded));
 }
 
@@ -616,6 +620,17 @@ Node* Scene::InstantiateJSON(Deserializer& source, const Vector3& position, cons
     return InstantiateJSON(json->GetRoot(), position, rotation, mode);
 }
 
+Node* Scene::InstantiatePrefab(const NodePrefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    if (!prefab || prefab->IsEmpty())
+    {
+        URHO3D_LOGERROR("Null or empty prefab given for InstantiatePrefab");
+        return nullptr;
+    }
+
+    return prefab->Instantiate(this, position, rotation, mode);
+}
+
 void Scene::Clear(bool clearReplicated, bool clearLocal)
 {
     StopAsyncLoading();
@@ -775,20 +790,19 @@ void Scene::Update(float timeStep)
 
     timeStep *= timeScale_;
 
-    using namespace SceneUpdate;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_SCENE] = this;
-    eventData[P_TIMESTEP] = timeStep;
+    SceneUpdate::Data eventData;
+    eventData.scene_ = this;
+    eventData.timeStep_ = timeStep;
 
     // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
+    SendTypedEvent(E_SCENEUPDATE, eventData);
+    UpdateLogicComponents(LUP_UPDATE, timeStep);
 
     // Update scene attribute animation.
-    SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
+    SendTypedEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
 
     // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
-    SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
+    SendTypedEvent(E_SCENESUBSYSTEMUPDATE, eventData);
 
     // Update transform smoothing
     {
@@ -805,7 +819,8 @@ void Scene::Update(float timeStep)
     }
 
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    SendTypedEvent(E_SCENEPOSTUPDATE, eventData);
+    UpdateLogicComponents(LUP_POSTUPDATE, timeStep);
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -844,6 +859,125 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.push_back(component);
 }
 
+void Scene::AddLogicUpdate(LogicComponent* component, LogicUpdatePhase phase)
+{
+    LogicUpdateList& list = GetLogicUpdateList(component, phase);
+    component->updateIndices_[phase] = list.components_.size();
+    list.components_.push_back(component);
+    list.unsorted_ = true;
+}
+
+void Scene::RemoveLogicUpdate(LogicComponent* component, LogicUpdatePhase phase)
+{
+    LogicUpdateList& list = GetLogicUpdateList(component, phase);
+    const unsigned index = component->updateIndices_[phase];
+    assert(index < list.components_.size() && list.components_[index] == component);
+    list.components_[index] = nullptr;
+    ++list.numRemoved_;
+}
+
+void Scene::UpdateLogicComponents(LogicUpdatePhase phase, float timeStep)
+{
+    static void (LogicComponent::* const updateFunctions[MAX_LOGIC_UPDATE_PHASES])(float) = {
+        &LogicComponent::Update,
+        &LogicComponent::PostUpdate,
+        &LogicComponent::FixedUpdate,
+        &LogicComponent::FixedPostUpdate
+    };
+    const auto updateFunction = updateFunctions[phase];
+    const bool startPhase = phase == LUP_UPDATE || phase == LUP_FIXEDUPDATE;
+
+    LogicUpdateList& threadedList = threadedLogicUpdates_[phase];
+    if (!threadedList.components_.empty())
+    {
+        URHO3D_PROFILE("UpdateThreadedLogic");
+
+        CompactLogicUpdateList(threadedList, phase);
+
+        // Delayed start may touch the scene freely, so run it on the main thread first
+        if (startPhase)
+        {
+            for (unsigned i = 0; i < threadedList.components_.size(); ++i)
+            {
+                LogicComponent* component = threadedList.components_[i];
+                if (component && !component->IsDelayedStartCalled())
+                    component->CallDelayedStart();
+            }
+        }
+
+        threadedList.updating_ = true;
+        BeginThreadedUpdate();
+        GetSubsystem<WorkQueue>()->ParallelFor(0, threadedList.components_.size(), LOGIC_UPDATE_GRAIN_SIZE,
+            [&](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+        {
+            for (unsigned i = begin; i < end; ++i)
+            {
+                if (LogicComponent* component = threadedList.components_[i])
+                    (component->*updateFunction)(timeStep);
+            }
+        });
+        EndThreadedUpdate();
+        threadedList.updating_ = false;
+    }
+
+    LogicUpdateList& list = logicUpdates_[phase];
+    if (!list.components_.empty())
+    {
+        URHO3D_PROFILE("UpdateLogic");
+
+        CompactLogicUpdateList(list, phase);
+
+        // Components may be added or removed by the update functions. Additions go to the end of the list and removals
+        // leave null entries, so indexing stays valid. Nested updates of the same phase leave the list uncompacted.
+        const bool wasUpdating = list.updating_;
+        list.updating_ = true;
+        for (unsigned i = 0; i < list.components_.size(); ++i)
+        {
+            LogicComponent* component = list.components_[i];
+            if (!component)
+                continue;
+
+            if (startPhase && !component->IsDelayedStartCalled())
+            {
+                // The component may remove itself from the list when the phase was only needed for the delayed start
+                if (!component->CallDelayedStart() || !list.components_[i])
+                    continue;
+            }
+
+            (component->*updateFunction)(timeStep);
+        }
+        list.updating_ = wasUpdating;
+    }
+}
+
+Scene::LogicUpdateList& Scene::GetLogicUpdateList(LogicComponent* component, LogicUpdatePhase phase)
+{
+    return component->IsThreadSafeUpdate() ? threadedLogicUpdates_[phase] : logicUpdates_[phase];
+}
+
+void Scene::CompactLogicUpdateList(LogicUpdateList& list, LogicUpdatePhase phase)
+{
+    if (list.updating_ || (!list.numRemoved_ && !list.unsorted_))
+        return;
+
+    if (list.numRemoved_)
+    {
+        list.components_.erase(ea::remove(list.components_.begin(), list.components_.end(), nullptr), list.components_.end());
+        list.numRemoved_ = 0;
+    }
+
+    // Keep components of the same type together so that consecutive calls go to the same update function
+    if (list.unsorted_)
+    {
+        ea::stable_sort(list.components_.begin(), list.components_.end(),
+            [](const LogicComponent* lhs, const LogicComponent* rhs) { return lhs->GetType().Value() < rhs->GetType().Value(); });
+        list.unsorted_ = false;
+    }
+
+    for (unsigned i = 0; i < list.components_.size(); ++i)
+        list.components_[i]->updateIndices_[phase] = i;
+}
+
 unsigned Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -1111,6 +1245,9 @@ void Scene::PrepareNetworkUpdate()
 
     networkUpdateNodes_.clear();
     networkUpdateComponents_.clear();
+
+    if (interestGrid_.IsEnabled())
+        interestGrid_.Update(this);
 }
 
 void Scene::CleanupConnection(Connection* connection)
@@ -1166,13 +1303,12 @@ void Scene::MarkReplicationDirty(Node* node)
     }
 }
 
-void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void Scene::HandleUpdate(const Update::Data& eventData)
 {
     if (!updateEnabled_)
         return;
 
-    using namespace Update;
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
@@ -27,13 +27,17 @@
 #include "../Core/Mutex.h"
 #include "../Resource/XMLElement.h"
 #include "../Resource/JSONFile.h"
+#include "../Scene/InterestGrid.h"
+#include "../Scene/LogicComponent.h"
 #include "../Scene/Node.h"
 #include "../Scene/SceneResolver.h"
 
 namespace Urho3D
 {
 
+namespace Update { struct Data; }
 class File;
+class NodePrefab;
 class PackageFile;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
@@ -140,6 +144,8 @@ public:
         (const JSONValue& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
     /// Instantiate scene content from JSON data. Return root node if successful.
     Node* InstantiateJSON(Deserializer& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Instantiate a compiled node prefab. Faster than instantiating from data when the same content is spawned repeatedly. Return root node if successful.
+    Node* InstantiatePrefab(const NodePrefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
 
     /// Clear scene completely of either replicated, local or all nodes and components.
     void Clear(bool clearReplicated = true, bool clearLocal = true);
@@ -208,6 +214,10 @@ public:
 
     /// Return required package files.
     const ea::vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
+    /// Return interest management grid of replicated nodes.
+    InterestGrid& GetInterestGrid() { return interestGrid_; }
+    /// Return interest management grid of replicated nodes.
+    const InterestGrid& GetInterestGrid() const { return interestGrid_; }
 
     /// Return a node user variable name, or empty if not registered.
     const ea::string& GetVarName(StringHash hash) const;
@@ -224,6 +234,13 @@ public:
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
 
+    /// Add a logic component to the update list of a phase. Called by LogicComponent.
+    void AddLogicUpdate(LogicComponent* component, LogicUpdatePhase phase);
+    /// Remove a logic component from the update list of a phase. Safe to call while the list is being updated. Called by LogicComponent.
+    void RemoveLogicUpdate(LogicComponent* component, LogicUpdatePhase phase);
+    /// Call the update function of a phase on all logic components in its update list. Fixed phases are updated by the fixed update source.
+    void UpdateLogicComponents(LogicUpdatePhase phase, float timeStep);
+
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -260,8 +277,25 @@ public:
     void MarkReplicationDirty(Node* node);
 
 private:
+    /// Logic components receiving one update phase.
+    struct LogicUpdateList
+    {
+        /// Components grouped by type. Removed components are left as null until the list is compacted, so that indices stay valid during update.
+        ea::vector<LogicComponent*> components_;
+        /// Number of null entries.
+        unsigned numRemoved_{};
+        /// Whether components were appended since the list was last grouped by type.
+        bool unsorted_{};
+        /// Whether the list is being updated.
+        bool updating_{};
+    };
+
+    /// Return the update list of a logic component for a phase.
+    LogicUpdateList& GetLogicUpdateList(LogicComponent* component, LogicUpdatePhase phase);
+    /// Remove null entries and group components by type, unless the list is being updated.
+    void CompactLogicUpdateList(LogicUpdateList& list, LogicUpdatePhase phase);
     /// Handle the logic update event to update the scene, if active.
-    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleUpdate(const Update::Data& eventData);
     /// Handle a background loaded resource completing.
     void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
     /// Update asynchronous loading.
@@ -303,12 +337,18 @@ private:
     ea::hash_set<unsigned> networkUpdateNodes_;
     /// Components to check for attribute changes on the next network update.
     ea::hash_set<unsigned> networkUpdateComponents_;
+    /// Interest management grid of replicated nodes.
+    InterestGrid interestGrid_;
     /// Delayed dirty notification queue for components.
     ea::vector<Component*> delayedDirtyComponents_;
     /// Mutex for the delayed dirty notification queue.
     Mutex sceneMutex_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
+    /// Logic component update lists per phase.
+    LogicUpdateList logicUpdates_[MAX_LOGIC_UPDATE_PHASES];
+    /// Thread-safe logic component update lists per phase.
+    LogicUpdateList threadedLogicUpdates_[MAX_LOGIC_UPDATE_PHASES];
     /// Next free non-local node ID.
     unsigned replicatedNodeID_;
     /// Next free non-local component ID.
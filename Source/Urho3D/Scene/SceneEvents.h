@@ -27,11 +27,29 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
 {
     URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+
+    /// Typed payload, shared by the scene update, subsystem update, attribute animation update and post-update events.
+    struct Data
+    {
+        /// Scene being updated.
+        Scene* scene_{};
+        /// Scaled timestep in seconds.
+        float timeStep_{};
+
+        /// List members for conversion from and to event parameters.
+        template <class Visitor> void Visit(Visitor& visitor)
+        {
+            visitor(P_SCENE, scene_);
+            visitor(P_TIMESTEP, timeStep_);
+        }
+    };
 }
 
 /// Scene subsystem update.
@@ -39,6 +57,7 @@ URHO3D_EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
 {
     URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    using Data = SceneUpdate::Data;
 }
 
 /// Scene transform smoothing update.
@@ -70,6 +89,7 @@ URHO3D_EVENT(E_ATTRIBUTEANIMATIONUPDATE, AttributeAnimationUpdate)
 {
     URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    using Data = SceneUpdate::Data;
 }
 
 /// Attribute animation added to object animation.
@@ -91,6 +111,7 @@ URHO3D_EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
 {
     URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    using Data = SceneUpdate::Data;
 }
 
 /// Asynchronous scene loading progress.
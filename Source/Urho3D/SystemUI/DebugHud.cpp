@@ -24,6 +24,7 @@
 #include <EASTL/sort.h>
 
 #include "../Core/CoreEvents.h"
+#include "../Core/FrameProfiler.h"
 #include "../Core/Profiler.h"
 #include "../Engine/Engine.h"
 #include "../Graphics/Graphics.h"
@@ -60,7 +61,6 @@ static const unsigned FPS_UPDATE_INTERVAL_MS = 500;
 DebugHud::DebugHud(Context* context) :
     Object(context),
     profilerMaxDepth_(M_MAX_UNSIGNED),
-    profilerInterval_(1000),
     useRendererStats_(true),
     mode_(DEBUGHUD_SHOW_NONE),
     fps_(0)
@@ -91,6 +91,11 @@ void DebugHud::SetExtents(const IntVector2& position, IntVector2 size)
 
 void DebugHud::SetMode(DebugHudModeFlags mode)
 {
+    // Start recording when the profiler is first shown
+    auto* profiler = GetSubsystem<FrameProfiler>();
+    if (profiler && (mode & DEBUGHUD_SHOW_PROFILER) && !(mode_ & DEBUGHUD_SHOW_PROFILER))
+        profiler->SetEnabled(true);
+
     mode_ = mode;
 }
 
@@ -119,6 +124,11 @@ void DebugHud::SetUseRendererStats(bool enable)
     useRendererStats_ = enable;
 }
 
+void DebugHud::SetProfilerMaxDepth(unsigned depth)
+{
+    profilerMaxDepth_ = depth;
+}
+
 void DebugHud::Toggle(DebugHudModeFlags mode)
 {
     SetMode(GetMode() ^ mode);
@@ -190,12 +200,19 @@ void DebugHud::RenderUi(VariantMap& eventData)
             ui::Text("Lights %u", renderer->GetNumLights(true));
             ui::Text("Shadowmaps %u", renderer->GetNumShadowMaps(true));
             ui::Text("Occluders %u", renderer->GetNumOccluders(true));
+            ui::Text("Batch sort %d us", (int)renderer->GetBatchSortTime(true));
 
             for (auto i = appStats_.begin(); i !=
                 appStats_.end(); ++i)
                 ui::Text("%s %s", i->first.c_str(), i->second.c_str());
         }
 
+        if (mode_ & DEBUGHUD_SHOW_PROFILER)
+        {
+            if (auto* profiler = GetSubsystem<FrameProfiler>())
+                ui::TextUnformatted(profiler->PrintData(profilerMaxDepth_).c_str());
+        }
+
         if (mode_ & DEBUGHUD_SHOW_MODE)
         {
             auto& style = ui::GetStyle();
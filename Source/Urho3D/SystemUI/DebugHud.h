@@ -37,6 +37,7 @@ enum DebugHudMode : unsigned
     DEBUGHUD_SHOW_NONE = 0x0,
     DEBUGHUD_SHOW_STATS = 0x1,
     DEBUGHUD_SHOW_MODE = 0x2,
+    DEBUGHUD_SHOW_PROFILER = 0x4,
     DEBUGHUD_SHOW_ALL = 0x7,
 };
 URHO3D_FLAGSET(DebugHudMode, DebugHudModeFlags);
@@ -59,6 +60,8 @@ public:
     void CycleMode();
     /// Set whether to show 3D geometry primitive/batch count only. Default false.
     void SetUseRendererStats(bool enable);
+    /// Set maximum profiler block depth to show.
+    void SetProfilerMaxDepth(unsigned depth);
     /// Toggle elements.
     /// \param mode is a combination of DEBUGHUD_SHOW_* flags.
     void Toggle(DebugHudModeFlags mode);
@@ -69,6 +72,8 @@ public:
     DebugHudModeFlags GetMode() const { return mode_; }
     /// Return whether showing 3D geometry primitive/batch count only.
     bool GetUseRendererStats() const { return useRendererStats_; }
+    /// Return maximum profiler block depth to show.
+    unsigned GetProfilerMaxDepth() const { return profilerMaxDepth_; }
     /// Set application-specific stats.
     /// \param label a title of stat to be displayed.
     /// \param stats a variant value to be displayed next to the specified label.
@@ -96,8 +101,6 @@ private:
     ea::map<ea::string, ea::string> appStats_;
     /// Profiler max block depth.
     unsigned profilerMaxDepth_;
-    /// Profiler accumulation interval.
-    unsigned profilerInterval_;
     /// Show 3D geometry primitive/batch count flag.
     bool useRendererStats_;
     /// Current shown-element mode.
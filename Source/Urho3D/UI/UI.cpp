@@ -861,8 +861,8 @@ void UI::Initialize()
     initialized_ = true;
 
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(UI, HandleBeginFrame));
-    SubscribeToEvent(E_POSTUPDATE, URHO3D_HANDLER(UI, HandlePostUpdate));
-    SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(UI, HandleRenderUpdate));
+    SubscribeToEvent(E_POSTUPDATE, &UI::HandlePostUpdate);
+    SubscribeToEvent(E_RENDERUPDATE, &UI::HandleRenderUpdate);
 }
 
 void UI::Update(float timeStep, UIElement* element)
@@ -1953,14 +1953,12 @@ void UI::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
         cursor_->SetShape(CS_NORMAL);
 }
 
-void UI::HandlePostUpdate(StringHash eventType, VariantMap& eventData)
+void UI::HandlePostUpdate(const Update::Data& eventData)
 {
-    using namespace PostUpdate;
-
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
-void UI::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void UI::HandleRenderUpdate(const Update::Data& eventData)
 {
     RenderUpdate();
 }
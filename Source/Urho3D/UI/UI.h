@@ -30,6 +30,8 @@
 namespace Urho3D
 {
 
+namespace Update { struct Data; }
+
 /// Font hinting level (only used for FreeType fonts)
 enum FontHintLevel
 {
@@ -318,9 +320,9 @@ private:
     /// Handle frame begin event.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     /// Handle logic post-update event.
-    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandlePostUpdate(const Update::Data& eventData);
     /// Handle render update event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const Update::Data& eventData);
     /// Handle a file being drag-dropped into the application window.
     void HandleDropFile(StringHash eventType, VariantMap& eventData);
     /// Handle off-screen UI subsystems gaining focus.
@@ -1902,7 +1902,7 @@ IntVector2 UIElement::GetEffectiveMinSize() const
 void UIElement::OnAttributeAnimationAdded()
 {
     if (attributeAnimationInfos_.size() == 1)
-        SubscribeToEvent(E_POSTUPDATE, URHO3D_HANDLER(UIElement, HandlePostUpdate));
+        SubscribeToEvent(E_POSTUPDATE, &UIElement::HandlePostUpdate);
 }
 
 void UIElement::OnAttributeAnimationRemoved()
@@ -2260,11 +2260,9 @@ void UIElement::VerifyChildAlignment()
     }
 }
 
-void UIElement::HandlePostUpdate(StringHash eventType, VariantMap& eventData)
+void UIElement::HandlePostUpdate(const Update::Data& eventData)
 {
-    using namespace PostUpdate;
-
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
+    UpdateAttributeAnimations(eventData.timeStep_);
 }
 
 }
@@ -31,6 +31,8 @@
 namespace Urho3D
 {
 
+namespace Update { struct Data; }
+
 /// %UI element horizontal alignment.
 enum HorizontalAlignment
 {
@@ -759,7 +761,7 @@ private:
     /// Verify that child elements have proper alignment for layout mode.
     void VerifyChildAlignment();
     /// Handle logic post-update event.
-    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandlePostUpdate(const Update::Data& eventData);
 
     /// Size.
     IntVector2 size_;
@@ -93,7 +93,7 @@ void AnimatedSprite2D::OnSetEnabled()
     if (scene)
     {
         if (enabled)
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(AnimatedSprite2D, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, &AnimatedSprite2D::HandleScenePostUpdate);
         else
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
     }
@@ -218,7 +218,7 @@ void AnimatedSprite2D::OnSceneSet(Scene* scene)
         if (scene == node_)
             URHO3D_LOGWARNING(GetTypeName() + " should not be created to the root scene node");
         if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(AnimatedSprite2D, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, &AnimatedSprite2D::HandleScenePostUpdate);
     }
     else
         UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
@@ -242,10 +242,9 @@ void AnimatedSprite2D::UpdateSourceBatches()
     sourceBatchesDirty_ = false;
 }
 
-void AnimatedSprite2D::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void AnimatedSprite2D::HandleScenePostUpdate(const SceneUpdate::Data& eventData)
 {
-    using namespace ScenePostUpdate;
-    float timeStep = eventData[P_TIMESTEP].GetFloat();
+    float timeStep = eventData.timeStep_;
     UpdateAnimation(timeStep);
 }
 
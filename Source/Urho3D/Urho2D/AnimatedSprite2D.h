@@ -44,6 +44,8 @@ enum LoopMode2D
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
+
 namespace Spriter
 {
     class SpriterInstance;
@@ -102,7 +104,7 @@ protected:
     /// Handle update vertices.
     void UpdateSourceBatches() override;
     /// Handle scene post update.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const SceneUpdate::Data& eventData);
     /// Update animation.
     void UpdateAnimation(float timeStep);
 #ifdef URHO3D_SPINE
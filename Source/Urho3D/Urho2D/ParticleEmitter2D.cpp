@@ -80,7 +80,7 @@ void ParticleEmitter2D::OnSetEnabled()
     if (scene)
     {
         if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(ParticleEmitter2D, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, &ParticleEmitter2D::HandleScenePostUpdate);
         else
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
     }
@@ -186,7 +186,7 @@ void ParticleEmitter2D::OnSceneSet(Scene* scene)
     Drawable2D::OnSceneSet(scene);
 
     if (scene && IsEnabledEffective())
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(ParticleEmitter2D, HandleScenePostUpdate));
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, &ParticleEmitter2D::HandleScenePostUpdate);
     else if (!scene)
         UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
 }
@@ -274,12 +274,11 @@ void ParticleEmitter2D::UpdateMaterial()
         sourceBatches_[0].material_ = nullptr;
 }
 
-void ParticleEmitter2D::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void ParticleEmitter2D::HandleScenePostUpdate(const SceneUpdate::Data& eventData)
 {
-    using namespace ScenePostUpdate;
     bool hasParticles = numParticles_ > 0;
     bool emitting = emissionTime_ > 0.0f;
-    float timeStep = eventData[P_TIMESTEP].GetFloat();
+    float timeStep = eventData.timeStep_;
     Update(timeStep);
 
     if (emitting && emissionTime_ == 0.0f)
@@ -27,6 +27,7 @@
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
 class ParticleEffect2D;
 class Sprite2D;
 
@@ -133,7 +134,7 @@ private:
     /// Update material.
     void UpdateMaterial();
     /// Handle scene post update.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const SceneUpdate::Data& eventData);
     /// Update.
     void Update(float timeStep);
     /// Emit particle.
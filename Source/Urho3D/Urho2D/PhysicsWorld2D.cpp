@@ -280,12 +280,12 @@ void PhysicsWorld2D::Update(float timeStep)
 {
     URHO3D_PROFILE("UpdatePhysics2D");
 
-    using namespace PhysicsPreStep;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_WORLD] = this;
-    eventData[P_TIMESTEP] = timeStep;
-    SendEvent(E_PHYSICSPRESTEP, eventData);
+    PhysicsPreStep::Data eventData;
+    eventData.world_ = this;
+    eventData.timeStep_ = timeStep;
+    SendTypedEvent(E_PHYSICSPRESTEP, eventData);
+    if (GetFixedUpdateSource() == this)
+        GetScene()->UpdateLogicComponents(LUP_FIXEDUPDATE, timeStep);
 
     physicsStepping_ = true;
     world_->Step(timeStep, velocityIterations_, positionIterations_);
@@ -328,8 +328,9 @@ void PhysicsWorld2D::Update(float timeStep)
     SendBeginContactEvents();
     SendEndContactEvents();
 
-    using namespace PhysicsPostStep;
-    SendEvent(E_PHYSICSPOSTSTEP, eventData);
+    SendTypedEvent(E_PHYSICSPOSTSTEP, eventData);
+    if (GetFixedUpdateSource() == this)
+        GetScene()->UpdateLogicComponents(LUP_FIXEDPOSTUPDATE, timeStep);
 }
 
 void PhysicsWorld2D::DrawDebugGeometry()
@@ -706,18 +707,17 @@ void PhysicsWorld2D::OnSceneSet(Scene* scene)
 {
     // Subscribe to the scene subsystem update, which will trigger the physics simulation step
     if (scene)
-        SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, URHO3D_HANDLER(PhysicsWorld2D, HandleSceneSubsystemUpdate));
+        SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, &PhysicsWorld2D::HandleSceneSubsystemUpdate);
     else
         UnsubscribeFromEvent(E_SCENESUBSYSTEMUPDATE);
 }
 
-void PhysicsWorld2D::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
+void PhysicsWorld2D::HandleSceneSubsystemUpdate(const SceneUpdate::Data& eventData)
 {
     if (!updateEnabled_)
         return;
 
-    using namespace SceneSubsystemUpdate;
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 void PhysicsWorld2D::SendBeginContactEvents()
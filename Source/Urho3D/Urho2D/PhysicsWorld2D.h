@@ -30,6 +30,7 @@
 namespace Urho3D
 {
 
+namespace SceneUpdate { struct Data; }
 class Camera;
 class CollisionShape2D;
 class RigidBody2D;
@@ -210,7 +211,7 @@ protected:
     void OnSceneSet(Scene* scene) override;
 
     /// Handle the scene subsystem update event, step simulation here.
-    void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneSubsystemUpdate(const SceneUpdate::Data& eventData);
     /// Send begin contact events.
     void SendBeginContactEvents();
     /// Send end contact events.